@@ -1,24 +1,48 @@
-#ifndef JSON_INCLUDED_H
-#define JSON_INCLUDED_H
-
-#include "Json_error.h"
-#include "Json_string.h"
-#include "Json_type.h"
-
-
-#define USING_JSON_UTILITIES \
-using json::String; \
-using json::Number; \
-using json::Object; \
-using json::Array; \
-using json::True; \
-using json::False; \
-using json::Null; \
-using json::Value; \
-using json::JsonString; \
-using json::JsonError; \
-using json::ErrorType; \
-using json::JsonType;
-
-
-#endif // JSON_INCLUDED_H
+#ifndef JSON_INCLUDED_H
+#define JSON_INCLUDED_H
+
+#include "Json_error.h"
+#include "Json_string.h"
+#include "Json_alloc.h"
+#include "Json_slab.h"
+#include "Json_type.h"
+#include "Json_parallel.h"
+#include "Json_scanner.h"
+#include "Json_shared.h"
+#include "Json_bind.h"
+#include "Json_literal.h"
+#include "Json_gather.h"
+#include "Json_stream.h"
+#include "Json_compress.h"
+#include "Json_projection.h"
+#include "Json_columns.h"
+#include "Json_path.h"
+#include "Json_index.h"
+#include "Json_release.h"
+
+
+#define USING_JSON_UTILITIES \
+using json::String; \
+using json::Number; \
+using json::Object; \
+using json::Array; \
+using json::True; \
+using json::False; \
+using json::Null; \
+using json::Value; \
+using json::JsonString; \
+using json::JsonError; \
+using json::ErrorType; \
+using json::JsonType; \
+using json::ParseResult; \
+using json::ParallelOptions; \
+using json::SharedDocument; \
+using json::Constant; \
+using json::GatherBuffer; \
+using json::ArrayStream; \
+using json::Projection; \
+using json::JsonPath; \
+using json::ArrayIndex;
+
+
+#endif // JSON_INCLUDED_H
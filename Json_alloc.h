@@ -0,0 +1,180 @@
+#ifndef JSON_ALLOC_H
+#define JSON_ALLOC_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <type_traits>
+
+_JSON_BEGIN
+
+/**************************************
+ 内存来源：树中所有的结点、容器与字符串的内存都可以来自一个std::pmr::memory_resource。
+ 1、当前线程有一个“当前的memory_resource”（为空表示::operator new，即默认情况），
+    由ResourceScope设置；创建结点、容器与字符串时使用它；
+ 2、结点（Value_base的派生类、NumberImpl、Shape等）在分配的内存块之前保存来源，
+    释放时归还给原来的memory_resource，与释放时的当前设置无关；
+    容器与字符串使用Allocator，来源保存在Allocator中；
+ 3、Object/Array的非const成员函数在插入新元素时临时切换到容器自己的来源，
+    因此通过它们创建的子结点继承父结点的memory_resource（见Value::Parse的说明）；
+    调用者构造之后移入的结点（obj["k"] = true、push_back(Value("..."))等）来源不同时
+    换成在容器的来源中的副本，在ResourceScope中构造它们可以省去这次复制；
+ 4、const访问时才生成的缓存（序列化结果、压缩Object/Array的view、数字的转换结果）
+    总是使用::operator new，因此多个线程仍然可以同时读取同一棵树；
+ 5、并行解析（Value::Parse(text, ParallelOptions)）的结果总是来自::operator new。
+ memory_resource必须比使用它的树活得更久；不是线程安全的memory_resource
+ （如unsynchronized_pool_resource、monotonic_buffer_resource）上的树
+ 不能在别的线程中修改或释放（例如交给后台的Reclaimer）。
+ 每个结点多占8个字节的头部（NumberImpl与Object::Packed为16个字节）。
+
+**************************************/
+
+/// 当前线程的memory_resource，nullptr表示使用::operator new
+inline thread_local std::pmr::memory_resource *tls_resource = nullptr;
+
+inline std::pmr::memory_resource *current_resource() noexcept { return tls_resource; }
+
+
+/// 在作用域内把当前线程的memory_resource设为mr（nullptr表示::operator new），退出时恢复
+class ResourceScope
+{
+public:
+    explicit ResourceScope(std::pmr::memory_resource *mr) noexcept:
+        saved(tls_resource) { tls_resource = mr; }
+    ~ResourceScope() { tls_resource = saved; }
+
+    ResourceScope(const ResourceScope &) = delete;
+    ResourceScope &operator=(const ResourceScope &) = delete;
+
+private:
+    std::pmr::memory_resource *saved;
+};
+
+
+/**************************************
+ Allocator：保存memory_resource的分配器，为空时直接使用::operator new。
+ 1、默认构造时取当前线程的memory_resource；
+ 2、拷贝容器时（select_on_container_copy_construction）也取当前线程的设置，
+    即副本的内存来自拷贝发生时的memory_resource，而不是原容器的；
+ 3、移动赋值与swap时随内容一起转移（propagate为true），移动之后不会逐个元素地复制。
+
+**************************************/
+template<typename T>
+class Allocator
+{
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    Allocator() noexcept: mr(tls_resource) {}
+    explicit Allocator(std::pmr::memory_resource *r) noexcept: mr(r) {}
+    template<typename U>
+    Allocator(const Allocator<U> &rhs) noexcept: mr(rhs.resource()) {}
+
+    T *allocate(std::size_t n)
+    {
+        if(n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        if(mr == nullptr)
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        return static_cast<T *>(mr->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        if(mr == nullptr)
+            ::operator delete(p);
+        else
+            mr->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    Allocator select_on_container_copy_construction() const noexcept { return Allocator(); }
+
+    std::pmr::memory_resource *resource() const noexcept { return mr; }
+
+private:
+    std::pmr::memory_resource *mr;
+};
+
+template<typename T, typename U>
+inline bool operator==(const Allocator<T> &lhs, const Allocator<U> &rhs) noexcept
+    { return lhs.resource() == rhs.resource(); }
+
+template<typename T, typename U>
+inline bool operator!=(const Allocator<T> &lhs, const Allocator<U> &rhs) noexcept
+    { return lhs.resource() != rhs.resource(); }
+
+
+/// String结点保存内容的字符串
+typedef std::basic_string<char, std::char_traits<char>, Allocator<char>> NodeString;
+
+
+/// 结点的内存块：之前的头部保存来源，见上面的说明2
+namespace alloc_detail
+{
+/// 对齐不超过8的结点：头部只有来源，大小由类的operator delete给出
+const std::size_t kNodeHeader = 8;
+/// 大小可变或需要16字节对齐的块（NumberImpl、Object::Packed）：头部保存来源与大小
+const std::size_t kBlockHeader = 16;
+}
+
+inline void *allocate_node(std::size_t n)
+{
+    std::pmr::memory_resource *mr = tls_resource;
+    void *p = mr ? mr->allocate(n + alloc_detail::kNodeHeader, alloc_detail::kNodeHeader)
+                 : ::operator new(n + alloc_detail::kNodeHeader);
+    *static_cast<std::pmr::memory_resource **>(p) = mr;
+    return static_cast<char *>(p) + alloc_detail::kNodeHeader;
+}
+
+inline void deallocate_node(void *p, std::size_t n) noexcept
+{
+    void *block = static_cast<char *>(p) - alloc_detail::kNodeHeader;
+    if(std::pmr::memory_resource *mr = *static_cast<std::pmr::memory_resource **>(block))
+        mr->deallocate(block, n + alloc_detail::kNodeHeader, alloc_detail::kNodeHeader);
+    else
+        ::operator delete(block);
+}
+
+/// 结点p的内存来源（p必须由allocate_node分配）
+inline std::pmr::memory_resource *node_resource(const void *p) noexcept
+{
+    return *reinterpret_cast<std::pmr::memory_resource *const *>(
+        static_cast<const char *>(p) - alloc_detail::kNodeHeader);
+}
+
+inline void *allocate_block(std::size_t n)
+{
+    std::pmr::memory_resource *mr = tls_resource;
+    std::size_t total = n + alloc_detail::kBlockHeader;
+    void *p = mr ? mr->allocate(total, alloc_detail::kBlockHeader) : ::operator new(total);
+    static_cast<std::pmr::memory_resource **>(p)[0] = mr;
+    static_cast<std::size_t *>(p)[1] = total;
+    return static_cast<char *>(p) + alloc_detail::kBlockHeader;
+}
+
+inline void deallocate_block(void *p) noexcept
+{
+    void *block = static_cast<char *>(p) - alloc_detail::kBlockHeader;
+    if(std::pmr::memory_resource *mr = static_cast<std::pmr::memory_resource **>(block)[0])
+        mr->deallocate(block, static_cast<std::size_t *>(block)[1], alloc_detail::kBlockHeader);
+    else
+        ::operator delete(block);
+}
+
+
+/// 供结点类使用：operator new/delete经由allocate_node，见上面的说明2
+#define JSON_NODE_ALLOCATION \
+    static void *operator new(std::size_t n) { return _JSON allocate_node(n); } \
+    static void operator delete(void *p, std::size_t n) noexcept { _JSON deallocate_node(p, n); }
+
+
+_JSON_END
+#endif // JSON_ALLOC_H
@@ -0,0 +1,470 @@
+#ifndef JSON_BIND_H
+#define JSON_BIND_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include "Json_error.h"
+#include "Json_string.h"
+#include "Json_reader.h"
+#include "Json_scanner.h"
+#include "Json_type.h"
+
+
+/**************************************
+ JSON_BIND(_Type, field1, field2, ...)：
+ 在_Type所在的命名空间中生成JsonBindRead/JsonBindWrite两个函数，
+ 使ParseBound/SerializeBound可以在json文本与_Type之间直接转换，
+ 中间不构造任何Value。
+ 1、读取时对每个键计算FNV-1a散列，并switch到编译期算好的各字段散列值上，
+    两个字段的散列值若相同会导致重复的case标签而编译失败，因此该散列对已知键是完美的；
+ 2、未知的键以Scanner::skip_value的速度整体跳过；
+ 3、重复的键只取第一次出现的值（与Object::Parse一致），缺失的键与null值保留原值；
+ 4、最多支持32个字段，字段类型可以是bool、算术类型、std::string、std::vector、
+    Value，以及另一个用JSON_BIND绑定过的类型。
+
+ 用法（须在_Type所在的命名空间中、且在全局或命名空间作用域下使用）：
+    struct Point { int x; int y; std::string tag; };
+    JSON_BIND(Point, x, y, tag)
+
+    Point p = json::ParseBound<Point>("{\"x\":1,\"y\":2}");
+    JsonString s = json::SerializeBound(p);
+
+**************************************/
+#define JSON_BIND(_Type, ...) \
+inline void JsonBindRead(::json::Scanner &s, _Type &obj) \
+{ \
+    ::json::BindObjectReader reader(s); \
+    unsigned long long seen = 0; \
+    while(reader.next()) \
+    { \
+        const ::json::SubString &key = reader.key(); \
+        switch(::json::BindHash(key.first, key.second)) \
+        { \
+        _JSON_BIND_EACH(_JSON_BIND_CASE, __VA_ARGS__) \
+        default: break; \
+        } \
+        reader.skip(); \
+    } \
+    (void)seen; \
+} \
+ \
+inline void JsonBindWrite(std::string &out, const _Type &obj) \
+{ \
+    char sep = '{'; \
+    _JSON_BIND_EACH(_JSON_BIND_WRITE, __VA_ARGS__) \
+    if(sep == '{') \
+        out.push_back('{'); \
+    out.push_back('}'); \
+}
+
+
+#define _JSON_BIND_CASE(i, f) \
+        case ::json::BindHash(#f): \
+            if(::json::BindKeyIs(key, #f) && !(seen & (1ULL << (i)))) \
+            { \
+                seen |= 1ULL << (i); \
+                ::json::Binder<decltype(obj.f)>::Read(s, obj.f); \
+                continue; \
+            } \
+            break;
+
+#define _JSON_BIND_WRITE(i, f) \
+    out.push_back(sep); \
+    sep = ','; \
+    out.append("\"" #f "\":"); \
+    ::json::Binder<decltype(obj.f)>::Write(out, obj.f);
+
+#define _JSON_BIND_EXPAND(x) x
+#define _JSON_BIND_CAT(a, b) _JSON_BIND_CAT_IMPL(a, b)
+#define _JSON_BIND_CAT_IMPL(a, b) a##b
+#define _JSON_BIND_NARG(...) \
+    _JSON_BIND_EXPAND(_JSON_BIND_NARG_IMPL(__VA_ARGS__, 32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17,16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1))
+#define _JSON_BIND_NARG_IMPL(_1,_2,_3,_4,_5,_6,_7,_8,_9,_10,_11,_12,_13,_14,_15,_16,_17,_18,_19,_20,_21,_22,_23,_24,_25,_26,_27,_28,_29,_30,_31,_32, N, ...) N
+#define _JSON_BIND_EACH(M, ...) \
+    _JSON_BIND_EXPAND(_JSON_BIND_CAT(_JSON_BIND_EACH_, _JSON_BIND_NARG(__VA_ARGS__))(M, 0, __VA_ARGS__))
+#define _JSON_BIND_EACH_1(M, i, f) M(i, f)
+#define _JSON_BIND_EACH_2(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_1(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_3(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_2(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_4(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_3(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_5(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_4(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_6(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_5(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_7(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_6(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_8(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_7(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_9(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_8(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_10(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_9(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_11(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_10(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_12(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_11(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_13(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_12(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_14(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_13(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_15(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_14(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_16(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_15(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_17(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_16(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_18(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_17(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_19(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_18(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_20(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_19(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_21(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_20(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_22(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_21(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_23(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_22(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_24(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_23(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_25(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_24(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_26(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_25(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_27(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_26(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_28(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_27(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_29(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_28(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_30(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_29(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_31(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_30(M, i + 1, __VA_ARGS__))
+#define _JSON_BIND_EACH_32(M, i, f, ...) M(i, f) _JSON_BIND_EXPAND(_JSON_BIND_EACH_31(M, i + 1, __VA_ARGS__))
+
+_JSON_BEGIN
+
+/// 编译期与运行期使用同一个FNV-1a散列
+constexpr unsigned long long
+    BindHash(const char *s, unsigned long long h = 14695981039346656037ULL)
+{
+    return *s ? BindHash(s + 1, (h ^ static_cast<unsigned char>(*s)) * 1099511628211ULL) : h;
+}
+
+inline unsigned long long
+    BindHash(const char *b, const char *e)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    for(; b != e; ++b)
+        h = (h ^ static_cast<unsigned char>(*b)) * 1099511628211ULL;
+    return h;
+}
+
+template<std::size_t N>
+inline bool BindKeyIs(const SubString &key, const char (&name)[N])
+{
+    return key.length() == N - 1
+        && std::memcmp(key.first, name, N - 1) == 0;
+}
+
+
+inline void BindCheck(const Scanner &s, bool ok)
+{
+    if(!ok)
+        throw JsonError(s.error());
+}
+
+/// 若下一个值是null则吃掉它并返回true
+inline bool BindNull(Scanner &s)
+{
+    s.skip_ws();
+    if(s.peek() != 'n')
+        return false;
+    BindCheck(s, s.read_literal("null", 4));
+    return true;
+}
+
+
+
+/**************************************
+ BindObjectReader：逐个读出Object中的键，值留给调用者读取或跳过。
+ 不含转义字符的键直接指向原文，不做拷贝。
+
+**************************************/
+class BindObjectReader
+{
+public:
+    explicit BindObjectReader(Scanner &s): scanner(s), k(nullptr, nullptr), first(true)
+    {
+        scanner.skip_ws();
+        if(scanner.peek() != '{')
+            throw JsonError(scanner.eof() ? error_empty : json_bad_cast);
+        scanner.seek(scanner.position() + 1);
+    }
+
+    bool next()
+    {
+        if(scanner.consume('}'))
+            return false;
+        if(!first && !scanner.consume(','))
+            throw JsonError(scanner.eof() ? error_brace : error_comma);
+        first = false;
+
+        scanner.skip_ws();
+        if(scanner.peek() != '\"')
+            throw JsonError(scanner.eof() ? error_brace :
+                            scanner.peek() == '}' ? error_comma : error_pair);
+
+        const char *b = scanner.position() + 1;
+        BindCheck(scanner, scanner.skip_string());
+        const char *e = scanner.position() - 1;
+        if(std::memchr(b, '\\', e - b) == nullptr)
+            k = SubString(b, e);
+        else
+        {
+            buffer.clear();
+            scanner.seek(b - 1);
+            BindCheck(scanner, scanner.read_string(buffer));
+            k = SubString(buffer.data(), buffer.data() + buffer.size());
+        }
+
+        if(!scanner.consume(':'))
+            throw JsonError(error_pair);
+        scanner.skip_ws();
+        return true;
+    }
+
+    const SubString &key() const { return k; }
+
+    void skip() { BindCheck(scanner, scanner.skip_value()); }
+
+private:
+    Scanner &scanner;
+    SubString k;
+    std::string buffer;
+    bool first;
+};
+
+
+
+/// Binder<T>：T与json文本之间的读写规则，未特化时交给JSON_BIND生成的函数（通过ADL查找）
+template<typename T, typename = void>
+struct Binder
+{
+    static void Read(Scanner &s, T &v)
+    {
+        if(!BindNull(s))
+            JsonBindRead(s, v);
+    }
+
+    static void Write(std::string &out, const T &v)
+        { JsonBindWrite(out, v); }
+};
+
+
+template<>
+struct Binder<bool>
+{
+    static void Read(Scanner &s, bool &v)
+    {
+        if(BindNull(s))
+            return;
+        switch(s.peek())
+        {
+        case 't': BindCheck(s, s.read_literal("true", 4)); v = true; break;
+        case 'f': BindCheck(s, s.read_literal("false", 5)); v = false; break;
+        default:  throw JsonError(s.eof() ? error_empty : json_bad_cast);
+        }
+    }
+
+    static void Write(std::string &out, bool v)
+        { out += v ? "true" : "false"; }
+};
+
+
+/// 整数：浮点词素按Number::to_xxx的方式截断，截断或读出的值超出T的范围时报告error_badnum
+template<typename T>
+struct Binder<T, typename std::enable_if<std::is_integral<T>::value>::type>
+{
+    static void Read(Scanner &s, T &v)
+    {
+        if(BindNull(s))
+            return;
+        SubString lexeme(nullptr, nullptr);
+        bool integral = true;
+        if(s.peek() == '\"' || s.peek() == '[' || s.peek() == '{'
+           || s.peek() == 't' || s.peek() == 'f')
+            throw JsonError(json_bad_cast);
+        BindCheck(s, s.read_number(lexeme, integral));
+
+        if(!integral)
+        {
+            long double ld = 0.0L;
+            if(!parse_longdouble(lexeme, ld))
+                throw JsonError(error_badnum);
+            /// T的范围是[-2^digits, 2^digits)或[0, 2^digits)，边界可以用long double精确表示；
+            /// 比较失败（包括nan）时转换是未定义行为
+            long double t = std::trunc(ld);
+            const long double bound = std::ldexp(1.0L, std::numeric_limits<T>::digits);
+            if(!(t < bound && t >= (std::is_signed<T>::value ? -bound : 0.0L)))
+                throw JsonError(error_badnum);
+            v = static_cast<T>(t);
+        }
+        else if(*lexeme.first == '-')
+        {
+            long long ll = 0;
+            if(!parse_longlong(lexeme, ll))
+                throw JsonError(error_badnum);
+            if(std::is_unsigned<T>::value ? ll < 0
+                                          : ll < static_cast<long long>(std::numeric_limits<T>::min()))
+                throw JsonError(error_badnum);
+            v = static_cast<T>(ll);
+        }
+        else
+        {
+            unsigned long long ull = 0;
+            if(!parse_ulonglong(lexeme, ull))
+                throw JsonError(error_badnum);
+            if(ull > static_cast<unsigned long long>(std::numeric_limits<T>::max()))
+                throw JsonError(error_badnum);
+            v = static_cast<T>(ull);
+        }
+    }
+
+    static void Write(std::string &out, T v)
+        { out += std::to_string(v); }
+};
+
+
+/// 浮点数：以max_digits10位有效数字输出，保证读回后数值不变；
+/// nan与±inf在json中没有表示，输出时报告error_badnum
+template<typename T>
+struct Binder<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    static void Read(Scanner &s, T &v)
+    {
+        if(BindNull(s))
+            return;
+        SubString lexeme(nullptr, nullptr);
+        bool integral = true;
+        if(s.peek() == '\"' || s.peek() == '[' || s.peek() == '{'
+           || s.peek() == 't' || s.peek() == 'f')
+            throw JsonError(json_bad_cast);
+        BindCheck(s, s.read_number(lexeme, integral));
+
+        long double ld = 0.0L;
+        if(!parse_longdouble(lexeme, ld))
+            throw JsonError(error_badnum);
+        v = static_cast<T>(ld);
+    }
+
+    static void Write(std::string &out, T v)
+    {
+        if(!std::isfinite(v))
+            throw JsonError(error_badnum);
+        char buf[64];
+        int n = std::snprintf(buf, sizeof(buf), "%.*Lg",
+                              std::numeric_limits<T>::max_digits10,
+                              static_cast<long double>(v));
+        out.append(buf, n);
+    }
+};
+
+
+template<>
+struct Binder<std::string>
+{
+    static void Read(Scanner &s, std::string &v)
+    {
+        if(BindNull(s))
+            return;
+        if(s.peek() != '\"')
+            throw JsonError(s.eof() ? error_empty : json_bad_cast);
+        v.clear();
+        BindCheck(s, s.read_string(v));
+    }
+
+    static void Write(std::string &out, const std::string &v)
+        { append_escaped(out, v.data(), v.size()); }
+};
+
+
+template<typename T, typename _Alloc>
+struct Binder<std::vector<T, _Alloc>>
+{
+    static void Read(Scanner &s, std::vector<T, _Alloc> &v)
+    {
+        if(BindNull(s))
+            return;
+        if(s.peek() != '[')
+            throw JsonError(s.eof() ? error_empty : json_bad_cast);
+        s.seek(s.position() + 1);
+
+        v.clear();
+        if(s.consume(']'))
+            return;
+        do
+        {
+            v.emplace_back();
+            Binder<T>::Read(s, v.back());
+        }
+        while(s.consume(','));
+
+        if(!s.consume(']'))
+            throw JsonError(s.eof() ? error_brack : error_comma);
+    }
+
+    static void Write(std::string &out, const std::vector<T, _Alloc> &v)
+    {
+        out.push_back('[');
+        for(auto it = v.cbegin(); it != v.cend(); ++it)
+        {
+            if(it != v.cbegin())
+                out.push_back(',');
+            Binder<T>::Write(out, *it);
+        }
+        out.push_back(']');
+    }
+};
+
+
+/// Value字段：交给Reader在原文上直接解析
+template<>
+struct Binder<Value>
+{
+    static void Read(Scanner &s, Value &v)
+    {
+        Reader reader(s.position(), s.end());
+        if(!reader.parse_value(v))
+            throw JsonError(reader.scan().error());
+        s.seek(reader.scan().position());
+    }
+
+    static void Write(std::string &out, const Value &v)
+        { out += v.Serialize(); }
+};
+
+
+
+/// 把json文本直接解析到obj中，obj中未出现在文本里的字段保持原值
+template<typename T>
+void ParseBound(const JsonString &js, T &obj)
+{
+    Scanner s(js.data(), js.data() + js.size());
+    Binder<T>::Read(s, obj);
+
+    s.skip_ws();
+    if(!s.eof())
+    {
+        switch(s.peek())
+        {
+        case ']': throw JsonError(error_brack);
+        case '}': throw JsonError(error_brace);
+        default:  throw JsonError(error_comma);
+        }
+    }
+}
+
+template<typename T>
+T ParseBound(const JsonString &js)
+{
+    T obj{};
+    ParseBound(js, obj);
+    return obj;
+}
+
+/// 把obj直接序列化为json文本，字段按JSON_BIND中声明的顺序输出
+template<typename T>
+JsonString SerializeBound(const T &obj)
+{
+    JsonString ret;
+    Binder<T>::Write(ret, obj);
+    return ret;
+}
+
+
+_JSON_END
+#endif // JSON_BIND_H
@@ -0,0 +1,762 @@
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Json_error.h"
+#include "Json_string.h"
+#include "Json_scanner.h"
+#include "Json_reader.h"
+#include "Json_type.h"
+#include "Json_parallel.h"
+#include "Json_columns.h"
+
+_JSON_BEGIN
+
+
+const Column *ColumnTable::find(std::string_view name) const
+{
+    for(const auto &c : columns)
+        if(c.name == name)
+            return &c;
+    return nullptr;
+}
+
+
+
+/**************************************
+ Columnizer：to_columns的实现，是各结点类的友元。
+ 1、schema的路径编译成一棵前缀树（供文本版本按键查找）与每列的键序列（供Array版本逐级查找）；
+ 2、每一块行对应一个Chunk，其中的列只由处理该块的任务写入；
+ 3、Array版本对每一行、每一列沿路径查找：压缩的Object在Shape与上一行相同时直接按下标取值；
+ 4、文本版本对每一行做一次单遍扫描：前缀树中没有的键用skip_value跳过，
+    叶子结点直接把词素或字符串转换进列中，不构造任何Value；
+ 5、merge按块的顺序拼接各列，validity按位拼接。
+
+**************************************/
+class Columnizer
+{
+public:
+    static const std::size_t npos = static_cast<std::size_t>(-1);
+
+    explicit Columnizer(const std::vector<ColumnSpec> &schema);
+
+    struct Chunk
+    {
+        std::vector<Column> cols;
+        std::size_t rows = 0;
+        std::vector<char> set;          /// 文本版本：本行中该列是否已经有值
+        const char *errpos = nullptr;   /// 文本版本的格式错误
+        ErrorType err = error_empty;
+        std::exception_ptr error;       /// json_bad_cast等异常
+    };
+
+    void start(Chunk &c, std::size_t reserve) const;
+
+    /// Array版本：转换一行
+    void add_row(Chunk &c, const Value &row);
+    /// 文本版本：从s的当前位置解析“行 (, 行)*”直到stop；stop为nullptr时解析到「]」为止
+    bool add_rows(Chunk &c, Scanner &s, const char *stop) const;
+
+    ColumnTable merge(std::vector<Chunk> &chunks) const;
+
+    std::size_t columns() const { return specs.size(); }
+
+private:
+    struct Node
+    {
+        std::vector<std::pair<std::string, std::size_t>> children;   /// 按键排序
+        std::vector<std::size_t> columns;                            /// 以该结点为终点的列（同一路径可以有多列）
+
+        std::size_t find(std::string_view key) const;
+    };
+
+    /// Array版本中每列每一级的查找缓存：上一个压缩Object的Shape与键的下标
+    struct Hop
+    {
+        const Shape *shape = nullptr;
+        std::size_t index = 0;
+    };
+
+    static void push_valid(Column &col, std::size_t row, bool valid);
+    static void push_null(Column &col, std::size_t row);
+    static void push_number(Column &col, std::size_t row, const Number &n);
+    static void push_leaf(Column &col, std::size_t row, const Value_base *p);
+    static long long number_to_int(const SubString &lexeme, bool integral);
+    static bool number_to_double(const SubString &lexeme, bool integral, double &d);
+
+    bool text_row(Chunk &c, Scanner &s) const;
+    bool text_object(Chunk &c, Scanner &s, std::size_t n) const;
+    bool text_member(Chunk &c, Scanner &s, std::size_t n) const;
+    bool text_leaf(Chunk &c, Scanner &s, std::size_t column) const;
+
+    std::vector<ColumnSpec> specs;
+    std::vector<std::vector<std::string>> paths;
+    std::vector<Node> trie;                 /// trie[0]是根结点
+    std::vector<std::vector<Hop>> hops;     /// hops[列][级]，只在Array版本的单个任务中使用
+};
+
+
+Columnizer::Columnizer(const std::vector<ColumnSpec> &schema): specs(schema), trie(1)
+{
+    for(std::size_t i = 0; i != specs.size(); ++i)
+    {
+        std::vector<std::string> keys(1);
+        const std::string &path = specs[i].path;
+        for(std::size_t j = 0; j != path.size(); ++j)
+        {
+            if(path[j] == '\\' && j + 1 != path.size())
+                keys.back() += path[++j];
+            else if(path[j] == '.')
+                keys.emplace_back();
+            else
+                keys.back() += path[j];
+        }
+
+        std::size_t n = 0;
+        for(const auto &key : keys)
+        {
+            std::size_t child = trie[n].find(key);
+            if(child == 0)
+            {
+                child = trie.size();
+                auto &children = trie[n].children;
+                auto it = std::lower_bound(children.begin(), children.end(), key,
+                    [](const std::pair<std::string, std::size_t> &c, const std::string &k) { return c.first < k; });
+                children.emplace(it, key, child);
+                trie.emplace_back();
+            }
+            n = child;
+        }
+        trie[n].columns.push_back(i);
+        paths.push_back(std::move(keys));
+    }
+}
+
+
+std::size_t Columnizer::Node::find(std::string_view key) const
+{
+    auto it = std::lower_bound(children.begin(), children.end(), key,
+        [](const std::pair<std::string, std::size_t> &c, std::string_view k) { return c.first < k; });
+    return it != children.end() && it->first == key ? it->second : 0;
+}
+
+
+void Columnizer::start(Chunk &c, std::size_t reserve) const
+{
+    c.cols.resize(specs.size());
+    c.set.assign(specs.size(), 0);
+    for(std::size_t i = 0; i != specs.size(); ++i)
+    {
+        Column &col = c.cols[i];
+        col.name = specs[i].path;
+        col.type = specs[i].type;
+        col.validity.reserve((reserve + 63) / 64);
+        switch(col.type)
+        {
+        case ColumnType::float64: col.f64.reserve(reserve); break;
+        case ColumnType::int64:   col.i64.reserve(reserve); break;
+        case ColumnType::boolean: col.b8.reserve(reserve); break;
+        case ColumnType::string:
+            col.offsets.reserve(reserve + 1);
+            col.offsets.push_back(0);
+            break;
+        }
+    }
+}
+
+
+
+void Columnizer::push_valid(Column &col, std::size_t row, bool valid)
+{
+    if(row % 64 == 0)
+        col.validity.push_back(0);
+    if(valid)
+        col.validity.back() |= std::uint64_t(1) << (row % 64);
+    else
+        ++col.null_count;
+}
+
+
+void Columnizer::push_null(Column &col, std::size_t row)
+{
+    push_valid(col, row, false);
+    switch(col.type)
+    {
+    case ColumnType::float64: col.f64.push_back(0); break;
+    case ColumnType::int64:   col.i64.push_back(0); break;
+    case ColumnType::boolean: col.b8.push_back(0); break;
+    case ColumnType::string:  col.offsets.push_back(col.blob.size()); break;
+    }
+}
+
+
+/// 不超过18位的整数（词素已经符合JSON文法）逐位累加，不经过strtoll；位数更多时返回false
+static bool small_integer(const SubString &lexeme, long long &v)
+{
+    const char *b = lexeme.first;
+    bool negative = *b == '-';
+    b += negative;
+    if(lexeme.second - b > 18)
+        return false;
+    long long n = 0;
+    for(; b != lexeme.second; ++b)
+        n = n * 10 + (*b - '0');
+    v = negative ? -n : n;
+    return true;
+}
+
+
+/// 与LEXEME::to_impl + to_longlong的结果相同：整数按64位解析，其余按long double截断
+long long Columnizer::number_to_int(const SubString &lexeme, bool integral)
+{
+    if(integral)
+    {
+        long long ll;
+        unsigned long long ull;
+        if(small_integer(lexeme, ll))
+            return ll;
+        if(*lexeme.first == '-' ? parse_longlong(lexeme, ll) : parse_ulonglong(lexeme, ull))
+            return *lexeme.first == '-' ? ll : static_cast<long long>(ull);
+    }
+    long double ld = 0;
+    parse_longdouble(lexeme, ld);
+    return static_cast<long long>(ld);
+}
+
+
+/// 64位范围内的整数转换为double只舍入一次，与strtod的结果相同，因此按整数解析，避免strtod
+bool Columnizer::number_to_double(const SubString &lexeme, bool integral, double &d)
+{
+    if(integral)
+    {
+        long long ll;
+        unsigned long long ull;
+        if(small_integer(lexeme, ll))
+        {
+            d = static_cast<double>(ll);
+            return true;
+        }
+        if(*lexeme.first == '-' ? parse_longlong(lexeme, ll) : parse_ulonglong(lexeme, ull))
+        {
+            d = *lexeme.first == '-' ? static_cast<double>(ll) : static_cast<double>(ull);
+            return true;
+        }
+    }
+    return parse_double(lexeme, d);
+}
+
+
+/// 保存了词素的Number直接从词素转换，不调用to_X，因此不会在结点中缓存转换结果
+void Columnizer::push_number(Column &col, std::size_t row, const Number &n)
+{
+    std::string_view lx = n.lexeme();
+    SubString lexeme(lx.data(), lx.data() + lx.size());
+    if(col.type == ColumnType::float64)
+    {
+        double d;
+        if(lx.empty() || !number_to_double(lexeme, lx.find_first_of(".eE") == std::string_view::npos, d))
+            d = n.to_double();
+        col.f64.push_back(d);
+    }
+    else if(col.type == ColumnType::int64)
+    {
+        col.i64.push_back(lx.empty() ? n.to_longlong()
+                          : number_to_int(lexeme, lx.find_first_of(".eE") == std::string_view::npos));
+    }
+    else
+        throw JsonError(json_bad_cast);
+    push_valid(col, row, true);
+}
+
+
+void Columnizer::push_leaf(Column &col, std::size_t row, const Value_base *p)
+{
+    switch(p->Type())
+    {
+    case null_type:
+        push_null(col, row);
+        return;
+    case number_type:
+        push_number(col, row, *static_cast<const Number *>(p));
+        return;
+    case true_type:
+    case false_type:
+        if(col.type != ColumnType::boolean)
+            throw JsonError(json_bad_cast);
+        col.b8.push_back(p->Type() == true_type);
+        push_valid(col, row, true);
+        return;
+    case string_type:
+    {
+        if(col.type != ColumnType::string)
+            throw JsonError(json_bad_cast);
+        const NodeString &s = static_cast<const String *>(p)->str;
+        col.blob.append(s.data(), s.size());
+        col.offsets.push_back(col.blob.size());
+        push_valid(col, row, true);
+        return;
+    }
+    default:
+        throw JsonError(json_bad_cast);
+    }
+}
+
+
+void Columnizer::add_row(Chunk &c, const Value &row)
+{
+    if(hops.size() != specs.size())
+    {
+        hops.resize(specs.size());
+        for(std::size_t i = 0; i != specs.size(); ++i)
+            hops[i].resize(paths[i].size());
+    }
+
+    const Value_base *root = row.pbase;
+    if(root == nullptr)
+        throw JsonError(deref_nullptr);
+    if(root->Type() != object_type && root->Type() != null_type)
+        throw JsonError(json_bad_cast);
+
+    for(std::size_t i = 0; i != specs.size(); ++i)
+    {
+        const Value_base *p = root;
+        const std::vector<std::string> &keys = paths[i];
+        for(std::size_t k = 0; p && k != keys.size(); ++k)
+        {
+            if(p->Type() != object_type)
+            {
+                p = nullptr;
+                break;
+            }
+            const Object *obj = static_cast<const Object *>(p);
+            const Value *v = nullptr;
+            if(obj->packed)
+            {
+                Hop &hop = hops[i][k];
+                if(hop.shape != obj->packed->shape)
+                {
+                    hop.shape = obj->packed->shape;
+                    hop.index = hop.shape->index(keys[k]);
+                }
+                if(hop.index != Shape::npos)
+                    v = obj->packed->slots() + hop.index;
+            }
+            else
+            {
+                auto it = obj->obj.find(std::string_view(keys[k]));
+                if(it != obj->obj.end())
+                    v = &it->second;
+            }
+            p = v ? v->pbase : nullptr;
+        }
+
+        if(p)
+            push_leaf(c.cols[i], c.rows, p);
+        else
+            push_null(c.cols[i], c.rows);
+    }
+    ++c.rows;
+}
+
+
+
+/**************************************
+ 文本版本的解析算法说明：
+ 文法与错误类型同Reader（见parse_container），区别在于：
+ 1、每一行必须是Object或null，否则抛出json_bad_cast；
+ 2、键先用skip_string跳过，没有转义时直接用原文在前缀树中查找；
+ 3、不在前缀树中的成员、以及中间结点上不是Object的值用skip_value跳过；
+ 4、叶子结点按列的类型直接转换：数字从词素转换，字符串直接追加到blob中；
+    同一行中重复的键只保留第一次出现的值；
+ 5、一行结束时，没有出现的列补null。
+
+**************************************/
+bool Columnizer::add_rows(Chunk &c, Scanner &s, const char *stop) const
+{
+    for(;;)
+    {
+        if(!text_row(c, s))
+            return false;
+
+        s.skip_ws();
+        if(stop)
+        {
+            if(s.position() == stop)
+                return true;
+            if(s.position() > stop)
+                return s.fail(error_mismatch);
+        }
+        if(s.consume(','))
+            continue;
+        if(stop == nullptr && s.consume(']'))
+            return true;
+        if(s.eof())
+            return s.fail(error_brack);
+        return s.fail(s.peek() == '}' ? error_mismatch : error_comma);
+    }
+}
+
+
+bool Columnizer::text_row(Chunk &c, Scanner &s) const
+{
+    s.skip_ws();
+    if(s.eof())
+        return s.fail(error_brack);
+    if(s.peek() == ',' || s.peek() == ']')
+        return s.fail(error_comma);
+
+    std::fill(c.set.begin(), c.set.end(), 0);
+    if(s.peek() == '{')
+    {
+        if(!text_object(c, s, 0))
+            return false;
+    }
+    else if(s.peek() == 'n')
+    {
+        if(!s.read_literal("null", 4))
+            return false;
+    }
+    else
+        throw JsonError(json_bad_cast);
+
+    for(std::size_t i = 0; i != c.cols.size(); ++i)
+        if(!c.set[i])
+            push_null(c.cols[i], c.rows);
+    ++c.rows;
+    return true;
+}
+
+
+bool Columnizer::text_object(Chunk &c, Scanner &s, std::size_t n) const
+{
+    s.seek(s.position() + 1);
+    if(s.consume('}'))
+        return true;
+
+    for(;;)
+    {
+        if(!text_member(c, s, n))
+            return false;
+
+        if(s.consume(','))
+            continue;
+        if(s.consume('}'))
+            return true;
+
+        if(s.eof())
+            return s.fail(error_brace);
+        return s.fail(s.peek() == ']' ? error_mismatch : error_comma);
+    }
+}
+
+
+bool Columnizer::text_member(Chunk &c, Scanner &s, std::size_t n) const
+{
+    s.skip_ws();
+    if(s.peek() != '\"')
+    {
+        if(s.eof())
+            return s.fail(error_brace);
+        return s.fail(s.peek() == '}' ? error_comma : error_pair);
+    }
+
+    const char *quote = s.position();
+    if(!s.skip_string())
+        return false;
+    std::string_view key(quote + 1, s.position() - quote - 2);
+    std::string unescaped;
+    if(key.find('\\') != std::string_view::npos)
+    {
+        s.seek(quote);
+        if(!s.read_string(unescaped))
+            return false;
+        key = unescaped;
+    }
+
+    if(!s.consume(':'))
+        return s.fail(s.eof() ? error_brace : error_pair);
+
+    s.skip_ws();
+    if(s.eof())
+        return s.fail(error_brace);
+    if(s.peek() == '}' || s.peek() == ',')
+        return s.fail(error_pair);
+
+    std::size_t child = trie[n].find(key);
+    if(child == 0)
+        return s.skip_value();
+    const auto &columns = trie[child].columns;
+    if(!columns.empty())
+    {
+        if(c.set[columns[0]])
+            return s.skip_value();
+        // 同一路径的多列（例如分别作为int64与float64）各自从同一个标量值转换
+        const char *value = s.position();
+        for(std::size_t i : columns)
+        {
+            c.set[i] = 1;
+            s.seek(value);
+            if(!text_leaf(c, s, i))
+                return false;
+        }
+        return true;
+    }
+    if(s.peek() == '{')
+        return text_object(c, s, child);
+    return s.skip_value();
+}
+
+
+bool Columnizer::text_leaf(Chunk &c, Scanner &s, std::size_t i) const
+{
+    Column &col = c.cols[i];
+    switch(s.peek())
+    {
+    case 'n':
+        if(!s.read_literal("null", 4))
+            return false;
+        push_null(col, c.rows);
+        return true;
+
+    case 't':
+    case 'f':
+    {
+        bool b = s.peek() == 't';
+        if(col.type != ColumnType::boolean)
+            throw JsonError(json_bad_cast);
+        if(!(b ? s.read_literal("true", 4) : s.read_literal("false", 5)))
+            return false;
+        col.b8.push_back(b);
+        push_valid(col, c.rows, true);
+        return true;
+    }
+
+    case '\"':
+        if(col.type != ColumnType::string)
+            throw JsonError(json_bad_cast);
+        if(!s.read_string(col.blob))
+            return false;
+        col.offsets.push_back(col.blob.size());
+        push_valid(col, c.rows, true);
+        return true;
+
+    case '{': case '[':
+        throw JsonError(json_bad_cast);
+
+    case ']':
+        return s.fail(error_brack);
+    case ':':
+        return s.fail(error_pair);
+
+    default:
+    {
+        SubString lexeme(nullptr, nullptr);
+        bool integral = true;
+        if(!s.read_number(lexeme, integral))
+            return false;
+        if(col.type == ColumnType::float64)
+        {
+            double d = 0;
+            number_to_double(lexeme, integral, d);
+            col.f64.push_back(d);
+        }
+        else if(col.type == ColumnType::int64)
+            col.i64.push_back(number_to_int(lexeme, integral));
+        else
+            throw JsonError(json_bad_cast);
+        push_valid(col, c.rows, true);
+        return true;
+    }
+    }
+}
+
+
+
+/// 把src的前bits位追加到dst的第dst_rows位之后
+static void append_bits(std::vector<std::uint64_t> &dst, std::size_t dst_rows,
+                        const std::vector<std::uint64_t> &src, std::size_t src_rows)
+{
+    std::size_t shift = dst_rows % 64;
+    if(shift == 0)
+    {
+        dst.insert(dst.end(), src.begin(), src.begin() + (src_rows + 63) / 64);
+        return;
+    }
+    for(std::size_t i = 0, left = src_rows; left; ++i)
+    {
+        std::size_t bits = std::min<std::size_t>(64, left);
+        std::uint64_t w = src[i];
+        dst.back() |= w << shift;
+        if(bits > 64 - shift)
+            dst.push_back(w >> (64 - shift));
+        left -= bits;
+    }
+}
+
+
+ColumnTable Columnizer::merge(std::vector<Chunk> &chunks) const
+{
+    ColumnTable t;
+    for(const auto &c : chunks)
+        t.rows += c.rows;
+
+    if(chunks.size() == 1)
+    {
+        t.columns = std::move(chunks[0].cols);
+        return t;
+    }
+
+    t.columns.resize(specs.size());
+    for(std::size_t i = 0; i != specs.size(); ++i)
+    {
+        Column &col = t.columns[i];
+        col.name = specs[i].path;
+        col.type = specs[i].type;
+        col.validity.reserve((t.rows + 63) / 64);
+        if(col.type == ColumnType::string)
+            col.offsets.push_back(0);
+
+        std::size_t rows = 0;
+        for(auto &c : chunks)
+        {
+            Column &part = c.cols[i];
+            col.f64.insert(col.f64.end(), part.f64.begin(), part.f64.end());
+            col.i64.insert(col.i64.end(), part.i64.begin(), part.i64.end());
+            col.b8.insert(col.b8.end(), part.b8.begin(), part.b8.end());
+            if(col.type == ColumnType::string)
+            {
+                std::uint64_t base = col.blob.size();
+                for(std::size_t r = 1; r < part.offsets.size(); ++r)
+                    col.offsets.push_back(base + part.offsets[r]);
+                col.blob += part.blob;
+            }
+            append_bits(col.validity, rows, part.validity, c.rows);
+            col.null_count += part.null_count;
+            rows += c.rows;
+            part = Column();
+        }
+    }
+    return t;
+}
+
+
+
+ColumnTable to_columns(const Array &rows, const std::vector<ColumnSpec> &schema,
+                       const ParallelOptions &opt)
+{
+    const std::size_t n = rows.size();
+    unsigned threads = opt.thread_count();
+    std::size_t parts = 1;
+    if(threads > 1 && n * std::max<std::size_t>(1, schema.size()) * 8 >= opt.min_bytes)
+        parts = std::min<std::size_t>(n, static_cast<std::size_t>(threads) * std::max(1u, opt.tasks_per_thread));
+    parts = std::max<std::size_t>(parts, 1);
+
+    Columnizer proto(schema);
+    std::vector<Columnizer::Chunk> chunks(parts);
+    ThreadPool::shared().run(parts, [&](std::size_t k) {
+        Columnizer::Chunk &c = chunks[k];
+        std::size_t from = n * k / parts, to = n * (k + 1) / parts;
+        try
+        {
+            Columnizer conv(proto);
+            conv.start(c, to - from);
+            for(std::size_t r = from; r != to; ++r)
+                conv.add_row(c, rows[r]);
+        }
+        catch(...)
+        {
+            c.error = std::current_exception();
+        }
+    });
+
+    for(const auto &c : chunks)
+        if(c.error)
+            std::rethrow_exception(c.error);
+    return proto.merge(chunks);
+}
+
+
+/**************************************
+ to_columns（文本版本）算法说明：
+ 1、跳过空白后要求「[」，空输入报告error_empty，其余类型抛出json_bad_cast；
+ 2、输入不小于min_bytes且有多个线程时，用split_top_level在顶层逗号处切分，
+    各块由线程池并行转换；预扫描失败时退回顺序转换，
+    因此错误的类型与位置与顺序转换相同；
+ 3、按块的顺序报告第一个错误（格式错误按整个输入计算行列号），否则拼接各块。
+
+**************************************/
+ColumnTable to_columns(std::string_view text, const std::vector<ColumnSpec> &schema,
+                       const ParallelOptions &opt)
+{
+    const char *b = text.data(), *e = b + text.size();
+    const char *open = b;
+    while(open != e && IsSpace(*open)) ++open;
+    if(open == e)
+        throw JsonError(Reader::make_result(b, open, error_empty));
+    if(*open != '[')
+        throw JsonError(json_bad_cast);
+
+    std::vector<const char *> cuts;
+    const char *close = nullptr;
+    bool split = false;
+    unsigned threads = opt.thread_count();
+    if(threads > 1 && text.size() >= opt.min_bytes)
+    {
+        std::size_t parts = static_cast<std::size_t>(threads) * std::max(1u, opt.tasks_per_thread);
+        split = split_top_level(open, e, std::max<std::size_t>(1, (e - open) / parts), cuts, close)
+                && !cuts.empty() && *close == ']';
+        for(const char *p = split ? close + 1 : e; p != e; ++p)
+            if(!IsSpace(*p))
+                split = false;
+    }
+    if(!split)
+        cuts.clear();
+
+    Columnizer proto(schema);
+    const std::size_t n = cuts.size() + 1;
+    std::vector<Columnizer::Chunk> chunks(n);
+    ThreadPool::shared().run(n, [&](std::size_t k) {
+        Columnizer::Chunk &c = chunks[k];
+        Scanner s(b, e);
+        bool ok = true;
+        try
+        {
+            proto.start(c, 0);
+            if(!split)
+            {
+                s.seek(open + 1);
+                ok = s.consume(']') || proto.add_rows(c, s, nullptr);
+                s.skip_ws();
+                if(ok && !s.eof())
+                    ok = s.fail(s.peek() == ']' ? error_brack : s.peek() == '}' ? error_brace : error_comma);
+            }
+            else
+            {
+                s.seek(k == 0 ? open + 1 : cuts[k - 1] + 1);
+                ok = proto.add_rows(c, s, k + 1 == n ? close : cuts[k]);
+            }
+        }
+        catch(...)
+        {
+            c.error = std::current_exception();
+        }
+        if(!ok)
+        {
+            c.errpos = s.error_position() ? s.error_position() : s.position();
+            c.err = s.error();
+        }
+    });
+
+    for(const auto &c : chunks)
+    {
+        if(c.error)
+            std::rethrow_exception(c.error);
+        if(c.errpos)
+            throw JsonError(Reader::make_result(b, c.errpos, c.err));
+    }
+    return proto.merge(chunks);
+}
+
+
+_JSON_END
@@ -0,0 +1,92 @@
+#ifndef JSON_COLUMNS_H
+#define JSON_COLUMNS_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Json_type.h"
+#include "Json_parallel.h"
+
+_JSON_BEGIN
+
+/// 列的类型，决定Column中使用哪个向量
+enum class ColumnType { float64, int64, boolean, string };
+
+
+/// 一列的定义：path是以「.」分隔的键（同Projection，例如"user.followers_count"）
+struct ColumnSpec
+{
+    std::string path;
+    ColumnType type;
+};
+
+
+/**************************************
+ Column：一列的值（struct-of-arrays），第i行：
+ 1、float64/int64/boolean分别保存在f64/i64/b8的第i个元素中；
+ 2、string保存在blob的[offsets[i], offsets[i + 1])中，offsets比行数多一个元素；
+ 3、validity的第i位（validity[i / 64]的第i % 64位）为1表示该行有值；
+    值为null或者路径不存在时该位为0，对应的数值为0、字符串为空，
+    因此不检查validity直接对f64/i64求和也是正确的。
+
+**************************************/
+struct Column
+{
+    std::string name;
+    ColumnType type;
+
+    std::vector<double> f64;
+    std::vector<std::int64_t> i64;
+    std::vector<std::uint8_t> b8;
+    std::vector<std::uint64_t> offsets;
+    std::string blob;
+
+    std::vector<std::uint64_t> validity;
+    std::size_t null_count = 0;
+
+    bool valid(std::size_t row) const { return validity[row / 64] >> (row % 64) & 1; }
+    std::string_view str(std::size_t row) const
+        { return std::string_view(blob.data() + offsets[row], offsets[row + 1] - offsets[row]); }
+};
+
+
+/// to_columns的结果：rows行，columns与schema一一对应
+struct ColumnTable
+{
+    std::size_t rows = 0;
+    std::vector<Column> columns;
+
+    /// 按列名（即ColumnSpec::path）查找，不存在时返回nullptr
+    const Column *find(std::string_view name) const;
+};
+
+
+/**************************************
+ to_columns：把元素为Object的Array转换为列。
+ 1、每个元素按schema中的路径取值：null或路径不存在时为null，
+    值的类型与列的类型不符时抛出JsonError(json_bad_cast)
+    （int64列的非整数按Number::to_longlong转换）；
+ 2、为null的元素是全为null的一行，其余非Object的元素抛出json_bad_cast；
+ 3、行被分成若干块，由线程池并行转换，块内直接写入本块的列，最后按顺序拼接；
+ 4、解析得到的Number直接从词素转换，不修改树（不缓存转换结果），
+    压缩的Object在Shape与上一行相同时直接按下标取值，不再查找键。
+ opt.min_bytes在这里按行数×列数×8估计。
+
+**************************************/
+ColumnTable to_columns(const Array &rows, const std::vector<ColumnSpec> &schema,
+                       const ParallelOptions &opt = ParallelOptions());
+
+/// 直接从json文本（顶层为Object的数组）转换，不构造Value：
+/// 未被选中的成员只做结构检查地跳过，格式错误时抛出带有出错位置的JsonError
+ColumnTable to_columns(std::string_view text, const std::vector<ColumnSpec> &schema,
+                       const ParallelOptions &opt = ParallelOptions());
+
+
+_JSON_END
+#endif // JSON_COLUMNS_H
@@ -0,0 +1,469 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+#ifdef JSON_HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef JSON_HAS_ZSTD
+#include <zstd.h>
+#endif
+#include "Json_compress.h"
+
+_JSON_BEGIN
+
+namespace
+{
+
+/**************************************
+ Ring：单生产者/单消费者的环形缓冲区，由固定数量、固定大小的块组成。
+ tail只由生产者（解压线程）修改，head只由消费者修改，发布与归还一块各是一次release写，
+ 因此两端都不加锁；一端等待另一端时先让出CPU，等待较久时再短暂睡眠。
+ 生产者结束时调用close，出错时同时带上异常，消费者读完已发布的块之后重新抛出；
+ 消费者提前放弃时调用cancel，正在等待空闲块的生产者随即退出。
+
+**************************************/
+class Ring
+{
+public:
+    Ring(std::size_t count, std::size_t block_size):
+        blocks(std::max<std::size_t>(count, 2)), block_size(std::max<std::size_t>(block_size, 1)),
+        head(0), tail(0), closed(false), cancelled(false), offset(0)
+    {
+        for(auto &b : blocks)
+        {
+            b.data.reset(new char[this->block_size]);
+            b.len = 0;
+        }
+    }
+
+    std::size_t capacity() const { return block_size; }
+
+    /// 生产者：等待一个空闲块，返回它的缓冲区；消费者已放弃时返回nullptr
+    char *acquire()
+    {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        for(unsigned spins = 0; t - head.load(std::memory_order_acquire) == blocks.size(); )
+        {
+            if(cancelled.load(std::memory_order_relaxed))
+                return nullptr;
+            backoff(spins);
+        }
+        return cancelled.load(std::memory_order_relaxed) ? nullptr : blocks[t % blocks.size()].data.get();
+    }
+
+    /// 生产者：发布acquire得到的块，其中有len个字节
+    void publish(std::size_t len)
+    {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        blocks[t % blocks.size()].len = len;
+        tail.store(t + 1, std::memory_order_release);
+    }
+
+    void close(std::exception_ptr e)
+    {
+        error = e;
+        closed.store(true, std::memory_order_release);
+    }
+
+    /// 消费者：读取最多cap个字节，没有更多数据时返回0
+    std::size_t read(char *buf, std::size_t cap)
+    {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        for(unsigned spins = 0; h == tail.load(std::memory_order_acquire); )
+        {
+            if(closed.load(std::memory_order_acquire))
+            {
+                if(h != tail.load(std::memory_order_acquire))
+                    break;
+                if(error)
+                    std::rethrow_exception(error);
+                return 0;
+            }
+            backoff(spins);
+        }
+
+        const Block &b = blocks[h % blocks.size()];
+        std::size_t n = std::min(cap, b.len - offset);
+        std::memcpy(buf, b.data.get() + offset, n);
+        offset += n;
+        if(offset == b.len)
+        {
+            offset = 0;
+            head.store(h + 1, std::memory_order_release);
+        }
+        return n;
+    }
+
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+private:
+    static void backoff(unsigned &spins)
+    {
+        if(++spins < 1024)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t len;
+    };
+
+    std::vector<Block> blocks;
+    std::size_t block_size;
+    alignas(64) std::atomic<std::size_t> head;      /// 消费者下一个读取的块
+    alignas(64) std::atomic<std::size_t> tail;      /// 生产者下一个写入的块
+    std::atomic<bool> closed, cancelled;
+    std::exception_ptr error;                       /// closed之前写入
+    std::size_t offset;                             /// 消费者：当前块中已读取的字节数
+};
+
+
+
+/**************************************
+ Producer：解压线程的输出端，把解压结果依次填满环中的块。
+ next返回当前块中剩余的空间，commit记录写入的字节数，块写满时发布并取下一块；
+ 消费者放弃时next返回nullptr，解压循环随即结束。
+
+**************************************/
+class Producer
+{
+public:
+    explicit Producer(Ring &r): ring(r), block(nullptr), filled(0) {}
+
+    char *next(std::size_t &room)
+    {
+        if(block == nullptr && (block = ring.acquire()) == nullptr)
+            return nullptr;
+        room = ring.capacity() - filled;
+        return block + filled;
+    }
+
+    void commit(std::size_t n)
+    {
+        filled += n;
+        if(filled == ring.capacity())
+            flush();
+    }
+
+    void flush()
+    {
+        if(block && filled)
+        {
+            ring.publish(filled);
+            block = nullptr;
+            filled = 0;
+        }
+    }
+
+private:
+    Ring &ring;
+    char *block;
+    std::size_t filled;
+};
+
+
+/// 压缩输入：先交出格式检测时读到的数据，之后直接调用src
+struct Input
+{
+    ArrayStream::Source src;
+    std::vector<char> buf;
+    std::size_t pending;    /// buf开头尚未交出的检测数据
+
+    std::size_t read(char *p, std::size_t cap)
+    {
+        if(pending)
+        {
+            std::size_t n = std::min(cap, pending);
+            std::memcpy(p, buf.data() + buf.size() - pending, n);
+            pending -= n;
+            return n;
+        }
+        return src(p, cap);
+    }
+};
+
+
+Compression detect(const std::vector<char> &head)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(head.data());
+    if(head.size() >= 2 && p[0] == 0x1f && p[1] == 0x8b)
+        return Compression::gzip;
+    if(head.size() >= 4 && p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f && p[3] == 0xfd)
+        return Compression::zstd;
+    return Compression::none;
+}
+
+
+void copy_stream(Input &in, Producer &out)
+{
+    for(;;)
+    {
+        std::size_t room;
+        char *p = out.next(room);
+        if(p == nullptr)
+            return;
+        std::size_t n = in.read(p, room);
+        if(n == 0)
+            return;
+        out.commit(n);
+    }
+}
+
+
+#ifdef JSON_HAS_ZLIB
+/**************************************
+ gunzip算法说明：
+ 1、inflateInit2(15 + 32)自动识别gzip与zlib头；
+ 2、一个成员结束（Z_STREAM_END）后，如果还有输入就inflateReset，继续解压下一个成员；
+ 3、输入在成员中间结束时按数据损坏处理。
+
+**************************************/
+void gunzip(Input &in, Producer &out, std::size_t input_size)
+{
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    if(inflateInit2(&zs, 15 + 32) != Z_OK)
+        throw std::runtime_error("Decompress: inflateInit2 failed");
+    std::unique_ptr<z_stream, int (*)(z_stream *)> guard(&zs, inflateEnd);
+
+    std::vector<char> buf(std::max<std::size_t>(input_size, 1));
+    bool ended = false;
+    for(;;)
+    {
+        if(zs.avail_in == 0)
+        {
+            std::size_t n = in.read(buf.data(), buf.size());
+            if(n == 0)
+            {
+                if(!ended)
+                    throw std::runtime_error("Decompress: truncated gzip input");
+                return;
+            }
+            zs.next_in = reinterpret_cast<Bytef *>(buf.data());
+            zs.avail_in = static_cast<uInt>(n);
+        }
+        if(ended)
+        {
+            inflateReset(&zs);
+            ended = false;
+        }
+
+        std::size_t room;
+        char *p = out.next(room);
+        if(p == nullptr)
+            return;
+        zs.next_out = reinterpret_cast<Bytef *>(p);
+        zs.avail_out = static_cast<uInt>(room);
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        out.commit(room - zs.avail_out);
+
+        if(ret == Z_STREAM_END)
+            ended = true;
+        else if(ret != Z_OK && ret != Z_BUF_ERROR)
+            throw std::runtime_error(std::string("Decompress: ") + (zs.msg ? zs.msg : "corrupt gzip input"));
+    }
+}
+#endif
+
+
+#ifdef JSON_HAS_ZSTD
+/// ZSTD_decompressStream自动处理连续的多个帧；输入结束时上一帧必须已经完整
+void unzstd(Input &in, Producer &out, std::size_t input_size)
+{
+    std::unique_ptr<ZSTD_DCtx, std::size_t (*)(ZSTD_DCtx *)> ctx(ZSTD_createDCtx(), ZSTD_freeDCtx);
+    if(!ctx)
+        throw std::runtime_error("Decompress: ZSTD_createDCtx failed");
+
+    std::vector<char> buf(std::max<std::size_t>(input_size, 1));
+    ZSTD_inBuffer zin = { buf.data(), 0, 0 };
+    std::size_t last = 0;
+    for(;;)
+    {
+        if(zin.pos == zin.size)
+        {
+            std::size_t n = in.read(buf.data(), buf.size());
+            if(n == 0)
+            {
+                if(last != 0)
+                    throw std::runtime_error("Decompress: truncated zstd input");
+                return;
+            }
+            zin.size = n;
+            zin.pos = 0;
+        }
+
+        std::size_t room;
+        char *p = out.next(room);
+        if(p == nullptr)
+            return;
+        ZSTD_outBuffer zout = { p, room, 0 };
+        last = ZSTD_decompressStream(ctx.get(), &zout, &zin);
+        out.commit(zout.pos);
+        if(ZSTD_isError(last))
+            throw std::runtime_error(std::string("Decompress: ") + ZSTD_getErrorName(last));
+    }
+}
+#endif
+
+
+/// 后台线程与环：被返回的Source共享，最后一个副本销毁时取消并等待线程结束
+struct Pipeline
+{
+    Ring ring;
+    std::thread worker;
+
+    Pipeline(ArrayStream::Source src, const DecompressOptions &opt):
+        ring(opt.ring_blocks, opt.block_size)
+    {
+        worker = std::thread([this, src, opt]() mutable { run(std::move(src), opt); });
+    }
+
+    ~Pipeline()
+    {
+        ring.cancel();
+        worker.join();
+    }
+
+    void run(ArrayStream::Source src, const DecompressOptions &opt)
+    {
+        std::exception_ptr error;
+        try
+        {
+            Input in{std::move(src), std::vector<char>(), 0};
+            Compression format = opt.format;
+            if(format == Compression::automatic)
+            {
+                in.buf.resize(4);
+                std::size_t got = 0;
+                while(got < in.buf.size())
+                {
+                    std::size_t n = in.src(in.buf.data() + got, in.buf.size() - got);
+                    if(n == 0)
+                        break;
+                    got += n;
+                }
+                in.buf.resize(got);
+                in.pending = got;
+                format = detect(in.buf);
+            }
+            if(!CompressionSupported(format))
+                throw std::runtime_error(format == Compression::gzip
+                                         ? "Decompress: gzip support (zlib) is not compiled in"
+                                         : "Decompress: zstd support (libzstd) is not compiled in");
+
+            Producer out(ring);
+            switch(format)
+            {
+#ifdef JSON_HAS_ZLIB
+            case Compression::gzip: gunzip(in, out, opt.input_size); break;
+#endif
+#ifdef JSON_HAS_ZSTD
+            case Compression::zstd: unzstd(in, out, opt.input_size); break;
+#endif
+            default: copy_stream(in, out); break;
+            }
+            out.flush();
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+        ring.close(error);
+    }
+};
+
+
+ArrayStream::Source file_source(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::system_error(errno, std::generic_category(), "DecompressFile: open " + path);
+
+    std::shared_ptr<int> owner(new int(fd), [](int *f) {
+#ifndef _WIN32
+        ::close(*f);
+#else
+        ::_close(*f);
+#endif
+        delete f;
+    });
+    return [owner](char *buf, std::size_t cap) -> std::size_t {
+        for(;;)
+        {
+#ifndef _WIN32
+            ssize_t n = ::read(*owner, buf, cap);
+#else
+            int n = ::_read(*owner, buf, static_cast<unsigned>(cap));
+#endif
+            if(n >= 0)
+                return static_cast<std::size_t>(n);
+            if(errno != EINTR)
+                throw std::system_error(errno, std::generic_category(), "DecompressFile: read");
+        }
+    };
+}
+
+} // namespace
+
+
+
+bool CompressionSupported(Compression format)
+{
+    switch(format)
+    {
+#ifdef JSON_HAS_ZLIB
+    case Compression::gzip: return true;
+#endif
+#ifdef JSON_HAS_ZSTD
+    case Compression::zstd: return true;
+#endif
+    case Compression::automatic:
+    case Compression::none: return true;
+    default: return false;
+    }
+}
+
+
+ArrayStream::Source Decompress(ArrayStream::Source compressed, const DecompressOptions &opt)
+{
+    std::shared_ptr<Pipeline> pipe = std::make_shared<Pipeline>(std::move(compressed), opt);
+    return [pipe](char *buf, std::size_t cap) { return pipe->ring.read(buf, cap); };
+}
+
+
+ArrayStream::Source DecompressFile(const std::string &path, const DecompressOptions &opt)
+{
+    return Decompress(file_source(path), opt);
+}
+
+
+/// 解压已经在后台线程中进行，因此ParseStream不再另开预读线程
+Value ParseCompressed(const std::string &path, const DecompressOptions &opt)
+{
+    StreamOptions so;
+    so.read_ahead = false;
+    so.chunk_size = std::max<std::size_t>(opt.block_size, 1);
+    return ParseStream(DecompressFile(path, opt), so);
+}
+
+
+_JSON_END
@@ -0,0 +1,58 @@
+#ifndef JSON_COMPRESS_H
+#define JSON_COMPRESS_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <string>
+#include "Json_type.h"
+#include "Json_stream.h"
+
+_JSON_BEGIN
+
+/// 压缩格式；automatic根据开头的魔数判断（gzip：1f 8b，zstd：28 b5 2f fd，否则不压缩）
+enum class Compression { automatic, none, gzip, zstd };
+
+
+/// Decompress的选项
+struct DecompressOptions
+{
+    Compression format = Compression::automatic;
+    std::size_t block_size = 1 << 18;   /// 环形缓冲区中每块解压结果的字节数
+    std::size_t ring_blocks = 4;        /// 环形缓冲区的块数，解压线程最多领先这么多块
+    std::size_t input_size = 1 << 16;   /// 每次从压缩输入读取的字节数
+};
+
+
+/// 编译时是否启用了该格式（gzip需要zlib，zstd需要libzstd；none与automatic总是可用）
+bool CompressionSupported(Compression format);
+
+
+/**************************************
+ Decompress：把压缩的Source包装成解压之后的Source。
+ 1、解压在一个后台线程中进行，结果写入由ring_blocks个块组成的单生产者/单消费者环形缓冲区，
+    两端只通过原子的头尾下标同步，不加锁；环满时解压线程等待，实现反压；
+ 2、返回的Source在调用线程中从环中复制数据，可以交给ArrayStream或ParseStream，
+    于是解压与解析在两个线程中同时进行，总时间接近两者中较慢的一个；
+ 3、gzip支持多个连续的成员（例如cat a.gz b.gz）；
+ 4、数据损坏或格式不受支持时抛出std::runtime_error，compressed抛出的异常原样传给调用者。
+ 返回的Source（以及它的副本）全部销毁时停止后台线程。
+
+**************************************/
+ArrayStream::Source Decompress(ArrayStream::Source compressed,
+                               const DecompressOptions &opt = DecompressOptions());
+
+/// 读取并解压文件path；读取文件出错时抛出std::system_error
+ArrayStream::Source DecompressFile(const std::string &path,
+                                   const DecompressOptions &opt = DecompressOptions());
+
+
+/// 解析压缩的json文件：ParseStream(DecompressFile(path))，读取、解压与解析流水线进行
+Value ParseCompressed(const std::string &path,
+                      const DecompressOptions &opt = DecompressOptions());
+
+
+_JSON_END
+#endif // JSON_COMPRESS_H
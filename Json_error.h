@@ -1,47 +1,74 @@
-#ifndef JSON_ERROR_H
-#define JSON_ERROR_H
-
-#define _JSON_BEGIN namespace json {
-#define _JSON_END   }
-#define _JSON   ::json::
-
-#include <string>
-
-_JSON_BEGIN
-
-enum ErrorType
-{
-    /// errorͷ쳣Parseп׳
-    error_empty,    /// ַΪ
-    error_escape,   /// Чתַ
-    error_quote,    /// ƥ˫
-    error_brack,    /// ƥķ
-    error_brace,    /// ƥĻ
-    error_mismatch, /// ƥ˫//С/
-    error_comma,    /// ϷĶţλã
-    error_pair,     /// Ϸļֵ
-    error_badnum,   /// Ϸַ
-    error_literal,  /// ֵtrue/false/null
-
-    /// 쳣ʹValueп׳
-    deref_nullptr,  /// ͼʹһValue
-    json_bad_cast   /// ͼValueͳһƥJson
-};
-
-
-class JsonError
-{
-public:
-    JsonError(ErrorType t): type(t) {}
-
-    std::string What() const;
-
-    int Code() const { return type; }
-
-private:
-    ErrorType type;
-};
-
-
-_JSON_END
-#endif // JSON_ERROR_H
+#ifndef JSON_ERROR_H
+#define JSON_ERROR_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <string>
+
+_JSON_BEGIN
+
+enum ErrorType
+{
+    /// 下面error开头的异常是在Parse过程中可能抛出的
+    error_empty,    /// 待解析字符串为空
+    error_escape,   /// 无效的转义字符
+    error_quote,    /// 不匹配的双引号
+    error_brack,    /// 不匹配的方括号
+    error_brace,    /// 不匹配的花括号
+    error_mismatch, /// 不匹配的双引号/方括号/小括号/花括号
+    error_comma,    /// 不合法的逗号（位置）
+    error_pair,     /// 不合法的键值对
+    error_badnum,   /// 不合法的数字字符串
+    error_literal,  /// 错误的字面值（true/false/null）
+
+    /// 下面两个异常则是在使用Value过程中可能抛出的
+    deref_nullptr,  /// 试图使用一个空Value对象的数据
+    json_bad_cast,  /// 试图将Value解释成一个不匹配的Json类
+
+    /// 编译JsonPath时抛出，出错位置是表达式中的偏移
+    path_syntax     /// 不合法的JSONPath表达式
+};
+
+
+/// Value::TryParse的结果，ok为false时其余字段描述第一个错误
+struct ParseResult
+{
+    bool ok = true;
+    ErrorType type = error_empty;
+    std::size_t offset = 0;     /// 出错处在输入中的字节偏移，从0开始
+    std::size_t line = 0;       /// 从1开始
+    std::size_t column = 0;     /// 从1开始，按字节计
+
+    explicit operator bool() const { return ok; }
+};
+
+
+class JsonError
+{
+public:
+    static const std::size_t npos = static_cast<std::size_t>(-1);
+
+    JsonError(ErrorType t): type(t), offset(npos), line(0), column(0) {}
+    JsonError(const ParseResult &r):
+        type(r.type), offset(r.offset), line(r.line), column(r.column) {}
+
+    std::string What() const;
+
+    int Code() const { return type; }
+
+    /// 出错位置，只有解析错误才有，否则Offset()返回npos
+    std::size_t Offset() const { return offset; }
+    std::size_t Line() const { return line; }
+    std::size_t Column() const { return column; }
+
+private:
+    ErrorType type;
+    std::size_t offset, line, column;
+};
+
+
+_JSON_END
+#endif // JSON_ERROR_H
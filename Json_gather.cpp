@@ -0,0 +1,122 @@
+#include <cerrno>
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#include "Json_gather.h"
+
+_JSON_BEGIN
+
+
+void GatherBuffer::clear()
+{
+    segs.clear();
+    side.clear();
+    vec.clear();
+    total = 0;
+}
+
+
+void GatherBuffer::extend(std::size_t n)
+{
+    if(n == 0)
+        return;
+    total += n;
+    if(!segs.empty() && segs.back().ext == nullptr)
+        segs.back().len += n;
+    else
+        segs.push_back({nullptr, side.size() - n, n});
+}
+
+
+void GatherBuffer::reference(const char *s, std::size_t n)
+{
+    if(n == 0)
+        return;
+    total += n;
+    segs.push_back({s, 0, n});
+}
+
+
+void GatherBuffer::finish()
+{
+    vec.resize(segs.size());
+    for(std::size_t i = 0; i != segs.size(); ++i)
+    {
+        const char *base = segs[i].ext ? segs[i].ext : side.data() + segs[i].off;
+        vec[i].iov_base = const_cast<char *>(base);
+        vec[i].iov_len = segs[i].len;
+    }
+}
+
+
+std::string GatherBuffer::str() const
+{
+    std::string ret;
+    ret.reserve(total);
+    for(const auto &v : vec)
+        ret.append(static_cast<const char *>(v.iov_base), v.iov_len);
+    return ret;
+}
+
+
+#ifndef _WIN32
+/**************************************
+ GatherBuffer::write_to算法说明：
+ 1、每次最多提交IOV_MAX段；
+ 2、writev只写入了一部分时，跳过已完整写出的段，
+    对写了一半的段用一个临时的iovec指向剩余部分，然后继续；
+ 3、被信号中断（EINTR）时重试，其余错误返回false。
+
+**************************************/
+bool GatherBuffer::write_to(int fd) const
+{
+#ifdef IOV_MAX
+    const std::size_t batch = IOV_MAX;
+#else
+    const std::size_t batch = 1024;
+#endif
+    std::size_t i = 0;
+    iovec head{nullptr, 0};     /// vec[i]中尚未写出的部分
+    if(!vec.empty())
+        head = vec[0];
+
+    while(i != vec.size())
+    {
+        std::vector<iovec> part;
+        part.reserve(std::min(batch, vec.size() - i));
+        part.push_back(head);
+        for(std::size_t j = i + 1; j != vec.size() && part.size() != batch; ++j)
+            part.push_back(vec[j]);
+
+        ssize_t n = ::writev(fd, part.data(), static_cast<int>(part.size()));
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            return false;
+        }
+
+        std::size_t left = static_cast<std::size_t>(n);
+        while(i != vec.size() && left >= head.iov_len)
+        {
+            left -= head.iov_len;
+            if(++i != vec.size())
+                head = vec[i];
+        }
+        if(i != vec.size())
+        {
+            head.iov_base = static_cast<char *>(head.iov_base) + left;
+            head.iov_len -= left;
+        }
+    }
+    return true;
+}
+#endif
+
+
+_JSON_END
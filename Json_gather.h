@@ -0,0 +1,82 @@
+#ifndef JSON_GATHER_H
+#define JSON_GATHER_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+struct iovec
+{
+    void *iov_base;
+    std::size_t iov_len;
+};
+#else
+#include <sys/uio.h>
+#endif
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+/**************************************
+ GatherBuffer：分散/聚集输出的缓冲区，由Value::Serialize(GatherBuffer &)填充。
+ 1、不短于min_ref字节、且不需要转义的字符串（包括键），以及保存了序列化结果的
+    Array/Object（见cache_serialized），直接引用结点中的内容，不复制；
+ 2、括号、逗号、数字、短字符串等复制到内部的side缓冲区中，相邻的合并为一段；
+ 3、依次输出iov()中的各段，结果与Value::Serialize()逐字节相同。
+ 引用的内容属于被序列化的Value，在输出完成之前不能修改或销毁它；
+ 多次调用Value::Serialize(GatherBuffer &)时结果依次追加。
+
+**************************************/
+class GatherBuffer
+{
+public:
+    explicit GatherBuffer(std::size_t min_ref = 64): min_ref(min_ref), total(0) {}
+
+    /// 各段的iovec，可以直接传给writev；每次追加之后都会重新生成
+    const std::vector<iovec> &iov() const { return vec; }
+    /// 所有段的总长度
+    std::size_t size() const { return total; }
+    /// 直接引用的字节数（未复制到side中的部分）
+    std::size_t referenced() const { return total - side.size(); }
+
+    void clear();
+    /// 把所有段依次连接成一个字符串（预先精确地分配空间）
+    std::string str() const;
+#ifndef _WIN32
+    /// 用writev输出到fd，处理部分写入与IOV_MAX的限制；失败时返回false，errno保持不变
+    bool write_to(int fd) const;
+#endif
+
+private:
+    friend class Writer;
+    friend class Value;
+
+    /// ext为空时是side中从off开始的len个字节，否则是外部的内容
+    struct Segment
+    {
+        const char *ext;
+        std::size_t off, len;
+    };
+
+    void append(const char *s, std::size_t n) { side.append(s, n); extend(n); }
+    void append(char c) { side.push_back(c); extend(1); }
+    /// 记录side末尾新追加的n个字节，与前一段相邻时合并
+    void extend(std::size_t n);
+    void reference(const char *s, std::size_t n);
+    /// 根据segs重新生成vec（side可能已经重新分配）
+    void finish();
+
+    std::vector<Segment> segs;
+    std::string side;
+    std::vector<iovec> vec;
+    std::size_t min_ref;
+    std::size_t total;
+};
+
+
+_JSON_END
+#endif // JSON_GATHER_H
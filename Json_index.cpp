@@ -0,0 +1,584 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Json_error.h"
+#include "Json_type.h"
+#include "Json_index.h"
+
+_JSON_BEGIN
+
+
+/// 在一个Array上建立的全部索引，Array::indexes指向它
+struct IndexLinks
+{
+    std::vector<ArrayIndex::State *> states;
+};
+
+
+
+/**************************************
+ ArrayIndex::State算法说明：
+ 1、map从字段值的哈希（Value::hash，0换成1）映射到元素的下标，不保存字段结点的指针，
+    因此元素在vector中移动、紧凑的Array解除紧凑形式都不影响索引；
+    keyed[i]是第i个元素登记时的哈希（0表示没有被索引）；
+    查找时取出哈希相同的各个下标，再用该元素当前的字段值与键比较，哈希冲突与
+    绕过索引的修改都不会产生错误的结果；
+ 2、stale表示索引已过期：修改结构的touch只设置它，不释放map，因此失效是O(1)的；
+ 3、非const的operator[]、at、begin等交出元素的引用时不使索引过期，只把元素记入live
+    （交出整个范围时设置all）：这些引用在Array的下一次结构修改之前一直有效，随时可能被用来修改字段，
+    因此之后的每一次查找都先按keyed核对它们当前的哈希，有变化时加独占锁更新这些条目；
+    live直到下一次插入、删除（先核对一次）或重建才清空，查找的额外代价与交出过引用的元素个数成正比；
+ 4、核对候选的条目时发现不匹配（字段不等于键，当前的哈希也与登记的不同）说明有未登记的修改，
+    此时重新建立索引后再查找一次，而不是返回可能漏掉的结果；
+ 5、stale与live的更新在加独占锁后进行（双重检查），查找持有共享锁，多个线程可以同时查找，
+    一个线程更新或重建时，其他线程在锁上等待；
+ 6、每一级键有一个Hop：压缩的Object在Shape与上一次相同时直接按下标取值（同PathEvaluator），
+    只在持有独占锁以及Array的修改中使用，查找的核对用Object::packed_find。
+
+**************************************/
+struct ArrayIndex::State
+{
+    /// 上一个压缩Object的Shape与键的下标
+    struct Hop
+    {
+        const Shape *shape = nullptr;
+        std::size_t index = 0;
+    };
+
+    /// Value::hash的结果已经充分混合，直接作为unordered_multimap的哈希值
+    struct Identity
+    {
+        std::size_t operator()(std::size_t h) const noexcept { return h; }
+    };
+
+    Array *array = nullptr;             /// 析构之后为nullptr
+    std::string path;
+    std::vector<std::string> keys;
+    std::vector<Hop> hops;              /// 与keys一一对应
+    std::unordered_multimap<std::size_t, std::size_t, Identity> map;
+    std::vector<std::size_t> keyed;     /// 与元素一一对应
+    std::vector<std::size_t> live;      /// 交出过非const引用的元素的下标
+    std::vector<bool> marked;           /// 与元素一一对应：是否在live中
+    bool all = false;                   /// 交出过整个范围的引用，每个元素都要核对
+    std::shared_mutex mutex;
+    std::atomic<bool> stale{false};
+    std::atomic<bool> watching{false};  /// live不为空或者all
+    std::size_t generation = 0;         /// 每次重建加一
+
+    /// map中使用的哈希：0表示没有被索引
+    static std::size_t slot(std::size_t h) noexcept { return h ? h : 1; }
+    /// v中路径处的字段，路径不存在时返回nullptr；hop为nullptr时不使用缓存
+    const Value *resolve(const Value &v, Hop *hop) const noexcept;
+    /// 第i个元素当前的哈希，没有被索引时为0
+    std::size_t key_of(const Array::_Type &elems, std::size_t i, Hop *hop) const noexcept;
+    void rebuild();
+    /// 重新登记第i个元素
+    void recheck(const Array::_Type &elems, std::size_t i);
+    /// 交出过引用的元素的哈希都与登记的相同（持有共享锁时使用）
+    bool current(const Array::_Type &elems) const noexcept;
+    /// 重新登记交出过引用的元素 / 不再跟踪它们（Array的结构修改使引用失效）
+    void reconcile(const Array::_Type &elems);
+    void release() noexcept;
+    /// 重建之后使用：原来的元素已不存在（过期说明Array的结构被修改过）
+    void forget();
+    /// 过期时重建，交出过引用的元素有变化时更新；Array已析构时抛出JsonError(deref_nullptr)
+    const Array &refresh();
+    /// 对字段等于key的每个元素的下标调用fn（顺序不确定）
+    template<typename _Fn>
+    void matches(const Value_base *key, _Fn fn);
+
+    void inserted(std::size_t i);
+    void erasing(std::size_t i) noexcept;
+    void touched(std::size_t b, std::size_t e) noexcept;
+};
+
+
+const Value *ArrayIndex::State::resolve(const Value &v, Hop *hop) const noexcept
+{
+    const Value *cur = &v;
+    for(const std::string &key : keys)
+    {
+        const Value_base *p = cur->pbase;
+        if(p == nullptr || p->Type() != object_type)
+            return nullptr;
+
+        const Object &obj = *static_cast<const Object *>(p);
+        if(obj.packed == nullptr)
+        {
+            auto it = obj.obj.find(std::string_view(key));
+            if(it == obj.obj.end())
+                return nullptr;
+            cur = &it->second;
+        }
+        else if(hop == nullptr)
+        {
+            if((cur = obj.packed_find(key)) == nullptr)
+                return nullptr;
+        }
+        else
+        {
+            if(hop->shape != obj.packed->shape)
+            {
+                hop->shape = obj.packed->shape;
+                hop->index = hop->shape->index(key);
+            }
+            if(hop->index == Shape::npos)
+                return nullptr;
+            cur = obj.packed->slots() + hop->index;
+        }
+        if(hop)
+            ++hop;
+    }
+    return cur;
+}
+
+
+std::size_t ArrayIndex::State::key_of(const Array::_Type &elems, std::size_t i, Hop *hop) const noexcept
+{
+    const Value *field = resolve(elems[i], hop);
+    return field ? slot(Value::hash(field->pbase)) : 0;
+}
+
+
+void ArrayIndex::State::rebuild()
+{
+    map.clear();
+    const Array::_Type &elems = array->elements();
+    map.reserve(elems.size());
+    keyed.assign(elems.size(), 0);
+    for(std::size_t i = 0; i != elems.size(); ++i)
+        if((keyed[i] = key_of(elems, i, hops.data())) != 0)
+            map.emplace(keyed[i], i);
+    ++generation;
+}
+
+
+void ArrayIndex::State::recheck(const Array::_Type &elems, std::size_t i)
+{
+    std::size_t h = key_of(elems, i, hops.data());
+    if(h == keyed[i])
+        return;
+    if(keyed[i] != 0)
+    {
+        auto range = map.equal_range(keyed[i]);
+        for(auto it = range.first; it != range.second; ++it)
+            if(it->second == i)
+            {
+                map.erase(it);
+                break;
+            }
+    }
+    keyed[i] = 0;       /// emplace失败时keyed与map仍然一致
+    if(h != 0)
+        map.emplace(h, i);
+    keyed[i] = h;
+}
+
+
+bool ArrayIndex::State::current(const Array::_Type &elems) const noexcept
+{
+    if(all)
+    {
+        for(std::size_t i = 0; i != elems.size(); ++i)
+            if(key_of(elems, i, nullptr) != keyed[i])
+                return false;
+        return true;
+    }
+    for(std::size_t i : live)
+        if(key_of(elems, i, nullptr) != keyed[i])
+            return false;
+    return true;
+}
+
+
+void ArrayIndex::State::reconcile(const Array::_Type &elems)
+{
+    if(all)
+        for(std::size_t i = 0; i != elems.size(); ++i)
+            recheck(elems, i);
+    else
+        for(std::size_t i : live)
+            recheck(elems, i);
+}
+
+
+void ArrayIndex::State::release() noexcept
+{
+    for(std::size_t i : live)
+        marked[i] = false;
+    live.clear();
+    all = false;
+    watching.store(false, std::memory_order_relaxed);
+}
+
+
+void ArrayIndex::State::forget()
+{
+    marked.assign(keyed.size(), false);
+    live.clear();
+    all = false;
+    watching.store(false, std::memory_order_relaxed);
+}
+
+
+const Array &ArrayIndex::State::refresh()
+{
+    if(array == nullptr)
+        throw JsonError(deref_nullptr);
+
+    if(stale.load(std::memory_order_acquire))
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if(stale.load(std::memory_order_relaxed))
+        {
+            rebuild();
+            forget();
+            stale.store(false, std::memory_order_release);
+        }
+    }
+    if(watching.load(std::memory_order_acquire))
+    {
+        const Array::_Type &elems = array->elements();
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            if(current(elems))
+                return *array;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        reconcile(elems);
+    }
+    return *array;
+}
+
+
+/// 第一遍核对候选的条目，发现不匹配时重建后重试；没有不匹配时第二遍才调用fn，
+/// 因此fn不会对同一个下标调用两次
+template<typename _Fn>
+void ArrayIndex::State::matches(const Value_base *key, _Fn fn)
+{
+    const std::size_t h = slot(Value::hash(key));
+    for(int attempt = 0; ; ++attempt)
+    {
+        const Array::_Type &elems = refresh().elements();
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto range = map.equal_range(h);
+        bool consistent = true;
+        for(auto it = range.first; attempt == 0 && it != range.second; ++it)
+        {
+            std::size_t i = it->second;
+            const Value *field = i < elems.size() ? resolve(elems[i], nullptr) : nullptr;
+            if(field && Value::equal(field->pbase, key))
+                continue;
+            /// 不等于键时，哈希冲突的元素当前的哈希仍与登记的相同，否则就是被修改过
+            if(field == nullptr || slot(Value::hash(field->pbase)) != h)
+            {
+                consistent = false;
+                break;
+            }
+        }
+
+        if(consistent)
+        {
+            for(auto it = range.first; it != range.second; ++it)
+            {
+                std::size_t i = it->second;
+                if(i >= elems.size())
+                    continue;
+                const Value *field = resolve(elems[i], nullptr);
+                if(field && Value::equal(field->pbase, key))
+                    fn(i);
+            }
+            return;
+        }
+
+        std::size_t seen = generation;
+        lock.unlock();
+        std::unique_lock<std::shared_mutex> exclusive(mutex);
+        if(generation == seen)
+            rebuild();
+    }
+}
+
+
+/// 不在末尾插入时先把不小于i的下标加一；
+/// 先前交出过引用的元素（下标随之后移）最后核对一次，之后不再跟踪
+void ArrayIndex::State::inserted(std::size_t i)
+{
+    const Array::_Type &elems = array->elements();
+    std::size_t h = key_of(elems, i, hops.data());
+    keyed.insert(keyed.begin() + i, h);
+    marked.insert(marked.begin() + i, false);
+    if(i + 1 != elems.size())
+        for(auto &entry : map)
+            if(entry.second >= i)
+                ++entry.second;
+    if(h != 0)
+        map.emplace(h, i);
+    if(watching.load(std::memory_order_relaxed))
+    {
+        for(std::size_t &j : live)
+            j += j >= i;
+        reconcile(elems);
+        release();
+    }
+}
+
+
+/// 先核对交出过引用的元素并不再跟踪它们，再删除第i个元素的条目，
+/// 不在末尾删除时把大于i的下标减一；核对失败（内存不足）时索引过期
+void ArrayIndex::State::erasing(std::size_t i) noexcept
+{
+    if(watching.load(std::memory_order_relaxed))
+    {
+        try
+        {
+            reconcile(array->elements());
+        }
+        catch(...)
+        {
+            stale.store(true, std::memory_order_release);
+            return;
+        }
+        release();
+    }
+    if(keyed[i] != 0)
+    {
+        auto range = map.equal_range(keyed[i]);
+        for(auto it = range.first; it != range.second; ++it)
+            if(it->second == i)
+            {
+                map.erase(it);
+                break;
+            }
+    }
+    keyed.erase(keyed.begin() + i);
+    marked.erase(marked.begin() + i);
+    if(i != keyed.size())
+        for(auto &entry : map)
+            if(entry.second > i)
+                --entry.second;
+}
+
+
+/// 记录失败（内存不足）时改为核对全部元素
+void ArrayIndex::State::touched(std::size_t b, std::size_t e) noexcept
+{
+    if(stale.load(std::memory_order_relaxed) || all)
+        return;
+    e = std::min(e, marked.size());     /// at越界时先记录再抛出异常
+    if(b == 0 && e == marked.size())
+        all = true;
+    else
+        for(std::size_t i = b; i < e; ++i)
+        {
+            if(marked[i])
+                continue;
+            try
+            {
+                live.push_back(i);
+            }
+            catch(...)
+            {
+                all = true;
+                break;
+            }
+            marked[i] = true;
+        }
+    watching.store(true, std::memory_order_release);
+}
+
+
+
+/// 按「.」切分路径，转义规则同Projection::add
+ArrayIndex Array::build_index(std::string_view path)
+{
+    std::unique_ptr<ArrayIndex::State> s(new ArrayIndex::State);
+    s->array = this;
+    s->path = std::string(path);
+    if(!path.empty())
+    {
+        s->keys.emplace_back();
+        for(std::size_t i = 0; i != path.size(); ++i)
+        {
+            if(path[i] == '\\' && i + 1 != path.size())
+                s->keys.back() += path[++i];
+            else if(path[i] == '.')
+                s->keys.emplace_back();
+            else
+                s->keys.back() += path[i];
+        }
+    }
+    s->hops.resize(s->keys.size());
+    s->rebuild();
+    s->forget();
+
+    if(indexes == nullptr)
+        indexes = new IndexLinks;
+    indexes->states.push_back(s.get());
+    return ArrayIndex(std::move(s));
+}
+
+
+void Array::invalidate_indexes() noexcept
+{
+    for(ArrayIndex::State *s : indexes->states)
+        s->stale.store(true, std::memory_order_release);
+}
+
+
+/// 更新失败（内存不足）时索引标记为过期，由下一次查找重建
+void Array::index_inserted(size_type i) noexcept
+{
+    for(ArrayIndex::State *s : indexes->states)
+    {
+        if(s->stale.load(std::memory_order_relaxed))
+            continue;
+        try
+        {
+            s->inserted(i);
+        }
+        catch(...)
+        {
+            s->stale.store(true, std::memory_order_release);
+        }
+    }
+}
+
+
+void Array::index_erasing(size_type i) noexcept
+{
+    for(ArrayIndex::State *s : indexes->states)
+        if(!s->stale.load(std::memory_order_relaxed))
+            s->erasing(i);
+}
+
+
+void Array::index_touched(size_type b, size_type e) noexcept
+{
+    for(ArrayIndex::State *s : indexes->states)
+        s->touched(b, e);
+}
+
+
+void Array::detach_indexes() noexcept
+{
+    for(ArrayIndex::State *s : indexes->states)
+        s->array = nullptr;
+    delete indexes;
+    indexes = nullptr;
+}
+
+
+
+ArrayIndex::ArrayIndex(std::unique_ptr<State> s): state(std::move(s))
+{
+}
+
+
+ArrayIndex::ArrayIndex(ArrayIndex &&rhs) noexcept: state(std::move(rhs.state))
+{
+}
+
+
+ArrayIndex &ArrayIndex::operator=(ArrayIndex &&rhs) noexcept
+{
+    if(this != &rhs)
+    {
+        ArrayIndex old(std::move(*this));
+        state = std::move(rhs.state);
+    }
+    return *this;
+}
+
+
+/// 从所属Array的索引列表中删除自己，列表为空时释放它
+ArrayIndex::~ArrayIndex()
+{
+    if(state == nullptr || state->array == nullptr)
+        return;
+
+    Array &arr = *state->array;
+    auto &states = arr.indexes->states;
+    states.erase(std::find(states.begin(), states.end(), state.get()));
+    if(states.empty())
+    {
+        delete arr.indexes;
+        arr.indexes = nullptr;
+    }
+}
+
+
+std::size_t ArrayIndex::find(const Value &key) const
+{
+    if(state == nullptr)
+        throw JsonError(deref_nullptr);
+    std::size_t first = npos;
+    state->matches(key.pbase, [&first](std::size_t i) { first = std::min(first, i); });
+    return first;
+}
+
+
+/// 在栈上构造String作为键，不构造Value的结点
+std::size_t ArrayIndex::find_string(std::string_view key) const
+{
+    if(state == nullptr)
+        throw JsonError(deref_nullptr);
+    String probe(key);
+    std::size_t first = npos;
+    state->matches(&probe, [&first](std::size_t i) { first = std::min(first, i); });
+    return first;
+}
+
+
+std::vector<std::size_t> ArrayIndex::find_all(const Value &key) const
+{
+    if(state == nullptr)
+        throw JsonError(deref_nullptr);
+    std::vector<std::size_t> all;
+    state->matches(key.pbase, [&all](std::size_t i) { all.push_back(i); });
+    std::sort(all.begin(), all.end());
+    return all;
+}
+
+
+std::size_t ArrayIndex::count(const Value &key) const
+{
+    if(state == nullptr)
+        throw JsonError(deref_nullptr);
+    std::size_t n = 0;
+    state->matches(key.pbase, [&n](std::size_t) { ++n; });
+    return n;
+}
+
+
+std::size_t ArrayIndex::size() const
+{
+    if(state == nullptr)
+        throw JsonError(deref_nullptr);
+    state->refresh();
+    std::shared_lock<std::shared_mutex> lock(state->mutex);
+    return state->map.size();
+}
+
+
+bool ArrayIndex::attached() const
+{
+    return state != nullptr && state->array != nullptr;
+}
+
+
+const std::string &ArrayIndex::path() const
+{
+    static const std::string empty;
+    return state ? state->path : empty;
+}
+
+
+_JSON_END
@@ -0,0 +1,85 @@
+#ifndef JSON_INDEX_H
+#define JSON_INDEX_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+/**************************************
+ ArrayIndex：Array上的二级哈希索引，从元素中某个字段的值查找元素的下标，由Array::build_index建立。
+ 1、路径与Projection相同，是以「.」分隔的键（「\.」与「\\」表示键中的「.」与「\」），
+    例如"user.id"索引每个元素的user.id；空路径索引元素自身；
+    路径不存在（中间遇到非Object或缺少键）的元素不被索引；
+ 2、键按Value的相等比较（数字按数值，Array与Object深比较），同一个值可以对应多个元素；
+ 3、Array的push_back、pop_back、单个元素的insert与erase就地更新索引：
+    在末尾追加与删除是O(1)，在中间插入与删除要调整之后各元素的下标，是O(索引的大小)；
+    范围insert/erase、clear、resize、swap以及重用Array的解析把索引标记为过期，
+    下一次查找时重新建立；
+ 4、非const的operator[]、at、front、back、begin/end以及单个元素的insert/erase交出元素的引用，
+    不使索引过期：只记下这些元素，这些引用在Array的下一次结构修改（插入、删除等）之前一直有效，
+    因此之后的每一次查找都先核对它们的字段，字段改变的元素按新值登记，任何时候修改都能被查找到；
+    查找的额外代价与记下的元素个数成正比，下一次插入、删除或重建之后清空；
+    交出整个范围（begin()/end()、insert/erase返回的迭代器）之后每次查找核对全部元素，
+    此时应改用const引用读取，或者在修改完成后做一次结构修改；
+ 5、索引属于建立它的Array对象而不是其中的元素：拷贝或移动得到的Array没有索引，
+    被移动的Array的索引随之过期（重建后为空）；Array析构之后查找抛出JsonError(deref_nullptr)；
+ 6、多个线程可以同时查找（过期或需要核对时只有一个线程处理，其余的在锁上等待）；建立与析构索引都会修改Array，
+    不能与其他线程对同一个Array的访问同时进行。
+
+ 用法：
+     json::Array &users = doc.as_Object()["users"].as_Array();
+     json::ArrayIndex by_id = users.build_index("id");
+     std::size_t i = by_id.find(json::Value(42));      // 没有时返回ArrayIndex::npos
+     if(i != json::ArrayIndex::npos)
+         users[i].as_Object()["score"] = 100;           // 不使索引过期，之后的查找核对users[i]
+     users.push_back(user);                             // 索引随之更新
+
+**************************************/
+class ArrayIndex
+{
+public:
+    static const std::size_t npos = static_cast<std::size_t>(-1);
+
+    ArrayIndex(ArrayIndex &&) noexcept;
+    ArrayIndex &operator=(ArrayIndex &&) noexcept;
+    ~ArrayIndex();
+
+    /// 字段等于key的第一个元素的下标，没有时返回npos
+    std::size_t find(const Value &key) const;
+    /// 以字符串为键的版本：不构造Value
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    std::size_t find(const _Key &key) const { return find_string(std::string_view(key)); }
+    /// 字段等于key的全部元素的下标，按从小到大的顺序
+    std::vector<std::size_t> find_all(const Value &key) const;
+    std::size_t count(const Value &key) const;
+    /// 被索引的元素个数（不含路径不存在的元素）
+    std::size_t size() const;
+
+    /// 所属的Array仍然存在
+    bool attached() const;
+    const std::string &path() const;
+
+    /// 索引的状态，定义在Json_index.cpp中
+    struct State;
+
+private:
+    friend class Array;
+    explicit ArrayIndex(std::unique_ptr<State> s);
+
+    std::size_t find_string(std::string_view key) const;
+
+    std::unique_ptr<State> state;
+};
+
+
+_JSON_END
+#endif // JSON_INDEX_H
@@ -0,0 +1,69 @@
+#include <utility>
+#include <vector>
+#include "Json_literal.h"
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+
+Constant &Constant::operator=(const Constant &rhs)
+{
+    if(this != &rhs)
+    {
+        shared = rhs.shared;
+        own.reset(rhs.own ? new Value(*rhs.own) : nullptr);
+    }
+    return *this;
+}
+
+
+Value &Constant::mutate()
+{
+    if(!own)
+        own.reset(new Value(*shared));
+    return *own;
+}
+
+
+/**************************************
+ Constant::freeze算法说明：
+ 1、把v移入一个永不释放的Value，之后只通过const接口访问；
+ 2、用显式的栈遍历整棵树，对每个Number读取一次数值，
+    使解析时保留的词素（见Number的延迟转换）在此完成转换；
+ 3、计算根结点的哈希，所有Array/Object的哈希值都被缓存；
+ 完成后对常量文档的只读访问（包括多线程同时访问）不再修改结点、也不再分配内存。
+
+**************************************/
+const Value &Constant::freeze(Value v)
+{
+    const Value *doc = new Value(std::move(v));
+
+    std::vector<const Value *> stack{doc};
+    while(!stack.empty())
+    {
+        const Value *p = stack.back();
+        stack.pop_back();
+        switch(p->Type())
+        {
+        case number_type:
+            (void)p->to_longdouble();
+            break;
+        case array_type:
+            for(const auto &e : p->as_Array())
+                stack.push_back(&e);
+            break;
+        case object_type:
+            p->as_Object().for_each([&stack](const String &, const Value &e) {
+                stack.push_back(&e);
+            });
+            break;
+        default:
+            break;
+        }
+    }
+    (void)doc->hash();
+    return *doc;
+}
+
+
+_JSON_END
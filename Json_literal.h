@@ -0,0 +1,258 @@
+#ifndef JSON_LITERAL_H
+#define JSON_LITERAL_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+/**************************************
+ LiteralChecker：编译期检查json字面量的语法。
+ 文法与Scanner/Value::Parse完全相同（见Scanner::read_number等），
+ 只判断是否合法，不构造任何结点。嵌套深度超过max_depth视为错误，
+ 以免超出编译器对constexpr递归深度的限制。
+
+**************************************/
+class LiteralChecker
+{
+public:
+    static constexpr std::size_t ok = static_cast<std::size_t>(-1);
+    static constexpr std::size_t max_depth = 128;
+
+    constexpr explicit LiteralChecker(std::string_view text): s(text), pos(0) {}
+
+    /// 合法时返回ok，否则返回第一个错误的位置
+    constexpr std::size_t check()
+    {
+        skip_ws();
+        if(!value(0))
+            return pos;
+        skip_ws();
+        return pos == s.size() ? ok : pos;
+    }
+
+private:
+    constexpr char peek() const { return pos != s.size() ? s[pos] : '\0'; }
+    constexpr bool eat(char c)
+    {
+        skip_ws();
+        if(peek() != c)
+            return false;
+        ++pos;
+        return true;
+    }
+    constexpr void skip_ws()
+    {
+        while(pos != s.size() && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\n'
+                                  || s[pos] == '\r' || s[pos] == '\v' || s[pos] == '\f'))
+            ++pos;
+    }
+    static constexpr bool digit(char c) { return c >= '0' && c <= '9'; }
+    static constexpr bool hex(char c)
+        { return digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); }
+
+    constexpr bool value(std::size_t depth)
+    {
+        switch(peek())
+        {
+        case '{': return depth < max_depth && object(depth + 1);
+        case '[': return depth < max_depth && array(depth + 1);
+        case '\"': return string();
+        case 't': return word("true");
+        case 'f': return word("false");
+        case 'n': return word("null");
+        default: return number();
+        }
+    }
+
+    constexpr bool object(std::size_t depth)
+    {
+        ++pos;
+        if(eat('}'))
+            return true;
+        do
+        {
+            skip_ws();
+            if(!string() || !eat(':'))
+                return false;
+            skip_ws();
+            if(!value(depth))
+                return false;
+        } while(eat(','));
+        return eat('}');
+    }
+
+    constexpr bool array(std::size_t depth)
+    {
+        ++pos;
+        if(eat(']'))
+            return true;
+        do
+        {
+            skip_ws();
+            if(!value(depth))
+                return false;
+        } while(eat(','));
+        return eat(']');
+    }
+
+    constexpr bool string()
+    {
+        if(peek() != '\"')
+            return false;
+        for(++pos; pos != s.size(); ++pos)
+        {
+            char c = s[pos];
+            if(c == '\"')
+            {
+                ++pos;
+                return true;
+            }
+            if(c >= '\x00' && c <= '\x1f')
+                return false;
+            if(c != '\\')
+                continue;
+            if(++pos == s.size())
+                return false;
+            switch(s[pos])
+            {
+            case '\"': case '\\': case '/': case 'b':
+            case 'f': case 'n': case 'r': case 't':
+                break;
+            case 'u':
+                for(int i = 0; i != 4; ++i)
+                    if(++pos == s.size() || !hex(s[pos]))
+                        return false;
+                break;
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    constexpr bool number()
+    {
+        if(peek() == '-')
+            ++pos;
+        if(!digit(peek()))
+            return false;
+        if(peek() == '0')
+            ++pos;
+        else
+            while(digit(peek())) ++pos;
+
+        if(peek() == '.')
+        {
+            ++pos;
+            if(!digit(peek()))
+                return false;
+            while(digit(peek())) ++pos;
+        }
+        if(peek() == 'e' || peek() == 'E')
+        {
+            ++pos;
+            if(peek() == '+' || peek() == '-')
+                ++pos;
+            if(!digit(peek()))
+                return false;
+            while(digit(peek())) ++pos;
+        }
+        return true;
+    }
+
+    constexpr bool word(std::string_view w)
+    {
+        if(s.substr(pos, w.size()) != w)
+            return false;
+        pos += w.size();
+        return true;
+    }
+
+    std::string_view s;
+    std::size_t pos;
+};
+
+
+/// 编译期检查：合法时返回LiteralChecker::ok，否则返回第一个错误的位置
+constexpr std::size_t literal_error(std::string_view text)
+{
+    return LiteralChecker(text).check();
+}
+
+
+
+/**************************************
+ Constant：指向一棵常量文档的句柄，常量文档在进程内只构造一次、永不释放。
+ 1、拷贝句柄只拷贝指针；通过get()、*、->读取时使用普通的const Value接口，
+    常量文档构造时已转换所有数字、计算好哈希，读取不会分配内存；
+ 2、mutate()第一次调用时才把常量拷贝一份，之后的读写都作用于这份拷贝（写时复制）；
+ 3、常量文档由JSON_LITERAL、JSON_CONSTANT在第一次求值时构造，之后再求值不再分配内存；
+    freeze可以把运行时得到的Value变为常量文档，但每次调用都会保留一棵新树。
+ C++17中std::string、std::map不能在编译期构造，因此结点无法放入只读的静态存储区；
+ JSON_LITERAL在编译期检查语法，运行时只在第一次求值时解析一次。
+
+**************************************/
+class Constant
+{
+public:
+    /// doc必须在程序结束之前都有效且不再被修改（通常来自freeze）
+    explicit Constant(const Value &doc): shared(&doc) {}
+    Constant(const Constant &rhs):
+        shared(rhs.shared), own(rhs.own ? new Value(*rhs.own) : nullptr) {}
+    Constant(Constant &&) noexcept = default;
+    Constant &operator=(const Constant &rhs);
+    Constant &operator=(Constant &&) noexcept = default;
+
+    const Value &get() const { return own ? *own : *shared; }
+    const Value &operator*()  const { return get(); }
+    const Value *operator->() const { return &get(); }
+    operator const Value &() const { return get(); }
+
+    /// 第一次调用时拷贝常量，返回可以修改的拷贝
+    Value &mutate();
+    /// 是否已经调用过mutate
+    bool mutated() const { return own != nullptr; }
+
+    /// 接管v，转换所有数字并计算哈希后返回，返回的文档永不释放
+    static const Value &freeze(Value v);
+
+private:
+    const Value *shared;
+    std::unique_ptr<Value> own;
+};
+
+
+_JSON_END
+
+
+/// 编译期检查语法的常量json文档，例如
+///     json::Constant c = JSON_LITERAL(R"({"a":[1,2,3]})");
+/// 每个JSON_LITERAL只在第一次求值时解析一次（线程安全），得到json::Constant
+#define JSON_LITERAL(_text) \
+    ([]() -> ::json::Constant { \
+        static_assert(::json::literal_error(_text) == ::json::LiteralChecker::ok, \
+                      "JSON_LITERAL: invalid json text"); \
+        static const ::json::Value &doc = \
+            ::json::Constant::freeze(::json::Value::Parse(_text)); \
+        return ::json::Constant(doc); \
+    }())
+
+/// 用Value的初始化列表构造的常量json文档，例如
+///     json::Constant c = JSON_CONSTANT({{"a", {1, 2, 3}}, {"b", 3.14}});
+/// 每个JSON_CONSTANT只在第一次求值时构造一次（线程安全），得到json::Constant
+#define JSON_CONSTANT(...) \
+    ([]() -> ::json::Constant { \
+        static const ::json::Value &doc = \
+            ::json::Constant::freeze(::json::Value __VA_ARGS__); \
+        return ::json::Constant(doc); \
+    }())
+
+
+#endif // JSON_LITERAL_H
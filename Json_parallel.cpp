@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <string_view>
+#include <vector>
+#include "Json_error.h"
+#include "Json_string.h"
+#include "Json_reader.h"
+#include "Json_type.h"
+#include "Json_writer.h"
+#include "Json_parallel.h"
+
+_JSON_BEGIN
+
+
+unsigned ParallelOptions::thread_count() const
+{
+    if(threads)
+        return threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+
+
+struct ThreadPool::Batch
+{
+    Batch(const std::function<void(std::size_t)> &f, std::size_t count):
+        fn(&f), n(count), next(0), done(0) {}
+
+    const std::function<void(std::size_t)> *fn;
+    std::size_t n;
+    std::atomic<std::size_t> next, done;
+    std::mutex mtx;
+    std::condition_variable cv;
+};
+
+
+ThreadPool::ThreadPool(unsigned n): stopping(false)
+{
+    for(unsigned i = 0; i != n; ++i)
+        workers.emplace_back([this] { work(); });
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    for(auto &t : workers)
+        t.join();
+}
+
+
+ThreadPool &ThreadPool::shared()
+{
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+
+/// 领取并执行batch中剩余的任务，最后一个完成的任务负责唤醒等待者
+void ThreadPool::drain(Batch &batch)
+{
+    for(;;)
+    {
+        std::size_t i = batch.next.fetch_add(1);
+        if(i >= batch.n)
+            return;
+        (*batch.fn)(i);
+        if(batch.done.fetch_add(1) + 1 == batch.n)
+        {
+            std::lock_guard<std::mutex> lk(batch.mtx);
+            batch.cv.notify_all();
+        }
+    }
+}
+
+
+void ThreadPool::work()
+{
+    for(;;)
+    {
+        std::shared_ptr<Batch> batch;
+        {
+            std::unique_lock<std::mutex> lk(mtx);
+            cv.wait(lk, [this] { return stopping || !queue.empty(); });
+            if(stopping)
+                return;
+            batch = queue.front();
+        }
+
+        drain(*batch);
+
+        std::lock_guard<std::mutex> lk(mtx);
+        if(!queue.empty() && queue.front() == batch)
+            queue.pop_front();
+    }
+}
+
+
+void ThreadPool::run(std::size_t n, const std::function<void(std::size_t)> &fn)
+{
+    if(n == 0)
+        return;
+    if(n == 1 || workers.empty())
+    {
+        for(std::size_t i = 0; i != n; ++i)
+            fn(i);
+        return;
+    }
+
+    auto batch = std::make_shared<Batch>(fn, n);
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        queue.push_back(batch);
+    }
+    cv.notify_all();
+
+    drain(*batch);
+    {
+        std::unique_lock<std::mutex> lk(batch->mtx);
+        batch->cv.wait(lk, [&batch] { return batch->done.load() == batch->n; });
+    }
+
+    std::lock_guard<std::mutex> lk(mtx);
+    auto it = std::find(queue.begin(), queue.end(), batch);
+    if(it != queue.end())
+        queue.erase(it);
+}
+
+
+
+
+/**************************************
+ split_top_level算法说明（并行解析的结构预扫描）：
+ 从顶层容器的开括号之后顺序扫描，只跟踪字符串与括号深度，不做任何解析：
+ 1、字符串整体跳过（处理「\」转义），未闭合时返回false；
+ 2、深度为0处的逗号即顶层元素的分隔符，每隔约spacing字节记录一个作为切分点；
+ 3、深度为0处的闭括号即顶层容器的结尾，记入close并返回true。
+ 预扫描不检查括号种类是否配对，这类错误会在分块解析时被发现。
+
+**************************************/
+bool split_top_level(const char *open, const char *end, std::size_t spacing,
+                     std::vector<const char *> &cuts, const char *&close)
+{
+    const char *next = open + spacing;
+    std::size_t depth = 0;
+    for(const char *p = open + 1; p != end; ++p)
+    {
+        switch(*p)
+        {
+        case '\"':
+            for(++p; p != end && *p != '\"'; ++p)
+                if(*p == '\\' && ++p == end)
+                    return false;
+            if(p == end)
+                return false;
+            break;
+
+        case '[': case '{':
+            ++depth;
+            break;
+
+        case ']': case '}':
+            if(depth == 0)
+            {
+                close = p;
+                return true;
+            }
+            --depth;
+            break;
+
+        case ',':
+            if(depth == 0 && p >= next)
+            {
+                cuts.push_back(p);
+                next = p + spacing;
+            }
+            break;
+        }
+    }
+    return false;
+}
+
+
+
+/**************************************
+ Value::TryParse（并行版）算法说明：
+ 1、输入小于min_bytes、只有一个线程、或顶层不是Array/Object时，直接顺序解析；
+ 2、用split_top_level找出顶层元素的切分点，把顶层容器分成若干块，
+    每块由线程池中的一个任务用Reader::parse_elements/parse_members独立解析；
+ 3、所有块都成功时，按顺序把各块拼接成最终的Array/Object：
+    Array按顺序移动元素，Object按顺序merge（重复键保留最先出现的，与顺序解析一致）；
+ 4、预扫描或任何一块失败时，退回顺序解析，因此错误类型与位置与顺序解析完全相同。
+ 只切分最外层容器：最外层只有少数几个巨大成员的文档不会从中受益。
+ 各块由多个线程同时分配，不能共用当前线程的memory_resource（它通常不是线程安全的），
+ 因此并行解析的结果总是来自::operator new；退回顺序解析时仍使用当前的设置。
+
+**************************************/
+ParseResult Value::TryParse(std::string_view js, Value &out,
+                            const ParallelOptions &opt) noexcept
+{
+    unsigned threads = opt.thread_count();
+    if(threads <= 1 || js.size() < opt.min_bytes)
+        return TryParse(js, out);
+
+    const char *b = js.data(), *e = b + js.size();
+    const char *open = b;
+    while(open != e && IsSpace(*open)) ++open;
+    if(open == e || (*open != '[' && *open != '{'))
+        return TryParse(js, out);
+
+    std::size_t parts = static_cast<std::size_t>(threads) * std::max(1u, opt.tasks_per_thread);
+    std::vector<const char *> cuts;
+    const char *close = nullptr;
+    if(!split_top_level(open, e, std::max<std::size_t>(1, (e - open) / parts), cuts, close)
+       || cuts.empty()
+       || (*open == '[') != (*close == ']'))
+        return TryParse(js, out);
+
+    for(const char *p = close + 1; p != e; ++p)
+        if(!IsSpace(*p))
+            return TryParse(js, out);
+
+    std::pmr::memory_resource *mr = current_resource();
+    ResourceScope heap(nullptr);
+    const bool isArray = *open == '[';
+    const std::size_t n = cuts.size() + 1;
+    std::vector<Array> arrays(isArray ? n : 0);
+    std::vector<Object> objects(isArray ? 0 : n);
+    std::vector<char> ok(n, 0);
+
+    ThreadPool::shared().run(n, [&](std::size_t i) {
+        const char *from = i == 0 ? open + 1 : cuts[i - 1] + 1;
+        const char *stop = i + 1 == n ? close : cuts[i];
+        Reader reader(b, e);
+        reader.scan().seek(from);
+        ok[i] = isArray ? reader.parse_elements(arrays[i], stop)
+                        : reader.parse_members(objects[i], stop);
+    });
+
+    if(std::find(ok.begin(), ok.end(), 0) != ok.end())
+    {
+        ResourceScope sequential(mr);
+        return TryParse(js, out);
+    }
+
+    Value_base *node = nullptr;
+    if(isArray)
+    {
+        /// 各块都是紧凑的数字时拼接数组（整数与小数混合时先把整数块widen），
+        /// 否则全部转换回普通的Array再拼接，结果与顺序解析相同
+        std::size_t total = 0;
+        bool dense = true, floating = false;
+        for(const auto &a : arrays)
+        {
+            total += a.size();
+            dense = dense && a.dense;
+            floating = floating || (a.dense && a.dense->floating);
+        }
+        for(auto &a : arrays)
+            if(dense && floating && !a.dense->floating)
+                dense = a.dense->widen();
+
+        Array *arr = new Array();
+        if(dense)
+        {
+            arr->dense = new Array::Dense;
+            arr->dense->floating = floating;
+            if(floating)
+                arr->dense->f64.reserve(total);
+            else
+                arr->dense->i64.reserve(total);
+            for(const auto &a : arrays)
+            {
+                if(floating)
+                    arr->dense->f64.insert(arr->dense->f64.end(), a.dense->f64.begin(), a.dense->f64.end());
+                else
+                    arr->dense->i64.insert(arr->dense->i64.end(), a.dense->i64.begin(), a.dense->i64.end());
+            }
+        }
+        else
+        {
+            arr->arr.reserve(total);
+            for(auto &a : arrays)
+            {
+                if(a.dense)
+                    a.unpack();
+                arr->arr.insert(arr->arr.end(),
+                                std::make_move_iterator(a.arr.begin()),
+                                std::make_move_iterator(a.arr.end()));
+            }
+        }
+        node = arr;
+    }
+    else
+    {
+        Object *obj = new Object(std::move(objects[0]));
+        for(std::size_t i = 1; i != n; ++i)
+            obj->obj.merge(objects[i].obj);
+        node = obj;
+    }
+
+    delete out.pbase;
+    out.pbase = node;
+    return ParseResult();
+}
+
+
+Value Value::Parse(std::string_view js, const ParallelOptions &opt)
+{
+    Value ret(nullptr, adopt_t());
+    ParseResult r = TryParse(js, ret, opt);
+    if(!r)
+        throw JsonError(r);
+    return ret;
+}
+
+
+/**************************************
+ Value::Serialize（并行版）算法说明：
+ 1、用Writer::estimate估计整棵树的输出长度，小于min_bytes或只有一个线程时直接顺序序列化；
+ 2、取target = 估计长度 / (线程数 * tasks_per_thread)，
+    用Writer::split把估计长度超过target的Array/Object逐层展开成按顺序排列的片段；
+ 3、按估计长度把相邻的片段分组，每组约target字节，由线程池中的一个任务输出到自己的缓冲区；
+ 4、按顺序连接各缓冲区。片段依次输出的结果与顺序序列化相同，因此输出逐字节相同。
+ 任务中抛出的异常（如deref_nullptr）在全部任务结束后按顺序重新抛出第一个。
+
+**************************************/
+JsonString Value::Serialize(const ParallelOptions &opt) const
+{
+    check();
+    unsigned threads = opt.thread_count();
+    if(threads <= 1)
+        return Serialize();
+
+    std::size_t total = Writer::estimate(*this, std::numeric_limits<std::size_t>::max());
+    if(total < opt.min_bytes)
+        return Serialize();
+
+    std::size_t parts = static_cast<std::size_t>(threads) * std::max(1u, opt.tasks_per_thread);
+    std::size_t target = std::max<std::size_t>(1, total / parts);
+
+    std::vector<Writer::Piece> pieces;
+    Writer::split(*this, target, pieces);
+
+    std::vector<std::size_t> bounds(1, 0);
+    std::vector<std::size_t> sizes;
+    std::size_t acc = 0;
+    for(std::size_t i = 0; i != pieces.size(); ++i)
+    {
+        acc += pieces[i].size;
+        if(acc >= target || i + 1 == pieces.size())
+        {
+            bounds.push_back(i + 1);
+            sizes.push_back(acc);
+            acc = 0;
+        }
+    }
+
+    const std::size_t n = sizes.size();
+    if(n <= 1)
+        return Serialize();
+
+    std::vector<std::string> buffers(n);
+    std::vector<std::exception_ptr> errors(n);
+    ThreadPool::shared().run(n, [&](std::size_t i) {
+        try
+        {
+            buffers[i].reserve(sizes[i] + sizes[i] / 8);
+            Writer::write(buffers[i], pieces.data() + bounds[i], pieces.data() + bounds[i + 1]);
+        }
+        catch(...)
+        {
+            errors[i] = std::current_exception();
+        }
+    });
+
+    std::size_t length = 0;
+    for(std::size_t i = 0; i != n; ++i)
+    {
+        if(errors[i])
+            std::rethrow_exception(errors[i]);
+        length += buffers[i].size();
+    }
+
+    JsonString ret;
+    ret.reserve(length);
+    for(const auto &buf : buffers)
+        ret += buf;
+    return ret;
+}
+
+
+_JSON_END
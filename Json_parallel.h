@@ -0,0 +1,76 @@
+#ifndef JSON_PARALLEL_H
+#define JSON_PARALLEL_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+_JSON_BEGIN
+
+/// 并行解析/序列化的参数
+struct ParallelOptions
+{
+    unsigned threads = 0;               /// 使用的线程数，0表示硬件线程数
+    std::size_t min_bytes = 1 << 20;    /// 小于该大小的输入直接顺序处理
+    unsigned tasks_per_thread = 4;      /// 每个线程分到的块数，块越多负载越均衡
+
+    /// threads为0时换算成硬件线程数（至少为1）
+    unsigned thread_count() const;
+};
+
+
+
+/// 并行解析的结构预扫描：open指向顶层容器的开括号，每隔约spacing字节记录一个顶层逗号到cuts中，
+/// 找到顶层的闭括号时记入close并返回true（见Json_parallel.cpp），也供to_columns切分数组
+bool split_top_level(const char *open, const char *end, std::size_t spacing,
+                     std::vector<const char *> &cuts, const char *&close);
+
+
+
+/**************************************
+ ThreadPool：固定数量工作线程的线程池。
+ run(n, fn)把fn(0)...fn(n-1)分给工作线程与调用线程共同执行，全部完成后返回；
+ 调用线程自己也领取任务，因此在任务中再次调用run不会死锁。
+ fn不应抛出异常。
+
+**************************************/
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned workers);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void run(std::size_t n, const std::function<void(std::size_t)> &fn);
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    /// 进程内共享的线程池，首次使用时创建，工作线程数为硬件线程数减一
+    static ThreadPool &shared();
+
+private:
+    struct Batch;
+    void work();
+    static void drain(Batch &batch);
+
+    std::vector<std::thread> workers;
+    std::deque<std::shared_ptr<Batch>> queue;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping;
+};
+
+
+_JSON_END
+#endif // JSON_PARALLEL_H
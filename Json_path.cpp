@@ -0,0 +1,902 @@
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Json_error.h"
+#include "Json_type.h"
+#include "Json_parallel.h"
+#include "Json_path.h"
+
+_JSON_BEGIN
+
+namespace
+{
+
+/// 选择器的种类
+enum class Pick { name, wildcard, index, slice, filter };
+
+struct Selector
+{
+    Pick kind = Pick::wildcard;
+    std::string name;
+    std::size_t site = 0;                       /// name：查找缓存的下标（见PathEvaluator::Hop）
+    long long index = 0;
+    long long start = 0, end = 0, step = 1;     /// slice，has_start/has_end为false时按步长取默认值
+    bool has_start = false, has_end = false;
+    std::size_t filter = 0;                     /// filter：Plan::exprs中的下标
+};
+
+struct Segment
+{
+    bool descendant = false;                    /// ..：在结点自身与所有后代上应用选择器
+    std::vector<Selector> selectors;
+};
+
+/// 过滤器中单值路径的一级：名字或下标
+struct Step
+{
+    bool is_name = true;
+    std::string name;
+    std::size_t site = 0;
+    long long index = 0;
+};
+
+/// 比较的一边：字面量，或从@（当前元素）或$（根）出发的单值路径
+struct Operand
+{
+    enum Kind { literal, current, root } kind = literal;
+    Value value;
+    std::vector<Step> steps;
+};
+
+enum class Op { or_, and_, not_, exists, eq, ne, lt, le, gt, ge };
+
+/// 逻辑运算的a、b是Plan::exprs中的下标，存在性测试与比较的a、b是Plan::operands中的下标
+struct Expr
+{
+    Op op;
+    std::size_t a, b;
+};
+
+
+inline bool IsNameChar(char ch, bool first)
+{
+    unsigned char c = static_cast<unsigned char>(ch);
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c >= 0x80
+        || (!first && c >= '0' && c <= '9');
+}
+
+inline int HexDigit(char c)
+{
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+
+
+struct JsonPath::Plan
+{
+    std::vector<Segment> segments;
+    std::vector<Expr> exprs;
+    std::vector<Operand> operands;
+    std::size_t sites = 0;      /// 名字查找的处数，每个求值器为每一处保留一个Hop
+};
+
+
+
+namespace
+{
+
+/**************************************
+ PathParser：把表达式编译成JsonPath::Plan（递归下降）。
+ 段与段之间不允许空白，方括号与过滤器之内的空白被忽略；
+ 名字查找的每一处（选择器与过滤器路径中的名字）编号为一个site。
+
+**************************************/
+class PathParser
+{
+public:
+    PathParser(std::string_view s, JsonPath::Plan &plan): s(s), plan(plan), pos(0) {}
+
+    void parse();
+
+private:
+    [[noreturn]] void fail(std::size_t at) const;
+    char peek() const { return pos < s.size() ? s[pos] : '\0'; }
+    void skip_ws() { while(pos < s.size() && IsSpace(s[pos])) ++pos; }
+    /// 跳过空白之后匹配tok
+    bool eat(std::string_view tok);
+    /// 完整的单词（之后不是名字的字符）
+    bool keyword(std::string_view word);
+
+    void bracket(Segment &seg);
+    Selector selector();
+    Selector name_selector(std::string name);
+    std::string shorthand();
+    std::string quoted();
+    bool integer(long long &v);
+
+    std::size_t or_expr();
+    std::size_t and_expr();
+    std::size_t unary_expr();
+    std::size_t operand();
+    std::size_t add(Op op, std::size_t a, std::size_t b);
+
+    std::string_view s;
+    JsonPath::Plan &plan;
+    std::size_t pos;
+};
+
+
+void PathParser::fail(std::size_t at) const
+{
+    ParseResult r;
+    r.ok = false;
+    r.type = path_syntax;
+    r.offset = at;
+    r.line = 1;
+    r.column = at + 1;
+    throw JsonError(r);
+}
+
+
+bool PathParser::eat(std::string_view tok)
+{
+    skip_ws();
+    if(s.compare(pos, tok.size(), tok) != 0)
+        return false;
+    pos += tok.size();
+    return true;
+}
+
+
+bool PathParser::keyword(std::string_view word)
+{
+    if(s.compare(pos, word.size(), word) != 0)
+        return false;
+    std::size_t e = pos + word.size();
+    if(e < s.size() && IsNameChar(s[e], false))
+        return false;
+    pos = e;
+    return true;
+}
+
+
+void PathParser::parse()
+{
+    if(peek() != '$')
+        fail(0);
+    ++pos;
+
+    while(pos != s.size())
+    {
+        Segment seg;
+        if(s.compare(pos, 2, "..") == 0)
+        {
+            pos += 2;
+            seg.descendant = true;
+            if(peek() == '[')
+                bracket(seg);
+            else if(peek() == '*')
+            {
+                ++pos;
+                seg.selectors.emplace_back();
+            }
+            else
+                seg.selectors.push_back(name_selector(shorthand()));
+        }
+        else if(peek() == '.')
+        {
+            ++pos;
+            if(peek() == '*')
+            {
+                ++pos;
+                seg.selectors.emplace_back();
+            }
+            else
+                seg.selectors.push_back(name_selector(shorthand()));
+        }
+        else if(peek() == '[')
+            bracket(seg);
+        else
+            fail(pos);
+        plan.segments.push_back(std::move(seg));
+    }
+}
+
+
+/// [selector (, selector)*]
+void PathParser::bracket(Segment &seg)
+{
+    ++pos;
+    for(;;)
+    {
+        skip_ws();
+        seg.selectors.push_back(selector());
+        skip_ws();
+        if(peek() == ',')
+            ++pos;
+        else if(peek() == ']')
+        {
+            ++pos;
+            return;
+        }
+        else
+            fail(pos);
+    }
+}
+
+
+Selector PathParser::selector()
+{
+    Selector sel;
+    char c = peek();
+    if(c == '\'' || c == '\"')
+        return name_selector(quoted());
+    if(c == '*')
+    {
+        ++pos;
+        return sel;
+    }
+    if(c == '?')
+    {
+        ++pos;
+        sel.kind = Pick::filter;
+        sel.filter = or_expr();
+        return sel;
+    }
+
+    long long v = 0;
+    bool first = integer(v);
+    skip_ws();
+    if(peek() != ':')
+    {
+        if(!first)
+            fail(pos);
+        sel.kind = Pick::index;
+        sel.index = v;
+        return sel;
+    }
+
+    sel.kind = Pick::slice;
+    sel.has_start = first;
+    sel.start = v;
+    ++pos;
+    skip_ws();
+    sel.has_end = integer(sel.end);
+    skip_ws();
+    if(peek() == ':')
+    {
+        ++pos;
+        skip_ws();
+        if(!integer(sel.step))
+            sel.step = 1;
+    }
+    return sel;
+}
+
+
+Selector PathParser::name_selector(std::string name)
+{
+    Selector sel;
+    sel.kind = Pick::name;
+    sel.name = std::move(name);
+    sel.site = plan.sites++;
+    return sel;
+}
+
+
+/// .之后的名字：字母、_或非ASCII字节开头，之后还可以有数字
+std::string PathParser::shorthand()
+{
+    std::size_t b = pos;
+    while(pos < s.size() && IsNameChar(s[pos], pos == b))
+        ++pos;
+    if(pos == b)
+        fail(b);
+    return std::string(s.substr(b, pos - b));
+}
+
+
+/// 'name'或"name"：转义序列同Scanner::read_string（包括\u只保留低8位），另外允许\'
+std::string PathParser::quoted()
+{
+    const char q = s[pos];
+    const std::size_t b = pos++;
+    std::string out;
+    for(;;)
+    {
+        if(pos == s.size())
+            fail(b);
+        char c = s[pos++];
+        if(c == q)
+            return out;
+        if(IsCntrl(c))
+            fail(pos - 1);
+        if(c != '\\')
+        {
+            out.push_back(c);
+            continue;
+        }
+
+        if(pos == s.size())
+            fail(pos - 1);
+        switch(char e = s[pos++])
+        {
+        case '\'': case '\"': case '\\': case '/': out.push_back(e); break;
+        case 'b': out.push_back('\b'); break;
+        case 'f': out.push_back('\f'); break;
+        case 'n': out.push_back('\n'); break;
+        case 'r': out.push_back('\r'); break;
+        case 't': out.push_back('\t'); break;
+        case 'u':
+        {
+            unsigned n = 0;
+            for(int i = 0; i != 4; ++i)
+            {
+                int h = pos < s.size() ? HexDigit(s[pos]) : -1;
+                if(h < 0)
+                    fail(pos);
+                n = n * 16 + h;
+                ++pos;
+            }
+            out.push_back(static_cast<char>(n));
+        }
+        break;
+        default:
+            fail(pos - 2);
+        }
+    }
+}
+
+
+/// 可选的负号与十进制数字（绝对值不超过2^53，同RFC 9535），没有数字时返回false，pos不变
+bool PathParser::integer(long long &v)
+{
+    const std::size_t b = pos;
+    bool neg = peek() == '-';
+    if(neg)
+        ++pos;
+    if(peek() < '0' || peek() > '9')
+    {
+        pos = b;
+        return false;
+    }
+
+    long long n = 0;
+    while(peek() >= '0' && peek() <= '9')
+    {
+        n = n * 10 + (s[pos++] - '0');
+        if(n > (1LL << 53))
+            fail(b);
+    }
+    v = neg ? -n : n;
+    return true;
+}
+
+
+std::size_t PathParser::add(Op op, std::size_t a, std::size_t b)
+{
+    plan.exprs.push_back(Expr{op, a, b});
+    return plan.exprs.size() - 1;
+}
+
+
+std::size_t PathParser::or_expr()
+{
+    std::size_t e = and_expr();
+    while(eat("||"))
+    {
+        std::size_t r = and_expr();
+        e = add(Op::or_, e, r);
+    }
+    return e;
+}
+
+
+std::size_t PathParser::and_expr()
+{
+    std::size_t e = unary_expr();
+    while(eat("&&"))
+    {
+        std::size_t r = unary_expr();
+        e = add(Op::and_, e, r);
+    }
+    return e;
+}
+
+
+/// !unary、(or_expr)、operand op operand，或者单独的路径（存在性测试）
+std::size_t PathParser::unary_expr()
+{
+    skip_ws();
+    if(peek() == '!')
+    {
+        ++pos;
+        std::size_t e = unary_expr();
+        return add(Op::not_, e, 0);
+    }
+    if(peek() == '(')
+    {
+        ++pos;
+        std::size_t e = or_expr();
+        skip_ws();
+        if(peek() != ')')
+            fail(pos);
+        ++pos;
+        return e;
+    }
+
+    static const struct
+    {
+        const char *tok;
+        Op op;
+    } ops[] = {{"==", Op::eq}, {"!=", Op::ne}, {"<=", Op::le}, {">=", Op::ge}, {"<", Op::lt}, {">", Op::gt}};
+
+    skip_ws();
+    std::size_t at = pos;
+    std::size_t lhs = operand();
+    for(const auto &o : ops)
+        if(eat(o.tok))
+        {
+            std::size_t rhs = operand();
+            return add(o.op, lhs, rhs);
+        }
+
+    if(plan.operands[lhs].kind == Operand::literal)
+        fail(at);
+    return add(Op::exists, lhs, 0);
+}
+
+
+std::size_t PathParser::operand()
+{
+    skip_ws();
+    const std::size_t at = pos;
+    Operand o;
+    char c = peek();
+    if(c == '@' || c == '$')
+    {
+        o.kind = c == '@' ? Operand::current : Operand::root;
+        ++pos;
+        for(;;)
+        {
+            Step st;
+            if(peek() == '.')
+            {
+                ++pos;
+                st.name = shorthand();
+            }
+            else if(peek() == '[')
+            {
+                ++pos;
+                skip_ws();
+                if(peek() == '\'' || peek() == '\"')
+                    st.name = quoted();
+                else if(integer(st.index))
+                    st.is_name = false;
+                else
+                    fail(pos);
+                skip_ws();
+                if(peek() != ']')
+                    fail(pos);
+                ++pos;
+            }
+            else
+                break;
+
+            if(st.is_name)
+                st.site = plan.sites++;
+            o.steps.push_back(std::move(st));
+        }
+    }
+    else if(c == '\'' || c == '\"')
+        o.value = Value(quoted());
+    else if(c == '-' || (c >= '0' && c <= '9'))
+    {
+        while(pos < s.size() && ((s[pos] >= '0' && s[pos] <= '9') || s[pos] == '-' || s[pos] == '+'
+                                 || s[pos] == '.' || s[pos] == 'e' || s[pos] == 'E'))
+            ++pos;
+        try
+        {
+            o.value = Value::Parse(s.substr(at, pos - at));
+        }
+        catch(const JsonError &)
+        {
+            fail(at);
+        }
+    }
+    else if(keyword("true"))
+        o.value = true;
+    else if(keyword("false"))
+        o.value = false;
+    else if(keyword("null"))
+        o.value = Value();
+    else
+        fail(at);
+
+    plan.operands.push_back(std::move(o));
+    return plan.operands.size() - 1;
+}
+
+} // namespace
+
+
+
+/**************************************
+ PathEvaluator：JsonPath的求值，是各结点类的友元。
+ 1、按段深度优先：一个结点经过一段的各个选择器得到的每个子结点，立即继续求值之后的段，
+    因此结果直接按文档顺序追加到out中，不生成每一段的中间结果；递归深度不超过段数；
+ 2、..段用显式的栈先序遍历结点自身与所有后代中的Object/Array（标量没有可选取的子结点），
+    对每一个应用选择器，不受树的嵌套深度限制；
+ 3、每一处名字查找有一个Hop：压缩的Object在Shape与上一次相同时直接按下标取值（同to_columns）；
+    Object上的通配符与过滤器用for_each，压缩的Object也不生成map；
+ 4、有opt时，Array上的通配符与过滤器在元素个数×64不小于opt.min_bytes、且有多个线程时，
+    把元素分成线程数×tasks_per_thread块，每块由一个新的（顺序的）求值器对其中的元素求值之后的段，
+    最后按块的顺序拼接，因此结果与顺序求值完全相同；只有遇到的第一层大型Array被分块。
+ 求值不修改树，只读取（数字的转换结果等const缓存除外，见Json_alloc.h）。
+
+**************************************/
+class PathEvaluator
+{
+public:
+    static std::vector<const Value *> evaluate(const JsonPath::Plan &plan, const Value &root,
+                                               const ParallelOptions *opt);
+
+private:
+    PathEvaluator(const JsonPath::Plan &plan, const Value &root, const ParallelOptions *opt):
+        plan(plan), root(root), opt(opt), hops(plan.sites) {}
+
+    /// 上一个压缩Object的Shape与键的下标
+    struct Hop
+    {
+        const Shape *shape = nullptr;
+        std::size_t index = 0;
+    };
+
+    /// v经过第seg段及之后各段的结果追加到out中
+    void run(const Value &v, std::size_t seg, std::vector<const Value *> &out);
+    /// 对v应用第seg段中的选择器sel，选中的子结点继续求值第seg + 1段
+    void select(const Selector &sel, const Value &v, std::size_t seg, std::vector<const Value *> &out);
+    void descend(const Value &v, std::size_t seg, std::vector<const Value *> &out);
+    void slice(const Array &arr, const Selector &sel, std::size_t seg, std::vector<const Value *> &out);
+    /// Array上的通配符与过滤器，可能分块并行
+    void elements(const Array &arr, const Selector &sel, std::size_t seg, std::vector<const Value *> &out);
+
+    bool test(std::size_t expr, const Value &cur);
+    /// 路径不存在时返回nullptr
+    const Value *resolve(const Operand &o, const Value &cur);
+    const Value *member(const Object &obj, std::string_view key, std::size_t site);
+    static const Value *element(const Array &arr, long long i);
+    static bool equal(const Value *a, const Value *b);
+    static bool less(const Value *a, const Value *b);
+
+    const JsonPath::Plan &plan;
+    const Value &root;
+    const ParallelOptions *opt;
+    std::vector<Hop> hops;
+};
+
+
+std::vector<const Value *> PathEvaluator::evaluate(const JsonPath::Plan &plan, const Value &root,
+                                                   const ParallelOptions *opt)
+{
+    if(root.pbase == nullptr)
+        throw JsonError(deref_nullptr);
+    std::vector<const Value *> out;
+    PathEvaluator(plan, root, opt).run(root, 0, out);
+    return out;
+}
+
+
+void PathEvaluator::run(const Value &v, std::size_t seg, std::vector<const Value *> &out)
+{
+    if(seg == plan.segments.size())
+    {
+        out.push_back(&v);
+        return;
+    }
+
+    const Segment &s = plan.segments[seg];
+    if(s.descendant)
+        descend(v, seg, out);
+    else
+        for(const Selector &sel : s.selectors)
+            select(sel, v, seg, out);
+}
+
+
+void PathEvaluator::select(const Selector &sel, const Value &v, std::size_t seg,
+                           std::vector<const Value *> &out)
+{
+    const Value_base *p = v.pbase;
+    if(p == nullptr)
+        return;
+
+    if(p->Type() == object_type)
+    {
+        const Object &obj = *static_cast<const Object *>(p);
+        switch(sel.kind)
+        {
+        case Pick::name:
+            if(const Value *c = member(obj, sel.name, sel.site))
+                run(*c, seg + 1, out);
+            break;
+        case Pick::wildcard:
+            obj.for_each([&](const String &, const Value &c) { run(c, seg + 1, out); });
+            break;
+        case Pick::filter:
+            obj.for_each([&](const String &, const Value &c) {
+                if(test(sel.filter, c))
+                    run(c, seg + 1, out);
+            });
+            break;
+        default:
+            break;      /// 下标与切片只作用于Array
+        }
+    }
+    else if(p->Type() == array_type)
+    {
+        const Array &arr = *static_cast<const Array *>(p);
+        switch(sel.kind)
+        {
+        case Pick::index:
+            if(const Value *c = element(arr, sel.index))
+                run(*c, seg + 1, out);
+            break;
+        case Pick::slice:
+            slice(arr, sel, seg, out);
+            break;
+        case Pick::wildcard:
+        case Pick::filter:
+            elements(arr, sel, seg, out);
+            break;
+        default:
+            break;      /// 名字只作用于Object
+        }
+    }
+}
+
+
+void PathEvaluator::descend(const Value &v, std::size_t seg, std::vector<const Value *> &out)
+{
+    const Segment &s = plan.segments[seg];
+    std::vector<const Value *> stack(1, &v);
+    while(!stack.empty())
+    {
+        const Value *u = stack.back();
+        stack.pop_back();
+        for(const Selector &sel : s.selectors)
+            select(sel, *u, seg, out);
+
+        /// 选择器只选取Object/Array的子结点，因此只有容器需要入栈
+        auto push = [&](const Value &c) {
+            if(c.pbase && (c.pbase->Type() == object_type || c.pbase->Type() == array_type))
+                stack.push_back(&c);
+        };
+        const Value_base *p = u->pbase;
+        if(p == nullptr)
+            continue;
+        std::size_t mark = stack.size();
+        if(p->Type() == object_type)
+            static_cast<const Object *>(p)->for_each([&](const String &, const Value &c) { push(c); });
+        else if(p->Type() == array_type && !static_cast<const Array *>(p)->dense_values())
+            for(const Value &c : *static_cast<const Array *>(p))
+                push(c);
+        std::reverse(stack.begin() + mark, stack.end());
+    }
+}
+
+
+/// 边界按RFC 9535规范化：负数从末尾数起，再截断到[0, n]（步长为负时为[-1, n - 1]）
+void PathEvaluator::slice(const Array &arr, const Selector &sel, std::size_t seg,
+                          std::vector<const Value *> &out)
+{
+    const long long n = static_cast<long long>(arr.size());
+    const long long step = sel.step;
+    auto norm = [n](long long i) { return i >= 0 ? i : n + i; };
+
+    if(step > 0)
+    {
+        long long lo = sel.has_start ? std::min(std::max(norm(sel.start), 0LL), n) : 0;
+        long long hi = sel.has_end ? std::min(std::max(norm(sel.end), 0LL), n) : n;
+        for(long long i = lo; i < hi; i += step)
+            run(arr[static_cast<std::size_t>(i)], seg + 1, out);
+    }
+    else if(step < 0)
+    {
+        long long hi = sel.has_start ? std::min(std::max(norm(sel.start), -1LL), n - 1) : n - 1;
+        long long lo = sel.has_end ? std::min(std::max(norm(sel.end), -1LL), n - 1) : -1;
+        for(long long i = hi; i > lo; i += step)
+            run(arr[static_cast<std::size_t>(i)], seg + 1, out);
+    }
+}
+
+
+void PathEvaluator::elements(const Array &arr, const Selector &sel, std::size_t seg,
+                             std::vector<const Value *> &out)
+{
+    const Array::_Type &elems = arr.elements();
+    const std::size_t n = elems.size();
+    const bool filter = sel.kind == Pick::filter;
+
+    std::size_t parts = 1;
+    if(opt)
+    {
+        unsigned threads = opt->thread_count();
+        if(threads > 1 && n * 64 >= opt->min_bytes)
+            parts = std::min<std::size_t>(n, static_cast<std::size_t>(threads) * std::max(1u, opt->tasks_per_thread));
+    }
+
+    if(parts <= 1)
+    {
+        for(const Value &c : elems)
+            if(!filter || test(sel.filter, c))
+                run(c, seg + 1, out);
+        return;
+    }
+
+    std::vector<std::vector<const Value *>> results(parts);
+    std::vector<std::exception_ptr> errors(parts);
+    ThreadPool::shared().run(parts, [&](std::size_t k) {
+        std::size_t from = n * k / parts, to = n * (k + 1) / parts;
+        try
+        {
+            PathEvaluator sub(plan, root, nullptr);
+            for(std::size_t i = from; i != to; ++i)
+                if(!filter || sub.test(sel.filter, elems[i]))
+                    sub.run(elems[i], seg + 1, results[k]);
+        }
+        catch(...)
+        {
+            errors[k] = std::current_exception();
+        }
+    });
+
+    for(const auto &e : errors)
+        if(e)
+            std::rethrow_exception(e);
+
+    std::size_t total = out.size();
+    for(const auto &r : results)
+        total += r.size();
+    out.reserve(total);
+    for(const auto &r : results)
+        out.insert(out.end(), r.begin(), r.end());
+}
+
+
+bool PathEvaluator::test(std::size_t expr, const Value &cur)
+{
+    const Expr &e = plan.exprs[expr];
+    switch(e.op)
+    {
+    case Op::or_:    return test(e.a, cur) || test(e.b, cur);
+    case Op::and_:   return test(e.a, cur) && test(e.b, cur);
+    case Op::not_:   return !test(e.a, cur);
+    case Op::exists: return resolve(plan.operands[e.a], cur) != nullptr;
+    default:         break;
+    }
+
+    const Value *l = resolve(plan.operands[e.a], cur);
+    const Value *r = resolve(plan.operands[e.b], cur);
+    switch(e.op)
+    {
+    case Op::eq: return equal(l, r);
+    case Op::ne: return !equal(l, r);
+    case Op::lt: return less(l, r);
+    case Op::le: return less(l, r) || equal(l, r);
+    case Op::gt: return less(r, l);
+    default:     return less(r, l) || equal(l, r);
+    }
+}
+
+
+const Value *PathEvaluator::resolve(const Operand &o, const Value &cur)
+{
+    if(o.kind == Operand::literal)
+        return &o.value;
+
+    const Value *v = o.kind == Operand::current ? &cur : &root;
+    for(const Step &st : o.steps)
+    {
+        const Value_base *p = v->pbase;
+        if(p == nullptr)
+            return nullptr;
+        if(st.is_name)
+            v = p->Type() == object_type
+                ? member(*static_cast<const Object *>(p), st.name, st.site) : nullptr;
+        else
+            v = p->Type() == array_type
+                ? element(*static_cast<const Array *>(p), st.index) : nullptr;
+        if(v == nullptr)
+            return nullptr;
+    }
+    return v->pbase ? v : nullptr;
+}
+
+
+const Value *PathEvaluator::member(const Object &obj, std::string_view key, std::size_t site)
+{
+    if(obj.packed)
+    {
+        Hop &hop = hops[site];
+        if(hop.shape != obj.packed->shape)
+        {
+            hop.shape = obj.packed->shape;
+            hop.index = hop.shape->index(key);
+        }
+        return hop.index != Shape::npos ? obj.packed->slots() + hop.index : nullptr;
+    }
+
+    auto it = obj.obj.find(key);
+    return it != obj.obj.end() ? &it->second : nullptr;
+}
+
+
+const Value *PathEvaluator::element(const Array &arr, long long i)
+{
+    const long long n = static_cast<long long>(arr.size());
+    if(i < 0)
+        i += n;
+    return i >= 0 && i < n ? &arr[static_cast<std::size_t>(i)] : nullptr;
+}
+
+
+/// 不存在的路径只与不存在的路径相等，其余按Value的深比较（数字按数值）
+bool PathEvaluator::equal(const Value *a, const Value *b)
+{
+    if(a == nullptr || b == nullptr)
+        return a == b;
+    return *a == *b;
+}
+
+
+/// 只有两个数字（按数值）或两个字符串（按字节）之间有顺序
+bool PathEvaluator::less(const Value *a, const Value *b)
+{
+    if(a == nullptr || b == nullptr)
+        return false;
+    JsonType t = a->pbase->Type();
+    if(t != b->pbase->Type())
+        return false;
+    if(t == number_type)
+        return a->to_longdouble() < b->to_longdouble();
+    if(t == string_type)
+        return static_cast<const String *>(a->pbase)->str < static_cast<const String *>(b->pbase)->str;
+    return false;
+}
+
+
+
+JsonPath::JsonPath(std::string_view e): expr(e)
+{
+    /// 字面量总是来自::operator new，与编译时的memory_resource无关
+    ResourceScope heap(nullptr);
+    auto p = std::make_shared<Plan>();
+    PathParser(expr, *p).parse();
+    plan = std::move(p);
+}
+
+
+std::vector<const Value *> JsonPath::Select(const Value &root) const
+{
+    return PathEvaluator::evaluate(*plan, root, nullptr);
+}
+
+
+std::vector<const Value *> JsonPath::Select(const Value &root, const ParallelOptions &opt) const
+{
+    return PathEvaluator::evaluate(*plan, root, &opt);
+}
+
+
+_JSON_END
@@ -0,0 +1,62 @@
+#ifndef JSON_PATH_H
+#define JSON_PATH_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Json_type.h"
+#include "Json_parallel.h"
+
+_JSON_BEGIN
+
+/**************************************
+ JsonPath：编译好的JSONPath查询（RFC 9535的子集），编译一次，可以对任意多个文档求值。
+ 1、以$开头，之后依次是各段：.name、['name']、["name"]、.*、[*]、[n]（负数从末尾数起）、
+    [start:end:step]、[a,b,...]（各选择器结果的并集），以及在所有层的后代上选择的
+    ..name、..*、..[...]；
+ 2、过滤器[?expr]或[?(expr)]对Array的每个元素（Object的每个值）求值，保留结果为真的：
+    expr由比较（== != < <= > >=）、存在性测试、!、&&、||与括号组成，
+    比较的两边是字面量（数字、'字符串'、"字符串"、true、false、null）
+    或单值路径（@或$之后只有名字与下标的段，例如@.level、@['a b'][0]、$.limit）；
+ 3、比较的语义同RFC 9535：数字按数值、字符串按字节、Array与Object深比较；
+    < <= > >=只在两边同为数字或同为字符串时可能成立；不存在的路径只与不存在的路径相等；
+ 4、结果按文档顺序排列（Object按键的顺序），并集选中同一个结点时会重复出现。
+ 不支持函数扩展（length()、match()等）。表达式不合法时构造函数抛出JsonError(path_syntax)，
+ Offset()为出错处在表达式中的偏移。
+ JsonPath本身不可修改，多个线程可以同时用同一个JsonPath求值。
+
+ 用法：
+     json::JsonPath errors("$.events[?(@.level=='error')].msg");
+     for(const json::Value *msg : errors.Select(doc))
+         log(msg->to_string());
+
+**************************************/
+class JsonPath
+{
+public:
+    explicit JsonPath(std::string_view expr);
+
+    /// 所有匹配的结点，指向root中的Value而不是副本，在root被修改或销毁之前有效
+    std::vector<const Value *> Select(const Value &root) const;
+    /// 同上，大型Array上的通配符与过滤器分块并行求值（见PathEvaluator），结果与顺序求值完全相同
+    std::vector<const Value *> Select(const Value &root, const ParallelOptions &opt) const;
+
+    const std::string &expression() const { return expr; }
+
+    /// 编译的结果，定义在Json_path.cpp中
+    struct Plan;
+
+private:
+    std::string expr;
+    std::shared_ptr<const Plan> plan;
+};
+
+
+_JSON_END
+#endif // JSON_PATH_H
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Json_error.h"
+#include "Json_reader.h"
+#include "Json_type.h"
+#include "Json_projection.h"
+
+_JSON_BEGIN
+
+
+Projection::Projection(std::initializer_list<std::string_view> paths): nodes(1)
+{
+    for(auto path : paths)
+        add(path);
+}
+
+
+/// 按「.」切分路径，「\.」与「\\」分别表示键中的「.」与「\」
+Projection &Projection::add(std::string_view path)
+{
+    std::vector<std::string> keys(1);
+    for(std::size_t i = 0; i != path.size(); ++i)
+    {
+        if(path[i] == '\\' && i + 1 != path.size())
+            keys.back() += path[++i];
+        else if(path[i] == '.')
+            keys.emplace_back();
+        else
+            keys.back() += path[i];
+    }
+    if(path.empty())
+        keys.clear();
+    return add(keys);
+}
+
+
+/**************************************
+ Projection::add算法说明：
+ 从根结点开始逐级查找或插入子结点（children保持按键排序，供find二分查找），
+ 最后一级标记为whole；途中遇到已经是whole的结点时，新路径被它包含，不再深入。
+ keys为空时保留整个文档。
+
+**************************************/
+Projection &Projection::add(const std::vector<std::string> &keys)
+{
+    std::size_t n = 0;
+    for(const auto &key : keys)
+    {
+        if(nodes[n].whole)
+            return *this;
+
+        auto &children = nodes[n].children;
+        auto it = std::lower_bound(children.begin(), children.end(), key,
+            [](const std::pair<std::string, std::size_t> &c, const std::string &k) { return c.first < k; });
+        if(it != children.end() && it->first == key)
+        {
+            n = it->second;
+            continue;
+        }
+
+        std::size_t child = nodes.size();
+        children.emplace(it, key, child);
+        nodes.emplace_back();
+        n = child;
+    }
+    nodes[n].whole = true;
+    nodes[n].children.clear();
+    return *this;
+}
+
+
+std::size_t Projection::Node::find(std::string_view key) const
+{
+    auto it = std::lower_bound(children.begin(), children.end(), key,
+        [](const std::pair<std::string, std::size_t> &c, std::string_view k) { return c.first < k; });
+    return it != children.end() && it->first == key ? it->second : 0;
+}
+
+
+
+ParseResult Value::TryParse(std::string_view js, Value &out, const Projection &proj) noexcept
+{
+    Reader reader(js.data(), js.data() + js.size());
+    if(reader.parse_document(out, proj))
+        return ParseResult();
+    return reader.result();
+}
+
+
+Value Value::Parse(std::string_view js, const Projection &proj)
+{
+    Value ret(nullptr, adopt_t());
+    ParseResult r = TryParse(js, ret, proj);
+    if(!r)
+        throw JsonError(r);
+    return ret;
+}
+
+
+_JSON_END
@@ -0,0 +1,57 @@
+#ifndef JSON_PROJECTION_H
+#define JSON_PROJECTION_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+_JSON_BEGIN
+
+/**************************************
+ Projection：Value::Parse(text, proj)时要保留的字段，由一组路径编译成一棵前缀树。
+ 1、路径是以「.」分隔的键，例如"user.name"；键中的「.」与「\」写作「\.」与「\\」；
+ 2、路径的终点保留整个值；中间的键只保留该Object中被选中的成员，
+    遇到Array时对每个元素分别投影（例如"statuses.id"选中每条推文的id）；
+ 3、中间的键遇到标量时该值被省略：Object中省略这个成员，Array中省略这个元素；
+ 4、一条路径是另一条的前缀时，较短的路径保留整个值。
+ 未选中的成员不构造String/Number/Value，只用Scanner::skip_value做结构检查地跳过，
+ 因此其中诸如缺少逗号之类的错误不会被发现。
+
+**************************************/
+class Projection
+{
+public:
+    Projection(): nodes(1) {}
+    Projection(std::initializer_list<std::string_view> paths);
+
+    /// 添加一条以「.」分隔的路径
+    Projection &add(std::string_view path);
+    /// 添加一条由各级键组成的路径（键中的「.」没有特殊含义）
+    Projection &add(const std::vector<std::string> &keys);
+
+private:
+    friend class Reader;
+
+    struct Node
+    {
+        bool whole = false;     /// 保留整个值
+        /// 按键排序的子结点（键, nodes中的下标）
+        std::vector<std::pair<std::string, std::size_t>> children;
+
+        /// 没有该键时返回0（0是根结点，不可能是子结点）
+        std::size_t find(std::string_view key) const;
+    };
+
+    std::vector<Node> nodes;    /// nodes[0]是根结点
+};
+
+
+_JSON_END
+#endif // JSON_PROJECTION_H
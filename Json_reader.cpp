@@ -0,0 +1,1041 @@
+#include <string>
+#include <utility>
+#include <vector>
+#include "Json_error.h"
+#include "Json_string.h"
+#include "Json_scanner.h"
+#include "Json_reader.h"
+#include "Json_projection.h"
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+
+ParseResult Reader::make_result(const char *begin, const char *errpos, ErrorType t)
+{
+    ParseResult r;
+    r.ok = false;
+    r.type = t;
+    r.offset = errpos - begin;
+    r.line = 1;
+
+    const char *lineBegin = begin;
+    for(const char *b = begin; b != errpos; ++b)
+    {
+        if(*b == '\n')
+        {
+            ++r.line;
+            lineBegin = b + 1;
+        }
+    }
+    r.column = errpos - lineBegin + 1;
+    return r;
+}
+
+
+ParseResult Reader::result() const
+{
+    const char *p = scanner.error_position();
+    return make_result(scanner.begin(), p ? p : scanner.position(), scanner.error());
+}
+
+
+
+bool Reader::parse_document(Value &out)
+{
+    scanner.skip_ws();
+    if(scanner.eof())
+        return scanner.fail(error_empty);
+
+    Value_base *node = nullptr;
+    if(!parse_node(node))
+        return false;
+
+    scanner.skip_ws();
+    if(!scanner.eof())
+    {
+        delete node;
+        switch(scanner.peek())
+        {
+        case ']': return scanner.fail(error_brack);
+        case '}': return scanner.fail(error_brace);
+        default:  return scanner.fail(error_comma);
+        }
+    }
+
+    delete out.pbase;
+    out.pbase = node;
+    return true;
+}
+
+
+bool Reader::parse_value(Value &out)
+{
+    scanner.skip_ws();
+    if(scanner.eof())
+        return scanner.fail(error_empty);
+
+    Value_base *node = nullptr;
+    if(!parse_node(node))
+        return false;
+
+    delete out.pbase;
+    out.pbase = node;
+    return true;
+}
+
+
+
+/**************************************
+ Reader::parse_node算法说明：
+ 根据第一个字符决定值的类型：
+ 1、「{」解析Object，「[」解析Array，「"」解析String；
+ 2、「t」「f」「n」分别要求是true、false、null，否则返回error_literal；
+ 3、孤立的「]」「}」「,」「:」分别返回error_brack、error_brace、error_comma、error_pair；
+ 4、其余情况按Number解析，不符合数字文法时返回error_badnum。
+ 失败时已分配的结点全部释放，node保持不变。
+
+**************************************/
+bool Reader::parse_node(Value_base *&node)
+{
+    switch(scanner.peek())
+    {
+    case '{':
+    {
+        Object *obj = new Object();
+        if(!parse_container(obj))
+        {
+            delete obj;
+            return false;
+        }
+        node = obj;
+        return true;
+    }
+
+    case '[':
+    {
+        Array *arr = new Array();
+        if(!parse_container(arr))
+        {
+            delete arr;
+            return false;
+        }
+        node = arr;
+        return true;
+    }
+
+    case '\"':
+    {
+        String *str = new String();
+        if(!scanner.read_string(str->str))
+        {
+            delete str;
+            return false;
+        }
+        node = str;
+        return true;
+    }
+
+    case 't':
+        if(!scanner.read_literal("true", 4))
+            return false;
+        node = new True();
+        return true;
+
+    case 'f':
+        if(!scanner.read_literal("false", 5))
+            return false;
+        node = new False();
+        return true;
+
+    case 'n':
+        if(!scanner.read_literal("null", 4))
+            return false;
+        node = new Null();
+        return true;
+
+    case ']':
+        return scanner.fail(error_brack);
+    case '}':
+        return scanner.fail(error_brace);
+    case ',':
+        return scanner.fail(error_comma);
+    case ':':
+        return scanner.fail(error_pair);
+
+    default:
+        return parse_number(node);
+    }
+}
+
+
+/**************************************
+ Reader::parse_container算法说明：
+ frames中的每一项是一层尚未闭合的容器，栈顶是正在解析的一层：
+ 1、刚读到左括号时，紧跟右括号则为空容器；
+    读完一个值之后是「,」则继续，是右括号则该层结束；
+    Object中到达末尾返回error_brace，遇到「]」返回error_mismatch，其余返回error_comma；
+    Array中到达末尾返回error_brack，遇到「}」返回error_mismatch，其余返回error_comma；
+ 2、Object读取“键 : 值”（见member_head），Array读取元素的开头（见element_head）；
+ 3、值是「{」或「[」时新建容器压入栈中（连同它的键），接着解析它的元素；
+    其余的值由parse_node解析后立即插入栈顶的容器；
+ 4、一层结束时弹出，插入下一层（Object中重复的键只保留第一次出现的值，与std::map::insert一致），
+    弹出的是root时解析完成。
+ 容器直到闭合时才挂到上一层，失败时栈中root以上的各层分别释放。
+ 与递归下降的文法、错误类型与位置完全相同，但嵌套深度只受内存的限制。
+
+**************************************/
+bool Reader::parse_container(Value_base *root)
+{
+    const std::size_t base = frames.size();
+    frames.emplace_back(root, root->Type() == object_type);
+    scanner.seek(scanner.position() + 1);
+
+    /// 游标位于值的第一个字符上：容器压入栈中（连同Object成员的键），返回true；其余的值返回false
+    auto open_child = [this](String *key) {
+        char c = scanner.peek();
+        if(c != '{' && c != '[')
+            return false;
+        Value_base *child = c == '{' ? static_cast<Value_base *>(new Object())
+                                     : static_cast<Value_base *>(new Array());
+        frames.emplace_back(child, c == '{');
+        if(key)
+            frames.back().key.str.swap(key->str);
+        scanner.seek(scanner.position() + 1);
+        return true;
+    };
+
+    bool open = true;       /// 栈顶的容器刚读到左括号
+    for(;;)
+    {
+        Frame &top = frames.back();
+        char close = top.object ? '}' : ']';
+        bool closed = false;
+        if(open)
+            closed = scanner.consume(close);
+        else if(!scanner.consume(','))
+        {
+            if(!scanner.consume(close))
+            {
+                if(scanner.eof())
+                    scanner.fail(top.object ? error_brace : error_brack);
+                else
+                    scanner.fail(scanner.peek() == (top.object ? ']' : '}') ? error_mismatch
+                                                                           : error_comma);
+                break;
+            }
+            closed = true;
+        }
+
+        if(closed)
+        {
+            if(frames.size() == base + 1)
+            {
+                frames.pop_back();
+                return true;
+            }
+            Frame &parent = frames[frames.size() - 2];
+            if(parent.object)
+                insert_member(*static_cast<Object *>(parent.node), std::move(top.key), top.node);
+            else
+                static_cast<Array *>(parent.node)->arr.push_back(Value(top.node, Value::adopt_t()));
+            frames.pop_back();
+            open = false;
+            continue;
+        }
+
+        open = false;
+        Value_base *node = nullptr;
+        if(top.object)
+        {
+            String key;
+            if(!member_head(key))
+                break;
+            if((open = open_child(&key)))
+                continue;
+            if(!parse_node(node))
+                break;
+            insert_member(*static_cast<Object *>(top.node), std::move(key), node);
+        }
+        else
+        {
+            bool taken = false;
+            if(!element_head(*static_cast<Array *>(top.node), taken))
+                break;
+            if(taken)
+                continue;
+            if((open = open_child(nullptr)))
+                continue;
+            if(!parse_node(node))
+                break;
+            static_cast<Array *>(top.node)->arr.push_back(Value(node, Value::adopt_t()));
+        }
+    }
+
+    for(; frames.size() != base + 1; frames.pop_back())
+        delete frames.back().node;
+    frames.pop_back();
+    return false;
+}
+
+
+/**************************************
+ Reader::member_head算法说明：
+ 1、键必须是字符串，否则返回error_pair（逗号后紧跟「}」时返回error_comma）；
+ 2、键后必须是「:」，否则返回error_pair；
+ 3、值缺失时返回error_pair，到达末尾返回error_brace。
+
+**************************************/
+bool Reader::member_head(String &key)
+{
+    scanner.skip_ws();
+    if(scanner.peek() != '\"')
+    {
+        if(scanner.eof())
+            return scanner.fail(error_brace);
+        return scanner.fail(scanner.peek() == '}' ? error_comma : error_pair);
+    }
+
+    if(!scanner.read_string(key.str))
+        return false;
+
+    if(!scanner.consume(':'))
+        return scanner.fail(scanner.eof() ? error_brace : error_pair);
+
+    scanner.skip_ws();
+    if(scanner.eof())
+        return scanner.fail(error_brace);
+    if(scanner.peek() == '}' || scanner.peek() == ',')
+        return scanner.fail(error_pair);
+    return true;
+}
+
+
+void Reader::insert_member(Object &obj, String &&key, Value_base *node)
+{
+    auto it = obj.obj.lower_bound(key);
+    if(it == obj.obj.end() || key < it->first)
+        obj.obj.emplace_hint(it, std::move(key), Value(node, Value::adopt_t()));
+    else
+        delete node;
+}
+
+
+bool Reader::parse_member(Object &obj)
+{
+    String key;
+    if(!member_head(key))
+        return false;
+
+    Value_base *node = nullptr;
+    if(!parse_node(node))
+        return false;
+    insert_member(obj, std::move(key), node);
+    return true;
+}
+
+
+/**************************************
+ Reader::element_head算法说明：
+ 值的位置上到达末尾返回error_brack，出现「,」或「]」返回error_comma；
+ 1、Array中还没有元素、或者已经是紧凑形式时，数字先尝试追加到Array::Dense中，
+    第一个数字能够紧凑保存时才创建Dense；
+ 2、Dense::push失败（词素不能由数值原样生成）或者遇到其他类型的元素时，
+    调用unpack把已有的元素转换回Number，之后按普通的Array解析；
+ 3、检查小数需要一次from_chars与一次to_chars：以「%.17g」等格式输出的文档中
+    小数几乎都不能紧凑保存，连续dense_give_up个Array的第一个小数失败之后，
+    本次解析不再检查以小数开头的Array（整数的检查代价很小，总是进行）。
+ parse_elements分块解析时每一块各自决定，由调用者合并（见Value::TryParse的并行版本）。
+
+**************************************/
+bool Reader::element_head(Array &arr, bool &taken)
+{
+    scanner.skip_ws();
+    if(scanner.eof())
+        return scanner.fail(error_brack);
+    if(scanner.peek() == ',' || scanner.peek() == ']')
+        return scanner.fail(error_comma);
+
+    char c = scanner.peek();
+    if((arr.dense || arr.arr.empty()) && (c == '-' || (c >= '0' && c <= '9')))
+    {
+        SubString lexeme(nullptr, nullptr);
+        bool integral = true;
+        if(!scanner.read_number(lexeme, integral))
+            return false;
+        taken = true;
+        if(arr.dense == nullptr)
+        {
+            /// 第一个元素先在栈上检查，不能紧凑保存时不分配Dense
+            Array::Dense first;
+            if((integral || float_misses < dense_give_up) && first.push(lexeme, integral))
+            {
+                if(!integral)
+                    float_misses = 0;
+                arr.dense = new Array::Dense;
+                arr.dense->floating = first.floating;
+                arr.dense->i64.swap(first.i64);
+                arr.dense->f64.swap(first.f64);
+                return true;
+            }
+            if(!integral && float_misses < dense_give_up)
+                ++float_misses;
+        }
+        else if(arr.dense->push(lexeme, integral))
+            return true;
+        else
+            arr.unpack();
+
+        arr.arr.push_back(Value(new Number(std::string_view(lexeme.first, lexeme.length()),
+                                           integral, Number::lexeme_t()), Value::adopt_t()));
+        return true;
+    }
+
+    if(arr.dense)
+        arr.unpack();
+    return true;
+}
+
+
+bool Reader::parse_element(Array &arr)
+{
+    bool taken = false;
+    if(!element_head(arr, taken))
+        return false;
+    if(taken)
+        return true;
+
+    Value_base *node = nullptr;
+    if(!parse_node(node))
+        return false;
+    arr.arr.push_back(Value(node, Value::adopt_t()));
+    return true;
+}
+
+
+
+/**************************************
+ 重用结点的解析（Value::ParseInto）算法说明：
+ 与parse_node等函数的文法、错误类型与位置完全相同，区别只在于结点从哪里来：
+ 1、reuse_node：原结点的类型与下一个值相同时就地解析，
+    String清空后重用缓冲区，Number重用词素空间，true/false/null保持原结点；
+    类型不同（或原结点为空）时按parse_node新建，再释放原结点；
+    嵌套超过reuse_depth_limit层的容器也按parse_node新建，因此递归深度有上限；
+ 2、reuse_object：先把原有的成员全部移到old中，每读到一个键：
+    （2.1）已经出现过的键（重复键）按parse_node解析后丢弃，与解析时保留第一次出现的一致；
+    （2.2）old中有同名的键时，用extract取出该结点（键与值都不重新分配），
+          在它的值上递归重用，再插回；
+    （2.3）否则新建成员；
+    最后old中剩下的（新文档中没有的）成员随old一起释放；
+ 3、reuse_array：前size()个元素就地重用，多出的元素新建，最后删除多余的元素，容量保持不变。
+ 新建的结点使用被重用（或被替换）的结点的memory_resource。
+ 容器的缓存在解析前清除。失败时out仍然是一棵有效的树，但内容不确定。
+
+**************************************/
+bool Reader::parse_document_into(Value &out)
+{
+    scanner.skip_ws();
+    if(scanner.eof())
+        return scanner.fail(error_empty);
+
+    if(!reuse_node(out.pbase))
+        return false;
+
+    scanner.skip_ws();
+    if(!scanner.eof())
+    {
+        switch(scanner.peek())
+        {
+        case ']': return scanner.fail(error_brack);
+        case '}': return scanner.fail(error_brace);
+        default:  return scanner.fail(error_comma);
+        }
+    }
+    return true;
+}
+
+
+bool Reader::parse_value_into(Value &out)
+{
+    scanner.skip_ws();
+    if(scanner.eof())
+        return scanner.fail(error_empty);
+    return reuse_node(out.pbase);
+}
+
+
+bool Reader::reuse_node(Value_base *&node)
+{
+    ResourceScope scope(node ? node_resource(node) : current_resource());
+    JsonType t = node ? node->Type() : null_type;
+    switch(scanner.peek())
+    {
+    case '{':
+        if(node && t == object_type && reuse_depth != reuse_depth_limit)
+        {
+            ++reuse_depth;
+            bool ok = reuse_object(*static_cast<Object *>(node));
+            --reuse_depth;
+            return ok;
+        }
+        break;
+
+    case '[':
+        if(node && t == array_type && reuse_depth != reuse_depth_limit)
+        {
+            ++reuse_depth;
+            bool ok = reuse_array(*static_cast<Array *>(node));
+            --reuse_depth;
+            return ok;
+        }
+        break;
+
+    case '\"':
+        if(node && t == string_type)
+        {
+            NodeString &str = static_cast<String *>(node)->str;
+            str.clear();
+            return scanner.read_string(str);
+        }
+        break;
+
+    case 't':
+        if(node && t == true_type)
+            return scanner.read_literal("true", 4);
+        break;
+
+    case 'f':
+        if(node && t == false_type)
+            return scanner.read_literal("false", 5);
+        break;
+
+    case 'n':
+        if(node && t == null_type)
+            return scanner.read_literal("null", 4);
+        break;
+
+    case ']': case '}': case ',': case ':':
+        break;
+
+    default:
+        if(node && t == number_type)
+        {
+            SubString lexeme(nullptr, nullptr);
+            bool integral = true;
+            if(!scanner.read_number(lexeme, integral))
+                return false;
+            static_cast<Number *>(node)->assign_lexeme(
+                std::string_view(lexeme.first, lexeme.length()), integral);
+            return true;
+        }
+        break;
+    }
+
+    Value_base *fresh = nullptr;
+    if(!parse_node(fresh))
+        return false;
+    delete node;
+    node = fresh;
+    return true;
+}
+
+
+bool Reader::reuse_object(Object &obj)
+{
+    obj.touch();
+    Object::_Type old(obj.obj.get_allocator());
+    old.swap(obj.obj);
+
+    scanner.seek(scanner.position() + 1);
+    if(scanner.consume('}'))
+        return true;
+
+    for(;;)
+    {
+        if(!reuse_member(obj, old))
+            return false;
+
+        if(scanner.consume(','))
+            continue;
+        if(scanner.consume('}'))
+            return true;
+
+        if(scanner.eof())
+            return scanner.fail(error_brace);
+        return scanner.fail(scanner.peek() == ']' ? error_mismatch : error_comma);
+    }
+}
+
+
+bool Reader::reuse_member(Object &obj, Object::_Type &old)
+{
+    scanner.skip_ws();
+    if(scanner.peek() != '\"')
+    {
+        if(scanner.eof())
+            return scanner.fail(error_brace);
+        return scanner.fail(scanner.peek() == '}' ? error_comma : error_pair);
+    }
+
+    /// 键先读入线程内复用的缓冲区，只有新建成员时才构造String；
+    /// 递归的reuse_node会覆盖该缓冲区，因此k只在递归之前使用
+    thread_local std::string key;
+    key.clear();
+    if(!scanner.read_string(key))
+        return false;
+
+    if(!scanner.consume(':'))
+        return scanner.fail(scanner.eof() ? error_brace : error_pair);
+
+    scanner.skip_ws();
+    if(scanner.eof())
+        return scanner.fail(error_brace);
+    if(scanner.peek() == '}' || scanner.peek() == ',')
+        return scanner.fail(error_pair);
+
+    std::string_view k(key);
+    auto pos = obj.obj.lower_bound(k);
+    if(pos != obj.obj.end() && !(k < pos->first))
+    {
+        Value_base *node = nullptr;
+        if(!parse_node(node))
+            return false;
+        delete node;
+        return true;
+    }
+
+    auto it = old.find(k);
+    if(it != old.end())
+    {
+        auto nh = old.extract(it);
+        if(!reuse_node(nh.mapped().pbase))
+            return false;
+        obj.obj.insert(pos, std::move(nh));
+        return true;
+    }
+
+    Value_base *node = nullptr;
+    if(!parse_node(node))
+        return false;
+    obj.obj.emplace_hint(pos, String(k), Value(node, Value::adopt_t()));
+    return true;
+}
+
+
+bool Reader::reuse_array(Array &arr)
+{
+    /// 紧凑的Array清空之后重新解析，保留数组的容量；遇到非数字元素时由parse_element解除
+    if(Array::Dense *d = arr.dense)
+    {
+        arr.cache.reset();
+        if(arr.indexes)
+            arr.invalidate_indexes();
+        delete d->view.exchange(nullptr, std::memory_order_acq_rel);
+        d->exposed = false;
+        d->i64.clear();
+        d->f64.clear();
+        d->floating = false;
+        return parse_container(&arr);
+    }
+
+    arr.touch();
+    Array::size_type i = 0;
+
+    scanner.seek(scanner.position() + 1);
+    if(!scanner.consume(']'))
+    {
+        for(;;)
+        {
+            if(!reuse_element(arr, i))
+                return false;
+
+            if(scanner.consume(','))
+                continue;
+            if(scanner.consume(']'))
+                break;
+
+            if(scanner.eof())
+                return scanner.fail(error_brack);
+            return scanner.fail(scanner.peek() == '}' ? error_mismatch : error_comma);
+        }
+    }
+
+    arr.arr.erase(arr.arr.begin() + i, arr.arr.end());
+    return true;
+}
+
+
+bool Reader::reuse_element(Array &arr, Array::size_type &i)
+{
+    scanner.skip_ws();
+    if(scanner.eof())
+        return scanner.fail(error_brack);
+    if(scanner.peek() == ',' || scanner.peek() == ']')
+        return scanner.fail(error_comma);
+
+    if(i < arr.arr.size())
+    {
+        if(!reuse_node(arr.arr[i].pbase))
+            return false;
+    }
+    else
+    {
+        Value_base *node = nullptr;
+        if(!parse_node(node))
+            return false;
+        arr.arr.push_back(Value(node, Value::adopt_t()));
+    }
+    ++i;
+    return true;
+}
+
+
+/**************************************
+ 投影解析（Value::Parse(text, Projection)）算法说明：
+ 文法、错误类型与位置都与parse_node等函数相同，区别在于：
+ 1、project_node：proj中该结点保留整个值时按parse_node解析；
+    否则Object只保留选中的成员，Array对每个元素分别投影，标量跳过并省略（node为nullptr）；
+ 2、project_member：先用skip_string跳过键，键中没有转义时直接用原文查找子结点，
+    不构造String；未选中的成员用skip_value只做结构检查地跳过它的值；
+ 3、选中的成员被省略时不插入，重复的键同样只保留第一次插入的值；
+ 4、只有选中的Object成员才递归，深度不超过proj的层数；直接嵌套的Array在project_array中循环处理，
+    保留整个值的部分由parse_node解析，因此任意深的输入都不会耗尽调用栈。
+
+**************************************/
+bool Reader::parse_document(Value &out, const Projection &proj)
+{
+    scanner.skip_ws();
+    if(scanner.eof())
+        return scanner.fail(error_empty);
+
+    Value_base *node = nullptr;
+    if(scanner.peek() == '{' || scanner.peek() == '[' ? !project_node(node, proj, 0)
+                                                      : !parse_node(node))
+        return false;
+
+    scanner.skip_ws();
+    if(!scanner.eof())
+    {
+        delete node;
+        switch(scanner.peek())
+        {
+        case ']': return scanner.fail(error_brack);
+        case '}': return scanner.fail(error_brace);
+        default:  return scanner.fail(error_comma);
+        }
+    }
+
+    delete out.pbase;
+    out.pbase = node;
+    return true;
+}
+
+
+bool Reader::project_node(Value_base *&node, const Projection &proj, std::size_t n)
+{
+    if(proj.nodes[n].whole)
+        return parse_node(node);
+
+    switch(scanner.peek())
+    {
+    case '{':
+    {
+        Object *obj = new Object();
+        if(!project_object(*obj, proj, n))
+        {
+            delete obj;
+            return false;
+        }
+        node = obj;
+        return true;
+    }
+
+    case '[':
+    {
+        Array *arr = new Array();
+        if(!project_array(*arr, proj, n))
+        {
+            delete arr;
+            return false;
+        }
+        node = arr;
+        return true;
+    }
+
+    case ']':
+        return scanner.fail(error_brack);
+    case '}':
+        return scanner.fail(error_brace);
+    case ',':
+        return scanner.fail(error_comma);
+    case ':':
+        return scanner.fail(error_pair);
+
+    default:
+        return scanner.skip_value();
+    }
+}
+
+
+bool Reader::project_object(Object &obj, const Projection &proj, std::size_t n)
+{
+    scanner.seek(scanner.position() + 1);
+    if(scanner.consume('}'))
+        return true;
+
+    for(;;)
+    {
+        if(!project_member(obj, proj, n))
+            return false;
+
+        if(scanner.consume(','))
+            continue;
+        if(scanner.consume('}'))
+            return true;
+
+        if(scanner.eof())
+            return scanner.fail(error_brace);
+        return scanner.fail(scanner.peek() == ']' ? error_mismatch : error_comma);
+    }
+}
+
+
+bool Reader::project_member(Object &obj, const Projection &proj, std::size_t n)
+{
+    scanner.skip_ws();
+    if(scanner.peek() != '\"')
+    {
+        if(scanner.eof())
+            return scanner.fail(error_brace);
+        return scanner.fail(scanner.peek() == '}' ? error_comma : error_pair);
+    }
+
+    const char *quote = scanner.position();
+    if(!scanner.skip_string())
+        return false;
+    std::string_view key(quote + 1, scanner.position() - quote - 2);
+    std::string unescaped;
+    if(key.find('\\') != std::string_view::npos)
+    {
+        scanner.seek(quote);
+        if(!scanner.read_string(unescaped))
+            return false;
+        key = unescaped;
+    }
+
+    if(!scanner.consume(':'))
+        return scanner.fail(scanner.eof() ? error_brace : error_pair);
+
+    scanner.skip_ws();
+    if(scanner.eof())
+        return scanner.fail(error_brace);
+    if(scanner.peek() == '}' || scanner.peek() == ',')
+        return scanner.fail(error_pair);
+
+    std::size_t child = proj.nodes[n].find(key);
+    if(child == 0)
+        return scanner.skip_value();
+
+    Value_base *node = nullptr;
+    if(!project_node(node, proj, child))
+        return false;
+    if(node == nullptr)
+        return true;
+
+    auto it = obj.obj.lower_bound(key);
+    if(it == obj.obj.end() || key < it->first)
+    {
+        String k;
+        k.str.assign(key.data(), key.size());
+        obj.obj.emplace_hint(it, std::move(k), Value(node, Value::adopt_t()));
+    }
+    else
+        delete node;
+    return true;
+}
+
+
+bool Reader::project_array(Array &arr, const Projection &proj, std::size_t n)
+{
+    /// 直接嵌套的Array都按同一个n投影，且总是保留（即使为空），
+    /// 因此打开时就挂到上一层，nested中只记录尚未闭合的各层，不需要递归
+    std::vector<Array *> nested{&arr};
+    scanner.seek(scanner.position() + 1);
+
+    bool open = true;
+    for(;;)
+    {
+        bool closed = false;
+        if(open)
+            closed = scanner.consume(']');
+        else if(!scanner.consume(','))
+        {
+            if(!scanner.consume(']'))
+            {
+                if(scanner.eof())
+                    return scanner.fail(error_brack);
+                return scanner.fail(scanner.peek() == '}' ? error_mismatch : error_comma);
+            }
+            closed = true;
+        }
+
+        if(closed)
+        {
+            nested.pop_back();
+            if(nested.empty())
+                return true;
+            open = false;
+            continue;
+        }
+
+        scanner.skip_ws();
+        if(scanner.eof())
+            return scanner.fail(error_brack);
+        if(scanner.peek() == ',' || scanner.peek() == ']')
+            return scanner.fail(error_comma);
+
+        Array::_Type &elems = nested.back()->arr;
+        if(scanner.peek() == '[')
+        {
+            elems.push_back(Value(new Array(), Value::adopt_t()));
+            nested.push_back(static_cast<Array *>(elems.back().pbase));
+            scanner.seek(scanner.position() + 1);
+            open = true;
+            continue;
+        }
+
+        Value_base *node = nullptr;
+        if(!project_node(node, proj, n))
+            return false;
+        if(node)
+            elems.push_back(Value(node, Value::adopt_t()));
+        open = false;
+    }
+}
+
+
+
+/**************************************
+ Reader::parse_elements/parse_members算法说明（供并行解析使用）：
+ 从当前位置起解析“元素 (, 元素)*”，直到游标恰好到达stop。
+ stop是预扫描找到的顶层逗号或闭合括号的位置，
+ 若某个元素越过了stop，说明结构与预扫描的结果不符，返回error_mismatch。
+
+**************************************/
+bool Reader::parse_elements(Array &arr, const char *stop)
+{
+    for(;;)
+    {
+        if(!parse_element(arr))
+            return false;
+        scanner.skip_ws();
+        if(scanner.position() == stop)
+            return true;
+        if(scanner.position() > stop)
+            return scanner.fail(error_mismatch);
+        if(!scanner.consume(','))
+            return scanner.fail(scanner.peek() == '}' ? error_mismatch : error_comma);
+    }
+}
+
+
+bool Reader::parse_members(Object &obj, const char *stop)
+{
+    for(;;)
+    {
+        if(!parse_member(obj))
+            return false;
+        scanner.skip_ws();
+        if(scanner.position() == stop)
+            return true;
+        if(scanner.position() > stop)
+            return scanner.fail(error_mismatch);
+        if(!scanner.consume(','))
+            return scanner.fail(scanner.peek() == ']' ? error_mismatch : error_comma);
+    }
+}
+
+
+/**************************************
+ Reader::parse_number算法说明：
+ 由Scanner::read_number按文法取得词素，并判断是整数还是浮点数；
+ Number只保存词素，第一次访问数值时才转换（见Json_type_number.cpp中的LEXEME），
+ 因此超出64位的整数与超出long double范围的数在这里都不是错误。
+
+**************************************/
+bool Reader::parse_number(Value_base *&node)
+{
+    SubString lexeme(nullptr, nullptr);
+    bool integral = true;
+    if(!scanner.read_number(lexeme, integral))
+        return false;
+
+    node = new Number(std::string_view(lexeme.first, lexeme.length()),
+                      integral, Number::lexeme_t());
+    return true;
+}
+
+
+ParseResult Value::TryParse(std::string_view js, Value &out) noexcept
+{
+    Reader reader(js.data(), js.data() + js.size());
+    if(reader.parse_document(out))
+        return ParseResult();
+    return reader.result();
+}
+
+
+ParseResult Value::TryParseInto(std::string_view js, Value &reuse) noexcept
+{
+    Reader reader(js.data(), js.data() + js.size());
+    if(reader.parse_document_into(reuse))
+        return ParseResult();
+    return reader.result();
+}
+
+
+void Value::ParseInto(std::string_view js, Value &reuse)
+{
+    ParseResult r = TryParseInto(js, reuse);
+    if(!r)
+        throw JsonError(r);
+}
+
+
+Value Value::Parse(std::string_view js)
+{
+    Value ret(nullptr, adopt_t());
+    ParseResult r = TryParse(js, ret);
+    if(!r)
+        throw JsonError(r);
+    return ret;
+}
+
+
+Value Value::Parse(std::string_view js, std::pmr::memory_resource *mr)
+{
+    ResourceScope scope(mr);
+    return Parse(js);
+}
+
+
+/// 各具体类型的Parse：先按Value解析，再检查类型
+#define PARSEIMPL(_ClassName, _Check, _Error) \
+_ClassName _ClassName::Parse(std::string_view js) \
+{ \
+    Value v = Value::Parse(js); \
+    if(!v._Check()) \
+        throw JsonError(_Error); \
+    return std::move(v).to_##_ClassName(); \
+}
+
+PARSEIMPL(String, is_String, error_quote)
+PARSEIMPL(Number, is_Number, error_badnum)
+PARSEIMPL(Object, is_Object, error_brace)
+PARSEIMPL(Array, is_Array, error_brack)
+PARSEIMPL(True, is_True, error_literal)
+PARSEIMPL(False, is_False, error_literal)
+PARSEIMPL(Null, is_Null, error_literal)
+
+
+_JSON_END
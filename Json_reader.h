@@ -0,0 +1,106 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <vector>
+#include "Json_error.h"
+#include "Json_string.h"
+#include "Json_scanner.h"
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+/**************************************
+ Reader：单遍的解析器，直接在原文上构造Value。
+ 1、不预先删除空白符，也不做逗号预扫描，每个字符只看一次；
+ 2、不抛出异常，失败时返回false，出错类型与位置由result()给出；
+ 3、它是Object/Array/String/Number等类的友元，直接构造结点，避免多余的移动与拷贝；
+ 4、嵌套的Array/Object用显式的栈解析（见parse_container），嵌套深度不受调用栈大小的限制。
+
+**************************************/
+class Reader
+{
+public:
+    Reader(const char *b, const char *e): scanner(b, e) {}
+
+    /// 解析整个输入：可选空白 + 一个值 + 可选空白
+    bool parse_document(Value &out);
+    /// 从当前位置解析一个值（跳过前导空白），游标停在该值之后
+    bool parse_value(Value &out);
+    /// 同parse_document，但尽量重用out中原有的结点（见Value::ParseInto）
+    bool parse_document_into(Value &out);
+    /// 同parse_value，但尽量重用out中原有的结点，供ArrayStream逐个解析元素
+    bool parse_value_into(Value &out);
+
+    /// 同parse_document，但只构造proj选中的成员，其余的值用Scanner::skip_value跳过
+    bool parse_document(Value &out, const Projection &proj);
+
+    /// 从当前位置解析“元素 (, 元素)*”直到stop，结果追加到arr/obj中，供并行解析使用
+    bool parse_elements(Array &arr, const char *stop);
+    bool parse_members(Object &obj, const char *stop);
+
+    /// 把Scanner中记录的错误转换为ParseResult（计算行号与列号）
+    ParseResult result() const;
+
+    Scanner &scan() { return scanner; }
+
+    /// 从出错位置计算行列号
+    static ParseResult make_result(const char *begin, const char *errpos, ErrorType t);
+
+private:
+    bool parse_node(Value_base *&node);
+    /// 解析游标处的Array/Object，元素追加到已分配的空容器root中；
+    /// 嵌套的容器用frames中的显式栈解析，不递归。失败时root由调用者释放
+    bool parse_container(Value_base *root);
+    bool parse_member(Object &obj);
+    bool parse_element(Array &arr);
+    /// 成员的键与「:」：成功时游标停在值的第一个字符上
+    bool member_head(String &key);
+    /// 元素的开头：数字按紧凑形式追加时taken为true，否则游标停在值的第一个字符上
+    bool element_head(Array &arr, bool &taken);
+    bool parse_number(Value_base *&node);
+    /// 按键插入成员，重复的键只保留第一次出现的值
+    static void insert_member(Object &obj, String &&key, Value_base *node);
+
+    /// 按proj.nodes[n]解析一个值；该值被省略时node保持为nullptr
+    bool project_node(Value_base *&node, const Projection &proj, std::size_t n);
+    bool project_object(Object &obj, const Projection &proj, std::size_t n);
+    bool project_array(Array &arr, const Projection &proj, std::size_t n);
+    bool project_member(Object &obj, const Projection &proj, std::size_t n);
+
+    bool reuse_node(Value_base *&node);
+    bool reuse_object(Object &obj);
+    bool reuse_array(Array &arr);
+    bool reuse_member(Object &obj, Object::_Type &old);
+    bool reuse_element(Array &arr, Array::size_type &i);
+
+    /// parse_container中尚未闭合的一层容器：node还没有挂到上一层，key是它在上一层Object中的键
+    struct Frame
+    {
+        Frame(Value_base *n, bool o): node(n), object(o) {}
+
+        Value_base *node;
+        bool object;
+        String key;
+    };
+
+    Scanner scanner;
+    /// parse_container的栈，在同一个Reader的多次解析之间保留容量
+    std::vector<Frame> frames;
+    /// 重用解析（reuse_node）当前的嵌套层数，达到reuse_depth_limit之后更深的值按parse_node新建，
+    /// 因此ParseInto的递归深度也有上限
+    unsigned reuse_depth = 0;
+    static const unsigned reuse_depth_limit = 256;
+    /// 连续多少个Array的第一个小数不能紧凑保存（见parse_element），
+    /// 达到dense_give_up之后，本次解析不再尝试把以小数开头的Array紧凑保存
+    unsigned float_misses = 0;
+    static const unsigned dense_give_up = 16;
+};
+
+
+_JSON_END
+#endif // JSON_READER_H
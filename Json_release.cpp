@@ -0,0 +1,174 @@
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "Json_type.h"
+#include "Json_release.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+_JSON_BEGIN
+
+
+Reclaimer::Reclaimer(const ReleaseOptions &opt):
+    options(opt), ring(opt.max_pending ? opt.max_pending : 1, nullptr)
+{
+    if(options.background)
+        thread = std::thread(&Reclaimer::worker, this);
+}
+
+
+Reclaimer::~Reclaimer()
+{
+    std::unique_lock<std::mutex> lk(mtx);
+    stopping = true;
+    if(thread.joinable())
+    {
+        lk.unlock();
+        not_empty.notify_one();
+        thread.join();
+        lk.lock();
+    }
+    while(count != 0)
+        release_one(lk);
+}
+
+
+void Reclaimer::release_one(std::unique_lock<std::mutex> &lk)
+{
+    Value_base *p = ring[head];
+    head = (head + 1) % ring.size();
+    --count;
+    ++busy;
+    lk.unlock();
+    not_full.notify_one();
+
+    Value::destroy(p);
+
+    lk.lock();
+    --busy;
+    ++counters.released;
+    if(count == 0 && busy == 0)
+        idle.notify_all();
+}
+
+
+/**************************************
+ Reclaimer::release算法说明：
+ 1、取走v的结点，v变为空（与被移动过的Value相同）；标量结点直接释放；
+ 2、队列已满时：release_inline在调用线程释放这一棵；
+    block在有后台线程时等待它腾出位置，否则由调用者释放最早的一棵（它本来就要由调用者释放）；
+ 3、放入队列的末尾，唤醒后台线程。
+ Value::destroy不抛出异常，入队不分配内存，因此release只在加锁失败时抛出。
+
+**************************************/
+void Reclaimer::release(Value &&v)
+{
+    if(v.pbase == nullptr)
+        return;
+    JsonType t = v.Type();
+    Value_base *p = std::exchange(v.pbase, nullptr);
+
+    std::unique_lock<std::mutex> lk(mtx);
+    bool full = count == ring.size();
+    if((t != array_type && t != object_type)
+       || (full && options.when_full == WhenFull::release_inline))
+    {
+        ++counters.inline_released;
+        lk.unlock();
+        Value::destroy(p);
+        return;
+    }
+
+    if(full)
+        ++counters.waits;
+    while(count == ring.size())
+    {
+        if(thread.joinable())
+            not_full.wait(lk);
+        else
+            release_one(lk);
+    }
+
+    ring[(head + count) % ring.size()] = p;
+    ++count;
+    ++counters.queued;
+    bool wake = thread.joinable();
+    lk.unlock();
+    if(wake)
+        not_empty.notify_one();
+}
+
+
+std::size_t Reclaimer::reclaim(std::size_t max_trees)
+{
+    std::size_t n = 0;
+    std::unique_lock<std::mutex> lk(mtx);
+    for(; n != max_trees && count != 0; ++n)
+        release_one(lk);
+    return n;
+}
+
+
+void Reclaimer::drain()
+{
+    if(!thread.joinable())
+        reclaim();
+    std::unique_lock<std::mutex> lk(mtx);
+    idle.wait(lk, [this] { return count == 0 && busy == 0; });
+}
+
+
+std::size_t Reclaimer::pending() const
+{
+    std::lock_guard<std::mutex> lk(mtx);
+    return count + busy;
+}
+
+
+Reclaimer::Stats Reclaimer::stats() const
+{
+    std::lock_guard<std::mutex> lk(mtx);
+    return counters;
+}
+
+
+/// 后台线程：停止时先释放完队列中剩余的树再退出
+void Reclaimer::worker()
+{
+#ifdef __linux__
+    if(options.idle_priority)
+    {
+        sched_param param{};
+        sched_setscheduler(0, SCHED_IDLE, &param);     /// 失败时保持普通优先级
+    }
+#endif
+
+    std::unique_lock<std::mutex> lk(mtx);
+    for(;;)
+    {
+        not_empty.wait(lk, [this] { return stopping || count != 0; });
+        if(count == 0)
+            return;
+        release_one(lk);
+    }
+}
+
+
+Reclaimer &Reclaimer::global()
+{
+    static Reclaimer instance;
+    return instance;
+}
+
+
+void deferred_release(Value &&v)
+{
+    Reclaimer::global().release(std::move(v));
+}
+
+
+_JSON_END
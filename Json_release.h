@@ -0,0 +1,102 @@
+#ifndef JSON_RELEASE_H
+#define JSON_RELEASE_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+/// 队列已满时release的做法
+enum class WhenFull { block, release_inline };
+
+
+/// Reclaimer的选项
+struct ReleaseOptions
+{
+    std::size_t max_pending = 64;       /// 队列中最多的树数（至少为1）
+    WhenFull when_full = WhenFull::block;
+    bool background = true;             /// 由后台线程释放；为false时只在调用reclaim时释放
+    bool idle_priority = true;          /// 后台线程使用最低的调度优先级（Linux的SCHED_IDLE）
+};
+
+
+/**************************************
+ Reclaimer：把树的释放从调用线程移到后台线程或空闲时间。
+ 1、release接管Value的树放入有界的环形队列，调用线程只做一次加锁与入队，不分配内存；
+    标量结点很小，直接释放；
+ 2、background为true时后台线程逐棵取出并释放（Value::destroy，与析构相同），
+    idle_priority使它只在CPU空闲时运行，不与请求线程争抢；
+    为false时没有线程，由调用者在空闲时调用reclaim（例如事件循环没有事件时）；
+ 3、队列已满时（释放跟不上）施加反压：block等待后台线程腾出位置，
+    没有后台线程时由调用者先释放最早的一棵；release_inline直接在调用线程释放这一棵；
+ 4、析构时停止后台线程，释放队列中剩余的树。
+ 分配器在线程之间归还内存也有开销（例如glibc释放到别的arena需要加锁），
+ 吞吐量不会提高，只是把释放的时间从请求的关键路径上移走。
+
+**************************************/
+class Reclaimer
+{
+public:
+    struct Stats
+    {
+        std::uint64_t queued = 0;       /// 放入队列的树数
+        std::uint64_t released = 0;     /// 已从队列中释放的树数
+        std::uint64_t inline_released = 0;  /// 标量与release_inline在调用线程释放的个数
+        std::uint64_t waits = 0;        /// release因队列已满而等待（或先释放最早一棵）的次数
+    };
+
+    explicit Reclaimer(const ReleaseOptions &opt = ReleaseOptions());
+    ~Reclaimer();
+
+    Reclaimer(const Reclaimer &) = delete;
+    Reclaimer &operator=(const Reclaimer &) = delete;
+
+    /// 接管v的树，之后v与被移动过的Value相同（只能赋值或析构）
+    void release(Value &&v);
+
+    /// 在当前线程释放最多max_trees棵排队的树，返回释放的棵数
+    std::size_t reclaim(std::size_t max_trees = static_cast<std::size_t>(-1));
+
+    /// 等待此前放入的树全部释放（没有后台线程时在当前线程释放）
+    void drain();
+
+    /// 排队中与正在释放的树数
+    std::size_t pending() const;
+    Stats stats() const;
+
+    /// deferred_release使用的全局实例（默认选项，第一次使用时创建）
+    static Reclaimer &global();
+
+private:
+    /// 取出最早的一棵，解锁释放后重新加锁
+    void release_one(std::unique_lock<std::mutex> &lk);
+    void worker();
+
+    ReleaseOptions options;
+    std::vector<Value_base *> ring;
+    std::size_t head = 0, count = 0;
+    std::size_t busy = 0;               /// 已取出、正在释放的树数
+    bool stopping = false;
+    Stats counters;
+
+    mutable std::mutex mtx;
+    std::condition_variable not_empty, not_full, idle;
+    std::thread thread;
+};
+
+
+/// 用Reclaimer::global()延迟释放v的树
+void deferred_release(Value &&v);
+
+
+_JSON_END
+#endif // JSON_RELEASE_H
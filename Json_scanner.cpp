@@ -0,0 +1,361 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "Json_error.h"
+#include "Json_string.h"
+#include "Json_scanner.h"
+
+_JSON_BEGIN
+
+namespace
+{
+
+inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+inline int HexValue(char c)
+{
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/// 需要转义（或者终止快速扫描）的字符
+inline bool NeedEscape(char c)
+{
+    return c == '\"' || c == '\\' || IsCntrl(c);
+}
+
+/// strtoxx系列函数要求以'\0'结尾，短词素拷贝到栈上，长词素才使用std::string
+class LexemeBuffer
+{
+public:
+    explicit LexemeBuffer(const SubString &lexeme)
+    {
+        if(lexeme.length() < sizeof(local))
+        {
+            std::memcpy(local, lexeme.first, lexeme.length());
+            local[lexeme.length()] = '\0';
+            p = local;
+        }
+        else
+        {
+            heap.assign(lexeme.first, lexeme.second);
+            p = heap.c_str();
+        }
+    }
+
+    const char *c_str() const { return p; }
+
+private:
+    char local[64];
+    std::string heap;
+    const char *p;
+};
+
+} // namespace
+
+
+
+void append_escaped(std::string &out, const char *s, std::size_t n)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    out.push_back('\"');
+    for(const char *b = s, *e = s + n; b != e; )
+    {
+        const char *run = b;
+        while(b != e && !NeedEscape(*b)) ++b;
+        out.append(run, b);
+        if(b == e)
+            break;
+
+        switch(*b)
+        {
+        case '\"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            out += "\\u00";
+            out.push_back(hex[(*b >> 4) & 0xf]);
+            out.push_back(hex[*b & 0xf]);
+            break;
+        }
+        ++b;
+    }
+    out.push_back('\"');
+}
+
+
+
+/**************************************
+ Scanner::read_string算法说明：
+ 1、游标必须位于“"”上，否则返回error_quote；
+ 2、成段地把不需要转义的字符追加到out中；
+ 3、遇到“\”时按String::Parse的规则解释转义序列，失败返回error_escape；
+ 4、遇到未转义的控制字符返回error_escape，到达末尾仍未闭合返回error_quote；
+ 5、遇到闭合的“"”时，游标移到其后，返回true。
+
+**************************************/
+template<typename _String>
+bool Scanner::read_string_to(_String &out)
+{
+    if(cur == last || *cur != '\"')
+        return fail(error_quote);
+
+    for(const char *b = cur + 1; ; )
+    {
+        const char *run = b;
+        while(b != last && !NeedEscape(*b)) ++b;
+        out.append(run, b);
+
+        if(b == last)
+            return fail(error_quote);
+
+        if(*b == '\"')
+        {
+            cur = b + 1;
+            return true;
+        }
+
+        if(*b != '\\')
+            return fail(error_escape, b);
+
+        if(++b == last)
+            return fail(error_escape, b - 1);
+
+        switch(*b)
+        {
+        case '\"': out.push_back('\"'); break;
+        case '\\': out.push_back('\\'); break;
+        case '/':  out.push_back('/');  break;
+        case 'b':  out.push_back('\b'); break;
+        case 'f':  out.push_back('\f'); break;
+        case 'n':  out.push_back('\n'); break;
+        case 'r':  out.push_back('\r'); break;
+        case 't':  out.push_back('\t'); break;
+        case 'u':
+        {
+            if(last - b < 5)
+                return fail(error_escape, b - 1);
+            unsigned n = 0;
+            for(int i = 1; i <= 4; ++i)
+            {
+                int h = HexValue(b[i]);
+                if(h < 0)
+                    return fail(error_escape, b - 1);
+                n = n * 16 + h;
+            }
+            out.push_back(static_cast<char>(n)); /// 与String::Parse保持一致
+            b += 4;
+        }
+        break;
+
+        default:
+            return fail(error_escape, b - 1);
+        }
+        ++b;
+    }
+}
+
+
+bool Scanner::read_string(std::string &out) { return read_string_to(out); }
+bool Scanner::read_string(NodeString &out) { return read_string_to(out); }
+
+
+bool Scanner::skip_string()
+{
+    if(cur == last || *cur != '\"')
+        return fail(error_quote);
+
+    for(const char *b = cur + 1; b != last; ++b)
+    {
+        if(*b == '\"')
+        {
+            cur = b + 1;
+            return true;
+        }
+        if(IsCntrl(*b))
+            return fail(error_escape, b);
+        if(*b == '\\' && ++b == last)
+            break;
+    }
+    return fail(error_quote);
+}
+
+
+/**************************************
+ Scanner::read_number算法说明：
+ 按json.org的文法 -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)? 匹配最长的词素，
+ 不做任何数值转换，只返回词素的范围以及它是否为整数。
+
+**************************************/
+bool Scanner::read_number(SubString &lexeme, bool &integral)
+{
+    const char *b = cur;
+    if(b != last && *b == '-') ++b;
+    if(b == last || !IsDigit(*b))
+        return fail(error_badnum);
+
+    if(*b == '0')
+        ++b;
+    else
+        while(b != last && IsDigit(*b)) ++b;
+
+    integral = true;
+    if(b != last && *b == '.')
+    {
+        integral = false;
+        if(++b == last || !IsDigit(*b))
+            return fail(error_badnum);
+        while(b != last && IsDigit(*b)) ++b;
+    }
+
+    if(b != last && (*b == 'e' || *b == 'E'))
+    {
+        integral = false;
+        ++b;
+        if(b != last && (*b == '+' || *b == '-')) ++b;
+        if(b == last || !IsDigit(*b))
+            return fail(error_badnum);
+        while(b != last && IsDigit(*b)) ++b;
+    }
+
+    lexeme = SubString(cur, b);
+    cur = b;
+    return true;
+}
+
+
+bool Scanner::read_literal(const char *lit, std::size_t n, ErrorType t)
+{
+    if(static_cast<std::size_t>(last - cur) < n
+       || std::strncmp(cur, lit, n) != 0)
+        return fail(t);
+    cur += n;
+    return true;
+}
+
+
+/**************************************
+ Scanner::skip_value算法说明：
+ 1、标量按各自的文法完整检查后跳过；
+ 2、Array/Object只维护一个括号栈（std::string，深度不超过15时不分配内存），
+    字符串整体跳过，其余字符不做解释，直到最外层括号闭合。
+    因此skip_value比完整解析快得多，但不会发现诸如缺少逗号之类的错误。
+
+**************************************/
+bool Scanner::skip_value()
+{
+    skip_ws();
+    if(cur == last)
+        return fail(error_empty);
+
+    switch(*cur)
+    {
+    case '\"':
+        return skip_string();
+    case 't':
+        return read_literal("true", 4);
+    case 'f':
+        return read_literal("false", 5);
+    case 'n':
+        return read_literal("null", 4);
+    case '{': case '[':
+        break;
+    default:
+    {
+        SubString lexeme(cur, cur);
+        bool integral;
+        return read_number(lexeme, integral);
+    }
+    }
+
+    std::string letters;
+    for(const char *b = cur; b != last; ++b)
+    {
+        switch(*b)
+        {
+        case '\"':
+            cur = b;
+            if(!skip_string())
+                return false;
+            b = cur - 1;
+            break;
+
+        case '[': case '{':
+            letters.push_back(*b);
+            break;
+
+        case ']':
+            if(letters.back() != '[')
+                return fail(error_mismatch, b);
+            letters.pop_back();
+            break;
+
+        case '}':
+            if(letters.back() != '{')
+                return fail(error_mismatch, b);
+            letters.pop_back();
+            break;
+        }
+
+        if(letters.empty())
+        {
+            cur = b + 1;
+            return true;
+        }
+    }
+    return fail(letters.back() == '[' ? error_brack : error_brace);
+}
+
+
+
+bool parse_longlong(const SubString &lexeme, long long &v)
+{
+    LexemeBuffer buf(lexeme);
+    char *end = nullptr;
+    errno = 0;
+    v = std::strtoll(buf.c_str(), &end, 10);
+    return errno == 0 && end == buf.c_str() + lexeme.length();
+}
+
+
+bool parse_ulonglong(const SubString &lexeme, unsigned long long &v)
+{
+    if(lexeme.length() != 0 && *lexeme.first == '-')
+        return false;
+    LexemeBuffer buf(lexeme);
+    char *end = nullptr;
+    errno = 0;
+    v = std::strtoull(buf.c_str(), &end, 10);
+    return errno == 0 && end == buf.c_str() + lexeme.length();
+}
+
+
+bool parse_longdouble(const SubString &lexeme, long double &v)
+{
+    LexemeBuffer buf(lexeme);
+    char *end = nullptr;
+    errno = 0;
+    v = std::strtold(buf.c_str(), &end);
+    return errno != ERANGE && end == buf.c_str() + lexeme.length();
+}
+
+
+bool parse_double(const SubString &lexeme, double &v)
+{
+    LexemeBuffer buf(lexeme);
+    char *end = nullptr;
+    errno = 0;
+    v = std::strtod(buf.c_str(), &end);
+    return errno != ERANGE && end == buf.c_str() + lexeme.length();
+}
+
+
+_JSON_END
@@ -0,0 +1,93 @@
+#ifndef JSON_SCANNER_H
+#define JSON_SCANNER_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <string>
+#include "Json_error.h"
+#include "Json_string.h"
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+/// 将s转义为json字符串字面量（含首尾双引号）并追加到out末尾，
+/// 转义规则与String::Serialize一致
+void append_escaped(std::string &out, const char *s, std::size_t n);
+
+/// 把Scanner::read_number得到的词素转换为数值，溢出或格式不符时返回false，不抛出异常
+bool parse_longlong(const SubString &lexeme, long long &v);
+bool parse_ulonglong(const SubString &lexeme, unsigned long long &v);
+bool parse_longdouble(const SubString &lexeme, long double &v);
+bool parse_double(const SubString &lexeme, double &v);
+
+
+/**************************************
+ Scanner：在json原文上顺序移动的游标。
+ 与Value::Parse不同，Scanner不会先删除空白符、也不会构造任何Value，
+ 所有成员函数都不抛出异常：失败时返回false，并记录错误类型与出错位置。
+ 它是JSON_BIND等“绕过Value直接读取”功能的基础。
+
+**************************************/
+class Scanner
+{
+public:
+    Scanner(const char *b, const char *e):
+        first(b), cur(b), last(e), err(error_empty), errpos(nullptr) {}
+    explicit
+    Scanner(const SubString &subStr):
+        Scanner(subStr.first, subStr.second) {}
+
+    const char *begin() const { return first; }
+    const char *end() const { return last; }
+    const char *position() const { return cur; }
+    void seek(const char *p) { cur = p; }
+
+    bool eof() const { return cur == last; }
+    char peek() const { return cur != last ? *cur : '\0'; }
+
+    void skip_ws() { while(cur != last && IsSpace(*cur)) ++cur; }
+
+    /// 跳过空白后，若下一个字符为c则吃掉它并返回true
+    bool consume(char c)
+    {
+        skip_ws();
+        if(cur != last && *cur == c)
+        {
+            ++cur;
+            return true;
+        }
+        return false;
+    }
+
+    /// 以下函数要求游标已位于该值的第一个字符上
+    bool read_string(std::string &out);
+    bool read_string(NodeString &out);
+    bool skip_string();
+    bool read_number(SubString &lexeme, bool &integral);
+    bool read_literal(const char *lit, std::size_t n, ErrorType t = error_literal);
+    /// 只做结构检查（括号配对、字符串闭合）地跳过一个完整的值
+    bool skip_value();
+
+    /// 记录错误，总是返回false
+    bool fail(ErrorType t) { err = t; errpos = cur; return false; }
+    bool fail(ErrorType t, const char *p) { err = t; errpos = p; return false; }
+
+    ErrorType error() const { return err; }
+    const char *error_position() const { return errpos; }
+
+private:
+    /// read_string的两个版本共用的实现
+    template<typename _String>
+    bool read_string_to(_String &out);
+
+    const char *first, *cur, *last;
+    ErrorType err;
+    const char *errpos;
+};
+
+
+_JSON_END
+#endif // JSON_SCANNER_H
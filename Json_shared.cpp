@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "Json_release.h"
+#include "Json_type.h"
+#include "Json_shared.h"
+
+_JSON_BEGIN
+
+
+namespace
+{
+
+/**************************************
+ 读者登记：每个线程第一次读取时领取一个ReaderSlot，线程退出时归还，供以后的线程复用。
+ 所有slot组成只增不减的单链表，写者回收时遍历它。
+ slot中的epoch为0表示该线程当前没有持有任何快照，
+ 否则为它开始读取时的全局epoch；同一线程嵌套读取时保留最外层的（较小的）epoch。
+
+**************************************/
+struct ReaderSlot
+{
+    std::atomic<std::uint64_t> epoch{0};
+    std::atomic<bool> used{true};
+    ReaderSlot *next = nullptr;
+    unsigned depth = 0;     /// 只由所属线程访问
+};
+
+std::atomic<std::uint64_t> global_epoch{1};
+std::atomic<ReaderSlot *> slot_list{nullptr};
+
+
+ReaderSlot *acquire_slot()
+{
+    for(ReaderSlot *s = slot_list.load(std::memory_order_acquire); s; s = s->next)
+    {
+        bool expected = false;
+        if(!s->used.load(std::memory_order_relaxed)
+           && s->used.compare_exchange_strong(expected, true))
+            return s;
+    }
+
+    ReaderSlot *s = new ReaderSlot();
+    s->next = slot_list.load(std::memory_order_relaxed);
+    while(!slot_list.compare_exchange_weak(s->next, s))
+        ;
+    return s;
+}
+
+
+struct SlotHolder
+{
+    SlotHolder(): slot(acquire_slot()) {}
+    ~SlotHolder()
+    {
+        slot->epoch.store(0);
+        slot->depth = 0;
+        slot->used.store(false, std::memory_order_release);
+    }
+    ReaderSlot *slot;
+};
+
+
+ReaderSlot &this_slot()
+{
+    thread_local SlotHolder holder;
+    return *holder.slot;
+}
+
+
+/// 当前所有读者中最小的epoch，没有读者时为最大值
+std::uint64_t min_active_epoch()
+{
+    std::uint64_t m = std::numeric_limits<std::uint64_t>::max();
+    for(ReaderSlot *s = slot_list.load(std::memory_order_acquire); s; s = s->next)
+    {
+        std::uint64_t e = s->epoch.load();
+        if(e != 0 && e < m)
+            m = e;
+    }
+    return m;
+}
+
+} // namespace
+
+
+
+SharedDocument::SharedDocument(Value v, Reclaimer *r):
+    current(new Value(std::move(v))), npending(0), reclaimer(r) {}
+
+
+SharedDocument::~SharedDocument()
+{
+    free_snapshot(current.load());
+    for(const auto &r : retired)
+        free_snapshot(r.val);
+}
+
+
+/// 快照本身是单独分配的Value，树交给reclaimer之后只剩一个空的Value
+void SharedDocument::free_snapshot(const Value *v) const
+{
+    if(reclaimer)
+        reclaimer->release(std::move(*const_cast<Value *>(v)));
+    delete v;
+}
+
+
+/**************************************
+ SharedDocument::read算法说明：
+ 1、最外层的读取把全局epoch记入本线程的slot，然后读取当前快照指针；
+ 2、写者先替换指针、再递增全局epoch，并以递增前的值E登记旧快照；
+    若读者记下的epoch大于E，它读取指针时替换已经完成，不可能拿到旧快照；
+    若不大于E，回收时会看到它仍在读取，旧快照不会被释放；
+ 全部使用顺序一致的原子操作，读者只有固定的几步，不会等待。
+
+**************************************/
+SharedDocument::Snapshot SharedDocument::read() const
+{
+    ReaderSlot &slot = this_slot();
+    if(slot.depth++ == 0)
+        slot.epoch.store(global_epoch.load());
+    return Snapshot(this, current.load());
+}
+
+
+void SharedDocument::leave() const
+{
+    ReaderSlot &slot = this_slot();
+    if(--slot.depth == 0)
+        slot.epoch.store(0);
+
+    if(npending.load(std::memory_order_relaxed) != 0)
+    {
+        std::unique_lock<std::mutex> lk(mtx, std::try_to_lock);
+        if(lk.owns_lock())
+            reclaim_locked();
+    }
+}
+
+
+void SharedDocument::publish(Value v)
+{
+    std::lock_guard<std::mutex> lk(writer);
+    replace(std::move(v));
+}
+
+
+void SharedDocument::replace(Value v)
+{
+    const Value *old = current.exchange(new Value(std::move(v)));
+    std::uint64_t e = global_epoch.fetch_add(1);
+
+    std::lock_guard<std::mutex> lk(mtx);
+    retired.push_back({old, e});
+    npending.store(retired.size(), std::memory_order_relaxed);
+    reclaim_locked();
+}
+
+
+std::size_t SharedDocument::reclaim()
+{
+    std::lock_guard<std::mutex> lk(mtx);
+    return reclaim_locked();
+}
+
+
+std::size_t SharedDocument::reclaim_locked() const
+{
+    if(retired.empty())
+        return 0;
+
+    std::uint64_t m = min_active_epoch();
+    auto it = std::partition(retired.begin(), retired.end(),
+                             [m](const Retired &r) { return r.epoch >= m; });
+    for(auto p = it; p != retired.end(); ++p)
+        free_snapshot(p->val);
+    retired.erase(it, retired.end());
+    npending.store(retired.size(), std::memory_order_relaxed);
+    return retired.size();
+}
+
+
+
+SharedDocument::Snapshot &SharedDocument::Snapshot::operator=(Snapshot &&rhs) noexcept
+{
+    if(this != &rhs)
+    {
+        release();
+        doc = rhs.doc;
+        val = rhs.val;
+        rhs.doc = nullptr;
+    }
+    return *this;
+}
+
+
+void SharedDocument::Snapshot::release()
+{
+    if(doc)
+    {
+        doc->leave();
+        doc = nullptr;
+    }
+}
+
+
+_JSON_END
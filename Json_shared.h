@@ -0,0 +1,116 @@
+#ifndef JSON_SHARED_H
+#define JSON_SHARED_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+class Reclaimer;
+
+/**************************************
+ SharedDocument：供大量读线程并发访问、偶尔整体替换的文档（RCU）。
+ 1、每个快照是一个不可修改的const Value，通过原子指针发布；
+ 2、读者read()得到Snapshot，持有期间快照不会被释放；
+    进入与读取都只是几次原子操作，不加锁、不等待；
+ 3、publish/update用新快照替换旧快照，旧快照先放入待回收列表，
+    使用基于epoch的回收：所有在替换之前开始的读者都离开后才释放；
+    回收在publish时以及最后离开的读者处进行（读者只try_lock，从不等待）；
+ 4、快照上的哈希、序列化缓存都是原子的，多个读者可以同时使用它们；
+ 5、给出reclaimer时，可以回收的旧快照交给它释放（见Reclaimer），
+    publish与最后离开的读者只做入队，不在调用线程中释放整棵树。
+ Snapshot应在创建它的线程中释放，且不应长期持有（持有期间所有旧快照都无法回收）；
+ 析构SharedDocument时不应再有读者持有它的Snapshot；reclaimer的生存期应长于SharedDocument。
+
+**************************************/
+class SharedDocument
+{
+public:
+    class Snapshot
+    {
+    public:
+        Snapshot(Snapshot &&rhs) noexcept: doc(rhs.doc), val(rhs.val) { rhs.doc = nullptr; }
+        Snapshot(const Snapshot &) = delete;
+        Snapshot &operator=(const Snapshot &) = delete;
+        Snapshot &operator=(Snapshot &&rhs) noexcept;
+        ~Snapshot() { release(); }
+
+        const Value &operator*()  const { return *val; }
+        const Value *operator->() const { return val; }
+        const Value &get() const { return *val; }
+
+        /// 提前离开，之后不能再访问快照
+        void release();
+
+    private:
+        friend class SharedDocument;
+        Snapshot(const SharedDocument *d, const Value *v): doc(d), val(v) {}
+
+        const SharedDocument *doc;
+        const Value *val;
+    };
+
+    explicit SharedDocument(Value v = Value(), Reclaimer *reclaimer = nullptr);
+    ~SharedDocument();
+
+    SharedDocument(const SharedDocument &) = delete;
+    SharedDocument &operator=(const SharedDocument &) = delete;
+
+    /// 读取当前快照（wait-free）
+    Snapshot read() const;
+
+    /// 发布新快照；多个写者之间互斥
+    void publish(Value v);
+
+    /// 拷贝当前快照，用fn(Value &)修改后发布，期间其他写者等待
+    template<typename _Fn>
+    void update(_Fn fn);
+
+    /// 回收已没有读者的旧快照，返回仍待回收的个数
+    std::size_t reclaim();
+
+    /// 待回收的旧快照个数
+    std::size_t pending() const { return npending.load(std::memory_order_relaxed); }
+
+private:
+    struct Retired
+    {
+        const Value *val;
+        std::uint64_t epoch;    /// 替换时的epoch，读者的epoch都大于它之后才能释放
+    };
+
+    void leave() const;
+    void replace(Value v);
+    std::size_t reclaim_locked() const;
+    void free_snapshot(const Value *v) const;
+
+    std::atomic<const Value *> current;
+    std::mutex writer;                      /// 写者之间互斥
+    mutable std::mutex mtx;                 /// 保护retired
+    mutable std::vector<Retired> retired;
+    mutable std::atomic<std::size_t> npending;
+    Reclaimer *reclaimer;                   /// 为空时在回收的线程中直接释放
+};
+
+
+template<typename _Fn>
+void SharedDocument::update(_Fn fn)
+{
+    std::lock_guard<std::mutex> lk(writer);
+    Value v = *current.load(std::memory_order_acquire);
+    fn(v);
+    replace(std::move(v));
+}
+
+
+_JSON_END
+#endif // JSON_SHARED_H
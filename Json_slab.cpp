@@ -0,0 +1,208 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include "Json_slab.h"
+
+_JSON_BEGIN
+
+
+namespace
+{
+
+const std::size_t kSlabSize = 64 * 1024;
+const std::size_t kGrain = 16;
+const std::size_t kClasses = SlabPool::max_block / kGrain;
+
+struct Heap;
+
+/// slab的开头，块从kSlabHeader之后开始，因此按kSlabSize向下取整就得到块所在的slab
+struct Slab
+{
+    Heap *owner;
+    std::size_t cls;
+};
+const std::size_t kSlabHeader = 16;
+static_assert(sizeof(Slab) <= kSlabHeader, "Slab header must fit before the first block");
+
+/// 空闲的块：第一个字为链表的下一项
+struct FreeBlock
+{
+    FreeBlock *next;
+};
+
+
+/// 一个线程的分配状态：只由拥有它的线程访问，remote除外
+struct Heap
+{
+    struct Class
+    {
+        FreeBlock *free = nullptr;
+        char *bump = nullptr, *end = nullptr;   /// 正在切分的slab中剩余的部分
+    };
+
+    Class classes[kClasses];
+    std::atomic<FreeBlock *> remote{nullptr};   /// 别的线程释放的块（各级混在一起）
+    Heap *next = nullptr;                       /// 空闲的heap表中的下一项
+};
+
+
+/// 没有线程拥有的heap，由新的线程接管；heap与slab都不会被释放
+std::mutex idle_mtx;
+Heap *idle_heaps = nullptr;
+
+/// 当前线程的heap；线程退出（ThreadExit析构）之后为空，此后的释放都按别的线程处理
+thread_local Heap *current = nullptr;
+thread_local bool exited = false;
+
+struct ThreadExit
+{
+    ~ThreadExit()
+    {
+        Heap *h = current;
+        current = nullptr;
+        exited = true;
+        std::lock_guard<std::mutex> lk(idle_mtx);
+        h->next = idle_heaps;
+        idle_heaps = h;
+    }
+};
+
+
+Heap *acquire_heap()
+{
+    Heap *h = nullptr;
+    {
+        std::lock_guard<std::mutex> lk(idle_mtx);
+        if(idle_heaps)
+        {
+            h = idle_heaps;
+            idle_heaps = h->next;
+            h->next = nullptr;
+        }
+    }
+    if(h == nullptr)
+        h = new Heap();
+    current = h;
+
+    /// 线程退出之后（其他thread_local对象的析构函数中）仍然分配时，
+    /// 不再登记ThreadExit，这个heap就一直属于已退出的线程
+    if(!exited)
+    {
+        static thread_local ThreadExit guard;
+        (void)guard;
+    }
+    return h;
+}
+
+
+inline Slab *slab_of(void *p)
+{
+    return reinterpret_cast<Slab *>(reinterpret_cast<std::uintptr_t>(p) & ~(kSlabSize - 1));
+}
+
+} // namespace
+
+
+
+SlabPool &SlabPool::global()
+{
+    static SlabPool *instance = new SlabPool();
+    return *instance;
+}
+
+
+SlabPool::Stats SlabPool::stats() const
+{
+    Stats s;
+    s.slabs = slabs.load(std::memory_order_relaxed);
+    s.remote_frees = remote_frees.load(std::memory_order_relaxed);
+    return s;
+}
+
+
+/**************************************
+ SlabPool::do_allocate算法说明：
+ 1、大于max_block或对齐大于16的块交给new_delete_resource；
+ 2、取当前线程的heap（第一次使用时接管一个空闲的heap或新建），从对应一级的空闲链表取一块；
+ 3、链表为空时，先把remote栈整个取回，按每块所在slab的级别放回各级的链表，再取一次；
+ 4、仍然为空时从这一级正在切分的slab中切出一块，slab用完时分配新的slab。
+
+**************************************/
+void *SlabPool::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    if(bytes > max_block || alignment > kGrain)
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+
+    std::size_t cls = bytes ? (bytes - 1) / kGrain : 0;
+    Heap *h = current ? current : acquire_heap();
+    Heap::Class &c = h->classes[cls];
+    if(FreeBlock *b = c.free)
+    {
+        c.free = b->next;
+        return b;
+    }
+
+    for(FreeBlock *r = h->remote.exchange(nullptr, std::memory_order_acquire); r; )
+    {
+        FreeBlock *next = r->next;
+        Heap::Class &rc = h->classes[slab_of(r)->cls];
+        r->next = rc.free;
+        rc.free = r;
+        r = next;
+    }
+    if(FreeBlock *b = c.free)
+    {
+        c.free = b->next;
+        return b;
+    }
+
+    std::size_t size = (cls + 1) * kGrain;
+    if(static_cast<std::size_t>(c.end - c.bump) < size)
+    {
+        char *mem = static_cast<char *>(::operator new(kSlabSize, std::align_val_t(kSlabSize)));
+        Slab *s = reinterpret_cast<Slab *>(mem);
+        s->owner = h;
+        s->cls = cls;
+        c.bump = mem + kSlabHeader;
+        c.end = mem + kSlabSize;
+        slabs.fetch_add(1, std::memory_order_relaxed);
+    }
+    void *p = c.bump;
+    c.bump += size;
+    return p;
+}
+
+
+/// 同一线程的释放放回自己的链表；别的线程（以及已退出的线程）的释放压入所属heap的remote栈
+void SlabPool::do_deallocate(void *p, std::size_t bytes, std::size_t alignment)
+{
+    if(bytes > max_block || alignment > kGrain)
+    {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        return;
+    }
+
+    Slab *s = slab_of(p);
+    FreeBlock *b = static_cast<FreeBlock *>(p);
+    Heap *owner = s->owner;
+    if(owner == current)
+    {
+        Heap::Class &c = owner->classes[s->cls];
+        b->next = c.free;
+        c.free = b;
+        return;
+    }
+
+    FreeBlock *head = owner->remote.load(std::memory_order_relaxed);
+    do
+        b->next = head;
+    while(!owner->remote.compare_exchange_weak(head, b, std::memory_order_release,
+                                               std::memory_order_relaxed));
+    remote_frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+_JSON_END
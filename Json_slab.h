@@ -0,0 +1,69 @@
+#ifndef JSON_SLAB_H
+#define JSON_SLAB_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+_JSON_BEGIN
+
+/**************************************
+ SlabPool：按大小分级的slab内存池，供长期存在、不断修改的文档使用（见Json_alloc.h）。
+ 1、不超过max_block字节、对齐不超过16的块按16字节分级，每一级从64KB的slab中切出；
+    更大的块直接使用::operator new；
+ 2、每个线程有自己的heap（每一级一个空闲链表与一个正在切分的slab），
+    分配与同一线程的释放只操作线程自己的链表，不加锁；
+ 3、slab按64KB对齐，开头记录所属的heap：在别的线程中释放时，
+    用原子操作把块压入所属heap的remote栈，所属线程的空闲链表用完时再一次取回；
+ 4、线程退出时它的heap被放入空闲的heap表，之后新的线程接管它（包括remote栈中的块），
+    因此别的线程仍然可以释放它分配的块；slab不归还给系统。
+ 线程安全，可以被多个线程同时使用，树也可以交给别的线程修改或释放（例如Reclaimer）。
+ 与unsynchronized_pool_resource相比，它可以跨线程使用；与monotonic_buffer_resource相比，
+ 释放的结点立即可以重用，适合不断插入、替换与删除成员的文档。
+
+ 用法：
+     json::Value session = json::Value::Parse(text, &json::SlabPool::global());
+     // 赋值时右边的Value由调用者创建，来自当前线程的设置：修改文档的线程同样选择SlabPool
+     json::ResourceScope scope(&json::SlabPool::global());
+     session.as_Object()["hits"] = 1;
+
+**************************************/
+class SlabPool : public std::pmr::memory_resource
+{
+public:
+    static const std::size_t max_block = 256;
+
+    struct Stats
+    {
+        std::uint64_t slabs = 0;            /// 已分配的slab个数
+        std::uint64_t remote_frees = 0;     /// 在别的线程中释放的块数
+    };
+
+    /// 进程中唯一的实例，不会被销毁
+    static SlabPool &global();
+
+    Stats stats() const;
+
+    SlabPool(const SlabPool &) = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+
+private:
+    SlabPool() = default;
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        { return this == &other; }
+
+    std::atomic<std::uint64_t> slabs{0};
+    std::atomic<std::uint64_t> remote_frees{0};
+};
+
+
+_JSON_END
+#endif // JSON_SLAB_H
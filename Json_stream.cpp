@@ -0,0 +1,747 @@
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+#include "Json_error.h"
+#include "Json_reader.h"
+#include "Json_stream.h"
+
+_JSON_BEGIN
+
+namespace
+{
+
+/**************************************
+ ReadAhead：在后台线程中反复调用src读取数据块，最多预先保存depth块。
+ read从队首的块中复制数据；src抛出的异常在读到该位置时重新抛出。
+
+**************************************/
+class ReadAhead
+{
+public:
+    ReadAhead(ArrayStream::Source s, std::size_t chunk, std::size_t depth = 2):
+        src(std::move(s)), chunk(chunk), depth(depth), eof(false), stop(false), offset(0)
+    {
+        worker = std::thread([this] { run(); });
+    }
+
+    ~ReadAhead()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            stop = true;
+        }
+        cv.notify_all();
+        worker.join();
+    }
+
+    std::size_t read(char *buf, std::size_t cap)
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        cv.wait(lk, [this] { return !chunks.empty() || eof; });
+        if(chunks.empty())
+        {
+            if(error)
+                std::rethrow_exception(error);
+            return 0;
+        }
+
+        std::string &front = chunks.front();
+        std::size_t n = std::min(cap, front.size() - offset);
+        std::memcpy(buf, front.data() + offset, n);
+        offset += n;
+        if(offset == front.size())
+        {
+            chunks.pop_front();
+            offset = 0;
+            cv.notify_all();
+        }
+        return n;
+    }
+
+private:
+    void run()
+    {
+        for(;;)
+        {
+            {
+                std::unique_lock<std::mutex> lk(mtx);
+                cv.wait(lk, [this] { return chunks.size() < depth || stop; });
+                if(stop)
+                    return;
+            }
+
+            std::string block(chunk, '\0');
+            std::size_t n = 0;
+            std::exception_ptr e;
+            try
+            {
+                n = src(&block[0], block.size());
+            }
+            catch(...)
+            {
+                e = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lk(mtx);
+            if(n == 0)
+            {
+                error = e;
+                eof = true;
+                cv.notify_all();
+                return;
+            }
+            block.resize(n);
+            chunks.push_back(std::move(block));
+            cv.notify_all();
+        }
+    }
+
+    ArrayStream::Source src;
+    std::size_t chunk, depth;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::string> chunks;
+    std::exception_ptr error;
+    bool eof, stop;
+    std::size_t offset;     /// 队首的块中已被读取的字节数
+    std::thread worker;
+};
+
+
+ArrayStream::Source fd_source(int fd)
+{
+    return [fd](char *buf, std::size_t cap) -> std::size_t {
+        for(;;)
+        {
+#ifndef _WIN32
+            ssize_t n = ::read(fd, buf, cap);
+#else
+            int n = ::_read(fd, buf, static_cast<unsigned>(cap));
+#endif
+            if(n >= 0)
+                return static_cast<std::size_t>(n);
+            if(errno != EINTR)
+                throw std::system_error(errno, std::generic_category(), "ArrayStream: read");
+        }
+    };
+}
+
+
+/**************************************
+ Window：按块读取的输入窗口，供ArrayStream与ParseStream共用。
+ data[pos, size)是已读入、尚未处理的数据；buf只保存Source的数据中尚未丢弃的部分，
+ origin/line/line_start记录窗口起点在整个输入中的位置，用于报告出错位置。
+
+**************************************/
+struct Window
+{
+    StreamOptions opt;
+    ArrayStream::Source source;
+    std::unique_ptr<ReadAhead> ahead;
+
+    std::string buf;                /// Source的数据：只保存尚未处理的部分
+    const char *data = nullptr;     /// 当前窗口：buf或者整个内存输入
+    std::size_t size = 0, pos = 0;
+    bool eof = false;
+
+    std::size_t origin = 0;         /// 窗口起点在整个输入中的偏移
+    std::size_t line = 1;           /// 窗口起点所在的行
+    std::size_t line_start = 0;     /// 该行行首在整个输入中的偏移
+
+    Window() = default;
+    Window(ArrayStream::Source src, const StreamOptions &o): opt(o)
+    {
+        if(opt.read_ahead)
+            ahead.reset(new ReadAhead(std::move(src), opt.chunk_size));
+        else
+            source = std::move(src);
+    }
+
+    std::size_t read(char *p, std::size_t cap)
+        { return ahead ? ahead->read(p, cap) : source(p, cap); }
+
+    bool refill();
+    [[noreturn]] void fail(const char *p, ErrorType t) const;
+    bool skip_ws();
+};
+
+
+/**************************************
+ Window::refill算法说明：
+ 1、输入已结束时返回false；
+ 2、已处理的部分超过缓冲区的一半时丢弃它（同时累计行号），避免缓冲区无限增长；
+ 3、至少读取max(chunk_size, 未处理的字节数)个字节，
+    使同一个很大的元素被重新解析的总代价为O(元素大小)；
+ 返回true表示窗口中有了新的数据或者输入已结束，调用者应重新尝试。
+ 丢弃之后pos变为0，调用者保存的位置应当相对于pos。
+
+**************************************/
+bool Window::refill()
+{
+    if(eof)
+        return false;
+
+    if(pos != 0 && pos * 2 >= buf.size())
+    {
+        for(std::size_t i = 0; i != pos; ++i)
+        {
+            if(buf[i] == '\n')
+            {
+                ++line;
+                line_start = origin + i + 1;
+            }
+        }
+        buf.erase(0, pos);
+        origin += pos;
+        pos = 0;
+    }
+
+    std::size_t want = std::max(opt.chunk_size, buf.size() - pos);
+    std::size_t old = buf.size();
+    buf.resize(old + want);
+    std::size_t got = 0;
+    while(got < want)
+    {
+        std::size_t n = read(&buf[old + got], want - got);
+        if(n == 0)
+        {
+            eof = true;
+            break;
+        }
+        got += n;
+        if(got >= opt.chunk_size)
+            break;
+    }
+    buf.resize(old + got);
+    data = buf.data();
+    size = buf.size();
+    return true;
+}
+
+
+void Window::fail(const char *p, ErrorType t) const
+{
+    ParseResult r = Reader::make_result(data, p, t);
+    r.offset += origin;
+    if(r.line == 1)
+        r.column += origin - line_start;
+    r.line += line - 1;
+    throw JsonError(r);
+}
+
+
+/// 跳过空白；窗口用完时读取更多数据，到达输入末尾时返回false
+bool Window::skip_ws()
+{
+    for(;;)
+    {
+        while(pos != size && IsSpace(data[pos]))
+            ++pos;
+        if(pos != size)
+            return true;
+        if(!refill())
+            return false;
+    }
+}
+
+} // namespace
+
+
+
+struct ArrayStream::Impl : Window
+{
+    enum State { opening, first_element, elements, closing, done };
+
+    void *map = nullptr;            /// mmap的文件
+    std::size_t map_len = 0, released = 0;
+
+    State state = opening;
+    std::size_t count = 0;
+    Value current;
+
+    using Window::Window;
+
+    ~Impl()
+    {
+        ahead.reset();
+#ifndef _WIN32
+        if(map)
+            ::munmap(map, map_len);
+#endif
+    }
+
+    void release_pages();
+    bool next(Value &out);
+};
+
+
+/// mmap的输入：把已经处理完的整页交还给内核，常驻内存不随已处理的数据增长
+void ArrayStream::Impl::release_pages()
+{
+#ifndef _WIN32
+    if(map == nullptr)
+        return;
+    static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::size_t end = pos / page * page;
+    if(end >= released + (std::size_t(1) << 20))
+    {
+        ::madvise(static_cast<char *>(map) + released, end - released, MADV_DONTNEED);
+        released = end;
+    }
+#endif
+}
+
+
+/**************************************
+ ArrayStream::Impl::next算法说明：
+ 1、opening：跳过空白后要求「[」；first_element：「]」表示空数组；
+    elements：要求「,」或「]」；closing：「]」之后只允许空白；
+ 2、元素用Reader::parse_value_into在窗口中解析，失败时如果输入尚未结束且
+    元素不超过max_element，就读取更多数据后从元素开头重新解析；
+ 3、解析成功但元素紧挨着窗口末尾时（例如数字123可能被截成12）同样重新解析，
+    保证元素之后至少还有一个字符或者输入已经结束；
+ 4、错误的类型与Value::Parse解析整个数组时相同。
+
+**************************************/
+bool ArrayStream::Impl::next(Value &out)
+{
+    switch(state)
+    {
+    case done:
+        return false;
+
+    case opening:
+        if(!skip_ws())
+            fail(data + pos, error_empty);
+        if(data[pos] != '[')
+            throw JsonError(json_bad_cast);
+        ++pos;
+        state = first_element;
+        return next(out);
+
+    case first_element:
+        if(!skip_ws())
+            fail(data + pos, error_brack);
+        if(data[pos] == ']')
+        {
+            ++pos;
+            state = closing;
+            return next(out);
+        }
+        break;
+
+    case elements:
+        if(!skip_ws())
+            fail(data + pos, error_brack);
+        if(data[pos] == ']')
+        {
+            ++pos;
+            state = closing;
+            return next(out);
+        }
+        if(data[pos] != ',')
+            fail(data + pos, error_comma);
+        ++pos;
+        if(!skip_ws())
+            fail(data + pos, error_brack);
+        if(data[pos] == ']')
+            fail(data + pos, error_comma);
+        break;
+
+    case closing:
+        if(skip_ws())
+        {
+            switch(data[pos])
+            {
+            case ']': fail(data + pos, error_brack);
+            case '}': fail(data + pos, error_brace);
+            default:  fail(data + pos, error_comma);
+            }
+        }
+        state = done;
+        return false;
+    }
+
+    for(;;)
+    {
+        Reader reader(data + pos, data + size);
+        bool ok = reader.parse_value_into(out);
+        const char *stop = ok ? reader.scan().position() : nullptr;
+        if(ok && (stop != data + size || eof))
+        {
+            pos = stop - data;
+            break;
+        }
+        if(!eof && size - pos <= opt.max_element && refill())
+            continue;
+        if(ok)
+        {
+            pos = stop - data;
+            break;
+        }
+        const char *p = reader.scan().error_position();
+        fail(p ? p : reader.scan().position(), reader.scan().error());
+    }
+
+    ++count;
+    state = elements;
+    release_pages();
+    return true;
+}
+
+
+
+ArrayStream::ArrayStream(std::unique_ptr<Impl> p): impl(std::move(p)) {}
+
+
+ArrayStream::ArrayStream(Source src, const Options &opt): impl(new Impl(std::move(src), opt))
+{
+}
+
+
+ArrayStream ArrayStream::from_fd(int fd, const Options &opt)
+{
+    return ArrayStream(fd_source(fd), opt);
+}
+
+
+ArrayStream ArrayStream::from_memory(std::string_view text, const Options &opt)
+{
+    std::unique_ptr<Impl> p(new Impl);
+    p->opt = opt;
+    p->data = text.data();
+    p->size = text.size();
+    p->eof = true;
+    return ArrayStream(std::move(p));
+}
+
+
+ArrayStream ArrayStream::from_file(const std::string &path, const Options &opt)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::system_error(errno, std::generic_category(), "ArrayStream: open " + path);
+
+#ifndef _WIN32
+    struct stat st;
+    if(::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        std::size_t len = static_cast<std::size_t>(st.st_size);
+        void *m = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(m != MAP_FAILED)
+        {
+            ::close(fd);
+            ::madvise(m, len, MADV_SEQUENTIAL);
+            std::unique_ptr<Impl> p(new Impl);
+            p->opt = opt;
+            p->map = m;
+            p->map_len = len;
+            p->data = static_cast<const char *>(m);
+            p->size = len;
+            p->eof = true;
+            return ArrayStream(std::move(p));
+        }
+    }
+#endif
+
+    /// 不能mmap（例如管道、空文件）时按文件描述符读取，由Source持有并关闭fd
+    std::shared_ptr<int> owner(new int(fd), [](int *f) {
+#ifndef _WIN32
+        ::close(*f);
+#else
+        ::_close(*f);
+#endif
+        delete f;
+    });
+    Source read = fd_source(fd);
+    return ArrayStream([owner, read](char *buf, std::size_t cap) { return read(buf, cap); }, opt);
+}
+
+
+ArrayStream::ArrayStream(ArrayStream &&) noexcept = default;
+ArrayStream &ArrayStream::operator=(ArrayStream &&) noexcept = default;
+ArrayStream::~ArrayStream() = default;
+
+
+bool ArrayStream::next(Value &out)
+{
+    return impl->next(out);
+}
+
+
+std::size_t ArrayStream::count() const
+{
+    return impl->count;
+}
+
+
+ArrayStream::iterator::iterator(ArrayStream *s): stream(s), current(&s->impl->current)
+{
+    advance();
+}
+
+
+void ArrayStream::iterator::advance()
+{
+    if(!stream->next(*current))
+        stream = nullptr;
+}
+
+
+/**************************************
+ ParseStream算法说明：
+ 1、顶层不是Array/Object时读入全部输入后按Value::Parse解析；
+ 2、stack中是所有尚未闭合的容器，只在最内层的容器中工作：从它的开括号（或上一次解析到的位置）
+    做可以跨块继续的结构扫描（只跟踪字符串、转义与括号深度，同并行解析的预扫描），
+    扫描到窗口末尾为止；
+ 3、窗口中最后一个深度为0的逗号（或者闭括号）之前的元素都已完整，一次用
+    Reader::parse_elements/parse_members解析并追加到该容器中，然后丢弃这部分原文；
+ 4、剩下的不完整元素本身是Array/Object时（Object的成员还要求键与冒号已经完整），
+    不等待它结束，而是进入它：压入一个新的容器并从它的开括号之后继续，
+    因此即使文档只有一个巨大的成员（例如{"statuses":[...]}），窗口中也只有一个不完整的叶子元素；
+ 5、容器闭合时移入上一层（Object按插入的方式，重复键保留先出现的，与顺序解析一致），
+    之后上一层只允许「,」或者闭括号；
+ 6、顶层容器闭合后只允许空白，输入在此之前结束时报告缺少的括号。
+ 每个字符只被解析一次；结构扫描不检查括号种类是否配对，这类错误在解析各段时发现；
+ 键、冒号等不完整或者有错时不进入元素，留给Reader在元素完整（或输入结束）时报告错误。
+
+**************************************/
+namespace
+{
+
+struct Frame
+{
+    Value node;             /// 正在构造的Array/Object
+    bool isArray;
+    bool empty = true;      /// 还没有元素，也没有读到逗号
+    bool separator = false; /// 刚移入了一个子容器，下一个字符应为逗号或闭括号
+    String key;             /// 上一层是Object时，本容器对应的键
+
+    explicit Frame(bool array): node(array ? Value(Array()) : Value(Object())), isArray(array) {}
+};
+
+} // namespace
+
+
+Value ParseStream(ArrayStream::Source src, const StreamOptions &opt)
+{
+    Window w(std::move(src), opt);
+    if(!w.skip_ws())
+        w.fail(w.data + w.pos, error_empty);
+
+    if(w.data[w.pos] != '[' && w.data[w.pos] != '{')
+    {
+        while(w.refill())
+            ;
+        Value out;
+        Reader reader(w.data + w.pos, w.data + w.size);
+        if(!reader.parse_document(out))
+        {
+            const char *p = reader.scan().error_position();
+            w.fail(p ? p : reader.scan().position(), reader.scan().error());
+        }
+        return out;
+    }
+
+    std::vector<Frame> stack;
+    stack.emplace_back(w.data[w.pos] == '[');
+    ++w.pos;
+
+    std::size_t scanned = 0;    /// 最内层容器已扫描到w.pos + scanned
+    std::size_t depth = 0;
+    bool in_string = false, escaped = false;
+
+    /// 解析[w.pos, stop)中的完整元素，追加到最内层容器中
+    auto parse = [&](const char *stop) {
+        Frame &top = stack.back();
+        Reader reader(w.data + w.pos, w.data + w.size);
+        bool ok = top.isArray ? reader.parse_elements(top.node.as_Array(), stop)
+                              : reader.parse_members(top.node.as_Object(), stop);
+        if(!ok)
+        {
+            const char *p = reader.scan().error_position();
+            w.fail(p ? p : reader.scan().position(), reader.scan().error());
+        }
+        w.pos = stop - w.data;
+    };
+
+    /// 最内层容器在w.pos处闭合：弹出并移入上一层，返回false表示顶层已闭合
+    auto close = [&]() -> bool {
+        ++w.pos;
+        scanned = depth = 0;
+        in_string = escaped = false;
+        if(stack.size() == 1)
+            return false;
+
+        Frame done = std::move(stack.back());
+        stack.pop_back();
+        Frame &parent = stack.back();
+        if(parent.isArray)
+            parent.node.as_Array().push_back(std::move(done.node));
+        else
+            parent.node.as_Object().insert(std::make_pair(std::move(done.key), std::move(done.node)));
+        parent.separator = true;
+        return true;
+    };
+
+    /// 剩下的不完整元素是Array/Object时进入它
+    auto descend = [&]() -> bool {
+        const char *q = w.data + w.pos, *end = w.data + w.size;
+        while(q != end && IsSpace(*q)) ++q;
+        Value key;
+        if(!stack.back().isArray)
+        {
+            if(q == end || *q != '\"')
+                return false;
+            Reader reader(q, end);
+            if(!reader.parse_value(key))
+                return false;
+            q = reader.scan().position();
+            while(q != end && IsSpace(*q)) ++q;
+            if(q == end || *q != ':')
+                return false;
+            for(++q; q != end && IsSpace(*q); ++q) {}
+        }
+        if(q == end || (*q != '[' && *q != '{'))
+            return false;
+
+        Frame child(*q == '[');
+        if(!stack.back().isArray)
+            child.key = String(key.to_string());
+        stack.back().empty = false;
+        stack.push_back(std::move(child));
+        w.pos = q + 1 - w.data;
+        scanned = depth = 0;
+        in_string = escaped = false;
+        return true;
+    };
+
+    for(;;)
+    {
+        Frame &top = stack.back();
+        const char closer = top.isArray ? ']' : '}';
+
+        if(top.separator)
+        {
+            if(!w.skip_ws())
+                w.fail(w.data + w.pos, top.isArray ? error_brack : error_brace);
+            const char c = w.data[w.pos];
+            if(c == closer)
+            {
+                if(close())
+                    continue;
+                break;
+            }
+            if(c != ',')
+                w.fail(w.data + w.pos, c == (top.isArray ? '}' : ']') ? error_mismatch : error_comma);
+            ++w.pos;
+            top.separator = false;
+            continue;
+        }
+
+        const char *cut = nullptr, *end = w.data + w.size, *closing = nullptr;
+        const char *p = w.data + w.pos + scanned;
+        for(; p != end && closing == nullptr; ++p)
+        {
+            const char c = *p;
+            if(in_string)
+            {
+                if(escaped)
+                    escaped = false;
+                else if(c == '\\')
+                    escaped = true;
+                else if(c == '\"')
+                    in_string = false;
+                continue;
+            }
+            switch(c)
+            {
+            case '\"':
+                in_string = true;
+                break;
+            case '[': case '{':
+                ++depth;
+                break;
+            case ']': case '}':
+                if(depth == 0)
+                    closing = p;
+                else
+                    --depth;
+                break;
+            case ',':
+                if(depth == 0)
+                    cut = p;
+                break;
+            }
+        }
+
+        if(closing)
+        {
+            const char *q = w.data + w.pos;
+            while(q != closing && IsSpace(*q))
+                ++q;
+            /// 空的容器与不配对的括号也交给Reader，错误码与Value::Parse相同（例如「{]」为error_pair）
+            if(q != closing || !top.empty || *closing != closer)
+                parse(closing);
+            else
+                w.pos = closing - w.data;
+            if(*closing != closer)
+                w.fail(closing, error_mismatch);
+            if(close())
+                continue;
+            break;
+        }
+
+        if(cut)
+        {
+            parse(cut);
+            ++w.pos;
+            top.empty = false;
+        }
+        scanned = p - (w.data + w.pos);
+
+        if(descend())
+            continue;
+        if(!w.refill())
+        {
+            /// 输入在闭括号之前结束：先解析剩余部分以得到其中的错误
+            const char *q = w.data + w.pos;
+            while(q != end && IsSpace(*q))
+                ++q;
+            if(q != end || !top.empty)
+                parse(end);
+            w.fail(end, top.isArray ? error_brack : error_brace);
+        }
+    }
+
+    while(w.skip_ws())
+    {
+        switch(w.data[w.pos])
+        {
+        case ']': w.fail(w.data + w.pos, error_brack);
+        case '}': w.fail(w.data + w.pos, error_brace);
+        default:  w.fail(w.data + w.pos, error_comma);
+        }
+    }
+    return std::move(stack.back().node);
+}
+
+
+_JSON_END
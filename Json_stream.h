@@ -0,0 +1,189 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "Json_error.h"
+#include "Json_type.h"
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#define JSON_HAS_COROUTINE 1
+#endif
+
+_JSON_BEGIN
+
+/// ArrayStream的选项
+struct StreamOptions
+{
+    std::size_t chunk_size = 1 << 16;     /// 每次读取的字节数
+    std::size_t max_element = 1 << 26;    /// 单个元素的最大字节数，超过时按格式错误处理
+    bool read_ahead = true;               /// 用后台线程预读（只对Source与文件描述符有效）
+};
+
+
+/**************************************
+ ArrayStream：逐个读取顶层json数组的元素，不构造整个Array。
+ 1、数据来自任意的块读取函数（Source）、文件描述符、内存或者mmap的文件；
+ 2、next每次解析一个元素，用Value::ParseInto的方式重用上一个元素的结点，
+    缓冲区只保存尚未处理的数据，内存占用与单个元素的大小成正比；
+ 3、read_ahead为true时由一个后台线程预先读取后面的数据块，
+    处理第n个元素的同时读取第n+1个元素所在的数据；
+ 4、mmap的文件依靠内核预读，已处理的页面及时交还（MADV_DONTNEED），常驻内存同样有界；
+ 5、格式错误时抛出JsonError，偏移、行号与列号都相对于整个输入；
+    读取文件出错时抛出std::system_error，Source抛出的异常原样传给调用者。
+ 支持C++20协程时，elements()返回一个生成器，可以用于range-for。
+
+**************************************/
+class ArrayStream
+{
+public:
+    /// 读取最多cap个字节到buf中，返回读到的字节数，0表示输入结束；出错时抛出异常
+    typedef std::function<std::size_t(char *buf, std::size_t cap)> Source;
+
+    typedef StreamOptions Options;
+
+    explicit ArrayStream(Source src, const Options &opt = Options());
+    /// fd由调用者关闭；read_ahead时析构会等待后台线程正在进行的read返回
+    static ArrayStream from_fd(int fd, const Options &opt = Options());
+    /// text在ArrayStream销毁之前必须有效，不复制
+    static ArrayStream from_memory(std::string_view text, const Options &opt = Options());
+    /// mmap整个文件（不支持mmap的平台上按文件描述符读取）
+    static ArrayStream from_file(const std::string &path, const Options &opt = Options());
+
+    ArrayStream(ArrayStream &&) noexcept;
+    ArrayStream &operator=(ArrayStream &&) noexcept;
+    ~ArrayStream();
+
+    /// 读取下一个元素到out中（尽量重用out原有的结点），没有更多元素时返回false
+    bool next(Value &out);
+    /// 已读取的元素个数
+    std::size_t count() const;
+
+    /// 输入迭代器：解引用得到内部的Value，下一次++之后其内容被下一个元素覆盖
+    class iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef Value value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Value *pointer;
+        typedef Value &reference;
+
+        iterator(): stream(nullptr) {}
+        Value &operator*() const { return *current; }
+        Value *operator->() const { return current; }
+        iterator &operator++() { advance(); return *this; }
+        bool operator==(const iterator &rhs) const { return stream == rhs.stream; }
+        bool operator!=(const iterator &rhs) const { return stream != rhs.stream; }
+
+    private:
+        friend class ArrayStream;
+        explicit iterator(ArrayStream *s);
+        void advance();
+
+        ArrayStream *stream;
+        Value *current;
+    };
+
+    iterator begin() { return iterator(this); }
+    iterator end() { return iterator(); }
+
+#ifdef JSON_HAS_COROUTINE
+    template<typename T> class Generator;
+    /// 协程生成器：co_yield每个元素（内部Value的引用，含义同iterator）
+    Generator<Value> elements();
+#endif
+
+private:
+    struct Impl;
+    explicit ArrayStream(std::unique_ptr<Impl> p);
+
+    std::unique_ptr<Impl> impl;
+};
+
+
+#ifdef JSON_HAS_COROUTINE
+/// 最简单的同步生成器：每次恢复协程得到下一个co_yield的值
+template<typename T>
+class ArrayStream::Generator
+{
+public:
+    struct promise_type
+    {
+        T *value = nullptr;
+        std::exception_ptr error;
+
+        Generator get_return_object()
+            { return Generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(T &v) noexcept { value = &v; return {}; }
+        void return_void() {}
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    class iterator
+    {
+    public:
+        explicit iterator(std::coroutine_handle<promise_type> h = nullptr): h(h) { resume(); }
+        T &operator*() const { return *h.promise().value; }
+        iterator &operator++() { resume(); return *this; }
+        bool operator==(std::default_sentinel_t) const { return !h || h.done(); }
+
+    private:
+        void resume()
+        {
+            if(!h)
+                return;
+            h.resume();
+            if(h.promise().error)
+                std::rethrow_exception(h.promise().error);
+        }
+        std::coroutine_handle<promise_type> h;
+    };
+
+    Generator(Generator &&rhs) noexcept: h(std::exchange(rhs.h, nullptr)) {}
+    Generator(const Generator &) = delete;
+    ~Generator() { if(h) h.destroy(); }
+
+    iterator begin() { return iterator(h); }
+    std::default_sentinel_t end() { return {}; }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> h): h(h) {}
+    std::coroutine_handle<promise_type> h;
+};
+
+
+inline ArrayStream::Generator<Value> ArrayStream::elements()
+{
+    Value v;
+    while(next(v))
+        co_yield v;
+}
+#endif
+
+
+/**************************************
+ ParseStream：从Source逐块读取并解析整个json文档，返回与Value::Parse相同的结果。
+ 顶层Array/Object的元素在所在的数据块到达后立即解析，已解析的原文随即丢弃，
+ 因此内存中只有结果与一个数据窗口，不需要先把整个输入读入一个字符串；
+ 读取与解析可以重叠（见StreamOptions::read_ahead与Decompress）。
+ 格式错误时抛出JsonError，偏移、行号与列号都相对于整个输入。
+
+**************************************/
+Value ParseStream(ArrayStream::Source src, const StreamOptions &opt = StreamOptions());
+
+
+_JSON_END
+#endif // JSON_STREAM_H
@@ -1,701 +1,1238 @@
-#include <stack>
-#include <string>
-#include <sstream>
-#include <cstring>
-#include "Json_error.h"
-#include "Json_string.h"
-#include "Json_type.h"
-
-_JSON_BEGIN
-
-
-/// ɾַβĿհ׷\u0020\t\n\r\v\f
-std::string erase_head_tail_ws(const std::string &s)
-{
-    auto b = s.cbegin(), e = s.cend();
-
-    while(b != e && IsSpace(*b)) ++ b;
-    while(e != b && IsSpace(*(e-1))) --e;
-
-    return {b, e};
-}
-
-
-/**************************************
- ɾַУ˫֮ڵģпհ׷\u0020\t\n\r\v\f
- 㷨
- 1αÿַ
-    1.1ǿհַ߸ַ˫֮ڣӵַУ򲻴
-    1.2ȷǰǷ˫֮ڣ
-                "䲻תеһ֣Ǽ˫ţǼ뿪˫
-    1.3ȷ¸ַǷתеһ֣
-                ǰ˫֮ڣҵǰַΪ\
-                1.3.1ǰַ\תУ¸ַתеһ
-                1.3.2¸ַתеһ
- 2ؽ
-
-**************************************/
-std::string erase_all_whitespace(const std::string &s)
-{
-    bool inQuote = false, nextEscape = false;
-    std::string ret;
-    for (decltype(s.size()) i = 0; i != s.size(); ++i)
-    {
-        if (!IsSpace(s[i]) || inQuote)
-        ret.push_back(s[i]);
-
-        inQuote ^= (s[i] == '\"') && !nextEscape;
-        nextEscape = inQuote && s[i] == '\\' && !nextEscape;
-    }
-    return ret;
-}
-
-
-
-auto next_comma(const SubString &subStr) ->decltype(subStr.first)
-{
-    std::stack<char> letters;
-    bool inQuote = false, nextEscape = false;
-
-    for(auto b = subStr.first, e = subStr.second; b != e; ++b)
-    {
-        inQuote ^= (*b == '\"') && !nextEscape;
-        nextEscape = inQuote && *b == '\\' && !nextEscape;
-        if(inQuote) continue;
-
-        if(*b == ',' && letters.empty())
-            return b;
-
-        switch(*b)
-        {
-        case '[': case '{':
-            letters.push(*b); break;
-
-        case ']':
-            if(letters.empty() || letters.top() != '[')
-                throw JsonError(error_brack);
-            else
-                letters.pop();
-            break;
-
-        case '}':
-            if(letters.empty() || letters.top() != '{')
-                throw JsonError(error_brace);
-            else
-                letters.pop();
-            break;
-        }
-    }
-    if(!letters.empty())
-        throw JsonError(error_mismatch);
-    return subStr.second;
-}
-
-
-
-String String::Parse(const JsonString &js)
-{
-    auto ret = erase_head_tail_ws(js);
-    SubString subStr(ret.c_str(), ret.c_str() + ret.size());
-    return doParse(subStr);
-}
-
-
-/**************************************
- String::Parse㷨˵
- 1ַΪգ׳ error_empty
- 2ַΪ1βַǡ"׳ error_quote
- 3ַӵַУ
-    3.1δתġ"ַ\u0000-\u001f,׳ error_escape
-    3.2\ʱĸǡ"\/bfnrtuеһ׳ error_escape
-            3.2.1\š"\/bfnrtеһתַӵַ
-            3.2.2\šuĸַתУ
-                     תַӵַСʧܣ׳error_escape
- 4ؽ
-
-**************************************/
-String String::doParse(const SubString &subStr)
-{
-    if(subStr.length() == 0)
-        throw JsonError(error_empty);
-
-    if(subStr.length() == 1
-            || *subStr.first != '\"' || *(subStr.second - 1) != '\"')
-        throw JsonError(error_quote);
-
-    std::string content;
-
-    for(auto b = subStr.first + 1, e = subStr.second - 1; b != e; )
-    {
-        if(*b == '\"' || IsCntrl(*b))
-            throw JsonError(error_escape);
-
-        if(*b == '\\')
-        {
-            if(b + 1 == e)
-                throw JsonError(error_escape);
-            ++b;
-
-            switch (*b)
-            {
-            case '\"':
-                content.push_back('\"');
-                ++b;
-                break;
-
-            case '\\':
-                content.push_back('\\');
-                ++b;
-                break;
-
-            case '/':
-                content.push_back('/');
-                ++b;
-                break;
-
-            case 'b':
-                content.push_back('\b');
-                ++b;
-                break;
-
-            case 'f':
-                content.push_back('\f');
-                ++b;
-                break;
-
-            case 'n':
-                content.push_back('\n');
-                ++b;
-                break;
-
-            case 'r':
-                content.push_back('\r');
-                ++b;
-                break;
-
-            case 't':
-                content.push_back('\t');
-                ++b;
-                break;
-
-            case 'u':
-            {
-                ++b;  /// ָתֲֵĵһַ
-                if(b + 4 > e)
-                    throw JsonError(error_escape);
-
-                std::string hexstr(b, b + 4);
-                if(hexstr.find_first_not_of("0123456789AaBbCcDdEeFf")
-                        != std::string::npos)
-                    throw JsonError(error_escape);
-
-                std::istringstream stream(hexstr);
-                unsigned n;
-                stream >> std::hex >> n;
-                content.push_back(static_cast<char>(n));
-                b += 4; /// תеֲ֣4ʮַ
-            }
-            break;
-
-            default:
-                throw JsonError(error_escape);
-                break;
-            }
-        }
-        else
-        {
-            content.push_back(*b);
-            ++b;
-        }
-    }
-
-    return String(content);
-}
-
-
-
-/**************************************
- String::Serialize㷨˵
- 1ַһӵַУ
-    1.1\"\\\/\b\f\n\r\tʱǵתӵַУ
-    1.2ַ\u0000-\u001fȡǶӦ16תУ
- 2ڽַβӡ";
- 3ؽ
-
-**************************************/
-JsonString String::Serialize() const
-{
-    std::string ret = "\"";
-
-    for (auto c : str)
-    {
-        switch (c)
-        {
-        case '\"':
-            ret += "\\\""; break;
-
-        case '\\':
-            ret += "\\\\"; break;
-
-        case '/':
-            ret += "/"; break;  /// ע⣺/ԭjson.orgЩһ
-
-        case '\b':
-            ret += "\\b"; break;
-
-        case '\f':
-            ret += "\\f"; break;
-
-        case '\n':
-            ret += "\\n"; break;
-
-        case '\r':
-            ret += "\\r"; break;
-
-        case '\t':
-            ret += "\\t"; break;
-
-        default:
-            if (IsCntrl(c))
-            {
-                std::ostringstream buffer;
-                buffer << std::hex << static_cast<unsigned>(c);
-
-                std::string hex = buffer.str();
-
-                /// ccharwchar_t͵ģ˴׳쳣
-                ///if (hex.size() > 4)
-                ///    throw JsonError(error_escape);
-
-                hex.insert(hex.begin(), 4 - hex.size(), '0');
-                ret += "\\u" + hex;
-            }
-            else
-            {
-                ret.push_back(c);
-            }
-            break;
-        }
-    }
-
-    return ret + "\"";
-}
-
-
-
-Object Object::Parse(const JsonString &js)
-{
-    auto ret = erase_all_whitespace(js);
-    SubString subStr(ret.c_str(), ret.c_str() + ret.size());
-    return doParse(subStr);
-}
-
-
-/**************************************
- Object::Parse㷨˵
- 1ַΪգ׳ error_empty
- 2ַΪ1βַǡ{}׳ error_brace;
- 3{}ַ֮next_commaҵһλû߽λã
-    ֮ġֵԡӵmap
- 4ؽ
-
-**************************************/
-Object Object::doParse(const SubString &subStr)
-{
-    if(subStr.length() == 0)
-        throw JsonError(error_empty);
-
-    if(subStr.length() == 1
-       || *subStr.first != '{' || *(subStr.second - 1) != '}')
-        throw JsonError(error_brace);
-
-    Object ret;
-    for(auto b = subStr.first + 1, e = subStr.second - 1; b != e; )
-    {
-        auto comma = next_comma(SubString(b, e));
-        if(b == comma || comma + 1 == e)
-            throw JsonError(error_comma);
-
-        auto p = parse_pair(SubString(b, comma));
-        ret.insert(std::move(p));
-
-        if(comma == e)
-            break;
-        else
-            b = comma + 1;
-    }
-    return ret;
-}
-
-
-/**************************************
- Object::parse_pair㷨˵
- 1ַΪգ׳ error_empty
- 2ַΪ1׳ error_pair
- 3ַҵðҲ˫֮ڣðߵֱַStringValue
- 4ؽ
-
-**************************************/
-std::pair<String, Value>
-    Object::parse_pair(const SubString &subStr)
-
-{
-    if(subStr.length() == 0)
-        throw JsonError(error_empty);
-    if(subStr.length() == 1)
-        throw JsonError(error_pair);
-
-    bool inQuote = false, nextEscape = false;
-    auto b = subStr.first, e = subStr.second;
-    for(; b != e; ++b)
-    {
-        inQuote ^= (*b == '\"') && !nextEscape;
-        nextEscape = inQuote && *b == '\\' && !nextEscape;
-
-        if(inQuote) continue;
-        if(*b == ':') break;
-    }
-
-    if(b == e || b == subStr.first || b + 1 == subStr.second)
-        throw JsonError(error_pair);
-
-    String key = String::doParse(SubString(subStr.first, b));
-    Value value = Value::doParse(SubString(++b, e));
-
-    return {std::move(key), std::move(value)};
-}
-
-
-
-JsonString Object::Serialize() const
-{
-    std::string ret;
-    for(auto it = obj.cbegin(); it != obj.cend(); ++it)
-    {
-        if(it != obj.cbegin())
-            ret += ",";
-        ret += it->first.Serialize() + ":" + it->second.Serialize();
-    }
-    return "{" + ret + "}";
-}
-
-
-/**************************************
- Object::doFormat㷨˵
- 1Ϊգԭ
- 2Ϊգ
-    2.1{У
-    2.2ÿһһԪأʹãnest + 1* padstr࿪ͷ
-    2.3}ʹnest * padstr࿪ͷ
- 4ؽ
-
-**************************************/
-JsonString Object::doFormat(unsigned nest,
-                            const JsonString &padstr) const
-{
-    if(obj.empty())
-        return Serialize();
-
-    std::string ret;
-    for(auto it = obj.cbegin(); it != obj.cend(); ++it)
-    {
-        if(it != obj.cbegin())
-            ret += ",\n";
-        for(unsigned index = 0; index != nest + 1; ++index)
-            ret += padstr;
-        ret += it->first.doFormat(nest + 1, padstr);
-        ret += ": ";
-        ret += it->second.doFormat(nest + 1, padstr);
-    }
-
-    ret = "{\n" + ret + "\n";
-    for(unsigned index = 0; index != nest; ++index)
-        ret += padstr;
-    ret += "}";
-    return ret;
-}
-
-
-
-
-Array Array::Parse(const JsonString &js)
-{
-    auto ret = erase_all_whitespace(js);
-    SubString subStr(ret.c_str(), ret.c_str() + ret.size());
-    return doParse(subStr);
-}
-
-
-
-/**************************************
- Array::Parse㷨˵
- 1ַΪգ׳ error_empty
- 2ַΪ1βַǡ[]׳ error_brack;
- 3[]ַ֮next_commaҵһλû߽λã
-    ֮Valueӵvector
- 4ؽ
-
-**************************************/
-Array Array::doParse(const SubString &subStr)
-{
-    if(subStr.length() == 0)
-        throw JsonError(error_empty);
-
-    if(subStr.length() == 1
-       || *subStr.first != '[' || *(subStr.second - 1) != ']')
-       throw JsonError(error_brack);
-
-    Array ret;
-    for(auto b = subStr.first + 1, e = subStr.second - 1; b != e;)
-    {
-        auto comma = next_comma(SubString(b, e));
-        if(b == comma || comma + 1 == e)
-            throw JsonError(error_comma);
-
-        Value value = Value::doParse(SubString(b, comma));
-        ret.push_back(std::move(value));
-
-        if(comma == e)
-            break;
-        else
-            b = comma + 1;
-    }
-    return ret;
-}
-
-
-
-JsonString Array::Serialize() const
-{
-    std::string ret;
-    for (auto it = arr.cbegin(); it != arr.cend(); ++it)
-    {
-        if (it != arr.cbegin())
-            ret += ",";
-        ret += it->Serialize();
-    }
-    return "[" + ret + "]";
-}
-
-
-
-JsonString Array::doFormat(unsigned nest,
-                           const JsonString &padstr) const
-{
-    if(arr.empty())
-        return Serialize();
-
-    std::string ret;
-    for(auto it = arr.cbegin(); it != arr.cend(); ++it)
-    {
-        if(it != arr.cbegin())
-            ret += ",\n";
-        for(unsigned index = 0; index != nest + 1; ++index)
-            ret += padstr;
-        ret += it->doFormat(nest + 1, padstr);
-    }
-    ret = "[\n" + ret + "\n";
-    for(unsigned index = 0; index != nest; ++index)
-        ret += padstr;
-    ret += "]";
-    return ret;
-}
-
-
-
-True True::Parse(const JsonString &js)
-{
-    auto ret = erase_head_tail_ws(js);
-    SubString subStr(ret.c_str(), ret.c_str() + ret.size());
-    return doParse(subStr);
-}
-
-
-True True::doParse(const SubString &subStr)
-{
-    if(std::strncmp(subStr.first, "true", 4) != 0)
-        throw JsonError(error_literal);
-    return True();
-}
-
-
-False False::Parse(const JsonString &js)
-{
-    auto ret = erase_head_tail_ws(js);
-    SubString subStr(ret.c_str(), ret.c_str() + ret.size());
-    return doParse(subStr);
-}
-
-
-False False::doParse(const SubString &subStr)
-{
-    if(std::strncmp(subStr.first, "false", 5) != 0)
-        throw JsonError(error_literal);
-    return False();
-}
-
-
-Null Null::Parse(const JsonString &js)
-{
-    auto ret = erase_head_tail_ws(js);
-    SubString subStr(ret.c_str(), ret.c_str() + ret.size());
-    return doParse(subStr);
-}
-
-
-Null Null::doParse(const SubString &subStr)
-{
-    if(std::strncmp(subStr.first, "null", 4) != 0)
-        throw JsonError(error_literal);
-    return Null();
-}
-
-
-
-
-Value &Value::operator=(const Value &rhs)
-{
-    auto newp = rhs.pbase ?
-        rhs.pbase->clone(): nullptr;
-    delete pbase;
-    pbase = newp;
-    return *this;
-}
-
-
-Value &Value::operator=(Value &&rhs) noexcept
-{
-    if(this != &rhs)
-    {
-        delete pbase;
-        pbase = rhs.pbase;
-        rhs.pbase = nullptr;
-    }
-    return *this;
-}
-
-
-
-Value Value::Parse(const JsonString &js)
-{
-    auto ret = erase_all_whitespace(js);
-    SubString subStr(ret.c_str(), ret.c_str() + ret.size());
-    return doParse(subStr);
-}
-
-
-/**************************************
- Value::Parse㷨˵
- 1ַΪգ׳ error_empty
- 2ַСΪ1Number
- 3ַСڵ2
-    3.1βַΪ""String
-    3.2βַΪ[]Array
-    3.3βַΪ{}Object
- 4ַСΪ4ҵ"true"True()
- 5ַСΪ5ҵ"false"False()
- 6ַСΪ4ҵ"null"Null();
- 7Number
-
-**************************************/
-Value Value::doParse(const SubString &subStr)
-{
-    if(subStr.length() == 0)
-        throw JsonError(error_empty);
-
-    if(subStr.length() == 1)
-        return Number::doParse(subStr);
-
-    char head = *(subStr.first), tail = *(subStr.second -1);
-
-    if(head == '[' && tail == ']')
-        return Array::doParse(subStr);
-
-    if(head == '[' || head == ']')
-        throw JsonError(error_brack);
-
-
-    if(head == '{' && tail == '}')
-        return Object::doParse(subStr);
-
-    if(head == '{' || tail == '}')
-        throw JsonError(error_brace);
-
-
-    if(head == '\"' && tail == '\"')
-        return String::doParse(subStr);
-
-    if(head == '\"' || tail == '\"')
-        throw JsonError(error_quote);
-
-
-    if(subStr.length() == 4
-       && std::strncmp(subStr.first, "true", 4) == 0)
-        return True();
-
-    if(subStr.length() == 5
-       && std::strncmp(subStr.first, "false", 5) == 0)
-        return False();
-
-    if(subStr.length() == 4
-       && std::strncmp(subStr.first, "null", 4) == 0)
-       return Null();
-
-    return Number::doParse(subStr);
-}
-
-
-
-void Value::check() const
-{
-    if(pbase == nullptr)
-        throw JsonError(deref_nullptr);
-}
-
-
-JsonType Value::Type() const
-{
-    check();
-    return pbase->Type();
-}
-
-
-JsonString Value::Serialize() const
-{
-    check();
-    return pbase->Serialize();
-}
-
-
-JsonString Value::Format(const JsonString &padstr) const
-{
-    check();
-    return pbase->Format(padstr);
-}
-
-JsonString Value::doFormat(unsigned nest,
-                           const JsonString &padstr) const
-{
-    check();
-    return pbase->doFormat(nest, padstr);
-}
-
-#define GETPOINTERIMPL(_FuncName, _ClassName) \
-_ClassName *Value::_FuncName() const \
-{ \
-    auto p = dynamic_cast<_ClassName*>(pbase); \
-    if(!p) \
-        throw JsonError(json_bad_cast); \
-    return p; \
-}
-
-GETPOINTERIMPL(getString, String)
-GETPOINTERIMPL(getNumber, Number)
-GETPOINTERIMPL(getObject, Object)
-GETPOINTERIMPL(getArray, Array)
-GETPOINTERIMPL(getTrue, True)
-GETPOINTERIMPL(getFalse, False)
-GETPOINTERIMPL(getNull, Null)
-
-
-_JSON_END
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Json_error.h"
+#include "Json_string.h"
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+
+/// 删除字符串首尾的空白符「\u0020\t\n\r\v\f」
+std::string erase_head_tail_ws(const std::string &s)
+{
+    auto b = s.cbegin(), e = s.cend();
+
+    while(b != e && IsSpace(*b)) ++ b;
+    while(e != b && IsSpace(*(e-1))) --e;
+
+    return {b, e};
+}
+
+
+/**************************************
+ 删除字符串中（不包括双引号之内的）所有空白符「\u0020\t\n\r\v\f」
+ 算法描述：
+ 1、依次遍历每个字符
+    （1.1）如果不是空白字符，或者该字符在双引号之内，将它添加到结果字符串中，否则不处理
+    （1.2）确定当前是否处于双引号之内：
+                如果遇到「"」且其不属于转义序列的一部分，则不是即将进入双引号，就是即将离开双引号
+    （1.3）确定下个字符是否属于转义序列的一部分：
+                如果当前处于双引号之内，且当前字符为「\」
+                （1.3.1）如果当前字符「\」属于转义序列，则下个字符不属于转义序列的一部分
+                （1.3.2）否则，下个字符属于转义序列的一部分
+ 2、结束，返回结果
+
+**************************************/
+std::string erase_all_whitespace(const std::string &s)
+{
+    bool inQuote = false, nextEscape = false;
+    std::string ret;
+    for (decltype(s.size()) i = 0; i != s.size(); ++i)
+    {
+        if (!IsSpace(s[i]) || inQuote)
+        ret.push_back(s[i]);
+
+        inQuote ^= (s[i] == '\"') && !nextEscape;
+        nextEscape = inQuote && s[i] == '\\' && !nextEscape;
+    }
+    return ret;
+}
+
+
+
+/**************************************
+ String::Serialize算法说明：
+ 1、遍历字符串，将它们一次添加到结果字符串中；
+    （1.1）如果遇到「\"\\\/\b\f\n\r\t」时，将它们的转义序列添加到结果字符串中；
+    （1.2）如果遇到控制字符「\u0000-\u001f」，取它们对应的16进制转义序列；
+ 2、在结果字符串的首尾添加「"」;
+ 3、结束，返回结果
+
+**************************************/
+JsonString String::Serialize() const
+{
+    std::string ret = "\"";
+
+    for (auto c : str)
+    {
+        switch (c)
+        {
+        case '\"':
+            ret += "\\\""; break;
+
+        case '\\':
+            ret += "\\\\"; break;
+
+        case '/':
+            ret += "/"; break;  /// 注意：「/」按原样输出，这与json.org上有些不一样
+
+        case '\b':
+            ret += "\\b"; break;
+
+        case '\f':
+            ret += "\\f"; break;
+
+        case '\n':
+            ret += "\\n"; break;
+
+        case '\r':
+            ret += "\\r"; break;
+
+        case '\t':
+            ret += "\\t"; break;
+
+        default:
+            if (IsCntrl(c))
+            {
+                std::ostringstream buffer;
+                buffer << std::hex << static_cast<unsigned>(c);
+
+                std::string hex = buffer.str();
+
+                /// 如果c是char或者wchar_t类型的，则此处不会抛出异常
+                ///if (hex.size() > 4)
+                ///    throw JsonError(error_escape);
+
+                hex.insert(hex.begin(), 4 - hex.size(), '0');
+                ret += "\\u" + hex;
+            }
+            else
+            {
+                ret.push_back(c);
+            }
+            break;
+        }
+    }
+
+    return ret + "\"";
+}
+
+
+
+namespace
+{
+
+/// Serialize、doFormat、hash与equal在当前线程中的递归层数，
+/// 达到Value::recursion_limit之后更深的部分改用显式的栈（见Value::serialize_deep）
+thread_local unsigned serialize_depth = 0;
+thread_local unsigned format_depth = 0;
+thread_local unsigned hash_depth = 0;
+thread_local unsigned equal_depth = 0;
+
+/// 正在进行的显式栈比较：不为空时，Value::equal遇到两个容器只登记在这里，由开始这次比较的equal稍后比较
+thread_local std::vector<std::pair<const Value_base *, const Value_base *>> *comparing = nullptr;
+
+} // namespace
+
+
+/// 有保存的序列化结果时直接复制，否则逐个元素生成，需要时保存结果
+JsonString Object::Serialize() const
+{
+    if(const std::string *text = cache.cached_text())
+        return *text;
+
+    std::string ret;
+    if(serialize_depth == Value::recursion_limit)
+    {
+        Value::serialize_deep(this, ret);
+        return ret;
+    }
+    Value::Nesting nesting(serialize_depth);
+    for_each([&ret](const String &k, const Value &v) {
+        if(!ret.empty())
+            ret += ",";
+        ret += k.Serialize() + ":" + v.Serialize();
+    });
+    ret = "{" + ret + "}";
+    if(cache.keep_text)
+        cache.store_text(ret);
+    return ret;
+}
+
+
+/**************************************
+ Object::doFormat算法说明：
+ 1、如果对象为空，则原样输出
+ 2、如果对象不为空，
+    （2.1）输出{并换行，
+    （2.2）每一行输出一个元素，并使用（nest + 1）* padstr填充左侧开头。
+    （2.3）输出}，并使用nest * padstr填充左侧开头
+ 4、结束，返回结果。
+
+**************************************/
+JsonString Object::doFormat(unsigned nest,
+                            const JsonString &padstr) const
+{
+    if(empty())
+        return Serialize();
+
+    std::string ret;
+    if(format_depth == Value::recursion_limit)
+    {
+        Value::format_deep(this, nest, padstr, ret);
+        return ret;
+    }
+    Value::Nesting nesting(format_depth);
+    for_each([&](const String &k, const Value &v) {
+        if(!ret.empty())
+            ret += ",\n";
+        for(unsigned index = 0; index != nest + 1; ++index)
+            ret += padstr;
+        ret += k.doFormat(nest + 1, padstr);
+        ret += ": ";
+        ret += v.doFormat(nest + 1, padstr);
+    });
+
+    ret = "{\n" + ret + "\n";
+    for(unsigned index = 0; index != nest; ++index)
+        ret += padstr;
+    ret += "}";
+    return ret;
+}
+
+
+
+
+Object::Object(const Object &rhs):
+    Value_base(rhs), obj(rhs.obj), cache(rhs.cache)
+{
+    if(rhs.packed)
+    {
+        Packed *p = alloc_packed(rhs.packed->shape);
+        try
+        {
+            for(; p->size != rhs.packed->size; ++p->size)
+                new (p->slots() + p->size) Value(rhs.packed->slots()[p->size]);
+        }
+        catch(...)
+        {
+            free_packed(p);
+            throw;
+        }
+        packed = p;
+    }
+}
+
+
+Object::Object(Object &&rhs) noexcept:
+    Value_base(std::move(rhs)), obj(std::move(rhs.obj)),
+    packed(std::exchange(rhs.packed, nullptr)), cache(std::move(rhs.cache))
+{
+}
+
+
+Object &Object::operator=(const Object &rhs)
+{
+    if(this != &rhs)
+    {
+        Object tmp(rhs);
+        *this = std::move(tmp);
+    }
+    return *this;
+}
+
+
+Object &Object::operator=(Object &&rhs) noexcept
+{
+    if(this != &rhs)
+    {
+        free_packed(std::exchange(packed, std::exchange(rhs.packed, nullptr)));
+        obj = std::move(rhs.obj);
+        cache = std::move(rhs.cache);
+    }
+    return *this;
+}
+
+
+Object::~Object()
+{
+    free_packed(packed);
+}
+
+
+Object::Packed *Object::alloc_packed(const Shape *shape)
+{
+    void *mem = allocate_block(sizeof(Packed) + shape->size() * sizeof(Value));
+    Packed *p = new (mem) Packed{shape, 0, {nullptr}};
+    shape->retain();
+    return p;
+}
+
+
+void Object::free_packed(Packed *p) noexcept
+{
+    if(p)
+    {
+        delete p->view.load(std::memory_order_acquire);
+        for(std::size_t i = 0; i != p->size; ++i)
+            p->slots()[i].~Value();
+        p->shape->release();
+        p->~Packed();
+        deallocate_block(p);
+    }
+}
+
+
+/// 把压缩的成员移回map：view与map来自同一个memory_resource时直接使用它，
+/// 否则按键的顺序逐个插入（键在map的memory_resource中复制）
+void Object::unpack()
+{
+    Packed *p = std::exchange(packed, nullptr);
+    _Type *view = p->view.exchange(nullptr, std::memory_order_acq_rel);
+    if(view && view->get_allocator() != obj.get_allocator())
+    {
+        delete view;
+        view = nullptr;
+    }
+    auto scope = inherit();
+    try
+    {
+        if(view)
+        {
+            obj = std::move(*view);
+            delete view;
+        }
+        else
+        {
+            for(std::size_t i = 0; i != p->size; ++i)
+                obj.emplace_hint(obj.end(), p->shape->key(i), std::move(p->slots()[i]));
+        }
+    }
+    catch(...)
+    {
+        free_packed(p);
+        throw;
+    }
+    free_packed(p);
+}
+
+
+/// 多个线程同时生成时，只有一个能够发布，其余的丢弃自己的拷贝；
+/// view总是在::operator new中生成（同Array::dense_view）
+const Object::_Type &Object::packed_view() const
+{
+    if(const _Type *view = packed->view.load(std::memory_order_acquire))
+        return *view;
+
+    ResourceScope scope(nullptr);
+    std::unique_ptr<_Type> fresh(new _Type);
+    for(std::size_t i = 0; i != packed->size; ++i)
+        fresh->emplace_hint(fresh->end(), packed->shape->key(i), packed->slots()[i]);
+
+    _Type *expected = nullptr;
+    if(packed->view.compare_exchange_strong(expected, fresh.get(),
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire))
+        return *fresh.release();
+    return *expected;
+}
+
+
+
+JsonString Array::Serialize() const
+{
+    if(const std::string *text = cache.cached_text())
+        return *text;
+
+    std::string ret;
+    if(const Dense *d = dense_values())
+    {
+        char buf[32];
+        ret += '[';
+        for(std::size_t i = 0; i != d->size(); ++i)
+        {
+            if(i != 0)
+                ret += ',';
+            ret.append(buf, d->format(i, buf));
+        }
+        ret += ']';
+    }
+    else if(serialize_depth == Value::recursion_limit)
+    {
+        Value::serialize_deep(this, ret);
+        return ret;
+    }
+    else
+    {
+        Value::Nesting nesting(serialize_depth);
+        const _Type &elems = elements();
+        for (auto it = elems.cbegin(); it != elems.cend(); ++it)
+        {
+            if (it != elems.cbegin())
+                ret += ",";
+            ret += it->Serialize();
+        }
+        ret = "[" + ret + "]";
+    }
+    if(cache.keep_text)
+        cache.store_text(ret);
+    return ret;
+}
+
+
+
+JsonString Array::doFormat(unsigned nest,
+                           const JsonString &padstr) const
+{
+    if(empty())
+        return Serialize();
+
+    std::string ret;
+    if(format_depth == Value::recursion_limit)
+    {
+        Value::format_deep(this, nest, padstr, ret);
+        return ret;
+    }
+    Value::Nesting nesting(format_depth);
+    const _Type &elems = elements();
+    for(auto it = elems.cbegin(); it != elems.cend(); ++it)
+    {
+        if(it != elems.cbegin())
+            ret += ",\n";
+        for(unsigned index = 0; index != nest + 1; ++index)
+            ret += padstr;
+        ret += it->doFormat(nest + 1, padstr);
+    }
+    ret = "[\n" + ret + "\n";
+    for(unsigned index = 0; index != nest; ++index)
+        ret += padstr;
+    ret += "]";
+    return ret;
+}
+
+
+
+/// 副本的内存来自被替换的结点的memory_resource，树中的子结点因此保持同一来源
+Value &Value::operator=(const Value &rhs)
+{
+    ResourceScope scope(pbase ? node_resource(pbase) : current_resource());
+    auto newp = rhs.pbase ?
+        copy(rhs.pbase): nullptr;
+    if(pbase)
+        destroy(pbase);
+    pbase = newp;
+    return *this;
+}
+
+
+/// 被替换的结点来自::operator new时直接接管（例如v = Value::Parse(text, &arena)），
+/// 否则移入的结点也要来自同一个memory_resource，树中的子结点因此保持同一来源（同拷贝赋值）
+Value &Value::operator=(Value &&rhs)
+{
+    if(this != &rhs)
+    {
+        if(std::pmr::memory_resource *mr = pbase ? node_resource(pbase) : nullptr)
+            rhs.rehome(mr);
+        if(pbase)
+            destroy(pbase);
+        pbase = rhs.pbase;
+        rhs.pbase = nullptr;
+    }
+    return *this;
+}
+
+
+
+void Value::rehome(std::pmr::memory_resource *mr)
+{
+    if(pbase == nullptr || node_resource(pbase) == mr)
+        return;
+    ResourceScope scope(mr);
+    Value_base *p = copy(pbase);
+    destroy(pbase);
+    pbase = p;
+}
+
+
+
+namespace
+{
+
+/// copy与destroy先按容器自身的拷贝构造函数与析构函数递归（访问内存的顺序最好），
+/// 当前线程中的递归层数达到Value::recursion_limit之后，更深的部分改用显式的栈
+thread_local unsigned copy_depth = 0;
+thread_local unsigned destroy_depth = 0;
+
+/// 正在进行的显式栈拷贝（每一项是源结点与它的外壳）：
+/// 不为空时，Value的拷贝遇到容器只复制外壳并登记在这里，由开始这次拷贝的copy稍后填充
+thread_local std::vector<std::pair<const Value_base *, Value_base *>> *copying = nullptr;
+
+} // namespace
+
+
+/**************************************
+ Value::copy算法说明：
+ 1、标量直接clone；紧凑的Array没有元素结点，也直接clone；
+ 2、递归层数未达到recursion_limit时，容器也直接clone，
+    其元素的拷贝再调用copy，层数加一；
+ 3、达到之后，先用copy_shell复制容器自身（缓存的哈希、keep_text标记、压缩Object的Shape），
+    把“源结点、外壳”放入栈中并登记为copying，每次取出一对，
+    用vector/map自身的拷贝复制元素（map按结构复制，不重新比较与平衡）：
+    元素的拷贝再调用copy，其中的容器只复制外壳并登记到栈中，因此不再递归。
+ 外壳在填充之前就已挂到上一层，分配失败时整棵树仍然有效，
+ 随root一起释放，再把异常抛给调用者。
+ 宽而浅的树与原来的递归拷贝完全相同；显式的栈使每个容器被访问两次（复制外壳、填充元素），
+ 对宽的树不利于缓存，因此只用于深层。
+
+**************************************/
+Value_base *Value::copy_shell(const Value_base *p)
+{
+    if(p->Type() == array_type)
+    {
+        std::unique_ptr<Array> arr(new Array());
+        arr->cache = static_cast<const Array *>(p)->cache;
+        return arr.release();
+    }
+
+    const Object *src = static_cast<const Object *>(p);
+    std::unique_ptr<Object> obj(new Object());
+    obj->cache = src->cache;
+    if(src->packed)
+        obj->packed = Object::alloc_packed(src->packed->shape);
+    return obj.release();
+}
+
+
+Value_base *Value::copy(const Value_base *p)
+{
+    JsonType t = p->Type();
+    if((t != array_type && t != object_type)
+       || (t == array_type && static_cast<const Array *>(p)->dense))
+        return p->clone();
+
+    if(copying == nullptr && copy_depth != recursion_limit)
+    {
+        struct Depth
+        {
+            Depth() { ++copy_depth; }
+            ~Depth() { --copy_depth; }
+        } depth;
+        return p->clone();
+    }
+
+    Value root(copy_shell(p), adopt_t());
+    if(copying)
+    {
+        copying->emplace_back(p, root.pbase);
+        Value_base *ret = root.pbase;
+        root.pbase = nullptr;
+        return ret;
+    }
+
+    std::vector<std::pair<const Value_base *, Value_base *>> pending{{p, root.pbase}};
+    struct Guard
+    {
+        ~Guard() { copying = nullptr; }
+    } guard;
+    copying = &pending;
+
+    while(!pending.empty())
+    {
+        const Value_base *src = pending.back().first;
+        Value_base *dst = pending.back().second;
+        pending.pop_back();
+
+        if(src->Type() == array_type)
+            static_cast<Array *>(dst)->arr = static_cast<const Array *>(src)->arr;
+        else if(const Object::Packed *packed = static_cast<const Object *>(src)->packed)
+        {
+            Object::Packed *out = static_cast<Object *>(dst)->packed;
+            for(; out->size != packed->size; ++out->size)
+                new (out->slots() + out->size) Value(packed->slots()[out->size]);
+        }
+        else
+            static_cast<Object *>(dst)->obj = static_cast<const Object *>(src)->obj;
+    }
+
+    Value_base *ret = root.pbase;
+    root.pbase = nullptr;
+    return ret;
+}
+
+
+
+/**************************************
+ Value::destroy算法说明：
+ 1、递归层数未达到recursion_limit时直接delete，元素的析构再调用destroy，层数加一；
+ 2、达到之后，释放一个容器之前先把它的元素全部取出：标量立即释放，
+    容器放入栈中（元素的pbase置为空），因此容器自身的析构函数不再向下递归；
+    之后从栈中依次取出容器，重复上述过程。
+ 压缩Object的view中是成员的拷贝，同样取出；紧凑Array的view交出过引用之后可能有任意的结点，也同样取出。
+ 栈的空间不足（分配失败）时，该元素留在容器中，由容器的析构函数释放。
+
+**************************************/
+void Value::destroy(Value_base *p) noexcept
+{
+    if(destroy_depth != recursion_limit)
+    {
+        ++destroy_depth;
+        delete p;
+        --destroy_depth;
+        return;
+    }
+
+    std::vector<Value_base *> pending;
+    auto take = [&pending](Value &v) noexcept {
+        Value_base *c = v.pbase;
+        if(c == nullptr)
+            return;
+        JsonType t = c->Type();
+        if(t == array_type || t == object_type)
+        {
+            try
+            {
+                pending.push_back(c);
+            }
+            catch(...)
+            {
+                return;
+            }
+        }
+        else
+            delete c;
+        v.pbase = nullptr;
+    };
+
+    for(;;)
+    {
+        JsonType t = p->Type();
+        if(t == array_type)
+        {
+            Array *arr = static_cast<Array *>(p);
+            for(auto &v : arr->arr)
+                take(v);
+            if(arr->dense)
+                if(Array::_Type *view = arr->dense->view.load(std::memory_order_acquire))
+                    for(auto &v : *view)
+                        take(v);
+        }
+        else if(t == object_type)
+        {
+            Object *obj = static_cast<Object *>(p);
+            for(auto &member : obj->obj)
+                take(member.second);
+            if(Object::Packed *packed = obj->packed)
+            {
+                for(std::size_t i = 0; i != packed->size; ++i)
+                    take(packed->slots()[i]);
+                if(Object::_Type *view = packed->view.load(std::memory_order_acquire))
+                    for(auto &member : *view)
+                        take(member.second);
+            }
+        }
+        delete p;
+
+        if(pending.empty())
+            return;
+        p = pending.back();
+        pending.pop_back();
+    }
+}
+
+
+
+void Value::check() const
+{
+    if(pbase == nullptr)
+        throw JsonError(deref_nullptr);
+}
+
+
+JsonType Value::Type() const
+{
+    check();
+    return pbase->Type();
+}
+
+
+JsonString Value::Serialize() const
+{
+    check();
+    return pbase->Serialize();
+}
+
+
+JsonString Value::Format(const JsonString &padstr) const
+{
+    check();
+    return pbase->Format(padstr);
+}
+
+JsonString Value::doFormat(unsigned nest,
+                           const JsonString &padstr) const
+{
+    check();
+    return pbase->doFormat(nest, padstr);
+}
+
+
+
+/**************************************
+ Value::serialize_deep算法说明：
+ Array/Object::Serialize的递归层数达到recursion_limit时使用，输出追加到out，与递归的结果逐字节相同。
+ 1、标量、有保存的序列化结果的容器与紧凑的Array直接输出Serialize()的结果（不再递归）；
+ 2、其余容器输出左括号后入栈，Cursor的mark记下它在out中的起始位置；
+ 3、每次取栈顶的下一个子结点，输出逗号与键之后按1、2处理；
+    没有子结点时输出右括号并出栈，需要时把out中从mark开始的部分保存为它的序列化结果。
+ 所有层都追加到同一个字符串中，不像递归那样在每一层拼接一次子结点的结果。
+ format_deep相同，另外按层数在每个子结点前填充padstr。
+
+**************************************/
+void Value::serialize_deep(const Value_base *p, std::string &out)
+{
+    std::vector<Cursor> stack;
+    auto open = [&stack, &out](const Value_base *c) {
+        JsonType t = c->Type();
+        const NodeCache *cache = t == array_type ? &static_cast<const Array *>(c)->cache
+                               : t == object_type ? &static_cast<const Object *>(c)->cache : nullptr;
+        if(cache == nullptr || cache->cached_text()
+           || (t == array_type && static_cast<const Array *>(c)->dense_values()))
+        {
+            out += c->Serialize();
+            return;
+        }
+        stack.emplace_back(c);
+        stack.back().mark = out.size();
+        out += t == array_type ? '[' : '{';
+    };
+
+    open(p);
+    while(!stack.empty())
+    {
+        Cursor &top = stack.back();
+        const String *key;
+        const Value *value;
+        if(top.next(key, value))
+        {
+            if(top.index != 1)
+                out += ',';
+            if(key)
+            {
+                out += key->Serialize();
+                out += ':';
+            }
+            value->check();
+            open(value->pbase);
+            continue;
+        }
+
+        const NodeCache &cache = top.node->Type() == array_type
+                               ? static_cast<const Array *>(top.node)->cache
+                               : static_cast<const Object *>(top.node)->cache;
+        out += top.node->Type() == array_type ? ']' : '}';
+        if(cache.keep_text)
+            cache.store_text(out.substr(top.mark));
+        stack.pop_back();
+    }
+}
+
+
+void Value::format_deep(const Value_base *p, unsigned nest,
+                        const JsonString &padstr, std::string &out)
+{
+    std::vector<Cursor> stack;
+    auto pad = [&padstr, &out](std::size_t n) {
+        for(; n != 0 && !padstr.empty(); --n)
+            out += padstr;
+    };
+    /// 空的容器与标量按doFormat输出（不再递归）
+    auto open = [&](const Value_base *c) {
+        JsonType t = c->Type();
+        if((t != array_type || static_cast<const Array *>(c)->empty())
+           && (t != object_type || static_cast<const Object *>(c)->empty()))
+        {
+            out += c->doFormat(static_cast<unsigned>(nest + stack.size()), padstr);
+            return;
+        }
+        out += t == array_type ? "[\n" : "{\n";
+        stack.emplace_back(c);
+    };
+
+    open(p);
+    while(!stack.empty())
+    {
+        Cursor &top = stack.back();
+        std::size_t level = nest + stack.size() - 1;
+        const String *key;
+        const Value *value;
+        if(top.next(key, value))
+        {
+            if(top.index != 1)
+                out += ",\n";
+            pad(level + 1);
+            if(key)
+            {
+                out += key->doFormat(static_cast<unsigned>(level + 1), padstr);
+                out += ": ";
+            }
+            value->check();
+            open(value->pbase);
+            continue;
+        }
+
+        out += '\n';
+        pad(level);
+        out += top.node->Type() == array_type ? ']' : '}';
+        stack.pop_back();
+    }
+}
+
+#define GETPOINTERIMPL(_FuncName, _ClassName) \
+_ClassName *Value::_FuncName() const \
+{ \
+    auto p = dynamic_cast<_ClassName*>(pbase); \
+    if(!p) \
+        throw JsonError(json_bad_cast); \
+    return p; \
+}
+
+GETPOINTERIMPL(getString, String)
+GETPOINTERIMPL(getNumber, Number)
+GETPOINTERIMPL(getObject, Object)
+GETPOINTERIMPL(getArray, Array)
+GETPOINTERIMPL(getTrue, True)
+GETPOINTERIMPL(getFalse, False)
+GETPOINTERIMPL(getNull, Null)
+
+
+
+namespace
+{
+
+/// 把h合并进seed，合并的顺序影响结果
+inline std::size_t hash_mix(std::size_t seed, std::size_t h)
+{
+    return seed ^ (h + static_cast<std::size_t>(0x9e3779b97f4a7c15ULL)
+                     + (seed << 6) + (seed >> 2));
+}
+
+} // namespace
+
+
+/**************************************
+ Value::hash算法说明：
+ 1、以结点类型作为初始值，String对内容、Number对数值（见Number::hash）计算哈希；
+ 2、Array按顺序合并各元素的哈希，Object按键的顺序合并各个键与值的哈希；
+ 3、Array/Object的结果写入NodeCache，下次直接使用，直到容器被修改；
+    缓存中0表示尚未计算，因此计算结果为0时改用1；
+    交出过元素引用的容器（exposed）不缓存，每次重新计算，
+    因此缓存的哈希值总是等于按当前内容计算的结果：相等的Value哈希值一定相同；
+ 4、递归层数达到recursion_limit之后由hash_deep用显式的栈计算，合并的顺序与结果都不变。
+ pbase为空的Value（被移动过的）按一个固定的值计算，不抛出异常。
+
+**************************************/
+std::size_t Value::hash(const Value_base *p) noexcept
+{
+    if(p == nullptr)
+        return 0;
+
+    JsonType t = p->Type();
+    std::size_t seed = hash_mix(0, static_cast<std::size_t>(t) + 1);
+    switch(t)
+    {
+    case string_type:
+        return hash_mix(seed, std::hash<std::string_view>()(static_cast<const String *>(p)->str));
+
+    case number_type:
+        return hash_mix(seed, static_cast<const Number *>(p)->hash());
+
+    case array_type:
+    {
+        const Array *arr = static_cast<const Array *>(p);
+        std::size_t h = arr->cache.cached_hash();
+        if(h)
+            return h;
+        if(const Array::Dense *d = arr->dense_values())
+        {
+            /// 与展开之后的Number（保存同样的词素）的哈希值相同：整数的Number::hash就是
+            /// 转换为unsigned long long的哈希，double则按词素构造临时的Number计算
+            std::size_t number_seed = hash_mix(0, static_cast<std::size_t>(number_type) + 1);
+            char buf[32];
+            for(std::size_t i = 0; i != d->size(); ++i)
+            {
+                std::size_t nh;
+                if(!d->floating)
+                    nh = std::hash<unsigned long long>()(static_cast<unsigned long long>(d->i64[i]));
+                else
+                {
+                    std::string_view text(buf, d->format(i, buf));
+                    nh = Number(text, text.find_first_of(".eE") == std::string_view::npos,
+                                Number::lexeme_t()).hash();
+                }
+                seed = hash_mix(seed, hash_mix(number_seed, nh));
+            }
+        }
+        else
+        {
+            if(hash_depth == recursion_limit)
+                return hash_deep(p);
+            Nesting nesting(hash_depth);
+            for(const auto &v : arr->elements())
+                seed = hash_mix(seed, hash(v.pbase));
+        }
+        h = seed ? seed : 1;
+        arr->cache.store_hash(h);
+        return h;
+    }
+
+    case object_type:
+    {
+        const Object *obj = static_cast<const Object *>(p);
+        std::size_t h = obj->cache.cached_hash();
+        if(h)
+            return h;
+        if(hash_depth == recursion_limit)
+            return hash_deep(p);
+        Nesting nesting(hash_depth);
+        obj->for_each([&seed](const String &k, const Value &v) {
+            seed = hash_mix(seed, std::hash<std::string_view>()(k.str));
+            seed = hash_mix(seed, hash(v.pbase));
+        });
+        h = seed ? seed : 1;
+        obj->cache.store_hash(h);
+        return h;
+    }
+
+    default:
+        return seed;
+    }
+}
+
+
+/// hash的递归层数达到recursion_limit时使用：Cursor的mark是各层的种子，
+/// 标量、紧凑的Array与缓存了哈希值的容器直接由hash计算（不再递归）
+std::size_t Value::hash_deep(const Value_base *p) noexcept
+{
+    std::vector<Cursor> stack;
+    std::size_t h = 0;
+    auto open = [&stack, &h](const Value_base *c) {
+        JsonType t = c ? c->Type() : null_type;
+        if((t != array_type || static_cast<const Array *>(c)->cache.cached_hash()
+                            || static_cast<const Array *>(c)->dense_values())
+           && (t != object_type || static_cast<const Object *>(c)->cache.cached_hash()))
+        {
+            h = hash(c);
+            return false;
+        }
+        stack.emplace_back(c);
+        stack.back().mark = hash_mix(0, static_cast<std::size_t>(t) + 1);
+        return true;
+    };
+
+    open(p);
+    while(!stack.empty())
+    {
+        Cursor &top = stack.back();
+        const String *key;
+        const Value *value;
+        if(top.next(key, value))
+        {
+            if(key)
+                top.mark = hash_mix(top.mark, std::hash<std::string_view>()(key->str));
+            if(!open(value->pbase))
+                top.mark = hash_mix(top.mark, h);
+            continue;
+        }
+
+        h = top.mark ? top.mark : 1;
+        if(top.node->Type() == array_type)
+            static_cast<const Array *>(top.node)->cache.store_hash(h);
+        else
+            static_cast<const Object *>(top.node)->cache.store_hash(h);
+        stack.pop_back();
+        if(!stack.empty())
+            stack.back().mark = hash_mix(stack.back().mark, h);
+    }
+    return h;
+}
+
+
+
+/**************************************
+ Value::compact算法说明：
+ 1、用显式的栈遍历整棵树，深层嵌套的文档不会耗尽调用栈；
+ 2、对每个非空、未压缩的Object，以键序列的哈希值在Shape表中查找键完全相同的Shape，
+    找不到时用这个Object的键创建一个新的Shape；
+ 3、Object引用该Shape，把各个值按键的顺序移入紧接在Packed之后的slots，清空map；
+    内容没有变化，因此保留已缓存的哈希值与序列化结果；
+ 4、结束时释放Shape表持有的引用，Shape由引用它的Object共同持有。
+ Shape与Packed的内存来自根结点的memory_resource。
+ 键集合相同的n个Object只保存一份键，每个成员只剩一个Value指针，
+ 不再需要红黑树结点与键的拷贝。
+
+**************************************/
+void Value::compact()
+{
+    /// 结束（包括抛出异常）时释放表中的引用
+    struct ShapeTable
+    {
+        std::unordered_map<std::size_t, std::vector<const Shape *>> buckets;
+        ~ShapeTable()
+        {
+            for(auto &bucket : buckets)
+                for(const Shape *s : bucket.second)
+                    s->release();
+        }
+    } shapes;
+    ResourceScope scope(pbase ? node_resource(pbase) : current_resource());
+    std::vector<Value_base *> stack{pbase};
+
+    while(!stack.empty())
+    {
+        Value_base *p = stack.back();
+        stack.pop_back();
+        if(p == nullptr)
+            continue;
+
+        if(p->Type() == array_type)
+        {
+            /// 紧凑的Array只有数字；交出过引用的先settle，有其他元素时解除紧凑形式
+            Array *arr = static_cast<Array *>(p);
+            arr->settle();
+            for(auto &v : arr->arr)
+                stack.push_back(v.pbase);
+            continue;
+        }
+        if(p->Type() != object_type)
+            continue;
+
+        Object *obj = static_cast<Object *>(p);
+        if(!obj->packed && !obj->obj.empty())
+        {
+            std::size_t h = 0;
+            for(const auto &member : obj->obj)
+                h = hash_mix(h, std::hash<std::string_view>()(member.first.str));
+
+            auto &bucket = shapes.buckets[h];
+            const Shape *shape = nullptr;
+            for(const Shape *s : bucket)
+            {
+                if(s->size() != obj->obj.size())
+                    continue;
+                std::size_t i = 0;
+                for(auto it = obj->obj.cbegin(); it != obj->obj.cend() && s->key(i).str == it->first.str; ++it)
+                    ++i;
+                if(i == s->size())
+                {
+                    shape = s;
+                    break;
+                }
+            }
+            if(shape == nullptr)
+            {
+                std::vector<String, Allocator<String>> keys;
+                keys.reserve(obj->obj.size());
+                for(const auto &member : obj->obj)
+                    keys.push_back(member.first);
+                std::unique_ptr<Shape> fresh(new Shape(std::move(keys)));
+                bucket.push_back(fresh.get());
+                shape = fresh.release();
+            }
+
+            Object::Packed *packed = Object::alloc_packed(shape);
+            for(auto &member : obj->obj)
+                new (packed->slots() + packed->size++) Value(std::move(member.second));
+            obj->obj.clear();
+            obj->packed = packed;
+        }
+
+        if(obj->packed)
+            for(std::size_t i = 0; i != obj->packed->size; ++i)
+                stack.push_back(obj->packed->slots()[i].pbase);
+    }
+}
+
+bool Value::referenced() const noexcept
+{
+    const NodeCache *cache = nullptr;
+    if(pbase && pbase->Type() == array_type)
+        cache = &static_cast<const Array *>(pbase)->cache;
+    else if(pbase && pbase->Type() == object_type)
+        cache = &static_cast<const Object *>(pbase)->cache;
+    return cache && (cache->exposed || cache->escaped);
+}
+
+
+std::size_t Value::hash() const noexcept
+{
+    return hash(pbase);
+}
+
+
+/**************************************
+ Value::equal算法说明：
+ 1、指向同一结点时相等，类型不同时不等；
+ 2、String比较内容，Number按数值比较（见Number::equal），true/false/null只比较类型；
+ 3、Array/Object先比较元素个数，两边都已缓存哈希值且不同时直接返回不等
+    （缓存的哈希值总是与内容一致，见Value::hash），
+    否则逐个比较元素（Object的元素按键有序，因此可以同步遍历）；
+    两个压缩的Object共享同一个Shape时只比较值，一边压缩、一边不压缩时按键查找；
+ 4、递归层数达到recursion_limit之后，把这一对容器放入栈中并登记为comparing，
+    每次取出一对比较它们的元素：元素中的一对容器只登记到栈中（先当作相等），因此不再递归，
+    有一对不等时整个结果为不等。
+ 不会为了比较而计算哈希：计算哈希与逐个比较一样需要遍历整棵树。
+
+**************************************/
+bool Value::equal(const Value_base *lhs, const Value_base *rhs) noexcept
+{
+    if(lhs == rhs)
+        return true;
+    if(lhs == nullptr || rhs == nullptr || lhs->Type() != rhs->Type())
+        return false;
+
+    switch(lhs->Type())
+    {
+    case string_type:
+        return static_cast<const String *>(lhs)->str == static_cast<const String *>(rhs)->str;
+
+    case number_type:
+        return static_cast<const Number *>(lhs)->equal(*static_cast<const Number *>(rhs));
+
+    case array_type:
+    case object_type:
+        break;
+
+    default:
+        return true;
+    }
+
+    /// 栈的空间不足（分配失败）时直接比较这一对
+    if(comparing)
+    {
+        try
+        {
+            comparing->emplace_back(lhs, rhs);
+            return true;
+        }
+        catch(...)
+        {
+            return equal_members(lhs, rhs);
+        }
+    }
+    if(equal_depth != recursion_limit)
+    {
+        Nesting nesting(equal_depth);
+        return equal_members(lhs, rhs);
+    }
+
+    std::vector<std::pair<const Value_base *, const Value_base *>> pending;
+    try
+    {
+        pending.emplace_back(lhs, rhs);
+    }
+    catch(...)
+    {
+        return equal_members(lhs, rhs);
+    }
+    struct Guard
+    {
+        ~Guard() { comparing = nullptr; }
+    } guard;
+    comparing = &pending;
+
+    while(!pending.empty())
+    {
+        auto next = pending.back();
+        pending.pop_back();
+        if(!equal_members(next.first, next.second))
+            return false;
+    }
+    return true;
+}
+
+
+bool Value::equal_members(const Value_base *lhs, const Value_base *rhs) noexcept
+{
+    switch(lhs->Type())
+    {
+    case array_type:
+    {
+        const Array *l = static_cast<const Array *>(lhs), *r = static_cast<const Array *>(rhs);
+        if(l->size() != r->size())
+            return false;
+        std::size_t lh = l->cache.cached_hash();
+        std::size_t rh = r->cache.cached_hash();
+        if(lh && rh && lh != rh)
+            return false;
+        /// 两边以同样的形式紧凑保存时直接比较数值，其余情况通过dense_view按Number比较
+        const Array::Dense *ld = l->dense_values(), *rd = r->dense_values();
+        if(ld && rd && ld->floating == rd->floating)
+            return ld->floating ? ld->f64 == rd->f64 : ld->i64 == rd->i64;
+        const Array::_Type &le = l->elements(), &re = r->elements();
+        for(Array::size_type i = 0; i != le.size(); ++i)
+            if(!equal(le[i].pbase, re[i].pbase))
+                return false;
+        return true;
+    }
+
+    case object_type:
+    {
+        const Object *l = static_cast<const Object *>(lhs), *r = static_cast<const Object *>(rhs);
+        if(l->size() != r->size())
+            return false;
+        std::size_t lh = l->cache.cached_hash();
+        std::size_t rh = r->cache.cached_hash();
+        if(lh && rh && lh != rh)
+            return false;
+        if(!l->packed && !r->packed)
+        {
+            for(auto li = l->obj.cbegin(), ri = r->obj.cbegin(); li != l->obj.cend(); ++li, ++ri)
+                if(li->first.str != ri->first.str || !equal(li->second.pbase, ri->second.pbase))
+                    return false;
+            return true;
+        }
+        if(l->packed && r->packed && l->packed->shape == r->packed->shape)
+        {
+            for(std::size_t i = 0; i != l->packed->size; ++i)
+                if(!equal(l->packed->slots()[i].pbase, r->packed->slots()[i].pbase))
+                    return false;
+            return true;
+        }
+        bool same = true;
+        l->for_each([r, &same](const String &k, const Value &v) {
+            if(!same)
+                return;
+            const Value *rv = nullptr;
+            if(r->packed)
+                rv = r->packed_find(k.str);
+            else
+            {
+                auto it = r->obj.find(std::string_view(k.str));
+                rv = it == r->obj.end() ? nullptr : &it->second;
+            }
+            same = rv && equal(v.pbase, rv->pbase);
+        });
+        return same;
+    }
+
+    default:
+        return true;
+    }
+}
+
+
+bool operator==(const Value &lhs, const Value &rhs) noexcept
+{
+    return Value::equal(lhs.pbase, rhs.pbase);
+}
+
+
+_JSON_END
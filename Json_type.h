@@ -1,776 +1,1750 @@
-#ifndef JSON_TYPE_H
-#define JSON_TYPE_H
-
-#define _JSON_BEGIN namespace json {
-#define _JSON_END   }
-#define _JSON   ::json::
-
-#include <utility>
-#include <vector>
-#include <map>
-#include <string>
-#include <initializer_list>
-#include "Json_string.h"
-
-
-#define DECLARE_IMPL(_ClassName, _JsonType) \
-    friend class Value; \
-    static _ClassName doParse(const SubString&); \
-    JsonType Type() const { return _JsonType; } \
-    _ClassName *clone() const & { return new _ClassName(*this); } \
-    _ClassName *clone() && { return new _ClassName(std::move(*this));}
-
-
-_JSON_BEGIN
-
-inline bool IsSpace(char c)
-{
-    return c == ' '  || c == '\t' || c == '\n'
-        || c == '\r' || c == '\v' || c == '\f';
-}
-
-inline bool IsCntrl(char c)
-{
-    return c >= '\x00' && c <= '\x1f';
-}
-
-/// ɾַβĿհַ
-std::string erase_head_tail_ws(const std::string &s);
-/// ɾArrayObjectַУ˫֮ڵģпհ׷
-std::string erase_all_whitespace(const std::string &s);
-/// ArrayObjectַѰһŷָ
-auto next_comma(const SubString &subStr) ->decltype(subStr.first);
-
-
-enum JsonType
-{
-    string_type, number_type, object_type, array_type,
-    true_type, false_type, null_type
-};
-
-
-
-class Value_base
-{
-    friend class Value;
-    friend class Object;
-    virtual Value_base *clone() const & = 0;
-    virtual Value_base *clone() && = 0;
-    virtual JsonString Serialize() const = 0;
-    virtual JsonString doFormat(unsigned nest,
-                                const JsonString &padstr) const
-                                { return Serialize(); }
-    virtual JsonType Type() const = 0;
-
-protected:
-
-    Value_base() = default;
-    Value_base(const Value_base &) = default;
-    Value_base(Value_base &&) = default;
-    Value_base &operator =(const Value_base &) = default;
-    Value_base &operator =(Value_base &&) = default;
-    virtual ~Value_base() = default;
-
-public:
-
-    /// ʽɿɶԽϺõjsonʽַ
-    JsonString Format(const JsonString &padstr = "    ")
-        { return doFormat(0, padstr); }
-};
-
-
-
-class String : public Value_base
-{
-    friend class Object;
-    friend bool operator==(const String &lhs, const String &rhs);
-    friend bool operator!=(const String &lhs, const String &rhs);
-    friend bool operator< (const String &lhs, const String &rhs);
-    friend bool operator<=(const String &lhs, const String &rhs);
-    friend bool operator> (const String &lhs, const String &rhs);
-    friend bool operator>=(const String &lhs, const String &rhs);
-
-public:
-    static String Parse(const JsonString &);
-    JsonString Serialize() const;
-
-    String() = default;
-    String(const char *cp):       str(cp) {}
-    String(const std::string &s): str(s) {}
-    String(std::string &&s):      str(std::move(s)) {}
-
-    std::string to_string() const { return str; }
-
-    void clear() { str.clear(); }
-
-private:
-    DECLARE_IMPL(String, string_type)
-     ///small string optimization
-     ///зǳСStringԪʱ˷Ѵڴ棡
-    std::string str;
-};
-
-
-
-class NumberImpl;
-class Number : public Value_base
-{
-public:
-    static Number Parse(const JsonString &);
-    JsonString Serialize() const;
-
-    Number();
-    ~Number();
-    Number(const Number &);
-    Number(Number &&) noexcept;
-    Number &operator=(const Number &);
-    Number &operator=(Number &&) noexcept;
-
-    /************************************************/
-    Number(int i);
-    Number(unsigned int u);
-    Number(long l);
-    Number(unsigned long ul);
-    Number(long long ll);
-    Number(unsigned long long ull);
-    Number(float f);
-    Number(double d);
-    Number(long double ld);
-    /// ָܹSerialzeЧָ
-    Number(float f, int p);
-    Number(double d, int p);
-    Number(long double ld, int p);
-    /************************************************/
-
-    /************************************************/
-    int                to_int()        const;
-    unsigned int       to_uint()       const;
-    long               to_long()       const;
-    unsigned long      to_ulong()      const;
-    long long          to_longlong()   const;
-    unsigned long long to_ulonglong()  const;
-    float              to_float()      const;
-    double             to_double()     const;
-    long double        to_longdouble() const;
-    /************************************************/
-
-private:
-    DECLARE_IMPL(Number, number_type)
-    NumberImpl* pImpl; /// pImplΪ
-};
-
-
-
-class Value;
-class Object : public Value_base /// It's a std::map!
-{
-public:
-    static Object Parse(const JsonString &);
-    JsonString Serialize() const;
-
-    typedef std::map<String, Value> _Type;
-    typedef _Type::iterator iterator;
-    typedef _Type::const_iterator const_iterator;
-    typedef _Type::size_type size_type;
-    typedef _Type::difference_type difference_type;
-    typedef _Type::value_type value_type;
-    typedef _Type::reference reference;
-    typedef _Type::const_reference const_reference;
-    typedef _Type::key_type key_type;
-    typedef _Type::mapped_type mapped_type;
-
-    /************************************************/
-    Object() = default;
-    Object(std::initializer_list<value_type> il);
-    template<typename _InputIterator>
-    Object(_InputIterator b, _InputIterator e);
-    /************************************************/
-
-
-    /// ΪmapݵĲmapĲһһӦ
-    bool empty() const;
-    size_type size() const;
-    void swap(Object &);
-    void clear();
-
-    iterator begin() { return obj.begin(); }
-    iterator end() { return obj.end(); }
-    const_iterator begin() const { return obj.begin(); }
-    const_iterator end() const { return obj.end(); }
-    const_iterator cbegin() const { return obj.cbegin(); }
-    const_iterator cend() const { return obj.cend(); }
-
-    std::pair<iterator, bool> insert(const value_type &);
-    template<typename _Pair>
-    std::pair<iterator, bool> insert(_Pair &&p);
-    void insert(std::initializer_list<value_type> il);
-    template<typename _InputIterator>
-    void insert(_InputIterator, _InputIterator);
-    iterator insert(const_iterator _position, const value_type &);
-    template<typename _Pair>
-    iterator insert(const_iterator _position, _Pair &&p);
-
-    size_type erase(const key_type &);
-    iterator erase(const_iterator p);
-    iterator erase(const_iterator b, const_iterator e);
-
-    mapped_type &operator[](const key_type &);
-    mapped_type &at(const key_type &);
-    const mapped_type &at(const key_type &) const;
-
-    /// findһЩԱݶǷΪconst
-    iterator find(const key_type &);
-    const_iterator find(const key_type &) const;
-    size_type count(const key_type &) const;
-
-    iterator lower_bound(const key_type &);
-    const_iterator lower_bound(const key_type &) const;
-    iterator upper_bound(const key_type &);
-    const_iterator upper_bound(const key_type &) const;
-    std::pair<iterator, iterator>
-        equal_range(const key_type &);
-    std::pair<const_iterator, const_iterator>
-        equal_range(const key_type &) const;
-
-
-private:
-    DECLARE_IMPL(Object, object_type)
-
-    static std::pair<String, Value>
-                        parse_pair(const SubString &);
-    JsonString doFormat(unsigned nest,
-                        const JsonString &padstr) const;
-
-    _Type obj; /// json::members -> std::map;
-};
-
-
-
-class Array : public Value_base /// It's a std::vector!
-{
-public:
-    static Array Parse(const JsonString &);
-    JsonString Serialize() const;
-
-    typedef std::vector<Value> _Type;
-    typedef _Type::iterator iterator;
-    typedef _Type::const_iterator const_iterator;
-    typedef _Type::size_type size_type;
-    typedef _Type::difference_type difference_type;
-    typedef _Type::value_type value_type;
-    typedef _Type::reference reference;
-    typedef _Type::const_reference const_reference;
-
-    /************************************************/
-    Array() = default;
-    Array(std::initializer_list<value_type> il);
-    template<typename _InputIterator>
-    Array(_InputIterator b, _InputIterator e);
-    explicit
-    Array(size_type n);
-    Array(size_type n, const value_type &);
-    /************************************************/
-
-
-    /// ΪvectorݵĲvectorĲһһӦ
-    bool empty() const;
-    size_type size() const;
-    void swap(Array &);
-    void clear();
-
-    iterator begin() { return arr.begin(); }
-    iterator end() { return arr.end(); }
-    const_iterator begin() const { return arr.begin(); }
-    const_iterator end() const { return arr.end(); }
-    const_iterator cbegin() const { return arr.cbegin(); }
-    const_iterator cend() const { return arr.cend(); }
-
-    void push_back(const value_type &);
-    void push_back(value_type &&);
-    /// C++11׼£insertλòconst_iteratorָʾ
-    /// insertֵֵ汾
-    iterator insert(const_iterator p, const value_type &);
-    iterator insert(const_iterator p, value_type &&);
-    iterator insert(const_iterator p, size_type n, const value_type &);
-    template<typename _InputIterator>
-    iterator insert(const_iterator p, _InputIterator b, _InputIterator e);
-    iterator insert(const_iterator p, std::initializer_list<value_type> il);
-
-    void pop_back();
-    iterator erase(const_iterator p);
-    iterator erase(const_iterator b, const_iterator e);
-
-    value_type &back();
-    const value_type &back() const;
-    value_type &front();
-    const value_type &front() const;
-    value_type &operator[](size_type n);
-    const value_type &operator[](size_type n) const;
-    value_type &at(size_type n);
-    const value_type &at(size_type n) const;
-
-    void resize(size_type n);
-    void resize(size_type n, const value_type &);
-    void shrink_to_fit();
-    size_type capacity() const;
-    void reserve(size_type n);
-
-private:
-    DECLARE_IMPL(Array, array_type)
-    JsonString doFormat(unsigned nest,
-                        const JsonString &padstr) const;
-
-    _Type arr; /// json::elements -> std::vector
-};
-
-
-
-class True : public Value_base
-{
-public:
-    static True Parse(const JsonString &);
-    JsonString Serialize() const { return "true"; }
-    True() = default;
-
-private:
-    DECLARE_IMPL(True, true_type)
-};
-
-
-
-class False : public Value_base
-{
-public:
-    static False Parse(const JsonString &);
-    JsonString Serialize() const { return "false"; }
-    False() = default;
-
-private:
-    DECLARE_IMPL(False, false_type)
-};
-
-
-
-class Null : public Value_base
-{
-public:
-    static Null Parse(const JsonString &);
-    JsonString Serialize() const { return "null"; }
-    Null() = default;
-
-private:
-    DECLARE_IMPL(Null, null_type)
-};  const Null null;
-
-
-
-class Value
-{
-    friend class Object;
-    friend class Array;
-
-public:
-
-    static Value Parse(const JsonString &);
-    JsonString Serialize() const;
-    JsonType Type() const;
-    JsonString Format(const JsonString &padstr = "    ") const;
-
-    ~Value() { delete pbase; }
-    Value(const Value &rhs):     pbase(rhs.pbase ? rhs.pbase->clone(): nullptr) {}
-    Value(Value &&rhs) noexcept: pbase(rhs.pbase) { rhs.pbase = nullptr; }
-    Value &operator=(const Value &rhs);
-    Value &operator=(Value &&rhs) noexcept;
-
-    Value():                           pbase(new Null()) {}
-    Value(bool b):                     pbase(b ? static_cast<Value_base*>(new True()):
-                                                 static_cast<Value_base*>(new False())) {}
-    Value(int i):                      pbase(new Number(i)) {}
-    Value(unsigned int u):             pbase(new Number(u)) {}
-    Value(long l):                     pbase(new Number(l)) {}
-    Value(unsigned long ul):           pbase(new Number(ul)) {}
-    Value(long long ll):               pbase(new Number(ll)) {}
-    Value(unsigned long long ull):     pbase(new Number(ull)) {}
-    Value(float f):                    pbase(new Number(f)) {}
-    Value(double d):                   pbase(new Number(d)) {}
-    Value(long double ld):             pbase(new Number(ld)) {}
-    Value(float f, int p):             pbase(new Number(f, p)) {}
-    Value(double d, int p):            pbase(new Number(d, p)) {}
-    Value(long double ld, int p):      pbase(new Number(ld, p)) {}
-    Value(const std::string &s):       pbase(new String(s)) {}
-    Value(std::string &&s):            pbase(new String(std::move(s))) {}
-    Value(const char *cp):             pbase(new String(cp)) {}
-    Value(const Value_base &base):     pbase(base.clone()) {}
-    Value(Value_base &&base) noexcept: pbase(std::move(base).clone()) {}
-    Value(std::initializer_list
-            <Object::value_type> il):  pbase(new Object(il)) {}
-    template<typename T = void>
-    Value(std::initializer_list
-            <Array::value_type> il):   pbase(new Array(il)) {}
-
-    std::string        to_string()     const { auto p = getString(); return p->to_string(); }
-    int                to_int()        const { auto p = getNumber(); return p->to_int(); }
-    unsigned int       to_uint()       const { auto p = getNumber(); return p->to_uint(); }
-    long               to_long()       const { auto p = getNumber(); return p->to_long(); }
-    unsigned long      to_ulong()      const { auto p = getNumber(); return p->to_ulong(); }
-    long long          to_longlong()   const { auto p = getNumber(); return p->to_longlong(); }
-    unsigned long long to_ulonglong()  const { auto p = getNumber(); return p->to_ulonglong(); }
-    float              to_float()      const { auto p = getNumber(); return p->to_float(); }
-    double             to_double()     const { auto p = getNumber(); return p->to_double(); }
-    long double        to_longdouble() const { auto p = getNumber(); return p->to_longdouble(); }
-
-    bool is_String() const { return Type() == string_type; }
-    bool is_Number() const { return Type() == number_type; }
-    bool is_Object() const { return Type() == object_type; }
-    bool is_Array () const { return Type() == array_type; }
-    bool is_True  () const { return Type() == true_type; }
-    bool is_False () const { return Type() == false_type; }
-    bool is_Null  () const { return Type() == null_type; }
-
-    String to_String() const & { auto p = getString(); return *p; }
-    String to_String() &&      { auto p = getString(); return std::move(*p); }
-    Number to_Number() const & { auto p = getNumber(); return *p; }
-    Number to_Number() &&      { auto p = getNumber(); return std::move(*p); }
-    Object to_Object() const & { auto p = getObject(); return *p; }
-    Object to_Object() &&      { auto p = getObject(); return std::move(*p); }
-    Array  to_Array () const & { auto p = getArray (); return *p; }
-    Array  to_Array () &&      { auto p = getArray (); return std::move(*p); }
-    True   to_True  () const & { auto p = getTrue  (); return *p; }
-    True   to_True  () &&      { auto p = getTrue  (); return std::move(*p); }
-    False  to_False () const & { auto p = getFalse (); return *p; }
-    False  to_False () &&      { auto p = getFalse (); return std::move(*p); }
-    Null   to_Null  () const & { auto p = getNull  (); return *p; }
-    Null   to_Null  () &&      { auto p = getNull  (); return std::move(*p); }
-
-private:
-
-    String *getString() const;
-    Number *getNumber() const;
-    Object *getObject() const;
-    Array  *getArray () const;
-    True   *getTrue  () const;
-    False  *getFalse () const;
-    Null   *getNull  () const;
-
-    static Value doParse(const SubString &);
-    JsonString doFormat(unsigned nest,
-                        const JsonString &padstr) const;
-    void check() const;
-
-    Value_base* pbase; /// pbaseΪ
-};
-
-
-
-inline
-bool operator==(const String &lhs, const String &rhs)
-    { return lhs.str == rhs.str; }
-
-inline
-bool operator!=(const String &lhs, const String &rhs)
-    { return lhs.str != rhs.str; }
-
-inline
-bool operator< (const String &lhs, const String &rhs)
-    { return lhs.str <  rhs.str; }
-
-inline
-bool operator<=(const String &lhs, const String &rhs)
-    { return lhs.str <= rhs.str; }
-
-inline
-bool operator> (const String &lhs, const String &rhs)
-    { return lhs.str >  rhs.str; }
-
-inline
-bool operator>=(const String &lhs, const String &rhs)
-    { return lhs.str >= rhs.str; }
-
-
-inline Object::
-    Object(std::initializer_list<value_type> il):
-    obj(il) {}
-
-
-template<typename _InputIterator>
-inline Object::
-    Object(_InputIterator b, _InputIterator e):
-    obj(b, e) {}
-
-
-inline bool
-    Object::empty() const { return obj.empty(); }
-
-
-inline Object::size_type
-    Object::size() const { return obj.size(); }
-
-
-inline void
-    Object::swap(Object &rhs) { obj.swap(rhs.obj); }
-
-
-inline void
-    Object::clear() { return obj.clear(); }
-
-
-inline std::pair<Object::iterator, bool>
-    Object::insert(const value_type &v)
-    { return obj.insert(v); }
-
-
-template<typename _Pair>
-inline std::pair<Object::iterator, bool>
-    Object::insert(_Pair &&p)
-    { return obj.insert(std::forward<_Pair>(p)); }
-
-
-inline void
-    Object::insert(std::initializer_list<value_type> il)
-    { obj.insert(il); }
-
-
-template<typename _InputIterator>
-inline void
-    Object::insert(_InputIterator b, _InputIterator e)
-    { obj.insert(b, e); }
-
-
-inline Object::iterator
-    Object::insert(const_iterator _position, const value_type &v)
-    { return obj.insert(_position, v); }
-
-
-template<typename _Pair>
-inline Object::iterator
-    Object::insert(const_iterator _position, _Pair &&p)
-    { return obj.insert(_position, std::forward<_Pair>(p)); }
-
-
-inline Object::size_type
-    Object::erase(const key_type &k)
-    { return obj.erase(k); }
-
-
-inline Object::iterator
-    Object::erase(const_iterator p)
-    { return obj.erase(p); }
-
-
-inline Object::iterator
-    Object::erase(const_iterator b, const_iterator e)
-    { return obj.erase(b, e); }
-
-
-inline Object::mapped_type &
-    Object::operator[](const key_type &k)
-    { return obj.operator[](k); }
-
-
-inline Object::mapped_type &
-    Object::at(const key_type &k) { return obj.at(k); }
-
-
-inline const Object::mapped_type &
-    Object::at(const key_type &k) const { return obj.at(k); }
-
-
-inline Object::iterator
-    Object::find(const key_type &k) { return obj.find(k); }
-
-
-inline Object::const_iterator
-    Object::find(const key_type &k) const { return obj.find(k); }
-
-
-inline Object::size_type
-    Object::count(const key_type &k) const { return obj.count(k); }
-
-
-inline Object::iterator
-    Object::lower_bound(const key_type &k)
-    { return obj.lower_bound(k); }
-
-
-inline Object::const_iterator
-    Object::lower_bound(const key_type &k) const
-    { return obj.lower_bound(k); }
-
-
-inline Object::iterator
-    Object::upper_bound(const key_type &k)
-    { return obj.upper_bound(k); }
-
-
-inline Object::const_iterator
-    Object::upper_bound(const key_type &k) const
-    { return obj.upper_bound(k); }
-
-
-inline
-std::pair<Object::iterator, Object::iterator>
-    Object::equal_range(const key_type &k)
-    { return obj.equal_range(k); }
-
-
-inline
-std::pair<Object::const_iterator, Object::const_iterator>
-    Object::equal_range(const key_type &k) const
-    { return obj.equal_range(k); }
-
-
-inline
-void swap(Object &lhs, Object &rhs)
-    { lhs.swap(rhs); }
-
-
-
-
-inline Array::
-    Array(std::initializer_list<value_type> il):
-    arr(il) {}
-
-
-template<typename _InputIterator>
-inline Array::
-    Array(_InputIterator b, _InputIterator e):
-    arr(b, e) {}
-
-
-inline Array::
-    Array(size_type n): arr(n) {}
-
-
-inline Array::
-    Array(size_type n, const value_type &v):
-    arr(n, v) {}
-
-
-inline bool
-    Array::empty() const{ return arr.empty(); }
-
-
-inline Array::size_type
-    Array::size() const { return arr.size(); }
-
-
-inline void
-    Array::swap(Array &rhs) { arr.swap(rhs.arr); }
-
-
-inline void
-    Array::clear() { arr.clear(); }
-
-
-inline void
-Array::push_back(const value_type &v)
-    { arr.push_back(v); }
-
-
-inline void
-    Array::push_back(value_type &&v)
-    { arr.push_back(std::move(v)); }
-
-
-inline Array::iterator
-    Array::insert(const_iterator p, const value_type &v)
-    { return arr.insert(p, v); }
-
-
-inline Array::iterator
-    Array::insert(const_iterator p, value_type &&v)
-    { return arr.insert(p, std::move(v)); }
-
-
-inline Array::iterator
-    Array::insert(const_iterator p,
-                  size_type n, const value_type &v)
-                  { return arr.insert(p, n, v); }
-
-
-template<typename _InputIterator>
-inline Array::iterator
-    Array::insert(const_iterator p,
-                  _InputIterator b, _InputIterator e)
-                  { return arr.insert(p, b, e); }
-
-
-inline Array::iterator
-    Array::insert(const_iterator p,
-                  std::initializer_list<value_type> il)
-                  { return arr.insert(p, il); }
-
-
-inline void
-    Array::pop_back(){ arr.pop_back(); }
-
-
-inline Array::iterator
-    Array::erase(const_iterator p)
-    { return arr.erase(p); }
-
-
-inline Array::iterator
-    Array::erase(const_iterator b, const_iterator e)
-    { return arr.erase(b, e); }
-
-
-inline Array::value_type &
-    Array::back() { return arr.back(); }
-
-
-inline const Array::value_type &
-    Array::back() const { return arr.back(); }
-
-
-inline Array::value_type &
-    Array::front() { return arr.front(); }
-
-
-inline const Array::value_type &
-    Array::front() const { return arr.front(); }
-
-
-inline Array::value_type &
-    Array::operator[](size_type n)
-    { return arr.operator[](n); }
-
-
-inline const Array::value_type &
-    Array::operator[](size_type n) const
-    { return arr.operator[](n); }
-
-
-inline Array::value_type &
-    Array::at(size_type n) { return arr.at(n); }
-
-
-inline const Array::value_type &
-    Array::at(size_type n) const
-    { return arr.at(n); }
-
-
-inline void Array::resize(size_type n)
-    { arr.resize(n); }
-
-
-inline void
-    Array::resize(size_type n, const value_type &v)
-    { arr.resize(n, v); }
-
-
-inline void Array::shrink_to_fit()
-    { arr.shrink_to_fit(); }
-
-
-inline
-Array::size_type Array::capacity() const
-    { return arr.capacity(); }
-
-
-inline void
-    Array::reserve(size_type n)
-    { arr.reserve(n); }
-
-_JSON_END
-#endif // JSON_TYPE_H
+#ifndef JSON_TYPE_H
+#define JSON_TYPE_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <map>
+#include <string>
+#include <string_view>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include "Json_alloc.h"
+#include "Json_error.h"
+#include "Json_string.h"
+
+
+#define DECLARE_IMPL(_ClassName, _JsonType) \
+    friend class Value; \
+    friend class Reader; \
+    friend class Writer; \
+    friend class Columnizer; \
+    friend class PathEvaluator; \
+    friend class ArrayIndex; \
+    JsonType Type() const { return _JsonType; } \
+    _ClassName *clone() const & { return new _ClassName(*this); } \
+    _ClassName *clone() && { return new _ClassName(std::move(*this));}
+
+
+_JSON_BEGIN
+
+inline bool IsSpace(char c)
+{
+    return c == ' '  || c == '\t' || c == '\n'
+        || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline bool IsCntrl(char c)
+{
+    return c >= '\x00' && c <= '\x1f';
+}
+
+/// 删除字符串首尾的空白字符
+std::string erase_head_tail_ws(const std::string &s);
+/// 删除Array或Object字符串中（不包括双引号之内的）所有空白符
+std::string erase_all_whitespace(const std::string &s);
+
+
+struct ParallelOptions;
+class GatherBuffer;
+class Projection;
+class ArrayIndex;
+struct IndexLinks;
+
+
+enum JsonType
+{
+    string_type, number_type, object_type, array_type,
+    true_type, false_type, null_type
+};
+
+
+
+/**************************************
+ NodeCache：Array/Object结点上缓存的派生信息：结构哈希与序列化结果。
+ 1、哈希拷贝时随内容一起复制，序列化结果不复制（只复制是否保留它的标记）；
+    移动时全部转移给目标，源对象的缓存清空；
+ 2、容器任何可能修改元素的非const成员函数都会清空缓存；
+ 3、交出元素的引用或迭代器的非const成员函数（operator[]、at、find、begin、insert等）
+    还把容器标记为exposed：之后可能通过这些引用修改元素而不经过容器，
+    exposed的容器从此不再保存、也不使用缓存，每次重新计算；
+    要取得深层结点的引用，必须依次经过路径上每一层容器（或者通过Value::as_Object等
+    取得结点自身的引用，此时结点标记为escaped，以移动的方式插入容器时容器标记为exposed），
+    因此可能在不知情时被修改的子树，它到根的路径上的容器都是exposed的，
+    其余结点的缓存总是与内容一致；只读的访问应通过const引用进行，不影响缓存；
+ 4、使用原子操作，多个线程可以同时读取（并填充缓存）同一个const结点。
+
+**************************************/
+struct NodeCache
+{
+    NodeCache() = default;
+    /// 拷贝是新的结点，没有交出过任何引用
+    NodeCache(const NodeCache &rhs):
+        hash(rhs.cached_hash()), keep_text(rhs.keep_text) {}
+    /// 元素随移动转移，先前交出的元素引用现在指向目标
+    NodeCache(NodeCache &&rhs) noexcept:
+        hash(rhs.hash.exchange(0, std::memory_order_relaxed)),
+        text(rhs.text.exchange(nullptr, std::memory_order_acq_rel)),
+        keep_text(rhs.keep_text), exposed(rhs.exposed) {}
+    /// 赋值不清除exposed：先前交出的引用仍然指向这个结点的元素
+    NodeCache &operator=(const NodeCache &rhs)
+    {
+        if(this != &rhs)
+        {
+            reset();
+            hash.store(rhs.cached_hash(), std::memory_order_relaxed);
+            keep_text = rhs.keep_text;
+        }
+        return *this;
+    }
+    NodeCache &operator=(NodeCache &&rhs) noexcept
+    {
+        if(this != &rhs)
+        {
+            reset();
+            hash.store(rhs.hash.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+            text.store(rhs.text.exchange(nullptr, std::memory_order_acq_rel), std::memory_order_release);
+            keep_text = rhs.keep_text;
+            exposed = exposed || rhs.exposed;
+        }
+        return *this;
+    }
+    ~NodeCache() { delete text.load(std::memory_order_acquire); }
+
+    void reset()
+    {
+        hash.store(0, std::memory_order_relaxed);
+        delete text.exchange(nullptr, std::memory_order_acq_rel);
+    }
+    void expose() { reset(); exposed = true; }
+
+    /// 0表示没有可用的哈希值
+    std::size_t cached_hash() const
+        { return exposed ? 0 : hash.load(std::memory_order_relaxed); }
+    void store_hash(std::size_t h) const
+        { if(!exposed) hash.store(h, std::memory_order_relaxed); }
+    const std::string *cached_text() const
+        { return exposed ? nullptr : text.load(std::memory_order_acquire); }
+
+    /// 保存序列化结果；其他线程已先保存或者exposed时丢弃s
+    void store_text(const std::string &s) const
+    {
+        if(exposed)
+            return;
+        const std::string *expected = nullptr;
+        const std::string *p = new std::string(s);
+        if(!text.compare_exchange_strong(expected, p, std::memory_order_acq_rel))
+            delete p;
+    }
+
+    mutable std::atomic<std::size_t> hash{0};                  /// 0表示尚未计算
+    mutable std::atomic<const std::string *> text{nullptr};    /// 缓存的序列化结果
+    bool keep_text = false;     /// 是否保留序列化结果，由cache_serialized设置
+    bool exposed = false;       /// 交出过元素的引用或迭代器，不再缓存
+    bool escaped = false;       /// 交出过结点自身的非const引用（Value::as_Object/as_Array）
+};
+
+
+
+class Value_base
+{
+    friend class Value;
+    friend class Object;
+    friend class Reader;
+    friend class Writer;
+    friend class Columnizer;
+    friend class PathEvaluator;
+    friend class ArrayIndex;
+    virtual Value_base *clone() const & = 0;
+    virtual Value_base *clone() && = 0;
+    virtual JsonString Serialize() const = 0;
+    virtual JsonString doFormat(unsigned nest,
+                                const JsonString &padstr) const
+                                { return Serialize(); }
+    virtual JsonType Type() const = 0;
+
+protected:
+
+    Value_base() = default;
+    Value_base(const Value_base &) = default;
+    Value_base(Value_base &&) = default;
+    Value_base &operator =(const Value_base &) = default;
+    Value_base &operator =(Value_base &&) = default;
+    virtual ~Value_base() = default;
+
+public:
+
+    /// 格式化成可读性较好的json格式字符串
+    JsonString Format(const JsonString &padstr = "    ")
+        { return doFormat(0, padstr); }
+
+    /// 结点的内存来自当前线程的memory_resource（见Json_alloc.h）
+    JSON_NODE_ALLOCATION
+};
+
+
+
+class String : public Value_base
+{
+    friend class Object;
+    friend bool operator==(const String &lhs, const String &rhs);
+    friend bool operator!=(const String &lhs, const String &rhs);
+    friend bool operator< (const String &lhs, const String &rhs);
+    friend bool operator<=(const String &lhs, const String &rhs);
+    friend bool operator> (const String &lhs, const String &rhs);
+    friend bool operator>=(const String &lhs, const String &rhs);
+    friend bool operator< (const String &lhs, std::string_view rhs);
+    friend bool operator< (std::string_view lhs, const String &rhs);
+
+public:
+    static String Parse(std::string_view);
+    JsonString Serialize() const;
+
+    String() = default;
+    String(const char *cp):       str(cp) {}
+    String(const std::string &s): str(s.data(), s.size()) {}
+    String(std::string &&s):      str(s.data(), s.size()) {}
+    explicit
+    String(std::string_view sv):  str(sv.data(), sv.size()) {}
+
+    std::string to_string() const { return std::string(str.data(), str.size()); }
+
+    void clear() { str.clear(); }
+
+private:
+    DECLARE_IMPL(String, string_type)
+     ///由于small string optimization，
+     ///当有非常多的小String元素时会浪费大量内存！
+    NodeString str;
+};
+
+
+
+class NumberImpl;
+class Number : public Value_base
+{
+public:
+    static Number Parse(std::string_view);
+    JsonString Serialize() const;
+
+    Number();
+    ~Number();
+    Number(const Number &);
+    Number(Number &&) noexcept;
+    Number &operator=(const Number &);
+    Number &operator=(Number &&) noexcept;
+
+    /************************************************/
+    Number(int i);
+    Number(unsigned int u);
+    Number(long l);
+    Number(unsigned long ul);
+    Number(long long ll);
+    Number(unsigned long long ull);
+    Number(float f);
+    Number(double d);
+    Number(long double ld);
+    /// 能够保持浮点数输出（Serialze结果）中有效数字个数
+    Number(float f, int p);
+    Number(double d, int p);
+    Number(long double ld, int p);
+    /************************************************/
+
+    /************************************************/
+    int                to_int()        const;
+    unsigned int       to_uint()       const;
+    long               to_long()       const;
+    unsigned long      to_ulong()      const;
+    long long          to_longlong()   const;
+    unsigned long long to_ulonglong()  const;
+    float              to_float()      const;
+    double             to_double()     const;
+    long double        to_longdouble() const;
+    /************************************************/
+
+private:
+    DECLARE_IMPL(Number, number_type)
+    friend class Array;
+
+    /// 按数值比较与哈希：整数之间精确比较，含浮点数时按long double比较
+    bool equal(const Number &rhs) const noexcept;
+    std::size_t hash() const noexcept;
+
+    /// 保存原文中数字的词素，第一次调用to_X时才转换，Serialize原样输出词素；
+    /// 供Reader使用，词素必须符合JSON的数字文法，integral表示其中没有小数点与指数
+    struct lexeme_t {};
+    Number(std::string_view lexeme, bool integral, lexeme_t);
+    /// 同上，供ParseInto使用：原来的词素空间足够时直接覆盖，不重新分配
+    void assign_lexeme(std::string_view lexeme, bool integral);
+    /// 保存了原文词素时返回词素（即Serialize的结果），否则返回空
+    std::string_view lexeme() const noexcept;
+    NumberImpl* pImpl; /// pImpl可能为空
+};
+
+
+
+/// 可以直接与String比较的键类型：能转换为std::string_view但不是String本身
+/// （const char*、字符串字面量、std::string、std::string_view）
+template<typename _Key>
+using EnableIfKeyView = typename std::enable_if<
+    std::is_convertible<const _Key &, std::string_view>::value
+    && !std::is_same<typename std::decay<_Key>::type, String>::value>::type;
+
+
+
+/**************************************
+ Shape：一组有序、不重复的键，被键集合相同的多个压缩Object共享（见Value::compact）。
+ 压缩的Object只保存与keys一一对应的值，键本身与红黑树结点都不再重复存储。
+ 引用计数是原子的，Shape创建之后不再修改。
+
+**************************************/
+class Shape
+{
+public:
+    static const std::size_t npos = static_cast<std::size_t>(-1);
+
+    /// keys必须有序且不重复，引用计数从1开始
+    explicit Shape(std::vector<String, Allocator<String>> k): refs(1), keys(std::move(k)) {}
+
+    std::size_t size() const { return keys.size(); }
+    const String &key(std::size_t i) const { return keys[i]; }
+    /// 二分查找键的下标，不存在时返回npos
+    std::size_t index(std::string_view k) const;
+
+    void retain() const { refs.fetch_add(1, std::memory_order_relaxed); }
+    void release() const
+        { if(refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this; }
+
+    JSON_NODE_ALLOCATION
+
+private:
+    mutable std::atomic<std::size_t> refs;
+    std::vector<String, Allocator<String>> keys;
+};
+
+
+
+class Value;
+class Object : public Value_base /// It's a std::map!
+{
+public:
+    static Object Parse(std::string_view);
+    JsonString Serialize() const;
+
+    /// 保留估计长度不小于min_bytes的各层子树（包括自身）的序列化结果，
+    /// 之后的Serialize直接复制未被修改的子树的结果，只重新生成被修改的路径；
+    /// 交出过元素引用的结点不保存（见NodeCache），通过先前取得的引用修改之后结果仍然正确
+    void cache_serialized(std::size_t min_bytes = 256);
+    /// 不再保留序列化结果，并释放已保存的部分
+    void clear_serialized_cache();
+
+    /// std::less<>使map支持异构查找，可以用std::string_view直接查找
+    typedef std::map<String, Value, std::less<>, Allocator<std::pair<const String, Value>>> _Type;
+    typedef _Type::iterator iterator;
+    typedef _Type::const_iterator const_iterator;
+    typedef _Type::size_type size_type;
+    typedef _Type::difference_type difference_type;
+    typedef _Type::value_type value_type;
+    typedef _Type::reference reference;
+    typedef _Type::const_reference const_reference;
+    typedef _Type::key_type key_type;
+    typedef _Type::mapped_type mapped_type;
+
+    /************************************************/
+    Object() = default;
+    Object(std::initializer_list<value_type> il);
+    template<typename _InputIterator>
+    Object(_InputIterator b, _InputIterator e);
+    Object(const Object &);
+    Object(Object &&) noexcept;
+    Object &operator=(const Object &);
+    Object &operator=(Object &&) noexcept;
+    ~Object();
+    /************************************************/
+
+    /// 按键的顺序对每个成员调用fn(const String &key, const Value &value)，
+    /// 对压缩的Object也不会生成map，遍历时应优先使用它
+    template<typename _Fn>
+    void for_each(_Fn fn) const;
+    /// 是否是压缩的（共享Shape的）Object
+    bool compacted() const { return packed != nullptr; }
+
+
+    /// 以下为map兼容的操作，与map的操作一一对应
+    bool empty() const;
+    size_type size() const;
+    void swap(Object &);
+    void clear();
+
+    iterator begin() { expose(); return obj.begin(); }
+    iterator end() { expose(); return obj.end(); }
+    const_iterator begin() const { return members().begin(); }
+    const_iterator end() const { return members().end(); }
+    const_iterator cbegin() const { return members().cbegin(); }
+    const_iterator cend() const { return members().cend(); }
+
+    std::pair<iterator, bool> insert(const value_type &);
+    template<typename _Pair>
+    std::pair<iterator, bool> insert(_Pair &&p);
+    void insert(std::initializer_list<value_type> il);
+    template<typename _InputIterator>
+    void insert(_InputIterator, _InputIterator);
+    iterator insert(const_iterator _position, const value_type &);
+    template<typename _Pair>
+    iterator insert(const_iterator _position, _Pair &&p);
+
+    size_type erase(const key_type &);
+    iterator erase(const_iterator p);
+    iterator erase(const_iterator b, const_iterator e);
+
+    mapped_type &operator[](const key_type &);
+    mapped_type &at(const key_type &);
+    const mapped_type &at(const key_type &) const;
+
+    /// find和一些成员函数根据对象是否为const进行重载
+    iterator find(const key_type &);
+    const_iterator find(const key_type &) const;
+    size_type count(const key_type &) const;
+
+    iterator lower_bound(const key_type &);
+    const_iterator lower_bound(const key_type &) const;
+    iterator upper_bound(const key_type &);
+    const_iterator upper_bound(const key_type &) const;
+    std::pair<iterator, iterator>
+        equal_range(const key_type &);
+    std::pair<const_iterator, const_iterator>
+        equal_range(const key_type &) const;
+
+    /// 接受const char*、std::string_view等键的版本：直接与已有的键比较，不构造String，
+    /// 因此只读的查找不分配内存；operator[]只在插入新键时构造String
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    size_type erase(const _Key &);
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    mapped_type &operator[](const _Key &);
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    mapped_type &at(const _Key &);
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    const mapped_type &at(const _Key &) const;
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    iterator find(const _Key &);
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    const_iterator find(const _Key &) const;
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    size_type count(const _Key &) const;
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    iterator lower_bound(const _Key &);
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    const_iterator lower_bound(const _Key &) const;
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    iterator upper_bound(const _Key &);
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    const_iterator upper_bound(const _Key &) const;
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    std::pair<iterator, iterator>
+        equal_range(const _Key &);
+    template<typename _Key, typename = EnableIfKeyView<_Key>>
+    std::pair<const_iterator, const_iterator>
+        equal_range(const _Key &) const;
+
+
+private:
+    DECLARE_IMPL(Object, object_type)
+
+    /**************************************
+     压缩的Object：成员保存在packed->slots()中，与packed->shape的键一一对应，obj为空。
+     1、size、at、count、for_each以及序列化、哈希等只读操作直接使用slots；
+     2、const的begin、find等必须返回map的迭代器，第一次调用时把成员复制到
+        packed->view中（通过原子指针发布，多个线程可以同时读取）；
+     3、任何非const成员函数都先调用touch，把成员移回obj，之后就是普通的Object；
+        因此先前通过const版本取得的引用与迭代器都会失效。
+
+    **************************************/
+    struct Packed
+    {
+        const Shape *shape;
+        std::size_t size;                   /// 已构造的值的个数，构造完成后等于shape->size()
+        mutable std::atomic<_Type *> view;
+
+        /// 值紧接在Packed之后，与它在同一块内存中
+        Value *slots() { return reinterpret_cast<Value *>(this + 1); }
+        const Value *slots() const { return reinterpret_cast<const Value *>(this + 1); }
+    };
+
+    /// 任何可能修改元素的非const成员函数都先调用touch，使缓存失效，并解除压缩
+    void touch() { cache.reset(); if(packed) unpack(); }
+    /// 交出元素的引用或迭代器的非const成员函数使用：之后不再缓存（见NodeCache）
+    void expose() { cache.expose(); if(packed) unpack(); }
+    /// 接受位置的操作使用：压缩时p指向packed->view，unpack之后失效，
+    /// 因此先转换为下标（同Array的位置参数），expose之后返回obj中同一下标的迭代器
+    const_iterator expose(const_iterator p);
+    void unpack();
+    /// 插入新成员时使用：新的键与子结点的内存与map来自同一个memory_resource
+    ResourceScope inherit() const { return ResourceScope(obj.get_allocator().resource()); }
+    /// 为shape分配Packed（引用shape，值由调用者逐个构造）
+    static Packed *alloc_packed(const Shape *shape);
+    static void free_packed(Packed *p) noexcept;
+    /// const访问map时使用：压缩的Object返回packed->view
+    const _Type &members() const { return packed ? packed_view() : obj; }
+    const _Type &packed_view() const;
+    /// 压缩时查找键对应的值，不存在时返回nullptr
+    const Value *packed_find(std::string_view k) const;
+
+    JsonString doFormat(unsigned nest,
+                        const JsonString &padstr) const;
+
+    _Type obj; /// json::members -> std::map;
+    Packed *packed = nullptr;
+    NodeCache cache;
+};
+
+
+
+/// 一段连续元素的只读视图（C++17中没有std::span），由Array::as_span返回
+template<typename T>
+class Span
+{
+public:
+    Span() = default;
+    Span(T *p, std::size_t n): ptr(p), len(n) {}
+
+    T *data() const { return ptr; }
+    std::size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    T *begin() const { return ptr; }
+    T *end() const { return ptr + len; }
+    T &operator[](std::size_t i) const { return ptr[i]; }
+
+private:
+    T *ptr = nullptr;
+    std::size_t len = 0;
+};
+
+
+
+class Array : public Value_base /// It's a std::vector!
+{
+public:
+    static Array Parse(std::string_view);
+    JsonString Serialize() const;
+
+    /// 保留估计长度不小于min_bytes的各层子树（包括自身）的序列化结果，
+    /// 之后的Serialize直接复制未被修改的子树的结果，只重新生成被修改的路径；
+    /// 交出过元素引用的结点不保存（见NodeCache），通过先前取得的引用修改之后结果仍然正确
+    void cache_serialized(std::size_t min_bytes = 256);
+    /// 不再保留序列化结果，并释放已保存的部分
+    void clear_serialized_cache();
+
+    typedef std::vector<Value, Allocator<Value>> _Type;
+    typedef _Type::iterator iterator;
+    typedef _Type::const_iterator const_iterator;
+    typedef _Type::size_type size_type;
+    typedef _Type::difference_type difference_type;
+    typedef _Type::value_type value_type;
+    typedef _Type::reference reference;
+    typedef _Type::const_reference const_reference;
+
+    /************************************************/
+    Array() = default;
+    Array(std::initializer_list<value_type> il);
+    template<typename _InputIterator>
+    Array(_InputIterator b, _InputIterator e);
+    explicit
+    Array(size_type n);
+    Array(size_type n, const value_type &);
+    /// 直接以紧凑的形式保存数字（见Array::Dense），double按最短的往返表示序列化
+    explicit
+    Array(std::vector<double> values);
+    explicit
+    Array(std::vector<std::int64_t> values);
+
+    Array(const Array &);
+    Array(Array &&) noexcept;
+    Array &operator=(const Array &);
+    Array &operator=(Array &&) noexcept;
+    ~Array();
+    /************************************************/
+
+    /// 元素是否以紧凑的数字数组保存
+    bool is_dense() const { return dense != nullptr; }
+    /// 紧凑保存的数字，T为double或std::int64_t：
+    /// const版本要求元素已经以T保存，否则抛出JsonError(json_bad_cast)；
+    /// 非const的operator[]等交出引用之后、下一次修改结构之前，元素以view为准，const版本也抛出；
+    /// 非const版本先尝试把元素转换为T的紧凑形式（Serialize的结果必须保持不变），
+    /// 不能转换时（有非数字元素、超出范围等）抛出json_bad_cast
+    template<typename T>
+    Span<const T> as_span() const;
+    template<typename T>
+    Span<const T> as_span();
+
+    /// 以路径（见ArrayIndex）处的字段值建立哈希索引，索引随之后对Array的修改更新或失效
+    ArrayIndex build_index(std::string_view path);
+
+
+    /// 以下为vector兼容的操作，与vector的操作一一对应
+    bool empty() const;
+    size_type size() const;
+    void swap(Array &);
+    void clear();
+
+    iterator begin() { if(indexes) index_touched(0, size()); return expose(0, size()).begin(); }
+    iterator end() { if(indexes) index_touched(0, size()); return expose(0, size()).end(); }
+    const_iterator begin() const { return elements().begin(); }
+    const_iterator end() const { return elements().end(); }
+    const_iterator cbegin() const { return elements().cbegin(); }
+    const_iterator cend() const { return elements().cend(); }
+
+    void push_back(const value_type &);
+    void push_back(value_type &&);
+    /// 在C++11标准下，insert的位置参数可以用const_iterator来指示
+    /// insert有左值和右值两个版本
+    iterator insert(const_iterator p, const value_type &);
+    iterator insert(const_iterator p, value_type &&);
+    iterator insert(const_iterator p, size_type n, const value_type &);
+    template<typename _InputIterator>
+    iterator insert(const_iterator p, _InputIterator b, _InputIterator e);
+    iterator insert(const_iterator p, std::initializer_list<value_type> il);
+
+    void pop_back();
+    iterator erase(const_iterator p);
+    iterator erase(const_iterator b, const_iterator e);
+
+    value_type &back();
+    const value_type &back() const;
+    value_type &front();
+    const value_type &front() const;
+    value_type &operator[](size_type n);
+    const value_type &operator[](size_type n) const;
+    value_type &at(size_type n);
+    const value_type &at(size_type n) const;
+
+    void resize(size_type n);
+    void resize(size_type n, const value_type &);
+    void shrink_to_fit();
+    size_type capacity() const;
+    void reserve(size_type n);
+
+private:
+    DECLARE_IMPL(Array, array_type)
+
+    /**************************************
+     紧凑的Array：元素全部是数字时保存在dense->i64或dense->f64中，arr为空。
+     1、解析时，只有词素与按数值重新生成的文本（整数的十进制、double的最短往返表示）
+        完全相同的数字才保存为紧凑形式，因此Serialize的结果与原文逐字节相同；
+        整数之后出现小数时整体转换为f64，遇到其他元素时转换回普通的Array；
+     2、size、序列化、哈希与比较直接使用紧凑的数组；
+     3、const的begin、operator[]等必须返回Value，第一次调用时按上述文本构造Number，
+        保存在dense->view中（通过原子指针发布，多个线程可以同时读取）；
+     4、非const的operator[]、at、begin等同样返回view中的元素，不解除紧凑形式，
+        只把交出引用的范围记为exposed：之后可能通过引用修改元素，读取时以view为准；
+        下一次修改结构（push_back、insert、erase等）时由settle按view重新生成紧凑的数组，
+        只有元素被替换为不能紧凑保存的值（非数字等）时才转换回普通的Array，
+        因此非const版本取得的引用与迭代器在修改结构之后失效（std::vector扩容时也是如此）；
+     5、push_back、insert可以紧凑保存的数字时直接追加到i64/f64（需要时转换为f64），
+        pop_back、erase与clear直接删除；其余修改结构的非const成员函数（范围insert、resize、swap）
+        先调用touch，把元素移回arr，之后就是普通的Array；
+        因此先前通过const版本取得的引用与迭代器都会失效。
+     每个数字只占8个字节，而普通的Array中每个数字是一个Number结点加上保存词素的NumberImpl。
+
+    **************************************/
+    struct Dense
+    {
+        typedef std::vector<std::int64_t, Allocator<std::int64_t>> I64;
+        typedef std::vector<double, Allocator<double>> F64;
+
+        bool floating = false;              /// 元素保存在f64中，否则在i64中
+        I64 i64;
+        F64 f64;
+        mutable std::atomic<_Type *> view{nullptr};
+        bool exposed = false;               /// view中[lo, hi)的元素交出过非const引用，以view为准
+        std::size_t lo = 0, hi = 0;
+
+        std::size_t size() const { return floating ? f64.size() : i64.size(); }
+        /// 第i个元素的文本（即Serialize的结果），返回长度，buf至少32个字节
+        std::size_t format(std::size_t i, char *buf) const;
+        /// 按词素追加一个数字，不能保持Serialize结果不变时返回false，内容不变
+        bool push(const SubString &lexeme, bool integral);
+        /// 追加一个Number（规则同make_dense），不是数字或不能保持Serialize结果不变时返回false
+        bool push(const Value &v);
+        /// 把i64转换为f64，有整数不能精确往返时返回false，内容不变
+        bool widen();
+
+        JSON_NODE_ALLOCATION
+    };
+
+    /// 任何可能修改元素的非const成员函数都先调用touch，使缓存失效，并解除紧凑形式，
+    /// 已建立的索引标记为过期
+    void touch() { cache.reset(); if(dense) unpack(); if(indexes) invalidate_indexes(); }
+    /// 交出元素[b, e)的引用或迭代器之前调用，之后不再缓存（见NodeCache）；
+    /// 返回元素所在的vector：紧凑的Array返回dense->view，不解除紧凑形式
+    _Type &expose(size_type b, size_type e) { cache.expose(); return dense ? expose_dense(b, e) : arr; }
+    _Type &expose_dense(size_type b, size_type e);
+    /// 修改紧凑的Array的结构之前调用：交出过引用时按view重新生成紧凑的数组，不能时解除紧凑形式
+    void settle() { if(dense && dense->exposed) settle_view(); }
+    void settle_view();
+    /// 在紧凑的Array的第i个位置插入n个v；v不能紧凑保存时解除紧凑形式，返回false
+    bool dense_insert(size_type i, size_type n, const value_type &v);
+    /// 删除紧凑的Array的[b, e)，要求已经settle
+    void dense_erase(size_type b, size_type e) noexcept;
+    void unpack();
+    /// 复制元素时使用：新的子结点与vector来自同一个memory_resource
+    ResourceScope inherit() const { return ResourceScope(arr.get_allocator().resource()); }
+    static void free_dense(Dense *d) noexcept;
+    /// const访问vector时使用：紧凑的Array返回dense->view
+    const _Type &elements() const { return dense ? dense_view() : arr; }
+    /// 数值与元素一致的紧凑数组：交出过引用（以view为准）时返回nullptr，应使用elements()
+    const Dense *dense_values() const { return dense && !dense->exposed ? dense : nullptr; }
+    const _Type &dense_view() const;
+    /// 把普通的Array中的元素转换为紧凑形式，不能转换时返回false，内容不变
+    bool make_dense(bool floating);
+    /// 按format的文本构造与Reader的解析结果相同（保存词素）的Number
+    static Value lexeme_value(std::string_view text);
+
+    JsonString doFormat(unsigned nest,
+                        const JsonString &padstr) const;
+
+    /// 索引的维护（定义在Json_index.cpp中）：i为插入后新元素的下标、删除前被删元素的下标
+    void invalidate_indexes() noexcept;
+    void index_inserted(size_type i) noexcept;
+    void index_erasing(size_type i) noexcept;
+    /// 交出元素[b, e)的非const引用：索引不过期，下一次查找时核对这些元素
+    void index_touched(size_type b, size_type e) noexcept;
+    void detach_indexes() noexcept;
+
+    _Type arr; /// json::elements -> std::vector
+    Dense *dense = nullptr;
+    NodeCache cache;
+    IndexLinks *indexes = nullptr;  /// 在这个Array上建立的ArrayIndex
+};
+
+
+
+class True : public Value_base
+{
+public:
+    static True Parse(std::string_view);
+    JsonString Serialize() const { return "true"; }
+    True() = default;
+
+private:
+    DECLARE_IMPL(True, true_type)
+};
+
+
+
+class False : public Value_base
+{
+public:
+    static False Parse(std::string_view);
+    JsonString Serialize() const { return "false"; }
+    False() = default;
+
+private:
+    DECLARE_IMPL(False, false_type)
+};
+
+
+
+class Null : public Value_base
+{
+public:
+    static Null Parse(std::string_view);
+    JsonString Serialize() const { return "null"; }
+    Null() = default;
+
+private:
+    DECLARE_IMPL(Null, null_type)
+};  const Null null;
+
+
+
+class Value
+{
+    friend class Object;
+    friend class Array;
+    friend class Reader;
+    friend class Writer;
+    friend class Columnizer;
+    friend class PathEvaluator;
+    friend class ArrayIndex;
+    friend class Reclaimer;
+
+public:
+
+    /// 解析失败时抛出带有出错位置的JsonError
+    static Value Parse(std::string_view);
+    /// 不抛出异常的版本：成功时结果写入out，失败时out保持不变
+    static ParseResult TryParse(std::string_view, Value &out) noexcept;
+    /// 并行解析大型的顶层Array/Object，结果与顺序解析完全相同
+    static Value Parse(std::string_view, const ParallelOptions &);
+    static ParseResult TryParse(std::string_view, Value &out,
+                                const ParallelOptions &) noexcept;
+    /// 在reuse原有的树上解析：结构相同的部分重用Array的容量、Object的结点与String的缓冲区，
+    /// 反复解析同样结构的消息时几乎不分配内存；失败时reuse是有效的，但内容不确定
+    static void ParseInto(std::string_view, Value &reuse);
+    static ParseResult TryParseInto(std::string_view, Value &reuse) noexcept;
+    /// 只构造proj选中的成员，其余的值只做结构检查地跳过（见Projection）
+    static Value Parse(std::string_view, const Projection &proj);
+    static ParseResult TryParse(std::string_view, Value &out, const Projection &proj) noexcept;
+    /// 树的所有结点、容器与字符串都从mr分配（见Json_alloc.h），mr必须比树活得更久；
+    /// 之后通过Object/Array插入的子结点也来自mr，直到整棵树释放
+    static Value Parse(std::string_view, std::pmr::memory_resource *mr);
+    JsonString Serialize() const;
+    /// 并行序列化大型的Array/Object，结果与Serialize()逐字节相同
+    JsonString Serialize(const ParallelOptions &) const;
+    /// Serialize()结果的精确长度，不生成字符串
+    std::size_t SerializedSize() const;
+    /// 把序列化结果以iovec的形式追加到out中，供writev使用：
+    /// 较长且无需转义的字符串直接引用结点中的内容，不复制（见GatherBuffer）
+    void Serialize(GatherBuffer &out) const;
+    JsonType Type() const;
+    JsonString Format(const JsonString &padstr = "    ") const;
+
+    /// 把树中所有非空的Object转换为压缩形式：键集合相同的Object共享同一个Shape，
+    /// 各自只保存值的数组；Object的接口保持不变（见Object::Packed）
+    void compact();
+
+    /// 见Object::cache_serialized，对String等其他类型的结点不起作用
+    void cache_serialized(std::size_t min_bytes = 256);
+    void clear_serialized_cache();
+
+    /// 结构哈希：相等（operator==）的Value哈希值一定相同；Array/Object的哈希值缓存在结点上，
+    /// 交出过元素引用的结点不缓存（见NodeCache），因此通过先前取得的引用修改元素之后也成立
+    std::size_t hash() const noexcept;
+    /// 深比较：共享同一结点时直接相等，两边都有缓存的哈希值且不同时直接不等
+    friend bool operator==(const Value &lhs, const Value &rhs) noexcept;
+    friend bool operator!=(const Value &lhs, const Value &rhs) noexcept
+        { return !(lhs == rhs); }
+
+    ~Value() { if(pbase) destroy(pbase); }
+    Value(const Value &rhs):     pbase(rhs.pbase ? copy(rhs.pbase) : nullptr) {}
+    Value(Value &&rhs) noexcept: pbase(rhs.pbase) { rhs.pbase = nullptr; }
+    Value &operator=(const Value &rhs);
+    /// 被替换的结点来自memory_resource而移入的结点不是时，移入的是在其中的副本（见rehome）
+    Value &operator=(Value &&rhs);
+
+    Value():                           pbase(new Null()) {}
+    Value(bool b):                     pbase(b ? static_cast<Value_base*>(new True()):
+                                                 static_cast<Value_base*>(new False())) {}
+    Value(int i):                      pbase(new Number(i)) {}
+    Value(unsigned int u):             pbase(new Number(u)) {}
+    Value(long l):                     pbase(new Number(l)) {}
+    Value(unsigned long ul):           pbase(new Number(ul)) {}
+    Value(long long ll):               pbase(new Number(ll)) {}
+    Value(unsigned long long ull):     pbase(new Number(ull)) {}
+    Value(float f):                    pbase(new Number(f)) {}
+    Value(double d):                   pbase(new Number(d)) {}
+    Value(long double ld):             pbase(new Number(ld)) {}
+    Value(float f, int p):             pbase(new Number(f, p)) {}
+    Value(double d, int p):            pbase(new Number(d, p)) {}
+    Value(long double ld, int p):      pbase(new Number(ld, p)) {}
+    Value(const std::string &s):       pbase(new String(s)) {}
+    Value(std::string &&s):            pbase(new String(std::move(s))) {}
+    Value(const char *cp):             pbase(new String(cp)) {}
+    Value(const Value_base &base):     pbase(base.clone()) {}
+    Value(Value_base &&base) noexcept: pbase(std::move(base).clone()) {}
+    Value(std::initializer_list
+            <Object::value_type> il):  pbase(new Object(il)) {}
+    template<typename T = void>
+    Value(std::initializer_list
+            <Array::value_type> il):   pbase(new Array(il)) {}
+
+    std::string        to_string()     const { auto p = getString(); return p->to_string(); }
+    int                to_int()        const { auto p = getNumber(); return p->to_int(); }
+    unsigned int       to_uint()       const { auto p = getNumber(); return p->to_uint(); }
+    long               to_long()       const { auto p = getNumber(); return p->to_long(); }
+    unsigned long      to_ulong()      const { auto p = getNumber(); return p->to_ulong(); }
+    long long          to_longlong()   const { auto p = getNumber(); return p->to_longlong(); }
+    unsigned long long to_ulonglong()  const { auto p = getNumber(); return p->to_ulonglong(); }
+    float              to_float()      const { auto p = getNumber(); return p->to_float(); }
+    double             to_double()     const { auto p = getNumber(); return p->to_double(); }
+    long double        to_longdouble() const { auto p = getNumber(); return p->to_longdouble(); }
+
+    bool is_String() const { return Type() == string_type; }
+    bool is_Number() const { return Type() == number_type; }
+    bool is_Object() const { return Type() == object_type; }
+    bool is_Array () const { return Type() == array_type; }
+    bool is_True  () const { return Type() == true_type; }
+    bool is_False () const { return Type() == false_type; }
+    bool is_Null  () const { return Type() == null_type; }
+
+    String to_String() const & { auto p = getString(); return *p; }
+    String to_String() &&      { auto p = getString(); return std::move(*p); }
+    Number to_Number() const & { auto p = getNumber(); return *p; }
+    Number to_Number() &&      { auto p = getNumber(); return std::move(*p); }
+    Object to_Object() const & { auto p = getObject(); return *p; }
+    Object to_Object() &&      { auto p = getObject(); return std::move(*p); }
+    Array  to_Array () const & { auto p = getArray (); return *p; }
+    Array  to_Array () &&      { auto p = getArray (); return std::move(*p); }
+    True   to_True  () const & { auto p = getTrue  (); return *p; }
+    True   to_True  () &&      { auto p = getTrue  (); return std::move(*p); }
+    False  to_False () const & { auto p = getFalse (); return *p; }
+    False  to_False () &&      { auto p = getFalse (); return std::move(*p); }
+    Null   to_Null  () const & { auto p = getNull  (); return *p; }
+    Null   to_Null  () &&      { auto p = getNull  (); return std::move(*p); }
+
+    /// 返回结点本身的引用，不拷贝；通过非const版本可以就地修改深层的结点
+    /// （结点标记为escaped，见NodeCache）
+    Object       &as_Object();
+    const Object &as_Object() const { return *getObject(); }
+    Array        &as_Array ();
+    const Array  &as_Array () const { return *getArray (); }
+
+private:
+
+    String *getString() const;
+    Number *getNumber() const;
+    Object *getObject() const;
+    Array  *getArray () const;
+    True   *getTrue  () const;
+    False  *getFalse () const;
+    Null   *getNull  () const;
+
+    struct adopt_t {};
+    /// 直接接管一个已分配的结点，供Reader使用
+    Value(Value_base *p, adopt_t): pbase(p) {}
+
+    JsonString doFormat(unsigned nest,
+                        const JsonString &padstr) const;
+    void check() const;
+    /// 结点是交出过引用的Array/Object：插入容器后可能绕过容器被修改
+    bool referenced() const noexcept;
+    /// 结点不是来自mr时换成在mr中的副本，原来的树随之释放（先前取得的子元素引用失效）：
+    /// 移入容器的结点因此与容器来自同一个memory_resource
+    void rehome(std::pmr::memory_resource *mr);
+
+    static std::size_t hash(const Value_base *p) noexcept;
+    static bool equal(const Value_base *lhs, const Value_base *rhs) noexcept;
+
+    /// 深拷贝与释放一棵树：用显式的栈代替递归，嵌套深度不受调用栈大小的限制
+    static Value_base *copy(const Value_base *p);
+    static void destroy(Value_base *p) noexcept;
+    /// copy使用：复制容器自身（缓存、Shape），不复制元素
+    static Value_base *copy_shell(const Value_base *p);
+
+    /// 递归处理嵌套的容器时，当前线程中的递归层数达到recursion_limit之后，更深的部分改用显式的栈
+    static constexpr unsigned recursion_limit = 64;
+    /// 递归层数的计数：构造时加一，析构（包括抛出异常）时减一
+    struct Nesting
+    {
+        explicit Nesting(unsigned &d): depth(++d) {}
+        ~Nesting() { --depth; }
+        unsigned &depth;
+    };
+    /// 显式栈中的一层：按顺序取出一个Array/Object的子结点
+    struct Cursor
+    {
+        explicit Cursor(const Value_base *p);
+        /// 取出下一个子结点，没有时返回false；Object的成员同时给出键，Array的key为nullptr
+        bool next(const String *&key, const Value *&value);
+
+        const Value_base *node;
+        std::size_t index = 0;              /// 已取出的子结点个数
+        Object::const_iterator member;      /// 未压缩的Object中下一个成员
+        std::size_t mark = 0;               /// 由使用者解释：输出的起始位置、哈希的种子等
+    };
+    /// 达到recursion_limit之后的Serialize、doFormat与hash：结果与递归的版本相同
+    static void serialize_deep(const Value_base *p, std::string &out);
+    static void format_deep(const Value_base *p, unsigned nest,
+                            const JsonString &padstr, std::string &out);
+    static std::size_t hash_deep(const Value_base *p) noexcept;
+    /// Array/Object的比较：逐个元素调用equal
+    static bool equal_members(const Value_base *lhs, const Value_base *rhs) noexcept;
+
+    Value_base* pbase; /// pbase可能为空
+};
+
+
+
+inline Object &
+    Value::as_Object()
+{
+    Object *p = getObject();
+    p->cache.escaped = true;
+    return *p;
+}
+
+
+inline Array &
+    Value::as_Array()
+{
+    Array *p = getArray();
+    p->cache.escaped = true;
+    return *p;
+}
+
+
+inline
+    Value::Cursor::Cursor(const Value_base *p): node(p)
+{
+    if(p->Type() == object_type && !static_cast<const Object *>(p)->packed)
+        member = static_cast<const Object *>(p)->obj.cbegin();
+}
+
+
+inline bool
+    Value::Cursor::next(const String *&key, const Value *&value)
+{
+    if(node->Type() == array_type)
+    {
+        const Array::_Type &elems = static_cast<const Array *>(node)->elements();
+        if(index == elems.size())
+            return false;
+        key = nullptr;
+        value = &elems[index];
+    }
+    else if(const Object::Packed *packed = static_cast<const Object *>(node)->packed)
+    {
+        if(index == packed->size)
+            return false;
+        key = &packed->shape->key(index);
+        value = packed->slots() + index;
+    }
+    else
+    {
+        if(member == static_cast<const Object *>(node)->obj.cend())
+            return false;
+        key = &member->first;
+        value = &member->second;
+        ++member;
+    }
+    ++index;
+    return true;
+}
+
+
+inline
+bool operator==(const String &lhs, const String &rhs)
+    { return lhs.str == rhs.str; }
+
+inline
+bool operator!=(const String &lhs, const String &rhs)
+    { return lhs.str != rhs.str; }
+
+inline
+bool operator< (const String &lhs, const String &rhs)
+    { return lhs.str <  rhs.str; }
+
+inline
+bool operator<=(const String &lhs, const String &rhs)
+    { return lhs.str <= rhs.str; }
+
+inline
+bool operator> (const String &lhs, const String &rhs)
+    { return lhs.str >  rhs.str; }
+
+inline
+bool operator>=(const String &lhs, const String &rhs)
+    { return lhs.str >= rhs.str; }
+
+/// 供Object的异构查找使用
+inline
+bool operator< (const String &lhs, std::string_view rhs)
+    { return std::string_view(lhs.str) < rhs; }
+
+inline
+bool operator< (std::string_view lhs, const String &rhs)
+    { return lhs < std::string_view(rhs.str); }
+
+
+inline Object::
+    Object(std::initializer_list<value_type> il):
+    obj(il) {}
+
+
+template<typename _InputIterator>
+inline Object::
+    Object(_InputIterator b, _InputIterator e):
+    obj(b, e) {}
+
+
+inline bool
+    Object::empty() const { return packed ? packed->size == 0 : obj.empty(); }
+
+
+inline Object::size_type
+    Object::size() const { return packed ? packed->size : obj.size(); }
+
+
+inline void
+    Object::swap(Object &rhs)
+{
+    touch();
+    rhs.touch();
+    obj.swap(rhs.obj);
+    /// 交出的引用随元素交换，两边都不再缓存
+    if(cache.exposed || rhs.cache.exposed)
+        cache.exposed = rhs.cache.exposed = true;
+}
+
+
+inline void
+    Object::clear() { touch(); return obj.clear(); }
+
+
+inline std::pair<Object::iterator, bool>
+    Object::insert(const value_type &v)
+    { expose(); auto scope = inherit(); return obj.insert(v); }
+
+
+/// 移入的值由调用者在自己的memory_resource中构造，插入之后换成在容器的memory_resource中的副本
+template<typename _Pair>
+inline std::pair<Object::iterator, bool>
+    Object::insert(_Pair &&p)
+{
+    expose();
+    auto scope = inherit();
+    auto ret = obj.insert(std::forward<_Pair>(p));
+    if(ret.second)
+        ret.first->second.rehome(obj.get_allocator().resource());
+    return ret;
+}
+
+
+inline void
+    Object::insert(std::initializer_list<value_type> il)
+    { touch(); auto scope = inherit(); obj.insert(il); }
+
+
+template<typename _InputIterator>
+inline void
+    Object::insert(_InputIterator b, _InputIterator e)
+    { touch(); auto scope = inherit(); obj.insert(b, e); }
+
+
+inline Object::iterator
+    Object::insert(const_iterator _position, const value_type &v)
+{
+    _position = expose(_position);
+    auto scope = inherit();
+    return obj.insert(_position, v);
+}
+
+
+template<typename _Pair>
+inline Object::iterator
+    Object::insert(const_iterator _position, _Pair &&p)
+{
+    _position = expose(_position);
+    auto scope = inherit();
+    size_type n = obj.size();
+    auto it = obj.insert(_position, std::forward<_Pair>(p));
+    if(obj.size() != n)
+        it->second.rehome(obj.get_allocator().resource());
+    return it;
+}
+
+
+inline Object::size_type
+    Object::erase(const key_type &k)
+    { touch(); return obj.erase(k); }
+
+
+inline Object::iterator
+    Object::erase(const_iterator p)
+    { return obj.erase(expose(p)); }
+
+
+inline Object::iterator
+    Object::erase(const_iterator b, const_iterator e)
+{
+    if(!packed)
+    {
+        expose();
+        return obj.erase(b, e);
+    }
+    size_type n = std::distance(b, e);
+    b = expose(b);
+    return obj.erase(b, std::next(b, n));
+}
+
+
+inline Object::mapped_type &
+    Object::operator[](const key_type &k)
+    { expose(); auto scope = inherit(); return obj.operator[](k); }
+
+
+inline Object::mapped_type &
+    Object::at(const key_type &k) { expose(); return obj.at(k); }
+
+
+inline const Object::mapped_type &
+    Object::at(const key_type &k) const
+{
+    if(!packed)
+        return obj.at(k);
+    if(const Value *v = packed_find(k.str))
+        return *v;
+    throw std::out_of_range("Object::at");
+}
+
+
+inline Object::iterator
+    Object::find(const key_type &k) { expose(); return obj.find(k); }
+
+
+inline Object::const_iterator
+    Object::find(const key_type &k) const { return members().find(k); }
+
+
+inline Object::size_type
+    Object::count(const key_type &k) const
+    { return packed ? (packed_find(k.str) ? 1 : 0) : obj.count(k); }
+
+
+inline Object::iterator
+    Object::lower_bound(const key_type &k)
+    { expose(); return obj.lower_bound(k); }
+
+
+inline Object::const_iterator
+    Object::lower_bound(const key_type &k) const
+    { return members().lower_bound(k); }
+
+
+inline Object::iterator
+    Object::upper_bound(const key_type &k)
+    { expose(); return obj.upper_bound(k); }
+
+
+inline Object::const_iterator
+    Object::upper_bound(const key_type &k) const
+    { return members().upper_bound(k); }
+
+
+inline
+std::pair<Object::iterator, Object::iterator>
+    Object::equal_range(const key_type &k)
+    { expose(); return obj.equal_range(k); }
+
+
+inline
+std::pair<Object::const_iterator, Object::const_iterator>
+    Object::equal_range(const key_type &k) const
+    { return members().equal_range(k); }
+
+
+inline
+void swap(Object &lhs, Object &rhs)
+    { lhs.swap(rhs); }
+
+
+inline std::size_t
+    Shape::index(std::string_view k) const
+{
+    std::size_t lo = 0, hi = keys.size();
+    while(lo < hi)
+    {
+        std::size_t mid = (lo + hi) / 2;
+        if(keys[mid] < k)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo != keys.size() && !(k < keys[lo]) ? lo : npos;
+}
+
+
+inline Object::const_iterator
+    Object::expose(const_iterator p)
+{
+    if(!packed)
+    {
+        expose();
+        return p;
+    }
+    const _Type &view = packed_view();
+    size_type i = p == view.end() ? packed->size : packed->shape->index(std::string_view(p->first.str));
+    expose();
+    return std::next(obj.cbegin(), i);
+}
+
+
+inline const Value *
+    Object::packed_find(std::string_view k) const
+{
+    std::size_t i = packed->shape->index(k);
+    return i == Shape::npos ? nullptr : packed->slots() + i;
+}
+
+
+template<typename _Fn>
+inline void
+    Object::for_each(_Fn fn) const
+{
+    if(packed)
+    {
+        const Value *slots = packed->slots();
+        for(std::size_t i = 0; i != packed->size; ++i)
+            fn(packed->shape->key(i), slots[i]);
+    }
+    else
+    {
+        for(const auto &member : obj)
+            fn(member.first, member.second);
+    }
+}
+
+
+template<typename _Key, typename>
+inline Object::size_type
+    Object::erase(const _Key &k)
+{
+    /// 键不存在时不解除压缩、不清空缓存；压缩的Object的成员在packed中，obj为空
+    std::string_view key(k);
+    if(packed ? packed_find(key) == nullptr : obj.find(key) == obj.end())
+        return 0;
+    touch();
+    obj.erase(obj.find(key));
+    return 1;
+}
+
+
+template<typename _Key, typename>
+inline Object::mapped_type &
+    Object::operator[](const _Key &k)
+{
+    expose();
+    std::string_view key(k);
+    auto it = obj.lower_bound(key);
+    if(it == obj.end() || key < it->first)
+    {
+        auto scope = inherit();
+        it = obj.emplace_hint(it, String(key), Value());
+    }
+    return it->second;
+}
+
+
+template<typename _Key, typename>
+inline Object::mapped_type &
+    Object::at(const _Key &k)
+{
+    expose();
+    auto it = obj.find(std::string_view(k));
+    if(it == obj.end())
+        throw std::out_of_range("Object::at");
+    return it->second;
+}
+
+
+template<typename _Key, typename>
+inline const Object::mapped_type &
+    Object::at(const _Key &k) const
+{
+    if(packed)
+    {
+        if(const Value *v = packed_find(std::string_view(k)))
+            return *v;
+        throw std::out_of_range("Object::at");
+    }
+    auto it = obj.find(std::string_view(k));
+    if(it == obj.end())
+        throw std::out_of_range("Object::at");
+    return it->second;
+}
+
+
+template<typename _Key, typename>
+inline Object::iterator
+    Object::find(const _Key &k)
+    { expose(); return obj.find(std::string_view(k)); }
+
+
+template<typename _Key, typename>
+inline Object::const_iterator
+    Object::find(const _Key &k) const
+    { return members().find(std::string_view(k)); }
+
+
+template<typename _Key, typename>
+inline Object::size_type
+    Object::count(const _Key &k) const
+{
+    if(packed)
+        return packed_find(std::string_view(k)) ? 1 : 0;
+    return obj.count(std::string_view(k));
+}
+
+
+template<typename _Key, typename>
+inline Object::iterator
+    Object::lower_bound(const _Key &k)
+    { expose(); return obj.lower_bound(std::string_view(k)); }
+
+
+template<typename _Key, typename>
+inline Object::const_iterator
+    Object::lower_bound(const _Key &k) const
+    { return members().lower_bound(std::string_view(k)); }
+
+
+template<typename _Key, typename>
+inline Object::iterator
+    Object::upper_bound(const _Key &k)
+    { expose(); return obj.upper_bound(std::string_view(k)); }
+
+
+template<typename _Key, typename>
+inline Object::const_iterator
+    Object::upper_bound(const _Key &k) const
+    { return members().upper_bound(std::string_view(k)); }
+
+
+template<typename _Key, typename>
+inline
+std::pair<Object::iterator, Object::iterator>
+    Object::equal_range(const _Key &k)
+    { expose(); return obj.equal_range(std::string_view(k)); }
+
+
+template<typename _Key, typename>
+inline
+std::pair<Object::const_iterator, Object::const_iterator>
+    Object::equal_range(const _Key &k) const
+    { return members().equal_range(std::string_view(k)); }
+
+
+
+
+inline Array::
+    Array(std::initializer_list<value_type> il):
+    arr(il) {}
+
+
+template<typename _InputIterator>
+inline Array::
+    Array(_InputIterator b, _InputIterator e):
+    arr(b, e) {}
+
+
+inline Array::
+    Array(size_type n): arr(n) {}
+
+
+inline Array::
+    Array(size_type n, const value_type &v):
+    arr(n, v) {}
+
+
+inline bool
+    Array::empty() const{ return dense ? dense->size() == 0 : arr.empty(); }
+
+
+inline Array::size_type
+    Array::size() const { return dense ? dense->size() : arr.size(); }
+
+
+inline void
+    Array::swap(Array &rhs)
+{
+    touch();
+    rhs.touch();
+    arr.swap(rhs.arr);
+    /// 交出的引用随元素交换，两边都不再缓存
+    if(cache.exposed || rhs.cache.exposed)
+        cache.exposed = rhs.cache.exposed = true;
+}
+
+
+inline void
+    Array::clear()
+{
+    cache.reset();
+    if(indexes)
+        invalidate_indexes();
+    if(dense)
+    {
+        dense->exposed = false;
+        dense_erase(0, size());
+    }
+    else
+        arr.clear();
+}
+
+
+inline void
+Array::push_back(const value_type &v)
+{
+    cache.reset();
+    if(dense == nullptr || !dense_insert(dense->size(), 1, v))
+    {
+        auto scope = inherit();
+        arr.push_back(v);
+    }
+    if(indexes)
+        index_inserted(size() - 1);
+}
+
+
+inline void
+    Array::push_back(value_type &&v)
+{
+    cache.reset();
+    /// 移入的结点先前交出过引用时，之后可能通过这些引用修改它
+    if(v.referenced())
+        cache.expose();
+    if(dense == nullptr || !dense_insert(dense->size(), 1, v))
+    {
+        v.rehome(arr.get_allocator().resource());
+        arr.push_back(std::move(v));
+    }
+    if(indexes)
+        index_inserted(size() - 1);
+}
+
+
+/// 位置参数先换算为下标：紧凑的Array的迭代器指向view，settle或unpack之后可能失效
+inline Array::iterator
+    Array::insert(const_iterator p, const value_type &v)
+{
+    size_type i = p - elements().cbegin();
+    cache.reset();
+    if(dense == nullptr || !dense_insert(i, 1, v))
+    {
+        auto scope = inherit();
+        arr.insert(arr.cbegin() + i, v);
+    }
+    /// 返回的迭代器可以到达任何元素
+    if(indexes)
+    {
+        index_inserted(i);
+        index_touched(0, size());
+    }
+    return expose(0, size()).begin() + i;
+}
+
+
+inline Array::iterator
+    Array::insert(const_iterator p, value_type &&v)
+{
+    size_type i = p - elements().cbegin();
+    cache.reset();
+    if(dense == nullptr || !dense_insert(i, 1, v))
+    {
+        v.rehome(arr.get_allocator().resource());
+        arr.insert(arr.cbegin() + i, std::move(v));
+    }
+    /// 返回的迭代器可以到达任何元素
+    if(indexes)
+    {
+        index_inserted(i);
+        index_touched(0, size());
+    }
+    return expose(0, size()).begin() + i;
+}
+
+
+inline Array::iterator
+    Array::insert(const_iterator p,
+                  size_type n, const value_type &v)
+{
+    size_type i = p - elements().cbegin();
+    cache.reset();
+    if(indexes)
+        invalidate_indexes();
+    if(dense == nullptr || !dense_insert(i, n, v))
+    {
+        auto scope = inherit();
+        arr.insert(arr.cbegin() + i, n, v);
+    }
+    return expose(0, size()).begin() + i;
+}
+
+
+template<typename _InputIterator>
+inline Array::iterator
+    Array::insert(const_iterator p,
+                  _InputIterator b, _InputIterator e)
+{
+    size_type i = p - elements().cbegin();
+    touch();
+    auto scope = inherit();
+    arr.insert(arr.cbegin() + i, b, e);
+    return expose(0, size()).begin() + i;
+}
+
+
+inline Array::iterator
+    Array::insert(const_iterator p,
+                  std::initializer_list<value_type> il)
+{
+    size_type i = p - elements().cbegin();
+    touch();
+    auto scope = inherit();
+    arr.insert(arr.cbegin() + i, il);
+    return expose(0, size()).begin() + i;
+}
+
+
+inline void
+    Array::pop_back()
+{
+    cache.reset();
+    settle();
+    if(indexes)
+        index_erasing(size() - 1);
+    if(dense)
+        dense_erase(size() - 1, size());
+    else
+        arr.pop_back();
+}
+
+
+inline Array::iterator
+    Array::erase(const_iterator p)
+{
+    size_type i = p - elements().cbegin();
+    cache.reset();
+    settle();
+    if(indexes)
+        index_erasing(i);
+    if(dense)
+        dense_erase(i, i + 1);
+    else
+        arr.erase(arr.cbegin() + i);
+    if(indexes)
+        index_touched(0, size());
+    return expose(0, size()).begin() + i;
+}
+
+
+inline Array::iterator
+    Array::erase(const_iterator b, const_iterator e)
+{
+    size_type i = b - elements().cbegin(), j = e - elements().cbegin();
+    cache.reset();
+    settle();
+    if(indexes)
+        invalidate_indexes();
+    if(dense)
+        dense_erase(i, j);
+    else
+        arr.erase(arr.cbegin() + i, arr.cbegin() + j);
+    return expose(0, size()).begin() + i;
+}
+
+
+inline Array::value_type &
+    Array::back()
+    { if(indexes) index_touched(size() - 1, size()); return expose(size() - 1, size()).back(); }
+
+
+inline const Array::value_type &
+    Array::back() const { return elements().back(); }
+
+
+inline Array::value_type &
+    Array::front()
+    { if(indexes) index_touched(0, 1); return expose(0, 1).front(); }
+
+
+inline const Array::value_type &
+    Array::front() const { return elements().front(); }
+
+
+inline Array::value_type &
+    Array::operator[](size_type n)
+    { if(indexes) index_touched(n, n + 1); return expose(n, n + 1)[n]; }
+
+
+inline const Array::value_type &
+    Array::operator[](size_type n) const
+    { return elements().operator[](n); }
+
+
+inline Array::value_type &
+    Array::at(size_type n)
+    { if(indexes) index_touched(n, n + 1); return expose(n, n + 1).at(n); }
+
+
+inline const Array::value_type &
+    Array::at(size_type n) const
+    { return elements().at(n); }
+
+
+inline void Array::resize(size_type n)
+    { touch(); auto scope = inherit(); arr.resize(n); }
+
+
+inline void
+    Array::resize(size_type n, const value_type &v)
+    { touch(); auto scope = inherit(); arr.resize(n, v); }
+
+
+inline void Array::shrink_to_fit()
+{
+    if(dense)
+        dense->floating ? dense->f64.shrink_to_fit() : dense->i64.shrink_to_fit();
+    arr.shrink_to_fit();
+}
+
+
+inline
+Array::size_type Array::capacity() const
+{
+    if(dense)
+        return dense->floating ? dense->f64.capacity() : dense->i64.capacity();
+    return arr.capacity();
+}
+
+
+inline void
+    Array::reserve(size_type n)
+{
+    if(dense)
+        dense->floating ? dense->f64.reserve(n) : dense->i64.reserve(n);
+    else
+        arr.reserve(n);
+}
+
+
+template<typename T>
+inline Span<const T> Array::as_span() const
+{
+    static_assert(std::is_same<T, double>::value || std::is_same<T, std::int64_t>::value,
+                  "Array::as_span<T>: T must be double or std::int64_t");
+    constexpr bool floating = std::is_same<T, double>::value;
+    if(dense_values() == nullptr || dense->floating != floating)
+        throw JsonError(json_bad_cast);
+    if constexpr(floating)
+        return Span<const T>(dense->f64.data(), dense->f64.size());
+    else
+        return Span<const T>(dense->i64.data(), dense->i64.size());
+}
+
+
+template<typename T>
+inline Span<const T> Array::as_span()
+{
+    constexpr bool floating = std::is_same<T, double>::value;
+    settle();
+    bool ok = dense ? dense->floating == floating || (floating && dense->widen())
+                    : make_dense(floating);
+    if(!ok)
+        throw JsonError(json_bad_cast);
+    return static_cast<const Array &>(*this).as_span<T>();
+}
+
+_JSON_END
+
+
+
+namespace std
+{
+/// 使Value可以作为unordered_map/unordered_set的键
+template<>
+struct hash<_JSON Value>
+{
+    size_t operator()(const _JSON Value &v) const noexcept { return v.hash(); }
+};
+}
+#endif // JSON_TYPE_H
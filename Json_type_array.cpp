@@ -0,0 +1,424 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include "Json_error.h"
+#include "Json_string.h"
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+
+namespace
+{
+
+/// 不含小数点与指数的文本是整数词素
+bool is_integral(std::string_view text)
+{
+    return text.find_first_of(".eE") == std::string_view::npos;
+}
+
+} // namespace
+
+
+
+Array::Array(std::vector<double> values): dense(new Dense)
+{
+    dense->floating = true;
+    dense->f64.assign(values.begin(), values.end());
+}
+
+
+Array::Array(std::vector<std::int64_t> values): dense(new Dense)
+{
+    dense->i64.assign(values.begin(), values.end());
+}
+
+
+Array::Array(const Array &rhs):
+    Value_base(rhs), arr(rhs.arr), cache(rhs.cache)
+{
+    if(rhs.dense && rhs.dense->exposed)
+    {
+        /// 交出过引用的紧凑Array以view为准：复制元素之后重新尝试紧凑形式
+        arr = *rhs.dense->view.load(std::memory_order_acquire);
+        if(!make_dense(rhs.dense->floating))
+            make_dense(true);
+    }
+    else if(rhs.dense)
+    {
+        std::unique_ptr<Dense> d(new Dense);
+        d->floating = rhs.dense->floating;
+        d->i64 = rhs.dense->i64;
+        d->f64 = rhs.dense->f64;
+        dense = d.release();
+    }
+}
+
+
+/// 索引不随元素转移：移动的目标没有索引，被移动的Array的索引过期
+Array::Array(Array &&rhs) noexcept:
+    Value_base(std::move(rhs)), arr(std::move(rhs.arr)),
+    dense(std::exchange(rhs.dense, nullptr)), cache(std::move(rhs.cache))
+{
+    if(rhs.indexes)
+        rhs.invalidate_indexes();
+}
+
+
+Array &Array::operator=(const Array &rhs)
+{
+    if(this != &rhs)
+    {
+        Array tmp(rhs);
+        *this = std::move(tmp);
+    }
+    return *this;
+}
+
+
+Array &Array::operator=(Array &&rhs) noexcept
+{
+    if(this != &rhs)
+    {
+        free_dense(std::exchange(dense, std::exchange(rhs.dense, nullptr)));
+        arr = std::move(rhs.arr);
+        cache = std::move(rhs.cache);
+        if(indexes)
+            invalidate_indexes();
+        if(rhs.indexes)
+            rhs.invalidate_indexes();
+    }
+    return *this;
+}
+
+
+Array::~Array()
+{
+    if(indexes)
+        detach_indexes();
+    free_dense(dense);
+}
+
+
+void Array::free_dense(Dense *d) noexcept
+{
+    if(d)
+    {
+        delete d->view.load(std::memory_order_acquire);
+        delete d;
+    }
+}
+
+
+
+/**************************************
+ Array::Dense::format算法说明：
+ 整数输出十进制，double输出std::to_chars的最短往返表示（定点与科学计数法中较短的一个），
+ 与解析时比较词素所用的规则相同，因此紧凑保存的数字原样输出原文中的词素。
+
+**************************************/
+std::size_t Array::Dense::format(std::size_t i, char *buf) const
+{
+    std::to_chars_result r = floating ? std::to_chars(buf, buf + 32, f64[i])
+                                      : std::to_chars(buf, buf + 32, i64[i]);
+    return r.ptr - buf;
+}
+
+
+/**************************************
+ Array::Dense::push算法说明：
+ 1、i64中：整数词素用from_chars转换，超出int64或为「-0」时返回false；
+    遇到非整数词素时先widen，成功后按2处理；
+ 2、f64中：用from_chars转换为double，超出范围时返回false；
+    再用format生成文本，与词素不同（例如「1.50」「1E3」或超过17位有效数字）时返回false。
+ 返回false时不修改已保存的元素，由调用者转换回普通的Array。
+
+**************************************/
+bool Array::Dense::push(const SubString &lexeme, bool integral)
+{
+    const char *b = lexeme.first, *e = lexeme.second;
+    if(!floating)
+    {
+        if(integral)
+        {
+            long long ll = 0;
+            std::from_chars_result r = std::from_chars(b, e, ll);
+            if(r.ec != std::errc() || r.ptr != e || (ll == 0 && *b == '-'))
+                return false;
+            i64.push_back(ll);
+            return true;
+        }
+        if(!widen())
+            return false;
+    }
+
+    double d = 0;
+    std::from_chars_result r = std::from_chars(b, e, d);
+    if(r.ec != std::errc() || r.ptr != e)
+        return false;
+    char buf[32];
+    std::to_chars_result w = std::to_chars(buf, buf + sizeof(buf), d);
+    if(static_cast<std::size_t>(w.ptr - buf) != lexeme.length()
+       || std::memcmp(buf, b, lexeme.length()) != 0)
+        return false;
+    f64.push_back(d);
+    return true;
+}
+
+
+/// 每个整数转换为double之后必须精确，并且最短表示与十进制文本相同（例如1000000的最短表示是1e+06）
+bool Array::Dense::widen()
+{
+    F64 wide(f64.get_allocator());
+    wide.reserve(i64.capacity());
+    for(std::int64_t v : i64)
+    {
+        double d = static_cast<double>(v);
+        if(d >= 9223372036854775808.0 || static_cast<std::int64_t>(d) != v)
+            return false;
+        char a[32], b[32];
+        std::to_chars_result ra = std::to_chars(a, a + sizeof(a), v);
+        std::to_chars_result rb = std::to_chars(b, b + sizeof(b), d);
+        if(ra.ptr - a != rb.ptr - b || std::memcmp(a, b, ra.ptr - a) != 0)
+            return false;
+        wide.push_back(d);
+    }
+    f64 = std::move(wide);
+    i64 = I64(i64.get_allocator());
+    floating = true;
+    return true;
+}
+
+
+
+/// make_dense与push_back、insert使用；失败时若已经widen，数值与文本仍然不变
+bool Array::Dense::push(const Value &v)
+{
+    if(v.pbase == nullptr || v.Type() != number_type)
+        return false;
+    const Number *num = static_cast<const Number *>(v.pbase);
+    std::string_view lexeme = num->lexeme();
+    std::string text;
+    if(lexeme.empty())
+        lexeme = text = num->Serialize();
+    if(!push(SubString(lexeme.data(), lexeme.data() + lexeme.size()), is_integral(lexeme)))
+        return false;
+    /// 构造的Number按精度输出（例如1.0 / 3输出0.333333），数值也必须保持不变
+    if(!text.empty() && (floating ? f64.back() != num->to_double()
+                                  : i64.back() != num->to_longlong()))
+    {
+        floating ? f64.pop_back() : i64.pop_back();
+        return false;
+    }
+    return true;
+}
+
+
+
+Value Array::lexeme_value(std::string_view text)
+{
+    return Value(new Number(text, is_integral(text), Number::lexeme_t()), Value::adopt_t());
+}
+
+
+/// 把紧凑的元素移回arr：view与arr来自同一个memory_resource时直接使用它，
+/// 交出过引用时以view为准，逐个移动元素（结点记录了各自的内存来源），
+/// 否则按format的文本逐个构造Number（在arr的memory_resource中）
+void Array::unpack()
+{
+    std::unique_ptr<Dense> d(std::exchange(dense, nullptr));
+    if(_Type *view = d->view.exchange(nullptr, std::memory_order_acq_rel))
+    {
+        std::unique_ptr<_Type> owned(view);
+        if(view->get_allocator() == arr.get_allocator())
+        {
+            arr = std::move(*view);
+            return;
+        }
+        if(d->exposed)
+        {
+            auto scope = inherit();
+            _Type fresh;
+            fresh.reserve(view->size());
+            for(auto &v : *view)
+                fresh.push_back(std::move(v));
+            arr = std::move(fresh);
+            return;
+        }
+    }
+
+    auto scope = inherit();
+    _Type fresh;
+    fresh.reserve(d->size());
+    char buf[32];
+    for(std::size_t i = 0; i != d->size(); ++i)
+        fresh.push_back(lexeme_value(std::string_view(buf, d->format(i, buf))));
+    arr = std::move(fresh);
+}
+
+
+/// 多个线程同时生成时，只有一个能够发布，其余的丢弃自己的拷贝；
+/// 与序列化结果的缓存一样使用::operator new，多个线程同时读取时不会并发地使用memory_resource
+const Array::_Type &Array::dense_view() const
+{
+    if(const _Type *view = dense->view.load(std::memory_order_acquire))
+        return *view;
+
+    ResourceScope scope(nullptr);
+    std::unique_ptr<_Type> fresh(new _Type);
+    fresh->reserve(dense->size());
+    char buf[32];
+    for(std::size_t i = 0; i != dense->size(); ++i)
+        fresh->push_back(lexeme_value(std::string_view(buf, dense->format(i, buf))));
+
+    _Type *expected = nullptr;
+    if(dense->view.compare_exchange_strong(expected, fresh.get(),
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_acquire))
+        return *fresh.release();
+    return *expected;
+}
+
+
+/**************************************
+ Array::expose_dense算法说明：
+ 1、返回dense->view（没有时先生成），非const的operator[]、begin等返回其中的元素；
+ 2、[b, e)并入exposed的范围：之后读取以view为准（dense_values返回nullptr），
+    直到下一次修改结构时settle_view按view中这些元素重新生成紧凑的数组。
+ 只交出一个元素（operator[]、at、back、front）时范围只有一个元素，
+ 因此反复地按下标修改再push_back，每次settle只检查一个元素。
+
+**************************************/
+Array::_Type &Array::expose_dense(size_type b, size_type e)
+{
+    _Type &view = const_cast<_Type &>(dense_view());
+    e = std::min<size_type>(e, view.size());
+    if(b < e)
+    {
+        if(!dense->exposed)
+        {
+            dense->lo = b;
+            dense->hi = e;
+            dense->exposed = true;
+        }
+        else
+        {
+            dense->lo = std::min(dense->lo, b);
+            dense->hi = std::max(dense->hi, e);
+        }
+    }
+    return view;
+}
+
+
+/// 按Dense::push(const Value &)的规则检查view中exposed的元素，全部可以紧凑保存时写回i64/f64
+/// （有非整数时整体widen），否则解除紧凑形式
+void Array::settle_view()
+{
+    const _Type &view = *dense->view.load(std::memory_order_relaxed);
+    Dense fresh;
+    fresh.floating = dense->floating;
+    for(std::size_t i = dense->lo; i != dense->hi; ++i)
+        if(!fresh.push(view[i]))
+        {
+            unpack();
+            return;
+        }
+    if(fresh.floating && !dense->floating && !dense->widen())
+    {
+        unpack();
+        return;
+    }
+    if(dense->floating)
+        std::copy(fresh.f64.begin(), fresh.f64.end(), dense->f64.begin() + dense->lo);
+    else
+        std::copy(fresh.i64.begin(), fresh.i64.end(), dense->i64.begin() + dense->lo);
+    dense->exposed = false;
+}
+
+
+/// view存在时插入同样的元素以保持一致；插入view失败（内存不足）时释放view，下次按需重新生成
+bool Array::dense_insert(size_type i, size_type n, const value_type &v)
+{
+    settle();
+    if(dense == nullptr)
+        return false;
+
+    Dense one;
+    one.floating = dense->floating;
+    if(!one.push(v) || (one.floating && !dense->floating && !dense->widen()))
+    {
+        unpack();
+        return false;
+    }
+    if(dense->floating)
+        dense->f64.insert(dense->f64.begin() + i, n, one.f64[0]);
+    else
+        dense->i64.insert(dense->i64.begin() + i, n, one.i64[0]);
+
+    if(_Type *view = dense->view.load(std::memory_order_relaxed))
+    {
+        try
+        {
+            ResourceScope scope(nullptr);
+            char buf[32];
+            Value e = lexeme_value(std::string_view(buf, one.format(0, buf)));
+            view->insert(view->begin() + i, n, e);
+        }
+        catch(...)
+        {
+            delete dense->view.exchange(nullptr, std::memory_order_acq_rel);
+        }
+    }
+    return true;
+}
+
+
+void Array::dense_erase(size_type b, size_type e) noexcept
+{
+    if(dense->floating)
+        dense->f64.erase(dense->f64.begin() + b, dense->f64.begin() + e);
+    else
+        dense->i64.erase(dense->i64.begin() + b, dense->i64.begin() + e);
+    if(_Type *view = dense->view.load(std::memory_order_relaxed))
+        view->erase(view->begin() + b, view->begin() + e);
+}
+
+
+/**************************************
+ Array::make_dense算法说明：
+ 每个元素必须是Number，取它的Serialize结果（保存了词素时就是词素）按Dense::push的规则追加，
+ 没有词素的Number还要求数值与to_double/to_longlong相同（见Dense::push(const Value &)），
+ 因此转换前后Serialize的结果与数值都不变，已缓存的哈希值与序列化结果仍然有效；
+ 要求int64时出现非整数、或者有元素不能精确往返时返回false，arr保持不变。
+
+**************************************/
+bool Array::make_dense(bool floating)
+{
+    auto scope = inherit();
+    std::unique_ptr<Dense> d(new Dense);
+    d->floating = floating;
+    if(floating)
+        d->f64.reserve(arr.size());
+    else
+        d->i64.reserve(arr.size());
+
+    for(const auto &v : arr)
+        if(!d->push(v) || d->floating != floating)
+            return false;
+
+    arr = _Type(arr.get_allocator());
+    dense = d.release();
+    return true;
+}
+
+
+_JSON_END
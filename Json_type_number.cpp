@@ -1,251 +1,389 @@
-#include <sstream>
-#include <string>
-#include <stdexcept>
-#include "Json_error.h"
-#include "Json_string.h"
-#include "Json_type.h"
-
-_JSON_BEGIN
-
-class NumberImpl
-{
-    friend class Number;
-    virtual JsonString Serialize() const = 0;
-    virtual NumberImpl *clone() const & = 0;
-    virtual NumberImpl *clone() && = 0;
-
-    virtual int to_int() const = 0;
-    virtual unsigned int to_uint() const = 0;
-    virtual long to_long() const = 0;
-    virtual unsigned long to_ulong() const = 0;
-    virtual long long to_longlong() const = 0;
-    virtual unsigned long long to_ulonglong() const = 0;
-    virtual float to_float() const = 0;
-    virtual double to_double() const = 0;
-    virtual long double to_longdouble() const = 0;
-
-protected:
-    virtual ~NumberImpl() = default;
-};
-
-
-
-#define DERIVED_NUMBERIMPL(_ClassName, _Type) \
-class _ClassName : public NumberImpl \
-{ \
-    friend class Number; \
-    JsonString Serialize() const; \
-    _ClassName *clone() const & { return new _ClassName(*this); } \
-    _ClassName *clone() && { return new _ClassName(std::move(*this)); } \
- \
-    int                to_int() const        { return static_cast<int>(val); } \
-    unsigned int       to_uint() const       { return static_cast<unsigned int>(val); } \
-    long               to_long() const       { return static_cast<long>(val); } \
-    unsigned long      to_ulong() const      { return static_cast<unsigned long>(val); } \
-    long long          to_longlong() const   { return static_cast<long long>(val); } \
-    unsigned long long to_ulonglong() const  { return static_cast<unsigned long>(val); } \
-    float              to_float() const      { return static_cast<float>(val); } \
-    double             to_double() const     { return static_cast<double>(val); } \
-    long double        to_longdouble() const { return static_cast<long double>(val); } \
- \
-protected: \
-    _ClassName(_Type t): val(t) {} \
-    _Type val; \
-}; \
- \
-JsonString _ClassName::Serialize() const \
-{ \
-    std::ostringstream out; \
-    out << val; \
-    return out.str(); \
-}
-
-
-#define DECLARE_ENHANCED_FLOATER(_ClassName, _BaseName, _Type) \
-class _ClassName : public _BaseName \
-{ \
-    friend class Number; \
-    JsonString Serialize() const; \
-    _ClassName *clone() const & { return new _ClassName(*this); } \
-    _ClassName *clone() && { return new _ClassName(std::move(*this)); } \
- \
-    _ClassName(_Type t, int p):_BaseName(t), prec(p) {} \
-    int prec; \
-}; \
- \
-JsonString _ClassName::Serialize() const \
-{ \
-    std::ostringstream out; \
-    out.precision(prec); \
-    out << val; \
-    return out.str(); \
-}
-
-
-DERIVED_NUMBERIMPL(INT, int)
-DERIVED_NUMBERIMPL(UINT, unsigned int)
-DERIVED_NUMBERIMPL(LONG, long)
-DERIVED_NUMBERIMPL(ULONG, unsigned long)
-DERIVED_NUMBERIMPL(LONGLONG, long long)
-DERIVED_NUMBERIMPL(ULONGLONG, unsigned long long)
-DERIVED_NUMBERIMPL(FLOAT, float)
-DERIVED_NUMBERIMPL(DOUBLE, double)
-DERIVED_NUMBERIMPL(LONGDOUBLE, long double)
-
-DECLARE_ENHANCED_FLOATER(EHFLOAT, FLOAT, float)
-DECLARE_ENHANCED_FLOATER(EHDOUBLE, DOUBLE, double)
-DECLARE_ENHANCED_FLOATER(EHLONGDOUBLE, LONGDOUBLE, long double)
-
-
-Number::Number(): pImpl(nullptr) {}
-Number::~Number() { delete pImpl; }
-Number::Number(const Number &rhs):      pImpl(rhs.pImpl ? rhs.pImpl->clone() : nullptr) {}
-Number::Number(Number &&rhs) noexcept : pImpl(rhs.pImpl) { rhs.pImpl = nullptr; }
-
-Number &Number::operator=(const Number &rhs)
-{
-    auto newp = rhs.pImpl ?
-        rhs.pImpl->clone() : nullptr;
-    delete pImpl;
-    pImpl = newp;
-    return *this;
-}
-
-
-Number &Number::operator=(Number &&rhs) noexcept
-{
-    if(this != &rhs)
-    {
-        delete pImpl;
-        pImpl = rhs.pImpl;
-        rhs.pImpl = nullptr;
-    }
-    return *this;
-}
-
-
-Number::Number(int i):                     pImpl(new INT(i)) {}
-Number::Number(unsigned int u):            pImpl(new UINT(u)) {}
-Number::Number(long l):                    pImpl(new LONG(l)) {}
-Number::Number(unsigned long ul):          pImpl(new ULONG(ul)) {}
-Number::Number(long long ll):              pImpl(new LONGLONG(ll)) {}
-Number::Number(unsigned long long ull):    pImpl(new ULONGLONG(ull)) {}
-Number::Number(float f):               pImpl(new FLOAT(f)) {}
-Number::Number(double d):              pImpl(new DOUBLE(d)) {}
-Number::Number(long double ld):        pImpl(new LONGDOUBLE(ld)) {}
-Number::Number(float f, int p):        pImpl(new EHFLOAT(f, p)) {}
-Number::Number(double d, int p):       pImpl(new EHDOUBLE(d, p)) {}
-Number::Number(long double ld, int p): pImpl(new EHLONGDOUBLE(ld, p)) {}
-
-
-///עpImplΪʱĬϴ
-int                Number::to_int() const        { return pImpl ? pImpl->to_int() : 0; }
-unsigned int       Number::to_uint() const       { return pImpl ? pImpl->to_uint() : 0U; }
-long               Number::to_long() const       { return pImpl ? pImpl->to_long() : 0L; }
-unsigned long      Number::to_ulong() const      { return pImpl ? pImpl->to_ulong() : 0UL; }
-long long          Number::to_longlong() const   { return pImpl ? pImpl->to_longlong() : 0LL; }
-unsigned long long Number::to_ulonglong() const  { return pImpl ? pImpl->to_ulonglong() : 0ULL; }
-float              Number::to_float() const      { return pImpl ? pImpl->to_float() : 0.0f; }
-double             Number::to_double() const     { return pImpl ? pImpl->to_double() : 0.0; }
-long double        Number::to_longdouble() const { return pImpl ? pImpl->to_longdouble() : 0.0L; }
-
-
-Number Number::Parse(const JsonString &js)
-{
-    auto ret = erase_head_tail_ws(js);
-    SubString subStr(ret.c_str(), ret.c_str() + ret.size());
-    return doParse(subStr);
-}
-
-
-/**************************************
- Number::Parse㷨˵
- 1ַΪգ׳ error_empty
- 2ַǵַ"+", "-", ".", "e", "E", ׳ error_badnum;
- 3ַǷ.eEӶȷǸ
-    3.1һַǷΪ-ӶȷǷǸǸ
-        3.1.1ǷǸstoullתΪunsigned long long͵ֵ
-        3.1.2ǸstollתΪlong long͵ֵ
-    3.2ǸstoldתΪlong double͵ֵ
-           ͳЧָӶ־ȡ
- 4ؽ
-
-**************************************/
-Number Number::doParse(const SubString &subStr)
-{
-    if(subStr.length() == 0)
-        throw JsonError(error_empty);
-
-    static const std::string sym = "+-.eE";
-    static const auto npos = std::string::npos;
-
-    if(subStr.length() == 1
-       && sym.find(*subStr.first) != npos)
-        throw JsonError(error_badnum);
-
-    std::string num(subStr.first, subStr.second);
-    std::size_t idx = 0;
-    auto expIdx = num.find_first_of("eE");
-    auto dotIdx = num.find('.');
-
-    if(expIdx == npos && dotIdx == npos) /// 
-    {
-        if(num[0] != '-') /// Ǹ
-        {
-            unsigned long long ull = 0;
-            try{
-                ull = std::stoull(num, &idx);
-            }
-            catch(std::exception &e){
-                throw JsonError(error_badnum);
-            }
-
-            if(idx != num.size())
-                throw JsonError(error_badnum);
-            return Number(ull);
-        }
-        else              /// 
-        {
-            long long ll = 0;
-            try{
-                ll = std::stoll(num, &idx);
-            }
-            catch(std::exception &e){
-                throw JsonError(error_badnum);
-            }
-
-            if(idx != num.size())
-                throw JsonError(error_badnum);
-            return Number(ll);
-        }
-    }
-    else                                      /// 
-    {
-        long double ld = 0.0;
-        try{
-            ld = std::stold(num, &idx);
-        }
-        catch(std::exception &e){
-            throw JsonError(error_badnum);
-        }
-
-        if(idx != num.size())
-            throw JsonError(error_badnum);
-
-        int p = 0;
-        for(decltype(dotIdx) b = 0,
-            e = (expIdx == npos ? num.size() : expIdx);
-            b != e; ++b)
-            if(std::isdigit(num[b])) ++p;
-        return Number(ld, p);
-    }
-}
-
-
-JsonString Number::Serialize() const
-{
-    return pImpl ? pImpl->Serialize() : JsonString("0");
-}
-
-
-_JSON_END
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include "Json_error.h"
+#include "Json_string.h"
+#include "Json_scanner.h"
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+/// 数值的种类，决定比较与哈希的方式
+enum NumberKind { signed_kind, unsigned_kind, floating_kind };
+
+class LEXEME;
+class NumberImpl
+{
+    friend class Number;
+    friend class LEXEME;
+    virtual JsonString Serialize() const = 0;
+    virtual NumberKind kind() const = 0;
+    /// 保存了原文词素的数字返回词素，其余返回空
+    virtual std::string_view lexeme() const { return std::string_view(); }
+    virtual NumberImpl *clone() const & = 0;
+    virtual NumberImpl *clone() && = 0;
+
+    virtual int to_int() const = 0;
+    virtual unsigned int to_uint() const = 0;
+    virtual long to_long() const = 0;
+    virtual unsigned long to_ulong() const = 0;
+    virtual long long to_longlong() const = 0;
+    virtual unsigned long long to_ulonglong() const = 0;
+    virtual float to_float() const = 0;
+    virtual double to_double() const = 0;
+    virtual long double to_longdouble() const = 0;
+
+public:
+    /// 大小可变（LEXEME）并且可能需要16字节对齐（long double），头部同时保存大小
+    static void *operator new(std::size_t n) { return allocate_block(n); }
+    static void operator delete(void *p) noexcept { deallocate_block(p); }
+
+protected:
+    virtual ~NumberImpl() = default;
+};
+
+
+
+#define DERIVED_NUMBERIMPL(_ClassName, _Type) \
+class _ClassName : public NumberImpl \
+{ \
+    friend class Number; \
+    friend class LEXEME; \
+    JsonString Serialize() const; \
+    _ClassName *clone() const & { return new _ClassName(*this); } \
+    _ClassName *clone() && { return new _ClassName(std::move(*this)); } \
+    NumberKind kind() const \
+    { \
+        return std::is_floating_point<_Type>::value ? floating_kind : \
+               std::is_signed<_Type>::value ? signed_kind : unsigned_kind; \
+    } \
+ \
+    int                to_int() const        { return static_cast<int>(val); } \
+    unsigned int       to_uint() const       { return static_cast<unsigned int>(val); } \
+    long               to_long() const       { return static_cast<long>(val); } \
+    unsigned long      to_ulong() const      { return static_cast<unsigned long>(val); } \
+    long long          to_longlong() const   { return static_cast<long long>(val); } \
+    unsigned long long to_ulonglong() const  { return static_cast<unsigned long>(val); } \
+    float              to_float() const      { return static_cast<float>(val); } \
+    double             to_double() const     { return static_cast<double>(val); } \
+    long double        to_longdouble() const { return static_cast<long double>(val); } \
+ \
+protected: \
+    _ClassName(_Type t): val(t) {} \
+    _Type val; \
+}; \
+ \
+JsonString _ClassName::Serialize() const \
+{ \
+    std::ostringstream out; \
+    out << val; \
+    return out.str(); \
+}
+
+
+#define DECLARE_ENHANCED_FLOATER(_ClassName, _BaseName, _Type) \
+class _ClassName : public _BaseName \
+{ \
+    friend class Number; \
+    friend class LEXEME; \
+    JsonString Serialize() const; \
+    _ClassName *clone() const & { return new _ClassName(*this); } \
+    _ClassName *clone() && { return new _ClassName(std::move(*this)); } \
+ \
+    _ClassName(_Type t, int p):_BaseName(t), prec(p) {} \
+    int prec; \
+}; \
+ \
+JsonString _ClassName::Serialize() const \
+{ \
+    std::ostringstream out; \
+    out.precision(prec); \
+    out << val; \
+    return out.str(); \
+}
+
+
+DERIVED_NUMBERIMPL(INT, int)
+DERIVED_NUMBERIMPL(UINT, unsigned int)
+DERIVED_NUMBERIMPL(LONG, long)
+DERIVED_NUMBERIMPL(ULONG, unsigned long)
+DERIVED_NUMBERIMPL(LONGLONG, long long)
+DERIVED_NUMBERIMPL(ULONGLONG, unsigned long long)
+DERIVED_NUMBERIMPL(FLOAT, float)
+DERIVED_NUMBERIMPL(DOUBLE, double)
+DERIVED_NUMBERIMPL(LONGDOUBLE, long double)
+
+DECLARE_ENHANCED_FLOATER(EHFLOAT, FLOAT, float)
+DECLARE_ENHANCED_FLOATER(EHDOUBLE, DOUBLE, double)
+DECLARE_ENHANCED_FLOATER(EHLONGDOUBLE, LONGDOUBLE, long double)
+
+
+/**************************************
+ LEXEME：解析得到的数字，保存原文中的词素，推迟到第一次访问数值时才转换。
+ 1、词素紧跟在对象之后存放在同一块内存中，不需要额外的分配；
+ 2、Serialize原样输出词素，因此只做转发的数字没有任何转换开销，
+    并且超出64位的整数、任意精度的小数都能精确地往返；
+ 3、第一次调用to_X或kind时按to_impl转换出普通的NumberImpl并缓存，
+    缓存通过原子指针发布，多个线程可以同时读取同一个const结点；
+ 4、cap记录分配时留给词素的空间，ParseInto重用结点时不超过cap的词素直接覆盖。
+
+**************************************/
+class LEXEME : public NumberImpl
+{
+    friend class Number;
+    JsonString Serialize() const { return JsonString(text(), len); }
+    LEXEME *clone() const & { return create(std::string_view(text(), len), integral); }
+    LEXEME *clone() && { return create(std::string_view(text(), len), integral); }
+    NumberKind kind() const { return value()->kind(); }
+    std::string_view lexeme() const { return std::string_view(text(), len); }
+
+    int                to_int() const        { return value()->to_int(); }
+    unsigned int       to_uint() const       { return value()->to_uint(); }
+    long               to_long() const       { return value()->to_long(); }
+    unsigned long      to_ulong() const      { return value()->to_ulong(); }
+    long long          to_longlong() const   { return value()->to_longlong(); }
+    unsigned long long to_ulonglong() const  { return value()->to_ulonglong(); }
+    float              to_float() const      { return value()->to_float(); }
+    double             to_double() const     { return value()->to_double(); }
+    long double        to_longdouble() const { return value()->to_longdouble(); }
+
+    static LEXEME *create(std::string_view lexeme, bool integral);
+    /// 词素不超过cap时覆盖原来的词素并清除已转换的值，返回false表示空间不够
+    bool assign(std::string_view lexeme, bool integral);
+
+    LEXEME(std::size_t n, bool i):
+        cached(nullptr), len(static_cast<std::uint32_t>(n)), cap(len), integral(i) {}
+    ~LEXEME() { delete cached.load(std::memory_order_acquire); }
+
+    const char *text() const { return reinterpret_cast<const char *>(this + 1); }
+    const NumberImpl *value() const;
+    static NumberImpl *to_impl(const SubString &lexeme, bool integral);
+
+    mutable std::atomic<NumberImpl *> cached;
+    std::uint32_t len, cap;
+    bool integral;
+};
+
+
+LEXEME *LEXEME::create(std::string_view lexeme, bool integral)
+{
+    void *mem = allocate_block(sizeof(LEXEME) + lexeme.size());
+    LEXEME *p = ::new(mem) LEXEME(lexeme.size(), integral);
+    std::memcpy(reinterpret_cast<char *>(p + 1), lexeme.data(), lexeme.size());
+    return p;
+}
+
+
+bool LEXEME::assign(std::string_view lexeme, bool i)
+{
+    if(lexeme.size() > cap)
+        return false;
+    delete cached.exchange(nullptr, std::memory_order_acq_rel);
+    std::memcpy(reinterpret_cast<char *>(this + 1), lexeme.data(), lexeme.size());
+    len = static_cast<std::uint32_t>(lexeme.size());
+    integral = i;
+    return true;
+}
+
+
+/**************************************
+ LEXEME::to_impl算法说明（与原先解析时立即转换的规则相同）：
+ 1、整数：非负数转换为unsigned long long，负数转换为long long；
+ 2、浮点数，以及超出64位范围的整数：转换为long double，
+    并统计指数之前的有效数字个数作为输出精度；
+    超出long double范围时取strtold给出的结果（±inf或0），不报告错误。
+
+**************************************/
+NumberImpl *LEXEME::to_impl(const SubString &lexeme, bool integral)
+{
+    if(integral)
+    {
+        if(*lexeme.first != '-')
+        {
+            unsigned long long ull = 0;
+            if(parse_ulonglong(lexeme, ull))
+                return new ULONGLONG(ull);
+        }
+        else
+        {
+            long long ll = 0;
+            if(parse_longlong(lexeme, ll))
+                return new LONGLONG(ll);
+        }
+    }
+
+    long double ld = 0.0L;
+    parse_longdouble(lexeme, ld);
+
+    int p = 0;
+    for(const char *b = lexeme.first; b != lexeme.second
+        && *b != 'e' && *b != 'E'; ++b)
+        if(*b >= '0' && *b <= '9') ++p;
+    return new EHLONGDOUBLE(ld, p);
+}
+
+
+const NumberImpl *LEXEME::value() const
+{
+    NumberImpl *p = cached.load(std::memory_order_acquire);
+    if(p)
+        return p;
+
+    /// 可能在多个线程中同时转换，不使用结点的memory_resource
+    ResourceScope scope(nullptr);
+    NumberImpl *fresh = to_impl(SubString(text(), text() + len), integral);
+    if(cached.compare_exchange_strong(p, fresh, std::memory_order_acq_rel))
+        return fresh;
+    delete fresh;
+    return p;
+}
+
+
+Number::Number(): pImpl(nullptr) {}
+Number::~Number() { delete pImpl; }
+Number::Number(const Number &rhs):      pImpl(rhs.pImpl ? rhs.pImpl->clone() : nullptr) {}
+Number::Number(Number &&rhs) noexcept : pImpl(rhs.pImpl) { rhs.pImpl = nullptr; }
+
+Number &Number::operator=(const Number &rhs)
+{
+    auto newp = rhs.pImpl ?
+        rhs.pImpl->clone() : nullptr;
+    delete pImpl;
+    pImpl = newp;
+    return *this;
+}
+
+
+Number &Number::operator=(Number &&rhs) noexcept
+{
+    if(this != &rhs)
+    {
+        delete pImpl;
+        pImpl = rhs.pImpl;
+        rhs.pImpl = nullptr;
+    }
+    return *this;
+}
+
+
+Number::Number(int i):                     pImpl(new INT(i)) {}
+Number::Number(unsigned int u):            pImpl(new UINT(u)) {}
+Number::Number(long l):                    pImpl(new LONG(l)) {}
+Number::Number(unsigned long ul):          pImpl(new ULONG(ul)) {}
+Number::Number(long long ll):              pImpl(new LONGLONG(ll)) {}
+Number::Number(unsigned long long ull):    pImpl(new ULONGLONG(ull)) {}
+Number::Number(float f):               pImpl(new FLOAT(f)) {}
+Number::Number(double d):              pImpl(new DOUBLE(d)) {}
+Number::Number(long double ld):        pImpl(new LONGDOUBLE(ld)) {}
+Number::Number(float f, int p):        pImpl(new EHFLOAT(f, p)) {}
+Number::Number(double d, int p):       pImpl(new EHDOUBLE(d, p)) {}
+Number::Number(long double ld, int p): pImpl(new EHLONGDOUBLE(ld, p)) {}
+Number::Number(std::string_view lexeme, bool integral, lexeme_t):
+    pImpl(LEXEME::create(lexeme, integral)) {}
+
+
+void Number::assign_lexeme(std::string_view lexeme, bool integral)
+{
+    if(pImpl && !pImpl->lexeme().empty()
+       && static_cast<LEXEME *>(pImpl)->assign(lexeme, integral))
+        return;
+    NumberImpl *p = LEXEME::create(lexeme, integral);
+    delete pImpl;
+    pImpl = p;
+}
+
+
+///注意pImpl为空时的默认处理
+int                Number::to_int() const        { return pImpl ? pImpl->to_int() : 0; }
+unsigned int       Number::to_uint() const       { return pImpl ? pImpl->to_uint() : 0U; }
+long               Number::to_long() const       { return pImpl ? pImpl->to_long() : 0L; }
+unsigned long      Number::to_ulong() const      { return pImpl ? pImpl->to_ulong() : 0UL; }
+long long          Number::to_longlong() const   { return pImpl ? pImpl->to_longlong() : 0LL; }
+unsigned long long Number::to_ulonglong() const  { return pImpl ? pImpl->to_ulonglong() : 0ULL; }
+float              Number::to_float() const      { return pImpl ? pImpl->to_float() : 0.0f; }
+double             Number::to_double() const     { return pImpl ? pImpl->to_double() : 0.0; }
+long double        Number::to_longdouble() const { return pImpl ? pImpl->to_longdouble() : 0.0L; }
+
+
+JsonString Number::Serialize() const
+{
+    return pImpl ? pImpl->Serialize() : JsonString("0");
+}
+
+
+std::string_view Number::lexeme() const noexcept
+{
+    return pImpl ? pImpl->lexeme() : std::string_view();
+}
+
+
+
+/**************************************
+ Number::equal算法说明：
+ 1、两边都是整数时精确比较：同为有符号或同为无符号时直接比较，
+    一正一负时必不相等，否则都转换为unsigned long long比较；
+ 2、任何一边是浮点数时，都转换为long double比较（NaN与任何数都不相等）；
+ pImpl为空的Number视为整数0；两边都保存着相同的词素时不必转换，直接相等。
+
+**************************************/
+bool Number::equal(const Number &rhs) const noexcept
+{
+    if(pImpl && rhs.pImpl)
+    {
+        std::string_view l = pImpl->lexeme(), r = rhs.pImpl->lexeme();
+        if(!l.empty() && l == r)
+            return true;
+    }
+
+    NumberKind lk = pImpl ? pImpl->kind() : signed_kind;
+    NumberKind rk = rhs.pImpl ? rhs.pImpl->kind() : signed_kind;
+
+    if(lk == floating_kind || rk == floating_kind)
+        return to_longdouble() == rhs.to_longdouble();
+
+    if(lk == rk)
+        return lk == signed_kind ? to_longlong() == rhs.to_longlong()
+                                 : to_ulonglong() == rhs.to_ulonglong();
+
+    long long s = lk == signed_kind ? to_longlong() : rhs.to_longlong();
+    unsigned long long u = lk == signed_kind ? rhs.to_ulonglong() : to_ulonglong();
+    return s >= 0 && static_cast<unsigned long long>(s) == u;
+}
+
+
+/**************************************
+ Number::hash算法说明：
+ 为了与equal一致，值为整数的浮点数（且在long long/unsigned long long范围内）
+ 按对应的整数计算哈希，因此Number(1)与Number(1.0)的哈希值相同；
+ 其余浮点数按long double计算哈希。
+
+**************************************/
+std::size_t Number::hash() const noexcept
+{
+    NumberKind k = pImpl ? pImpl->kind() : signed_kind;
+    if(k == signed_kind)
+        return std::hash<unsigned long long>()(static_cast<unsigned long long>(to_longlong()));
+    if(k == unsigned_kind)
+        return std::hash<unsigned long long>()(to_ulonglong());
+
+    long double ld = to_longdouble();
+    if(ld == std::floor(ld))
+    {
+        if(ld >= -9223372036854775808.0L && ld < 0.0L)
+            return std::hash<unsigned long long>()(
+                static_cast<unsigned long long>(static_cast<long long>(ld)));
+        if(ld >= 0.0L && ld < 18446744073709551616.0L)
+            return std::hash<unsigned long long>()(static_cast<unsigned long long>(ld));
+    }
+    return std::hash<long double>()(ld);
+}
+
+
+_JSON_END
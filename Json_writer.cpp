@@ -0,0 +1,539 @@
+#include <string>
+#include <vector>
+#include "Json_gather.h"
+#include "Json_scanner.h"
+#include "Json_string.h"
+#include "Json_type.h"
+#include "Json_writer.h"
+
+_JSON_BEGIN
+
+
+namespace
+{
+
+/// estimate、split、exact_size与gather在当前线程中的递归层数（见Value::recursion_limit）
+thread_local unsigned estimate_depth = 0;
+thread_local unsigned split_depth = 0;
+thread_local unsigned size_depth = 0;
+thread_local unsigned gather_depth = 0;
+
+} // namespace
+
+
+/**************************************
+ Writer::estimate算法说明：
+ 1、String按「字符数 + 2」估计，不考虑转义；Number统一按8个字符估计；
+    true、false、null取实际长度；
+ 2、Array/Object为括号、逗号、键与各子结点估计值之和；
+ 3、累计值一旦超过limit立即返回，因此对巨大子树的估计代价不超过O(limit)；
+ 4、递归层数达到Value::recursion_limit之后，由estimate_deep用显式的栈按同样的规则累计。
+ 估计值只用于决定如何拆分，与实际长度不同不影响输出结果。
+
+**************************************/
+std::size_t Writer::estimate(const Value_base *p, std::size_t limit)
+{
+    if(p == nullptr)
+        return 0;
+
+    switch(p->Type())
+    {
+    case string_type:
+        return static_cast<const String *>(p)->str.size() + 2;
+    case number_type:
+        return 8;
+    case true_type:
+    case null_type:
+        return 4;
+    case false_type:
+        return 5;
+
+    case array_type:
+    {
+        std::size_t n = 2;
+        if(const Array::Dense *d = static_cast<const Array *>(p)->dense)
+            return n + d->size() * 9;
+        if(estimate_depth == Value::recursion_limit)
+            return estimate_deep(p, limit);
+        Value::Nesting nesting(estimate_depth);
+        for(const auto &v : static_cast<const Array *>(p)->arr)
+        {
+            n += estimate(v.pbase, limit - (n < limit ? n : limit)) + 1;
+            if(n > limit)
+                break;
+        }
+        return n;
+    }
+
+    case object_type:
+    {
+        if(estimate_depth == Value::recursion_limit)
+            return estimate_deep(p, limit);
+        Value::Nesting nesting(estimate_depth);
+        std::size_t n = 2;
+        static_cast<const Object *>(p)->for_each([&n, limit](const String &k, const Value &v) {
+            if(n > limit)
+                return;
+            n += k.str.size() + 4;
+            n += estimate(v.pbase, limit - (n < limit ? n : limit));
+        });
+        return n;
+    }
+    }
+    return 0;
+}
+
+
+std::size_t Writer::estimate(const Value &v, std::size_t limit)
+{
+    return estimate(v.pbase, limit);
+}
+
+
+std::size_t Writer::estimate_deep(const Value_base *p, std::size_t limit)
+{
+    std::vector<Value::Cursor> stack{Value::Cursor(p)};
+    std::size_t n = 2;
+    while(!stack.empty() && n <= limit)
+    {
+        Value::Cursor &top = stack.back();
+        const String *key;
+        const Value *value;
+        if(!top.next(key, value))
+        {
+            stack.pop_back();
+            continue;
+        }
+        n += key ? key->str.size() + 4 : 1;
+        const Value_base *c = value->pbase;
+        if(c && (c->Type() == object_type
+                 || (c->Type() == array_type && !static_cast<const Array *>(c)->dense)))
+        {
+            stack.emplace_back(c);
+            n += 2;
+        }
+        else
+            n += estimate(c, limit);
+    }
+    return n;
+}
+
+
+
+/**************************************
+ Writer::split算法说明：
+ 1、估计长度不超过target的结点，或者不是Array/Object的结点，作为一个value片段整体输出；
+    紧凑的Array没有可以引用的元素Value，也整体输出；
+ 2、较大的Array展开为「[」、各元素（递归拆分）、「]」，元素之间插入「,」片段；
+ 3、较大的Object展开为「{」、各成员、「}」，每个成员是一个key片段加上递归拆分的值；
+ 4、递归层数达到Value::recursion_limit之后不再展开，更深的部分由value片段的Serialize处理。
+ 因为Array/Object::Serialize的结果正是上述各部分依次连接，所以输出逐字节相同。
+
+**************************************/
+void Writer::split(const Value &v, std::size_t target, std::vector<Piece> &pieces)
+{
+    std::size_t size = estimate(v.pbase, target);
+    JsonType t = v.pbase ? v.pbase->Type() : null_type;
+    if(size <= target || (t != array_type && t != object_type)
+       || (t == array_type && static_cast<const Array *>(v.pbase)->dense)
+       || split_depth == Value::recursion_limit)
+    {
+        pieces.push_back({nullptr, nullptr, &v, size});
+        return;
+    }
+
+    Value::Nesting nesting(split_depth);
+
+    if(t == array_type)
+    {
+        const Array *arr = static_cast<const Array *>(v.pbase);
+        pieces.push_back({"[", nullptr, nullptr, 1});
+        for(auto it = arr->arr.cbegin(); it != arr->arr.cend(); ++it)
+        {
+            if(it != arr->arr.cbegin())
+                pieces.push_back({",", nullptr, nullptr, 1});
+            split(*it, target, pieces);
+        }
+        pieces.push_back({"]", nullptr, nullptr, 1});
+    }
+    else
+    {
+        const Object *obj = static_cast<const Object *>(v.pbase);
+        bool first = true;
+        pieces.push_back({"{", nullptr, nullptr, 1});
+        obj->for_each([&](const String &k, const Value &member) {
+            if(!first)
+                pieces.push_back({",", nullptr, nullptr, 1});
+            first = false;
+            pieces.push_back({nullptr, &k, nullptr, k.str.size() + 3});
+            split(member, target, pieces);
+        });
+        pieces.push_back({"}", nullptr, nullptr, 1});
+    }
+}
+
+
+void Writer::write(std::string &out, const Piece *b, const Piece *e)
+{
+    for(; b != e; ++b)
+    {
+        if(b->text)
+            out += b->text;
+        else if(b->key)
+        {
+            out += b->key->Serialize();
+            out += ':';
+        }
+        else
+            out += b->value->Serialize();
+    }
+}
+
+
+
+/**************************************
+ Writer::keep_serialized算法说明：
+ 1、标记时，估计长度不小于min_bytes的Array/Object设置keep_text，并继续处理其元素；
+    估计长度小于min_bytes的结点，其子树更小，不再向下遍历；
+ 2、取消标记时遍历整棵树，清除所有keep_text并释放已保存的序列化结果；
+ 3、用显式的栈遍历，深层嵌套的文档不会耗尽调用栈。
+ min_bytes过小时每一层都保存一份结果，内存占用约为“文档大小 * 深度”。
+
+**************************************/
+void Writer::keep_serialized(Value_base *p, std::size_t min_bytes, bool on)
+{
+    std::vector<Value_base *> stack{p};
+    while(!stack.empty())
+    {
+        p = stack.back();
+        stack.pop_back();
+        if(p == nullptr)
+            continue;
+
+        NodeCache *cache = nullptr;
+        JsonType t = p->Type();
+        if(t == array_type)
+            cache = &static_cast<Array *>(p)->cache;
+        else if(t == object_type)
+            cache = &static_cast<Object *>(p)->cache;
+        else
+            continue;
+
+        if(on && estimate(p, min_bytes) < min_bytes)
+            continue;
+
+        cache->keep_text = on;
+        if(!on)
+            delete cache->text.exchange(nullptr, std::memory_order_acq_rel);
+
+        if(t == array_type)
+            for(auto &v : static_cast<Array *>(p)->arr)
+                stack.push_back(v.pbase);
+        else if(Object::Packed *packed = static_cast<Object *>(p)->packed)
+            for(std::size_t i = 0; i != packed->size; ++i)
+                stack.push_back(packed->slots()[i].pbase);
+        else
+            for(auto &member : static_cast<Object *>(p)->obj)
+                stack.push_back(member.second.pbase);
+    }
+}
+
+
+
+/**************************************
+ Writer::exact_size算法说明：
+ 1、String按String::Serialize的转义规则逐个字符计算：
+    「"\\\b\f\n\r\t」占2个字符，其余控制字符占6个（\u00XX），其他字符占1个；
+ 2、保存了词素的Number取词素的长度，其余Number只能生成一次结果再取长度；
+    紧凑的Array逐个生成元素的文本取长度（不分配内存）；
+ 3、保存了序列化结果的Array/Object直接取结果的长度，
+    否则为括号、逗号、键、「:」与各子结点长度之和；
+ 4、递归层数达到Value::recursion_limit之后，由exact_size_deep用显式的栈累计。
+
+**************************************/
+std::size_t Writer::escaped_size(std::string_view s)
+{
+    /// 先只数需要转义的字符（无分支，编译器可以向量化），绝大多数字符串到此为止
+    std::size_t special = 0;
+    for(char c : s)
+        special += (static_cast<unsigned char>(c) < 0x20) | (c == '\"') | (c == '\\');
+
+    std::size_t n = s.size() + 2;
+    if(special == 0)
+        return n;
+    for(char c : s)
+    {
+        if(c == '\"' || c == '\\' || IsCntrl(c))
+        {
+            bool short_form = c == '\"' || c == '\\' || c == '\b' || c == '\f'
+                           || c == '\n' || c == '\r' || c == '\t';
+            n += short_form ? 1 : 5;
+        }
+    }
+    return n;
+}
+
+
+std::size_t Writer::exact_size(const Value_base *p)
+{
+    switch(p->Type())
+    {
+    case string_type:
+        return escaped_size(static_cast<const String *>(p)->str);
+    case number_type:
+    {
+        const Number *num = static_cast<const Number *>(p);
+        std::string_view lexeme = num->lexeme();
+        return lexeme.empty() ? num->Serialize().size() : lexeme.size();
+    }
+    case true_type:
+    case null_type:
+        return 4;
+    case false_type:
+        return 5;
+
+    case array_type:
+    {
+        const Array *arr = static_cast<const Array *>(p);
+        if(const std::string *text = arr->cache.cached_text())
+            return text->size();
+        std::size_t n = 2 + (arr->empty() ? 0 : arr->size() - 1);
+        if(const Array::Dense *d = arr->dense_values())
+        {
+            char buf[32];
+            for(std::size_t i = 0; i != d->size(); ++i)
+                n += d->format(i, buf);
+            return n;
+        }
+        if(size_depth == Value::recursion_limit)
+            return exact_size_deep(p);
+        Value::Nesting nesting(size_depth);
+        for(const auto &v : arr->elements())
+            n += exact_size(v.pbase);
+        return n;
+    }
+
+    case object_type:
+    {
+        const Object *obj = static_cast<const Object *>(p);
+        if(const std::string *text = obj->cache.cached_text())
+            return text->size();
+        if(size_depth == Value::recursion_limit)
+            return exact_size_deep(p);
+        Value::Nesting nesting(size_depth);
+        std::size_t n = 2 + (obj->empty() ? 0 : obj->size() - 1);
+        obj->for_each([&n](const String &k, const Value &v) {
+            n += escaped_size(k.str) + 1 + exact_size(v.pbase);
+        });
+        return n;
+    }
+    }
+    return 0;
+}
+
+
+std::size_t Writer::exact_size_deep(const Value_base *p)
+{
+    std::vector<Value::Cursor> stack{Value::Cursor(p)};
+    std::size_t n = 0;
+    while(!stack.empty())
+    {
+        Value::Cursor &top = stack.back();
+        const String *key;
+        const Value *value;
+        if(!top.next(key, value))
+        {
+            n += top.index == 0 ? 2 : top.index + 1;
+            stack.pop_back();
+            continue;
+        }
+        if(key)
+            n += escaped_size(key->str) + 1;
+        const Value_base *c = value->pbase;
+        JsonType t = c->Type();
+        if((t == array_type && !static_cast<const Array *>(c)->dense_values()
+                            && !static_cast<const Array *>(c)->cache.cached_text())
+           || (t == object_type && !static_cast<const Object *>(c)->cache.cached_text()))
+            stack.emplace_back(c);
+        else
+            n += exact_size(c);
+    }
+    return n;
+}
+
+
+/// 不需要转义时，足够长的字符串只复制首尾的双引号
+void Writer::gather(const String &s, GatherBuffer &out)
+{
+    if(s.str.size() >= out.min_ref && escaped_size(s.str) == s.str.size() + 2)
+    {
+        out.append('\"');
+        out.reference(s.str.data(), s.str.size());
+        out.append('\"');
+    }
+    else
+    {
+        std::size_t before = out.side.size();
+        append_escaped(out.side, s.str.data(), s.str.size());
+        out.extend(out.side.size() - before);
+    }
+}
+
+
+/**************************************
+ Writer::gather算法说明：
+ 1、String见上；Number优先复制词素，true/false/null复制字面量，紧凑的Array逐个复制元素的文本；
+ 2、保存了序列化结果的Array/Object整体作为一段：不短于min_ref时引用，否则复制；
+ 3、其余Array/Object依次输出括号、逗号、键、「:」与各子结点；
+ 4、递归层数达到Value::recursion_limit之后，更深的子树由Value::serialize_deep生成文本后整体复制。
+
+**************************************/
+void Writer::gather(const Value_base *p, GatherBuffer &out)
+{
+    switch(p->Type())
+    {
+    case string_type:
+        gather(*static_cast<const String *>(p), out);
+        return;
+    case number_type:
+    {
+        const Number *num = static_cast<const Number *>(p);
+        std::string_view lexeme = num->lexeme();
+        if(!lexeme.empty())
+            out.append(lexeme.data(), lexeme.size());
+        else
+        {
+            std::string text = num->Serialize();
+            out.append(text.data(), text.size());
+        }
+        return;
+    }
+    case true_type:
+        out.append("true", 4);
+        return;
+    case false_type:
+        out.append("false", 5);
+        return;
+    case null_type:
+        out.append("null", 4);
+        return;
+
+    case array_type:
+    case object_type:
+        break;
+    }
+
+    const NodeCache &cache = p->Type() == array_type ? static_cast<const Array *>(p)->cache
+                                                     : static_cast<const Object *>(p)->cache;
+    if(const std::string *text = cache.cached_text())
+    {
+        if(text->size() >= out.min_ref)
+            out.reference(text->data(), text->size());
+        else
+            out.append(text->data(), text->size());
+        return;
+    }
+
+    if(gather_depth == Value::recursion_limit)
+    {
+        std::string text;
+        Value::serialize_deep(p, text);
+        out.append(text.data(), text.size());
+        return;
+    }
+    Value::Nesting nesting(gather_depth);
+    if(p->Type() == array_type)
+    {
+        const Array *arr = static_cast<const Array *>(p);
+        out.append('[');
+        if(const Array::Dense *d = arr->dense_values())
+        {
+            char buf[32];
+            for(std::size_t i = 0; i != d->size(); ++i)
+            {
+                if(i != 0)
+                    out.append(',');
+                out.append(buf, d->format(i, buf));
+            }
+        }
+        else
+        {
+            const Array::_Type &elems = arr->elements();
+            for(auto it = elems.cbegin(); it != elems.cend(); ++it)
+            {
+                if(it != elems.cbegin())
+                    out.append(',');
+                gather(it->pbase, out);
+            }
+        }
+        out.append(']');
+    }
+    else
+    {
+        bool first = true;
+        out.append('{');
+        static_cast<const Object *>(p)->for_each([&](const String &k, const Value &v) {
+            if(!first)
+                out.append(',');
+            first = false;
+            gather(k, out);
+            out.append(':');
+            gather(v.pbase, out);
+        });
+        out.append('}');
+    }
+}
+
+
+std::size_t Value::SerializedSize() const
+{
+    check();
+    return Writer::exact_size(pbase);
+}
+
+
+void Value::Serialize(GatherBuffer &out) const
+{
+    check();
+    Writer::gather(pbase, out);
+    out.finish();
+}
+
+
+void Object::cache_serialized(std::size_t min_bytes)
+{
+    Writer::keep_serialized(this, min_bytes, true);
+}
+
+
+void Object::clear_serialized_cache()
+{
+    Writer::keep_serialized(this, 0, false);
+}
+
+
+void Array::cache_serialized(std::size_t min_bytes)
+{
+    Writer::keep_serialized(this, min_bytes, true);
+}
+
+
+void Array::clear_serialized_cache()
+{
+    Writer::keep_serialized(this, 0, false);
+}
+
+
+void Value::cache_serialized(std::size_t min_bytes)
+{
+    Writer::keep_serialized(pbase, min_bytes, true);
+}
+
+
+void Value::clear_serialized_cache()
+{
+    Writer::keep_serialized(pbase, 0, false);
+}
+
+
+_JSON_END
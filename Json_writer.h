@@ -0,0 +1,71 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#define _JSON_BEGIN namespace json {
+#define _JSON_END   }
+#define _JSON   ::json::
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Json_gather.h"
+#include "Json_string.h"
+#include "Json_type.h"
+
+_JSON_BEGIN
+
+/**************************************
+ Writer：把序列化工作拆分成若干片段，供并行序列化使用。
+ 1、estimate按结点估计序列化结果的长度，只遍历树，不生成字符串；
+ 2、split把一棵树展开成按顺序排列的片段：括号、逗号、键，以及整棵序列化的子树，
+    依次输出所有片段得到的结果与Value::Serialize逐字节相同；
+ 3、keep_serialized为cache_serialized标记需要保留序列化结果的结点；
+ 4、exact_size与gather供Value::SerializedSize与Value::Serialize(GatherBuffer &)使用；
+ 5、它是各类型的友元，直接读取结点，避免to_Object/to_Array带来的拷贝；
+ 6、嵌套超过Value::recursion_limit层的部分不再递归，见各函数的算法说明。
+
+**************************************/
+class Writer
+{
+public:
+    /// 片段：text、key、value三者恰有一个非空
+    struct Piece
+    {
+        const char *text;     /// 原样输出的括号或逗号
+        const String *key;    /// 输出键以及其后的「:」
+        const Value *value;   /// 输出value->Serialize()
+        std::size_t size;     /// 估计的输出长度
+    };
+
+    /// 估计v序列化后的长度，估计值超过limit后不再继续遍历
+    static std::size_t estimate(const Value &v, std::size_t limit);
+
+    /// 把v展开成片段追加到pieces中：估计长度超过target的Array/Object被拆开，其余整体输出
+    static void split(const Value &v, std::size_t target, std::vector<Piece> &pieces);
+
+    /// 依次输出[b, e)中的片段
+    static void write(std::string &out, const Piece *b, const Piece *e);
+
+    /// 标记（on为true）或取消标记p中需要保留序列化结果的容器结点
+    static void keep_serialized(Value_base *p, std::size_t min_bytes, bool on);
+
+    /// p序列化后的精确长度
+    static std::size_t exact_size(const Value_base *p);
+
+    /// 把p的序列化结果以段的形式追加到out中
+    static void gather(const Value_base *p, GatherBuffer &out);
+
+private:
+    static std::size_t estimate(const Value_base *p, std::size_t limit);
+    /// estimate与exact_size的递归层数达到Value::recursion_limit之后使用显式的栈
+    static std::size_t estimate_deep(const Value_base *p, std::size_t limit);
+    static std::size_t exact_size_deep(const Value_base *p);
+    /// s转义并加上首尾双引号之后的长度
+    static std::size_t escaped_size(std::string_view s);
+    static void gather(const String &s, GatherBuffer &out);
+};
+
+
+_JSON_END
+#endif // JSON_WRITER_H
@@ -0,0 +1,224 @@
+#ifndef JSON_BENCH_H
+#define JSON_BENCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "JsonOOLib.h"
+
+namespace bench
+{
+
+/// 命令行选项
+struct Options
+{
+    std::string format = "text";        /// text, json, csv
+    std::vector<std::string> suites;    /// 为空时运行全部
+    std::vector<std::string> corpus;    /// 本地语料文件
+    std::size_t size = 1 << 20;         /// 合成文档的目标大小（字节）
+    double minTime = 0.25;              /// 每个用例最少运行的秒数
+    unsigned minIterations = 3;
+};
+
+
+/// 一个用例的测量结果，所有“每次”的量都已除以迭代次数
+struct Result
+{
+    std::string suite, doc, op;
+    std::size_t bytes = 0;      /// 每次处理的输入/输出字节数
+    std::size_t nodes = 0;      /// 每次处理的Value结点数
+    std::size_t iterations = 0;
+    double ns = 0;              /// 平均耗时
+    double nsMin = 0;           /// 最短耗时
+    double allocs = 0;          /// 平均分配次数
+    double allocBytes = 0;      /// 平均分配字节数
+    long peakRssKb = 0;         /// 用例结束时进程的峰值常驻内存
+};
+
+
+/// 合成或从文件读入的测试文档
+struct Document
+{
+    std::string name;
+    json::JsonString text;
+};
+
+
+/// 全局分配计数（由bench_main.cpp中替换的operator new维护）
+std::size_t alloc_count();
+std::size_t alloc_bytes();
+long peak_rss_kb();
+
+/// 统计Value中的结点数（每个String/Number/Object/Array/true/false/null各算一个）
+std::size_t count_nodes(const json::Value &v);
+
+
+/// 合成语料生成器，bytes为目标大小的近似值
+json::JsonString make_canada(std::size_t bytes);
+json::JsonString make_twitter(std::size_t bytes);
+json::JsonString make_nested(std::size_t bytes);
+
+/// 三个合成文档加上命令行给出的语料文件
+std::vector<Document> load_documents(const Options &opt);
+
+
+
+/**************************************
+ Stopwatch：只统计start与stop之间的时间与分配次数，
+ 用于需要在每次迭代中做不计时准备工作的用例（例如destroy）。
+
+**************************************/
+class Stopwatch
+{
+public:
+    void start()
+    {
+        allocs0 = alloc_count();
+        bytes0 = alloc_bytes();
+        t0 = std::chrono::steady_clock::now();
+    }
+
+    void stop()
+    {
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        elapsed += ns;
+        lap += ns;
+        allocs += alloc_count() - allocs0;
+        bytes += alloc_bytes() - bytes0;
+    }
+
+    double elapsed = 0, lap = 0;
+    std::size_t allocs = 0, bytes = 0;
+
+private:
+    std::chrono::steady_clock::time_point t0;
+    std::size_t allocs0 = 0, bytes0 = 0;
+};
+
+
+
+/**************************************
+ LatencyHistogram：记录每个请求的耗时（纳秒），报告尾部延迟。
+ 保存全部样本，分位数是精确值；按2的幂（微秒）分桶的直方图只用于text格式的显示。
+
+**************************************/
+class LatencyHistogram
+{
+public:
+    void record(double ns) { samples.push_back(ns); sorted = false; }
+    std::size_t size() const { return samples.size(); }
+
+    /// q在[0, 1]之间，例如0.99；没有样本时为0
+    double percentile(double q);
+
+    /// 「<1us:n <2us:n <4us:n ...」，从第一个非空的桶到最后一个非空的桶
+    std::string buckets() const;
+
+private:
+    std::vector<double> samples;
+    bool sorted = false;
+};
+
+
+
+class Context
+{
+public:
+    explicit Context(const Options &o): options(o) {}
+
+    const Options &options;
+
+    /// body(Stopwatch &)自行调用start/stop，反复运行直至满足minTime与minIterations
+    template<typename _Fn>
+    Result measure_with(const std::string &suite, const std::string &doc,
+                        const std::string &op, std::size_t bytes,
+                        std::size_t nodes, _Fn body);
+
+    /// body()整体计时
+    template<typename _Fn>
+    Result measure(const std::string &suite, const std::string &doc,
+                   const std::string &op, std::size_t bytes,
+                   std::size_t nodes, _Fn body)
+    {
+        return measure_with(suite, doc, op, bytes, nodes,
+                            [&body](Stopwatch &sw) { sw.start(); body(); sw.stop(); });
+    }
+
+    void report(const Result &r);
+    /// 每个分位数（p50、p90、p99、p99.9、max）报告为一行，op为「op/p99」等，
+    /// nodes为1，因此ns/node一列就是该分位数的延迟；text格式另外显示直方图
+    void report_latency(const std::string &suite, const std::string &doc,
+                        const std::string &op, std::size_t bytes, LatencyHistogram &h);
+    void finish();
+
+    /// 防止被测代码被优化掉
+    void consume(std::size_t v) { sink += v; }
+
+private:
+    std::vector<Result> results;
+    std::size_t sink = 0;
+};
+
+
+template<typename _Fn>
+Result Context::measure_with(const std::string &suite, const std::string &doc,
+                             const std::string &op, std::size_t bytes,
+                             std::size_t nodes, _Fn body)
+{
+    Stopwatch sw;
+    Result r;
+    r.suite = suite;
+    r.doc = doc;
+    r.op = op;
+    r.bytes = bytes;
+    r.nodes = nodes;
+    r.nsMin = -1;
+
+    while(r.iterations < options.minIterations
+          || sw.elapsed < options.minTime * 1e9)
+    {
+        sw.lap = 0;
+        body(sw);
+        if(r.nsMin < 0 || sw.lap < r.nsMin)
+            r.nsMin = sw.lap;
+        ++r.iterations;
+    }
+
+    r.ns = sw.elapsed / r.iterations;
+    r.allocs = static_cast<double>(sw.allocs) / r.iterations;
+    r.allocBytes = static_cast<double>(sw.bytes) / r.iterations;
+    r.peakRssKb = peak_rss_kb();
+    report(r);
+    return r;
+}
+
+
+
+/// 测试套件注册：BENCH_SUITE(name) { ... } 定义一个以Context &ctx为参数的函数
+typedef void (*SuiteFn)(Context &, const std::vector<Document> &);
+
+struct Suite
+{
+    const char *name;
+    SuiteFn fn;
+};
+
+std::vector<Suite> &suites();
+
+struct SuiteRegistrar
+{
+    SuiteRegistrar(const char *name, SuiteFn fn) { suites().push_back({name, fn}); }
+};
+
+#define BENCH_SUITE(_name) \
+    static void bench_suite_##_name(::bench::Context &, \
+                                    const std::vector<::bench::Document> &); \
+    static ::bench::SuiteRegistrar bench_registrar_##_name(#_name, bench_suite_##_name); \
+    static void bench_suite_##_name(::bench::Context &ctx, \
+                                    const std::vector<::bench::Document> &docs)
+
+} // namespace bench
+
+#endif // JSON_BENCH_H
@@ -0,0 +1,132 @@
+/// bind：JSON_BIND与Value路径的对比
+///   Value路径：Value::Parse + to_Object().at("x").to_xxx()
+///   绑定路径： ParseBound<T>，不构造任何Value
+/// 先验证超出字段范围的数字与nan/inf报告error_badnum。
+
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace bench
+{
+
+struct User
+{
+    long long id = 0;
+    std::string name;
+    int followers = 0;
+    bool verified = false;
+};
+JSON_BIND(User, id, name, followers, verified)
+
+struct Tweet
+{
+    long long id = 0;
+    std::string text;
+    double score = 0.0;
+    User user;
+    std::vector<long long> mentions;
+};
+JSON_BIND(Tweet, id, text, score, user, mentions)
+
+/// 每条记录都带有两个绑定中不存在的字段，用于测量跳过未知键的代价
+std::string make_tweet(int i)
+{
+    std::string s = "{\"id\":" + std::to_string(1000000 + i)
+        + ",\"text\":\"tweet number " + std::to_string(i)
+        + " with some \\\"quoted\\\" text and padding padding padding\""
+        + ",\"lang\":\"en\",\"entities\":{\"urls\":[],\"tags\":[\"a\",\"b\",\"c\"]}"
+        + ",\"score\":" + std::to_string(i * 0.25)
+        + ",\"user\":{\"id\":" + std::to_string(i % 977)
+        + ",\"name\":\"user" + std::to_string(i % 977)
+        + "\",\"followers\":" + std::to_string(i * 7 % 10007)
+        + ",\"verified\":" + (i % 3 ? "false" : "true") + "}"
+        + ",\"mentions\":[1,2,3]}";
+    return s;
+}
+
+Tweet from_value(const Value &v)
+{
+    Tweet t;
+    Object o = v.to_Object();
+    t.id = o.at("id").to_longlong();
+    t.text = o.at("text").to_string();
+    t.score = o.at("score").to_double();
+    Object u = o.at("user").to_Object();
+    t.user.id = u.at("id").to_longlong();
+    t.user.name = u.at("name").to_string();
+    t.user.followers = u.at("followers").to_int();
+    t.user.verified = u.at("verified").is_True();
+    for(const auto &m : o.at("mentions").to_Array())
+        t.mentions.push_back(m.to_longlong());
+    return t;
+}
+
+} // namespace bench
+
+
+BENCH_SUITE(bind)
+{
+    (void)docs;
+    using namespace bench;
+
+    std::vector<std::string> records;
+    std::size_t bytes = 0;
+    for(int i = 0; bytes < ctx.options.size; ++i)
+    {
+        records.push_back(make_tweet(i));
+        bytes += records.back().size();
+    }
+
+    std::size_t nodes = 0;
+    for(const auto &r : records)
+        nodes += count_nodes(Value::Parse(r));
+
+    ctx.measure("bind", "tweets", "parse(Value)", bytes, nodes, [&] {
+        for(const auto &r : records)
+            ctx.consume(from_value(Value::Parse(r)).user.followers);
+    });
+
+    ctx.measure("bind", "tweets", "parse(BIND)", bytes, nodes, [&] {
+        for(const auto &r : records)
+            ctx.consume(json::ParseBound<Tweet>(r).user.followers);
+    });
+
+    auto rejects = [](auto &&f) {
+        try { f(); }
+        catch(const JsonError &e) { return e.Code() == json::error_badnum; }
+        return false;
+    };
+    if(!rejects([] { json::ParseBound<User>("{\"followers\":1e30}"); })
+       || !rejects([] { json::ParseBound<User>("{\"followers\":4294967297}"); })
+       || !rejects([] { json::ParseBound<User>("{\"followers\":-2147483649}"); })
+       || !rejects([] { json::ParseBound<User>("{\"followers\":-3e9}"); })
+       || json::ParseBound<User>("{\"followers\":-2147483648}").followers != std::numeric_limits<int>::min())
+        std::fprintf(stderr, "json_bench: bind accepts numbers out of the field's range\n");
+    Tweet odd;
+    odd.score = std::numeric_limits<double>::quiet_NaN();
+    if(!rejects([&] { json::SerializeBound(odd); }))
+        std::fprintf(stderr, "json_bench: bind writes a non-finite number\n");
+
+    std::vector<Tweet> tweets;
+    std::vector<Value> values;
+    for(const auto &r : records)
+    {
+        tweets.push_back(json::ParseBound<Tweet>(r));
+        values.push_back(Value::Parse(r));
+    }
+
+    ctx.measure("bind", "tweets", "serialize(Value)", bytes, nodes, [&] {
+        for(const auto &v : values)
+            ctx.consume(v.Serialize().size());
+    });
+
+    ctx.measure("bind", "tweets", "serialize(BIND)", bytes, nodes, [&] {
+        for(const auto &t : tweets)
+            ctx.consume(json::SerializeBound(t).size());
+    });
+}
@@ -0,0 +1,115 @@
+/// columns：从由twitter语料的statuses组成的顶层Array中取出4列
+///   manual      对每一行用at()逐级查找，再to_double/to_string，写入各自的vector
+///               （第一次之后to_double读取的是结点中缓存的转换结果）
+///   parse_manual  Value::Parse之后manual，与text比较
+///   array       to_columns(Array)，单线程
+///   text        to_columns(text)，单线程，不构造Value
+///   text/tN     to_columns(text)，N个线程
+/// 先验证各种方式得到的列相同。
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+using json::ColumnSpec;
+using json::ColumnTable;
+using json::ColumnType;
+
+namespace
+{
+
+struct Manual
+{
+    std::vector<double> id;
+    std::vector<double> retweets;
+    std::vector<std::string> name;
+    std::vector<double> followers;
+};
+
+Manual extract(const Value &rows)
+{
+    Manual m;
+    for(const auto &row : rows.as_Array())
+    {
+        const Object &o = row.as_Object();
+        m.id.push_back(o.at("id").to_double());
+        m.retweets.push_back(o.at("retweet_count").to_double());
+        const Object &user = o.at("user").as_Object();
+        m.name.push_back(user.at("screen_name").to_string());
+        m.followers.push_back(user.at("followers_count").to_double());
+    }
+    return m;
+}
+
+bool same(const Manual &m, const ColumnTable &t)
+{
+    if(t.rows != m.id.size())
+        return false;
+    for(std::size_t i = 0; i != t.rows; ++i)
+        if(t.columns[0].f64[i] != m.id[i] || t.columns[1].f64[i] != m.retweets[i]
+           || t.columns[2].str(i) != m.name[i] || t.columns[3].f64[i] != m.followers[i])
+            return false;
+    return true;
+}
+
+} // namespace
+
+
+BENCH_SUITE(columns)
+{
+    (void)docs;
+
+    JsonString text = Value::Parse(bench::make_twitter(ctx.options.size))
+                          .to_Object().at("statuses").Serialize();
+    Value rows = Value::Parse(text);
+    std::size_t nodes = bench::count_nodes(rows);
+    std::vector<ColumnSpec> schema = {
+        {"id", ColumnType::float64},
+        {"retweet_count", ColumnType::float64},
+        {"user.screen_name", ColumnType::string},
+        {"user.followers_count", ColumnType::float64},
+    };
+
+    ParallelOptions single;
+    single.threads = 1;
+    Manual expected = extract(rows);
+    if(!same(expected, json::to_columns(rows.as_Array(), schema, single))
+       || !same(expected, json::to_columns(text, schema, single)))
+        std::fprintf(stderr, "json_bench: to_columns differs from manual extraction\n");
+
+    ctx.measure("columns", "records", "manual", text.size(), nodes, [&] {
+        ctx.consume(extract(rows).id.size());
+    });
+
+    ctx.measure("columns", "records", "parse_manual", text.size(), nodes, [&] {
+        ctx.consume(extract(Value::Parse(text)).id.size());
+    });
+
+    ctx.measure("columns", "records", "array", text.size(), nodes, [&] {
+        ctx.consume(json::to_columns(rows.as_Array(), schema, single).rows);
+    });
+
+    ctx.measure("columns", "records", "text", text.size(), nodes, [&] {
+        ctx.consume(json::to_columns(text, schema, single).rows);
+    });
+
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    for(unsigned threads : {2u, 4u, hw})
+    {
+        if(threads <= 1 || (threads == hw && hw <= 4))
+            continue;
+        ParallelOptions opt;
+        opt.threads = threads;
+        opt.min_bytes = 0;
+        if(!same(expected, json::to_columns(text, schema, opt)))
+            std::fprintf(stderr, "json_bench: parallel to_columns with %u threads differs\n", threads);
+
+        ctx.measure("columns", "records", "text/t" + std::to_string(threads), text.size(), nodes, [&] {
+            ctx.consume(json::to_columns(text, schema, opt).rows);
+        });
+    }
+}
@@ -0,0 +1,117 @@
+/// compress：解析gzip压缩的文档（twitter，约4倍--size）
+///   gunzip            只解压到一个字符串
+///   parse             只解析已经解压的字符串
+///   gunzip_then_parse 先完整解压再Value::Parse（两个阶段依次进行，内存中同时有压缩与解压的数据）
+///   pipeline          json::ParseStream(json::Decompress(...))：解压线程与解析线程通过环形缓冲区流水线进行
+/// 理想情况下pipeline接近max(gunzip, parse)，而不是两者之和；先验证结果相同。
+/// 编译时没有找到zlib则跳过。
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#ifdef JSON_HAS_ZLIB
+#include <zlib.h>
+#endif
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+#ifdef JSON_HAS_ZLIB
+namespace
+{
+
+std::string gzip(const std::string &text)
+{
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&zs, text.size()), '\0');
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(text.data()));
+    zs.avail_in = static_cast<uInt>(text.size());
+    zs.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+
+std::string gunzip(const std::string &gz, std::size_t hint)
+{
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    inflateInit2(&zs, 15 + 32);
+    std::string out(hint, '\0');
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(gz.data()));
+    zs.avail_in = static_cast<uInt>(gz.size());
+    for(;;)
+    {
+        if(zs.total_out == out.size())
+            out.resize(out.size() * 2);
+        zs.next_out = reinterpret_cast<Bytef *>(&out[zs.total_out]);
+        zs.avail_out = static_cast<uInt>(out.size() - zs.total_out);
+        if(inflate(&zs, Z_NO_FLUSH) != Z_OK)
+            break;
+    }
+    out.resize(zs.total_out);
+    inflateEnd(&zs);
+    return out;
+}
+
+
+/// 从内存中按块读取压缩数据
+ArrayStream::Source memory_source(const std::string &data)
+{
+    auto pos = std::make_shared<std::size_t>(0);
+    return [&data, pos](char *buf, std::size_t cap) {
+        std::size_t n = std::min(cap, data.size() - *pos);
+        std::memcpy(buf, data.data() + *pos, n);
+        *pos += n;
+        return n;
+    };
+}
+
+} // namespace
+#endif
+
+
+BENCH_SUITE(compress)
+{
+    (void)docs;
+#ifndef JSON_HAS_ZLIB
+    std::fprintf(stderr, "json_bench: compress suite skipped (built without zlib)\n");
+    (void)ctx;
+#else
+    JsonString text = bench::make_twitter(ctx.options.size * 4);
+    std::string gz = gzip(text);
+    Value expect = Value::Parse(text);
+    std::size_t nodes = bench::count_nodes(expect);
+
+    if(!(json::ParseStream(json::Decompress(memory_source(gz))) == expect))
+        std::fprintf(stderr, "json_bench: pipeline result differs\n");
+
+    ctx.measure("compress", "twitter.gz", "gunzip", text.size(), nodes, [&] {
+        ctx.consume(gunzip(gz, gz.size() * 4).size());
+    });
+
+    ctx.measure("compress", "twitter.gz", "parse", text.size(), nodes, [&] {
+        ctx.consume(Value::Parse(text).as_Object().size());
+    });
+
+    ctx.measure("compress", "twitter.gz", "gunzip_then_parse", text.size(), nodes, [&] {
+        Value v = Value::Parse(gunzip(gz, gz.size() * 4));
+        ctx.consume(v.as_Object().size());
+    });
+
+    ctx.measure("compress", "twitter.gz", "pipeline", text.size(), nodes, [&] {
+        json::StreamOptions so;
+        so.read_ahead = false;
+        so.chunk_size = json::DecompressOptions().block_size;
+        Value v = json::ParseStream(json::Decompress(memory_source(gz)), so);
+        ctx.consume(v.as_Object().size());
+    });
+#endif
+}
@@ -0,0 +1,102 @@
+/// core：对每个文档测量Value的基本操作
+///   parse      Value::Parse
+///   serialize  Value::Serialize
+///   format     Value::Format
+///   access     以用户代码的方式（to_Object/to_Array + at/operator[]）访问每个字段
+///   copy       Value的深拷贝
+///   destroy    只计销毁一棵完整的树的时间
+///   hash       没有缓存时计算Value::hash
+///   equal      与另一次解析得到的相同文档做operator==
+
+#include <string>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+std::size_t access_walk(const Value &v)
+{
+    switch(v.Type())
+    {
+    case json::object_type:
+    {
+        std::size_t n = 0;
+        Object o = v.to_Object();
+        for(const auto &member : o)
+            n += access_walk(o.at(member.first));
+        return n + 1;
+    }
+    case json::array_type:
+    {
+        std::size_t n = 0;
+        Array a = v.to_Array();
+        for(Array::size_type i = 0; i != a.size(); ++i)
+            n += access_walk(a[i]);
+        return n + 1;
+    }
+    case json::string_type:
+        return v.to_string().size();
+    case json::number_type:
+        return static_cast<std::size_t>(v.to_double() != 0);
+    default:
+        return 1;
+    }
+}
+
+} // namespace
+
+
+BENCH_SUITE(core)
+{
+    for(const auto &doc : docs)
+    {
+        Value v = Value::Parse(doc.text);
+        std::size_t nodes = bench::count_nodes(v);
+        JsonString serialized = v.Serialize();
+        JsonString formatted = v.Format();
+
+        ctx.measure("core", doc.name, "parse", doc.text.size(), nodes, [&] {
+            ctx.consume(Value::Parse(doc.text).is_Null());
+        });
+
+        ctx.measure("core", doc.name, "serialize", serialized.size(), nodes, [&] {
+            ctx.consume(v.Serialize().size());
+        });
+
+        ctx.measure("core", doc.name, "format", formatted.size(), nodes, [&] {
+            ctx.consume(v.Format().size());
+        });
+
+        ctx.measure("core", doc.name, "access", serialized.size(), nodes, [&] {
+            ctx.consume(access_walk(v));
+        });
+
+        ctx.measure("core", doc.name, "copy", serialized.size(), nodes, [&] {
+            Value c = v;
+            ctx.consume(c.is_Null());
+        });
+
+        ctx.measure_with("core", doc.name, "destroy", serialized.size(), nodes,
+                         [&](bench::Stopwatch &sw) {
+            Value *c = new Value(v);
+            sw.start();
+            delete c;
+            sw.stop();
+        });
+
+        ctx.measure_with("core", doc.name, "hash", serialized.size(), nodes,
+                         [&](bench::Stopwatch &sw) {
+            Value c = Value::Parse(doc.text);
+            sw.start();
+            ctx.consume(c.hash());
+            sw.stop();
+        });
+
+        Value twin = Value::Parse(doc.text);
+        ctx.measure("core", doc.name, "equal", serialized.size(), nodes, [&] {
+            ctx.consume(v == twin);
+        });
+    }
+}
@@ -0,0 +1,223 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace bench
+{
+
+namespace
+{
+
+/// 固定种子的线性同余发生器，保证每次运行生成相同的语料
+class Lcg
+{
+public:
+    explicit Lcg(unsigned long long seed): state(seed) {}
+
+    unsigned long long next()
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    }
+
+    double uniform(double lo, double hi)
+    {
+        return lo + (hi - lo) * (next() % 1000000007ULL) / 1000000007.0;
+    }
+
+private:
+    unsigned long long state;
+};
+
+
+void append_double(std::string &out, double d)
+{
+    char buf[40];
+    int n = std::snprintf(buf, sizeof(buf), "%.15f", d);
+    out.append(buf, n);
+}
+
+} // namespace
+
+
+
+/**************************************
+ make_canada：仿canada.json，一个FeatureCollection，
+ 几何体由大量高精度的[经度,纬度]浮点数对组成，数字占绝大部分字节。
+
+**************************************/
+JsonString make_canada(std::size_t bytes)
+{
+    Lcg rng(0xC0FFEE);
+    std::string s = "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\","
+                    "\"properties\":{\"name\":\"Canada\"},\"geometry\":{\"type\":\"Polygon\","
+                    "\"coordinates\":[";
+
+    for(int ring = 0; ring == 0 || s.size() < bytes; ++ring)
+    {
+        if(ring)
+            s += ",";
+        s += "[";
+        double lon = rng.uniform(-141.0, -52.0), lat = rng.uniform(42.0, 83.0);
+        for(int i = 0; i != 256; ++i)
+        {
+            if(i)
+                s += ",";
+            lon += rng.uniform(-0.01, 0.01);
+            lat += rng.uniform(-0.01, 0.01);
+            s += "[";
+            append_double(s, lon);
+            s += ",";
+            append_double(s, lat);
+            s += "]";
+        }
+        s += "]";
+    }
+    s += "]}}]}";
+    return s;
+}
+
+
+/**************************************
+ make_twitter：仿twitter.json，statuses数组中是字段繁多、以字符串为主的推文对象，
+ 包含转义字符、\u转义、URL、嵌套的user/entities以及null/true/false。
+
+**************************************/
+JsonString make_twitter(std::size_t bytes)
+{
+    static const char *words[] = {
+        "json", "parse", "the", "quick", "brown", "fox", "jumps", "over",
+        "lazy", "dog", "caf\\u00e9", "\\\"quoted\\\"", "tab\\there", "line\\nbreak",
+        "https:\\/\\/example.com", "#hashtag", "@mention", "emoji"
+    };
+    static const std::size_t nwords = sizeof(words) / sizeof(words[0]);
+
+    Lcg rng(0x7417);
+    std::string s = "{\"statuses\":[";
+    for(int i = 0; i == 0 || s.size() < bytes; ++i)
+    {
+        if(i)
+            s += ",";
+        std::string id = std::to_string(505874924095815680ULL + rng.next());
+        std::string uid = std::to_string(rng.next() % 100000000);
+
+        std::string text;
+        for(int w = 0, n = 6 + rng.next() % 14; w != n; ++w)
+        {
+            if(w)
+                text += " ";
+            text += words[rng.next() % nwords];
+        }
+
+        s += "{\"metadata\":{\"result_type\":\"recent\",\"iso_language_code\":\"en\"},"
+             "\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\","
+             "\"id\":" + id + ",\"id_str\":\"" + id + "\","
+             "\"text\":\"" + text + "\","
+             "\"source\":\"<a href=\\\"https:\\/\\/mobile.twitter.com\\\" rel=\\\"nofollow\\\">Mobile Web<\\/a>\","
+             "\"truncated\":false,\"in_reply_to_status_id\":null,\"in_reply_to_user_id\":null,"
+             "\"user\":{\"id\":" + uid + ",\"id_str\":\"" + uid + "\","
+             "\"name\":\"user " + uid + "\",\"screen_name\":\"u" + uid + "\","
+             "\"location\":\"\",\"description\":\"" + text + "\","
+             "\"url\":null,\"protected\":false,"
+             "\"followers_count\":" + std::to_string(rng.next() % 50000) + ","
+             "\"friends_count\":" + std::to_string(rng.next() % 5000) + ","
+             "\"verified\":" + (rng.next() % 10 ? "false" : "true") + ","
+             "\"lang\":\"en\",\"profile_background_color\":\"C0DEED\"},"
+             "\"geo\":null,\"coordinates\":null,\"place\":null,"
+             "\"retweet_count\":" + std::to_string(rng.next() % 1000) + ","
+             "\"favorite_count\":" + std::to_string(rng.next() % 1000) + ","
+             "\"entities\":{\"hashtags\":[{\"text\":\"json\",\"indices\":[3,8]}],"
+             "\"symbols\":[],\"urls\":[{\"url\":\"http:\\/\\/t.co\\/" + uid + "\","
+             "\"indices\":[10,32]}],\"user_mentions\":[]},"
+             "\"favorited\":false,\"retweeted\":false,\"lang\":\"en\"}";
+    }
+    s += "],\"search_metadata\":{\"completed_in\":0.087,\"max_id\":505874924095815681,"
+         "\"query\":\"%E4%B8%80\",\"count\":100,\"since_id\":0}}";
+    return s;
+}
+
+
+/**************************************
+ make_nested：顶层数组中重复放置深度为kDepth的Object/Array交替嵌套链，
+ 每层带少量标量兄弟结点，用于衡量与嵌套深度相关的开销。
+
+**************************************/
+JsonString make_nested(std::size_t bytes)
+{
+    static const int kDepth = 100;
+
+    std::string s = "[";
+    for(int i = 0; i == 0 || s.size() < bytes; ++i)
+    {
+        if(i)
+            s += ",";
+        for(int d = 0; d != kDepth; ++d)
+            s += (d % 2 == 0) ? "{\"level\":" + std::to_string(d) + ",\"child\":"
+                              : std::string("[true,null,");
+        s += "\"leaf " + std::to_string(i) + "\"";
+        for(int d = kDepth - 1; d >= 0; --d)
+            s += (d % 2 == 0) ? "}" : "]";
+    }
+    s += "]";
+    return s;
+}
+
+
+
+std::vector<Document> load_documents(const Options &opt)
+{
+    std::vector<Document> docs;
+    docs.push_back({"canada", make_canada(opt.size)});
+    docs.push_back({"twitter", make_twitter(opt.size)});
+    docs.push_back({"nested", make_nested(opt.size)});
+
+    for(const auto &path : opt.corpus)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if(!in)
+        {
+            std::fprintf(stderr, "json_bench: cannot read %s, skipped\n", path.c_str());
+            continue;
+        }
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+
+        std::string name = path.substr(path.find_last_of("/\\") + 1);
+        try
+        {
+            Value::Parse(buffer.str());
+        }
+        catch(JsonError e)
+        {
+            std::fprintf(stderr, "json_bench: %s is not valid json (%s), skipped\n",
+                         path.c_str(), e.What().c_str());
+            continue;
+        }
+        docs.push_back({name, buffer.str()});
+    }
+    return docs;
+}
+
+
+
+std::size_t count_nodes(const Value &v)
+{
+    std::size_t n = 1;
+    if(v.is_Object())
+    {
+        for(const auto &member : v.to_Object())
+            n += count_nodes(member.second);
+    }
+    else if(v.is_Array())
+    {
+        for(const auto &element : v.to_Array())
+            n += count_nodes(element);
+    }
+    return n;
+}
+
+} // namespace bench
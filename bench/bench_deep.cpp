@@ -0,0 +1,140 @@
+/// deep：巨大与极深的树的解析、拷贝、销毁、序列化与比较（解析用显式的栈，其余超过64层的部分用显式的栈）
+///   wide     顶层Array中大量的小Object，每个带几个标量、一个小Array与一个子Object
+///   deep     Object与Array交替嵌套kDepth层，递归实现会耗尽调用栈
+///   parse       Value::Parse
+///   parse_into  Value::ParseInto在结构相同的树上解析（超过reuse_depth_limit层的部分新建）
+///   copy        Value的深拷贝
+///   destroy     只计销毁一棵完整的树的时间
+///   serialize   Value::Serialize
+///   hash        Value::hash，只计在没有缓存哈希值的副本上计算的时间
+///   equal       与副本的==
+/// 先沿deep的第一个元素走到底，验证解析与拷贝的结果都有kDepth层，
+/// 再验证序列化的结果与输入相同（wide的键被排序，验证重新解析的结果相等）、副本与原树相等且哈希值相同。
+
+#include <cstdio>
+#include <string>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+const std::size_t kDepth = 100000;
+
+
+JsonString make_wide(std::size_t bytes)
+{
+    JsonString s = "[";
+    for(std::size_t i = 0; i == 0 || s.size() < bytes; ++i)
+    {
+        if(i)
+            s += ',';
+        std::string n = std::to_string(i);
+        s += "{\"id\":" + n + ",\"name\":\"item " + n + "\",\"active\":" + (i % 3 ? "true" : "false")
+           + ",\"tags\":[\"t" + n + "\",null],\"pos\":{\"x\":" + n + ",\"y\":-" + n + "}}";
+    }
+    s += ']';
+    return s;
+}
+
+
+/// 偶数层是{"k":...}，奇数层是[...]，最内层是一个字符串
+JsonString make_deep(std::size_t depth)
+{
+    JsonString s;
+    s.reserve(depth * 4 + 8);
+    for(std::size_t d = 0; d != depth; ++d)
+        s += d % 2 == 0 ? "{\"k\":" : "[";
+    s += "\"leaf\"";
+    for(std::size_t d = depth; d-- != 0;)
+        s += d % 2 == 0 ? '}' : ']';
+    return s;
+}
+
+
+/// 沿第一个元素向下走，返回容器的层数
+std::size_t depth_of(const Value &v)
+{
+    std::size_t depth = 0;
+    for(const Value *p = &v;; ++depth)
+    {
+        if(p->is_Object() && !p->as_Object().empty())
+            p = &p->as_Object().begin()->second;
+        else if(p->is_Array() && !p->as_Array().empty())
+            p = &p->as_Array()[0];
+        else
+            return depth;
+    }
+}
+
+} // namespace
+
+
+BENCH_SUITE(deep)
+{
+    (void)docs;
+
+    JsonString wide = make_wide(ctx.options.size);
+    JsonString deep = make_deep(kDepth);
+
+    for(const JsonString *text : {&wide, &deep})
+    {
+        const char *name = text == &wide ? "wide" : "deep";
+        Value v = Value::Parse(*text);
+        std::size_t nodes = text == &wide ? bench::count_nodes(v) : kDepth + 1;
+
+        Value reuse = Value::Parse(*text);
+        Value::ParseInto(*text, reuse);
+        if(text == &deep)
+        {
+            Value c = v;
+            if(depth_of(v) != kDepth || depth_of(c) != kDepth || depth_of(reuse) != kDepth)
+                std::fprintf(stderr, "json_bench: deep document has the wrong depth\n");
+        }
+        else if(Value(v) != v || reuse != v)
+            std::fprintf(stderr, "json_bench: copy of the wide document differs\n");
+        Value twin = v;
+        bool round_trip = text == &deep ? v.Serialize() == *text : Value::Parse(v.Serialize()) == v;
+        if(!round_trip || twin != v || Value(v).hash() != twin.hash())
+            std::fprintf(stderr, "json_bench: %s document does not round-trip\n", name);
+
+        ctx.measure("deep", name, "parse", text->size(), nodes, [&] {
+            ctx.consume(Value::Parse(*text).is_Null());
+        });
+
+        ctx.measure("deep", name, "parse_into", text->size(), nodes, [&] {
+            Value::ParseInto(*text, reuse);
+            ctx.consume(reuse.is_Null());
+        });
+
+        ctx.measure("deep", name, "copy", text->size(), nodes, [&] {
+            Value c = v;
+            ctx.consume(c.is_Null());
+        });
+
+        ctx.measure_with("deep", name, "destroy", text->size(), nodes,
+                         [&](bench::Stopwatch &sw) {
+            Value *c = new Value(v);
+            sw.start();
+            delete c;
+            sw.stop();
+        });
+
+        ctx.measure("deep", name, "serialize", text->size(), nodes, [&] {
+            ctx.consume(v.Serialize().size());
+        });
+
+        ctx.measure_with("deep", name, "hash", text->size(), nodes,
+                         [&](bench::Stopwatch &sw) {
+            Value c = v;
+            sw.start();
+            ctx.consume(c.hash());
+            sw.stop();
+        });
+
+        ctx.measure("deep", name, "equal", text->size(), nodes, [&] {
+            ctx.consume(twin == v);
+        });
+    }
+}
@@ -0,0 +1,117 @@
+/// dense：元素全部是数字的大型Array
+///   doubles   形如123.45的小数（最短往返表示），紧凑保存为double
+///   ints      64位整数，紧凑保存为int64
+///   parse       Value::Parse
+///   parse/plain 开头多一个null的同样文本，按普通的Array解析
+///   sum/span    as_span求和
+///   sum/values  对同样内容的普通Array（每个元素一个Number结点）逐个to_double求和
+///   serialize   Serialize：紧凑的Array用to_chars生成每个数字，普通的Array复制词素
+/// 先验证紧凑与普通的Array序列化结果相同，求和结果相同，非const访问不解除紧凑形式。
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+JsonString make_numbers(std::size_t bytes, bool floating)
+{
+    std::uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    JsonString text = "[";
+    char buf[32];
+    while(text.size() < bytes)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::uint32_t r = static_cast<std::uint32_t>(seed >> 33);
+        std::to_chars_result w = floating
+            ? std::to_chars(buf, buf + sizeof(buf), static_cast<double>(r % 10000000) / 100)
+            : std::to_chars(buf, buf + sizeof(buf), static_cast<std::int64_t>(r) - (1LL << 30));
+        if(text.size() > 1)
+            text += ',';
+        text.append(buf, w.ptr - buf);
+    }
+    text += ']';
+    return text;
+}
+
+double sum_values(const Array &arr)
+{
+    double s = 0;
+    for(const auto &v : arr)
+        s += v.to_double();
+    return s;
+}
+
+} // namespace
+
+
+BENCH_SUITE(dense)
+{
+    (void)docs;
+
+    for(bool floating : {true, false})
+    {
+        const char *name = floating ? "doubles" : "ints";
+        JsonString text = make_numbers(ctx.options.size, floating);
+        Value dense = Value::Parse(text);
+        Value plain = dense;
+        plain.as_Array().push_back(Value());    // 插入null使它转换回普通的Array
+        plain.as_Array().pop_back();
+        const Array &da = static_cast<const Value &>(dense).as_Array();
+        const Array &pa = static_cast<const Value &>(plain).as_Array();
+        std::size_t nodes = da.size() + 1;
+
+        auto sum_span = [&] {
+            double s = 0;
+            if(floating)
+                for(double d : da.as_span<double>())
+                    s += d;
+            else
+                for(std::int64_t i : da.as_span<std::int64_t>())
+                    s += static_cast<double>(i);
+            return s;
+        };
+        if(!da.is_dense() || pa.is_dense() || dense.Serialize() != plain.Serialize()
+           || sum_span() != sum_values(pa))
+            std::fprintf(stderr, "json_bench: dense %s differs from the plain Array\n", name);
+
+        /// 非const的遍历与追加数字都不解除紧凑形式
+        Value probe = dense;
+        for(auto &v : probe.as_Array())
+            (void)v;
+        probe.as_Array().push_back(probe.as_Array()[0]);
+        if(!probe.as_Array().is_dense() || probe.as_Array().size() != da.size() + 1)
+            std::fprintf(stderr, "json_bench: dense %s was unpacked by non-const access\n", name);
+
+        ctx.measure("dense", name, "parse", text.size(), nodes, [&] {
+            ctx.consume(Value::Parse(text).is_Null());
+        });
+
+        JsonString mixed = "[null," + text.substr(1);
+        ctx.measure("dense", name, "parse/plain", mixed.size(), nodes + 1, [&] {
+            ctx.consume(Value::Parse(mixed).is_Null());
+        });
+
+        ctx.measure("dense", name, "sum/span", text.size(), nodes, [&] {
+            ctx.consume(static_cast<std::size_t>(sum_span()));
+        });
+
+        ctx.measure("dense", name, "sum/values", text.size(), nodes, [&] {
+            ctx.consume(static_cast<std::size_t>(sum_values(pa)));
+        });
+
+        ctx.measure("dense", name, "serialize/dense", text.size(), nodes, [&] {
+            ctx.consume(dense.Serialize().size());
+        });
+
+        ctx.measure("dense", name, "serialize/plain", text.size(), nodes, [&] {
+            ctx.consume(plain.Serialize().size());
+        });
+    }
+}
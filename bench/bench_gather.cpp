@@ -0,0 +1,89 @@
+/// gather：把序列化结果写到文件描述符（/dev/null）
+///   serialize+write  Value::Serialize得到字符串，再write
+///   gather+writev    Value::Serialize(GatherBuffer &)，再writev，长字符串不复制
+///   size             Value::SerializedSize
+/// 除三个合成文档外，另有一个由大块字符串组成的blobs文档；先验证输出逐字节相同。
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+/// 每个元素带一个4KB的字符串，类似附件、base64数据
+JsonString make_blobs(std::size_t bytes)
+{
+    std::string blob(4096, 'A');
+    for(std::size_t i = 0; i != blob.size(); ++i)
+        blob[i] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[i * 7 % 64];
+
+    std::string s = "[";
+    for(std::size_t i = 0; s.size() < bytes; ++i)
+    {
+        if(i)
+            s += ",";
+        s += "{\"id\":" + std::to_string(i) + ",\"type\":\"image/png\",\"data\":\"" + blob + "\"}";
+    }
+    return s + "]";
+}
+
+bool write_all(int fd, const std::string &s)
+{
+    for(std::size_t off = 0; off != s.size(); )
+    {
+        ssize_t n = ::write(fd, s.data() + off, s.size() - off);
+        if(n < 0)
+            return false;
+        off += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+
+BENCH_SUITE(gather)
+{
+    int fd = ::open("/dev/null", O_WRONLY);
+    if(fd < 0)
+    {
+        std::fprintf(stderr, "json_bench: cannot open /dev/null\n");
+        return;
+    }
+
+    std::vector<bench::Document> all(docs);
+    all.push_back({"blobs", make_blobs(ctx.options.size)});
+
+    for(const auto &doc : all)
+    {
+        Value v = Value::Parse(doc.text);
+        std::size_t nodes = bench::count_nodes(v);
+        JsonString serialized = v.Serialize();
+
+        GatherBuffer check;
+        v.Serialize(check);
+        if(check.str() != serialized || v.SerializedSize() != serialized.size())
+            std::fprintf(stderr, "json_bench: gather output differs for %s\n", doc.name.c_str());
+
+        ctx.measure("gather", doc.name, "serialize+write", serialized.size(), nodes, [&] {
+            ctx.consume(write_all(fd, v.Serialize()));
+        });
+
+        ctx.measure("gather", doc.name, "gather+writev", serialized.size(), nodes, [&] {
+            GatherBuffer out;
+            v.Serialize(out);
+            ctx.consume(out.write_to(fd));
+        });
+
+        ctx.measure("gather", doc.name, "size", serialized.size(), nodes, [&] {
+            ctx.consume(v.SerializedSize());
+        });
+    }
+    ::close(fd);
+}
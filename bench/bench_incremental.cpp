@@ -0,0 +1,63 @@
+/// incremental：大型、基本不变的文档每次只修改一个字段后重新序列化
+///   full    不保留序列化结果，每次完整地重新生成
+///   cached  cache_serialized之后，只重新生成被修改的路径，其余子树直接复制
+/// 先验证两种方式的结果逐字节相同（包括通过先前取得的引用修改之后）。
+
+#include <cstdio>
+#include <string>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+/// 修改第i条推文的user.followers_count，路径为root -> statuses -> [i] -> user
+void mutate(Value &state, std::size_t i)
+{
+    Array &statuses = state.as_Object()["statuses"].as_Array();
+    Value &status = statuses[i % statuses.size()];
+    status.as_Object()["user"].as_Object()["followers_count"] = static_cast<unsigned long long>(i);
+}
+
+} // namespace
+
+
+BENCH_SUITE(incremental)
+{
+    (void)docs;
+
+    JsonString text = bench::make_twitter(ctx.options.size);
+    Value full = Value::Parse(text);
+    Value cached = full;
+    cached.cache_serialized();
+    std::size_t nodes = bench::count_nodes(full);
+
+    mutate(full, 1);
+    mutate(cached, 1);
+    cached.Serialize();
+    mutate(cached, 2);
+    mutate(full, 2);
+    if(full.Serialize() != cached.Serialize())
+        std::fprintf(stderr, "json_bench: cached serialization differs\n");
+
+    /// 通过序列化之前取得的引用修改，结果也必须相同
+    Value &count = cached.as_Object()["statuses"].as_Array()[0]
+                         .as_Object()["user"].as_Object()["followers_count"];
+    cached.Serialize();
+    count = 7;
+    full.as_Object()["statuses"].as_Array()[0].as_Object()["user"].as_Object()["followers_count"] = 7;
+    if(full.Serialize() != cached.Serialize())
+        std::fprintf(stderr, "json_bench: cached serialization is stale after an edit through a reference\n");
+
+    std::size_t i = 0, size = full.Serialize().size();
+    ctx.measure("incremental", "twitter", "full", size, nodes, [&] {
+        mutate(full, ++i);
+        ctx.consume(full.Serialize().size());
+    });
+
+    ctx.measure("incremental", "twitter", "cached", size, nodes, [&] {
+        mutate(cached, ++i);
+        ctx.consume(cached.Serialize().size());
+    });
+}
@@ -0,0 +1,181 @@
+/// index：在Array上按字段查找元素（见Json_index.h）
+///   twitter id                  按每条推文的id查找
+///   twitter user.screen_name    按作者的screen_name查找（同一作者可能有多条）
+///   twitter/compact ...         同上，Value::compact之后
+///   build          Array::build_index
+///   find/scan      std::find_if逐个比较字段（建立索引之前的做法）
+///   find/index     ArrayIndex::find
+///   append/plain   没有索引的Array上push_back一个元素再pop_back
+///   append/index   有索引时同样的操作，索引随之更新
+///   find/use       find之后通过非const的operator[]取得找到的元素（索引不过期，之后的查找核对取过的元素）
+///   rebuild        范围insert使索引过期，之后的一次find重建索引
+/// nodes为每次的查找数（build与rebuild为元素个数）。先验证两种查找的结果相同，
+/// 以及通过查找之前取得的引用修改字段之后，新值立即可以找到。
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+/// v中路径处的字段，不存在时返回nullptr
+const Value *field(const Value &v, const std::vector<std::string> &keys)
+{
+    const Value *cur = &v;
+    for(const auto &key : keys)
+    {
+        if(!cur->is_Object())
+            return nullptr;
+        const Object &obj = cur->as_Object();
+        auto it = obj.find(key);
+        if(it == obj.end())
+            return nullptr;
+        cur = &it->second;
+    }
+    return cur;
+}
+
+
+std::size_t scan(const Array &arr, const std::vector<std::string> &keys, const Value &key)
+{
+    auto it = std::find_if(arr.begin(), arr.end(), [&](const Value &e) {
+        const Value *f = field(e, keys);
+        return f && *f == key;
+    });
+    return it == arr.end() ? ArrayIndex::npos : static_cast<std::size_t>(it - arr.begin());
+}
+
+} // namespace
+
+
+BENCH_SUITE(index)
+{
+    (void)docs;
+
+    struct Input
+    {
+        std::string name;
+        Value root;
+    };
+    std::vector<Input> inputs;
+    {
+        Value twitter = Value::Parse(bench::make_twitter(ctx.options.size));
+        inputs.push_back({"twitter", twitter});
+        twitter.compact();
+        inputs.push_back({"twitter/compact", std::move(twitter)});
+    }
+
+    struct Path
+    {
+        const char *path;
+        std::vector<std::string> keys;
+    };
+    const std::vector<Path> paths = {
+        {"id", {"id"}},
+        {"user.screen_name", {"user", "screen_name"}},
+    };
+
+    for(auto &in : inputs)
+        for(const auto &p : paths)
+        {
+            /// 查找的键：均匀地取自各个元素，另加四分之一不存在的键
+            Array &statuses = in.root.as_Object()["statuses"].as_Array();
+            const Array &view = statuses;
+            const std::size_t n = view.size();
+            std::vector<Value> keys;
+            for(std::size_t i = 0; i < n; i += std::max<std::size_t>(1, n / 256))
+                if(const Value *f = field(view[i], p.keys))
+                    keys.push_back(*f);
+            for(std::size_t i = 0, m = keys.size() / 4; i != m; ++i)
+                keys.push_back(Value("missing-" + std::to_string(i)));
+
+            ArrayIndex index = statuses.build_index(p.path);
+            for(const Value &key : keys)
+                if(index.find(key) != scan(view, p.keys, key))
+                    std::fprintf(stderr, "json_bench: index %s differs from scan on %s\n",
+                                 p.path, in.name.c_str());
+
+            std::string doc = in.name + " " + p.path;
+            ctx.measure("index", doc, "build", 0, n, [&] {
+                ArrayIndex fresh = statuses.build_index(p.path);
+                ctx.consume(fresh.size());
+            });
+
+            ctx.measure("index", doc, "find/scan", 0, keys.size(), [&] {
+                std::size_t sum = 0;
+                for(const Value &key : keys)
+                    sum += scan(view, p.keys, key);
+                ctx.consume(sum);
+            });
+
+            ctx.measure("index", doc, "find/index", 0, keys.size(), [&] {
+                std::size_t sum = 0;
+                for(const Value &key : keys)
+                    sum += index.find(key);
+                ctx.consume(sum);
+            });
+
+            /// 在副本上修改，不影响之后的用例
+            const Value extra = view[n / 2];
+            Array plain = view;
+            plain.reserve(n + 1);
+            ctx.measure("index", doc, "append/plain", 0, 1, [&] {
+                plain.push_back(extra);
+                plain.pop_back();
+            });
+
+            Array indexed = view;
+            indexed.reserve(n + 1);
+            ArrayIndex maintained = indexed.build_index(p.path);
+            ctx.measure("index", doc, "append/index", 0, 1, [&] {
+                indexed.push_back(extra);
+                indexed.pop_back();
+            });
+            if(maintained.find(*field(extra, p.keys)) == ArrayIndex::npos)
+                std::fprintf(stderr, "json_bench: index %s lost an element on %s\n",
+                             p.path, in.name.c_str());
+
+            ctx.measure("index", doc, "find/use", 0, keys.size(), [&] {
+                std::size_t sum = 0;
+                for(const Value &key : keys)
+                {
+                    std::size_t i = maintained.find(key);
+                    if(i != ArrayIndex::npos)
+                        sum += indexed[i].as_Object().size();
+                }
+                ctx.consume(sum);
+            });
+            for(const Value &key : keys)
+                if(maintained.find(key) != scan(indexed, p.keys, key))
+                    std::fprintf(stderr, "json_bench: index %s differs from scan after find/use on %s\n",
+                                 p.path, in.name.c_str());
+            {
+                /// 先取得引用，查找之后再通过它修改字段，最后恢复原值
+                Value &target = indexed[n / 3];
+                const Value *old = field(target, p.keys);
+                if(old && maintained.find(*old) != ArrayIndex::npos)
+                {
+                    Value saved = *old;
+                    Value *slot = &target;
+                    for(const auto &k : p.keys)
+                        slot = &slot->as_Object()[k];
+                    *slot = Value("edited-through-reference");
+                    if(maintained.find(*slot) != n / 3)
+                        std::fprintf(stderr, "json_bench: index %s misses an edit through a reference on %s\n",
+                                     p.path, in.name.c_str());
+                    *slot = saved;
+                }
+            }
+
+            ctx.measure("index", doc, "rebuild", 0, n, [&] {
+                indexed.insert(indexed.cend(), 1, extra);
+                indexed.pop_back();
+                ctx.consume(maintained.find(keys[0]));
+            });
+        }
+}
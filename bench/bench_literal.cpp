@@ -0,0 +1,69 @@
+/// literal：在热路径中使用常量文档
+///   build    每次都用初始化列表构造Value（main.cpp中的写法），再读取一个字段
+///   literal  JSON_LITERAL得到的常量文档，读取同一个字段
+///   mutate   从JSON_LITERAL得到句柄并修改一个字段（写时复制）
+/// 先验证三种方式得到的文档相同。
+
+#include <cstdio>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+Value build()
+{
+    return {{"name", "default"}, {"retries", 3}, {"timeout", 2.5},
+            {"hosts", {"a.example.com", "b.example.com", "c.example.com"}},
+            {"tls", {{"enabled", true}, {"verify", false}, {"ciphers", {}}}}};
+}
+
+Constant literal()
+{
+    return JSON_LITERAL(R"({"name":"default","retries":3,"timeout":2.5,
+                            "hosts":["a.example.com","b.example.com","c.example.com"],
+                            "tls":{"enabled":true,"verify":false,"ciphers":null}})");
+}
+
+} // namespace
+
+
+BENCH_SUITE(literal)
+{
+    (void)docs;
+
+    Value expect = build();
+    std::size_t bytes = expect.Serialize().size(), nodes = bench::count_nodes(expect);
+    if(*literal() != expect
+       || *JSON_CONSTANT({{"name", "default"}, {"retries", 3}, {"timeout", 2.5},
+                          {"hosts", {"a.example.com", "b.example.com", "c.example.com"}},
+                          {"tls", {{"enabled", true}, {"verify", false}, {"ciphers", {}}}}}) != expect)
+        std::fprintf(stderr, "json_bench: literal document differs\n");
+
+    const int rounds = 1000;
+    ctx.measure("literal", "config", "build", bytes * rounds, nodes * rounds, [&] {
+        for(int i = 0; i != rounds; ++i)
+        {
+            Value v = build();
+            ctx.consume(v.as_Object().at("retries").to_int());
+        }
+    });
+
+    ctx.measure("literal", "config", "literal", bytes * rounds, nodes * rounds, [&] {
+        for(int i = 0; i != rounds; ++i)
+        {
+            Constant c = literal();
+            ctx.consume(c->as_Object().at("retries").to_int());
+        }
+    });
+
+    ctx.measure("literal", "config", "mutate", bytes * rounds, nodes * rounds, [&] {
+        for(int i = 0; i != rounds; ++i)
+        {
+            Constant c = literal();
+            c.mutate().as_Object()["retries"] = i;
+            ctx.consume(c->as_Object().at("retries").to_int());
+        }
+    });
+}
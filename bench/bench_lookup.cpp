@@ -0,0 +1,65 @@
+/// lookup：以字段查找为主的只读负载，遍历twitter语料中的每条推文读取若干字段
+///   string    每次查找都构造String作为键（即改用异构查找之前字面量键的行为）
+///   literal   直接以字符串字面量查找（异构查找，不构造String）
+///   prebuilt  使用预先构造好的String作为键
+/// 查找的键中包括超过SSO长度的"profile_background_color"。
+
+#include <iterator>
+#include <string>
+#include <vector>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+const char *const fields[] = {
+    "user", "id", "text", "followers_count", "profile_background_color", "missing_field"
+};
+
+
+/// key(i)给出第i个字段的键
+template<typename _Key>
+std::size_t walk(const Array &statuses, _Key key)
+{
+    std::size_t n = 0;
+    for(const auto &v : statuses)
+    {
+        const Object &status = v.as_Object();
+        const Object &user = status.at(key(0)).as_Object();
+        n += status.at(key(1)).to_ulonglong() & 1;
+        n += status.at(key(2)).is_String();
+        n += user.at(key(3)).to_int();
+        n += user.count(key(4));
+        n += status.count(key(5));
+    }
+    return n;
+}
+
+} // namespace
+
+
+BENCH_SUITE(lookup)
+{
+    (void)docs;
+
+    Value doc = Value::Parse(bench::make_twitter(ctx.options.size));
+    const Array &statuses = doc.as_Object().at("statuses").as_Array();
+    std::size_t bytes = doc.Serialize().size();
+    std::size_t lookups = statuses.size() * 6;
+
+    std::vector<String> prebuilt(std::begin(fields), std::end(fields));
+
+    ctx.measure("lookup", "twitter", "string", bytes, lookups, [&] {
+        ctx.consume(walk(statuses, [](std::size_t i) { return String(fields[i]); }));
+    });
+
+    ctx.measure("lookup", "twitter", "literal", bytes, lookups, [&] {
+        ctx.consume(walk(statuses, [](std::size_t i) { return fields[i]; }));
+    });
+
+    ctx.measure("lookup", "twitter", "prebuilt", bytes, lookups, [&] {
+        ctx.consume(walk(statuses, [&prebuilt](std::size_t i) -> const String & { return prebuilt[i]; }));
+    });
+}
@@ -0,0 +1,296 @@
+/// json_bench：JsonOOLib的基准测试
+///
+/// 用法：json_bench [--format=text|json|csv] [--suite=name[,name...]]
+///                  [--size=bytes] [--min-time=seconds] [corpus.json ...]
+///
+/// --format=json/csv输出机器可读的结果，便于比较不同构建之间的差异。
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <sys/resource.h>
+#include "bench.h"
+
+
+/**************************************
+ 替换全局operator new/delete以统计分配次数与字节数，
+ 只计数，不改变分配行为。
+
+**************************************/
+namespace
+{
+std::atomic<std::size_t> g_allocs(0);
+std::atomic<std::size_t> g_bytes(0);
+}
+
+void *operator new(std::size_t n)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(n, std::memory_order_relaxed);
+    if(void *p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t n) { return operator new(n); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+
+
+namespace bench
+{
+
+std::size_t alloc_count() { return g_allocs.load(std::memory_order_relaxed); }
+std::size_t alloc_bytes() { return g_bytes.load(std::memory_order_relaxed); }
+
+long peak_rss_kb()
+{
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return usage.ru_maxrss;
+}
+
+
+std::vector<Suite> &suites()
+{
+    static std::vector<Suite> s;
+    return s;
+}
+
+
+namespace
+{
+
+double mb_per_s(const Result &r)
+{
+    return r.ns > 0 ? r.bytes / r.ns * 1e3 : 0;
+}
+
+double ns_per_node(const Result &r)
+{
+    return r.nodes ? r.ns / r.nodes : 0;
+}
+
+} // namespace
+
+
+void Context::report(const Result &r)
+{
+    results.push_back(r);
+    if(options.format != "text")
+        return;
+
+    std::printf("%-8s %-14s %-18s %10.2f MB/s %9.2f ns/node %12.1f allocs %10.0f KB alloc %9ld KB\n",
+                r.suite.c_str(), r.doc.c_str(), r.op.c_str(),
+                mb_per_s(r), ns_per_node(r), r.allocs, r.allocBytes / 1024, r.peakRssKb);
+    std::fflush(stdout);
+}
+
+
+double LatencyHistogram::percentile(double q)
+{
+    if(samples.empty())
+        return 0;
+    if(!sorted)
+    {
+        std::sort(samples.begin(), samples.end());
+        sorted = true;
+    }
+    std::size_t i = static_cast<std::size_t>(q * (samples.size() - 1) + 0.5);
+    return samples[i < samples.size() ? i : samples.size() - 1];
+}
+
+
+std::string LatencyHistogram::buckets() const
+{
+    std::vector<std::size_t> counts;
+    for(double ns : samples)
+    {
+        std::size_t b = 0;
+        for(double limit = 1000; ns >= limit; limit *= 2)
+            ++b;
+        if(counts.size() <= b)
+            counts.resize(b + 1);
+        ++counts[b];
+    }
+
+    std::size_t first = 0;
+    while(first != counts.size() && counts[first] == 0)
+        ++first;
+    std::string out;
+    char buf[64];
+    for(std::size_t b = first; b < counts.size(); ++b)
+    {
+        double us = static_cast<double>(1ULL << b);
+        if(us < 1000)
+            std::snprintf(buf, sizeof(buf), "%s<%.0fus:%zu", out.empty() ? "" : " ", us, counts[b]);
+        else
+            std::snprintf(buf, sizeof(buf), "%s<%.0fms:%zu", out.empty() ? "" : " ", us / 1000, counts[b]);
+        out += buf;
+    }
+    return out;
+}
+
+
+void Context::report_latency(const std::string &suite, const std::string &doc,
+                             const std::string &op, std::size_t bytes, LatencyHistogram &h)
+{
+    static const struct { const char *name; double q; } points[] = {
+        {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p99.9", 0.999}, {"max", 1}};
+
+    for(const auto &pt : points)
+    {
+        Result r;
+        r.suite = suite;
+        r.doc = doc;
+        r.op = op + "/" + pt.name;
+        r.bytes = bytes;
+        r.nodes = 1;
+        r.iterations = h.size();
+        r.ns = h.percentile(pt.q);
+        r.nsMin = h.percentile(0);
+        r.peakRssKb = peak_rss_kb();
+        report(r);
+    }
+    if(options.format == "text")
+        std::printf("         %s\n", h.buckets().c_str());
+}
+
+
+void Context::finish()
+{
+    if(options.format == "json")
+    {
+        std::printf("{\"results\":[\n");
+        for(std::size_t i = 0; i != results.size(); ++i)
+        {
+            const Result &r = results[i];
+            std::string doc;
+            json::append_escaped(doc, r.doc.data(), r.doc.size());
+            std::printf("{\"suite\":\"%s\",\"doc\":%s,\"op\":\"%s\","
+                        "\"bytes\":%zu,\"nodes\":%zu,\"iterations\":%zu,"
+                        "\"ns\":%.1f,\"ns_min\":%.1f,\"mb_per_s\":%.3f,"
+                        "\"ns_per_node\":%.3f,\"allocs\":%.2f,\"alloc_bytes\":%.1f,"
+                        "\"peak_rss_kb\":%ld}%s\n",
+                        r.suite.c_str(), doc.c_str(), r.op.c_str(),
+                        r.bytes, r.nodes, r.iterations, r.ns, r.nsMin,
+                        mb_per_s(r), ns_per_node(r), r.allocs, r.allocBytes,
+                        r.peakRssKb, i + 1 == results.size() ? "" : ",");
+        }
+        std::printf("],\"checksum\":%zu}\n", sink);
+    }
+    else if(options.format == "csv")
+    {
+        std::printf("suite,doc,op,bytes,nodes,iterations,ns,ns_min,"
+                    "mb_per_s,ns_per_node,allocs,alloc_bytes,peak_rss_kb\n");
+        for(const Result &r : results)
+            std::printf("%s,%s,%s,%zu,%zu,%zu,%.1f,%.1f,%.3f,%.3f,%.2f,%.1f,%ld\n",
+                        r.suite.c_str(), r.doc.c_str(), r.op.c_str(),
+                        r.bytes, r.nodes, r.iterations, r.ns, r.nsMin,
+                        mb_per_s(r), ns_per_node(r), r.allocs, r.allocBytes,
+                        r.peakRssKb);
+    }
+    else
+    {
+        std::printf("(checksum %zu)\n", sink);
+    }
+}
+
+} // namespace bench
+
+
+
+namespace
+{
+
+bool starts_with(const char *s, const char *prefix, const char *&value)
+{
+    std::size_t n = std::strlen(prefix);
+    if(std::strncmp(s, prefix, n) != 0)
+        return false;
+    value = s + n;
+    return true;
+}
+
+void split(const std::string &s, std::vector<std::string> &out)
+{
+    std::size_t b = 0;
+    while(b <= s.size())
+    {
+        std::size_t e = s.find(',', b);
+        if(e == std::string::npos)
+            e = s.size();
+        if(e != b)
+            out.push_back(s.substr(b, e - b));
+        b = e + 1;
+    }
+}
+
+int usage(const char *argv0)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--format=text|json|csv] [--suite=name[,name...]]\n"
+                 "          [--size=bytes] [--min-time=seconds] [corpus.json ...]\n"
+                 "suites:",
+                 argv0);
+    for(const auto &s : bench::suites())
+        std::fprintf(stderr, " %s", s.name);
+    std::fprintf(stderr, "\n");
+    return 2;
+}
+
+} // namespace
+
+
+int main(int argc, char **argv)
+{
+    bench::Options opt;
+    for(int i = 1; i < argc; ++i)
+    {
+        const char *v = nullptr;
+        if(starts_with(argv[i], "--format=", v))
+            opt.format = v;
+        else if(starts_with(argv[i], "--suite=", v))
+            split(v, opt.suites);
+        else if(starts_with(argv[i], "--size=", v))
+            opt.size = std::strtoull(v, nullptr, 10);
+        else if(starts_with(argv[i], "--min-time=", v))
+            opt.minTime = std::strtod(v, nullptr);
+        else if(argv[i][0] == '-')
+            return usage(argv[0]);
+        else
+            opt.corpus.push_back(argv[i]);
+    }
+    if(opt.format != "text" && opt.format != "json" && opt.format != "csv")
+        return usage(argv[0]);
+
+    try
+    {
+        std::vector<bench::Document> docs = bench::load_documents(opt);
+        bench::Context ctx(opt);
+
+        for(const auto &s : bench::suites())
+        {
+            bool selected = opt.suites.empty();
+            for(const auto &name : opt.suites)
+                selected = selected || name == s.name;
+            if(selected)
+                s.fn(ctx, docs);
+        }
+        ctx.finish();
+    }
+    catch(json::JsonError e)
+    {
+        std::fprintf(stderr, "%s\n", e.What().c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+/// parallel：并行解析与并行序列化在不同线程数下的吞吐量
+///   records  由twitter语料的statuses组成的顶层Array
+///   nested   make_nested生成的顶层Array
+/// 每种线程数先验证结果与顺序解析/顺序序列化的结果逐字节相同。
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+std::vector<unsigned> thread_counts()
+{
+    std::vector<unsigned> counts = {1, 2, 4};
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    if(hw > 4)
+        counts.push_back(hw);
+    return counts;
+}
+
+} // namespace
+
+
+BENCH_SUITE(parallel)
+{
+    (void)docs;
+
+    std::vector<bench::Document> inputs;
+    inputs.push_back({"records",
+                      Value::Parse(bench::make_twitter(ctx.options.size))
+                          .to_Object().at("statuses").Serialize()});
+    inputs.push_back({"nested", bench::make_nested(ctx.options.size)});
+
+    for(const auto &doc : inputs)
+    {
+        Value v = Value::Parse(doc.text);
+        std::size_t nodes = bench::count_nodes(v);
+        JsonString expected = v.Serialize();
+
+        for(unsigned threads : thread_counts())
+        {
+            ParallelOptions opt;
+            opt.threads = threads;
+            opt.min_bytes = 0;
+
+            if(Value::Parse(doc.text, opt).Serialize() != expected)
+                std::fprintf(stderr, "json_bench: parallel parse of %s with %u threads differs\n",
+                             doc.name.c_str(), threads);
+
+            ctx.measure("parallel", doc.name, "parse/t" + std::to_string(threads),
+                        doc.text.size(), nodes, [&] {
+                ctx.consume(Value::Parse(doc.text, opt).is_Null());
+            });
+
+            if(v.Serialize(opt) != expected)
+                std::fprintf(stderr, "json_bench: parallel serialize of %s with %u threads differs\n",
+                             doc.name.c_str(), threads);
+
+            ctx.measure("parallel", doc.name, "serialize/t" + std::to_string(threads),
+                        expected.size(), nodes, [&] {
+                ctx.consume(v.Serialize(opt).size());
+            });
+        }
+    }
+}
@@ -0,0 +1,215 @@
+/// path：JsonPath查询与等价的手写遍历（见Json_path.h）
+///   events           {"events":[{"level":..., "msg":..., "ts":..., "tags":[...]}, ...]}
+///   events/compact   同上，Value::compact之后
+///   twitter          make_twitter的文档
+///   compile     编译表达式
+///   select      JsonPath::Select(root)
+///   select/tN   Select(root, opt)，opt.threads = N，opt.min_bytes = 0
+///   hand        手写的Object/Array遍历，同样只收集结点的指针
+/// nodes为被查询的Array的元素个数（compile为1）。先验证各种方式得到的结点序列相同
+/// （压缩的Object上手写的find返回map视图中的结点，因此按值比较）。
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+typedef std::vector<const Value *> Nodes;
+
+struct Query
+{
+    const char *doc;
+    const char *path;
+    std::function<void(const Value &, Nodes &)> hand;
+};
+
+
+JsonString make_events(std::size_t bytes)
+{
+    static const char *levels[] = {"info", "info", "debug", "warn", "info", "error", "info", "debug"};
+    static const char *tags[] = {"db", "http", "auth", "cache"};
+    std::string s = "{\"events\":[";
+    for(std::size_t i = 0; i == 0 || s.size() < bytes; ++i)
+    {
+        if(i)
+            s += ",";
+        s += "{\"level\":\"" + std::string(levels[i * 7 % 8]) + "\",\"msg\":\"request " + std::to_string(i)
+           + " finished\",\"ts\":" + std::to_string(1409444955 + i) + ",\"tags\":[\"" + tags[i % 4] + "\",\""
+           + tags[i / 4 % 4] + "\"]}";
+    }
+    s += "]}";
+    return s;
+}
+
+
+std::vector<unsigned> thread_counts()
+{
+    std::vector<unsigned> counts = {1, 2, 4};
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    if(hw > 4)
+        counts.push_back(hw);
+    return counts;
+}
+
+
+bool same(const Nodes &a, const Nodes &b)
+{
+    if(a.size() != b.size())
+        return false;
+    for(std::size_t i = 0; i != a.size(); ++i)
+        if(*a[i] != *b[i])
+            return false;
+    return true;
+}
+
+
+/// $..screen_name：先序遍历，先取结点自身的成员，再进入各个子结点
+void collect(const Value &v, const char *key, Nodes &out)
+{
+    if(v.is_Object())
+    {
+        const Object &obj = v.as_Object();
+        auto it = obj.find(key);
+        if(it != obj.end())
+            out.push_back(&it->second);
+        for(const auto &member : obj)
+            collect(member.second, key, out);
+    }
+    else if(v.is_Array())
+    {
+        for(const Value &e : v.as_Array())
+            collect(e, key, out);
+    }
+}
+
+} // namespace
+
+
+BENCH_SUITE(path)
+{
+    (void)docs;
+
+    struct Input
+    {
+        std::string name;
+        Value root;
+        std::size_t elements;
+    };
+    std::vector<Input> inputs;
+    {
+        Value events = Value::Parse(make_events(ctx.options.size));
+        std::size_t n = events.as_Object().at("events").as_Array().size();
+        inputs.push_back({"events", events, n});
+        events.compact();
+        inputs.push_back({"events/compact", std::move(events), n});
+
+        Value twitter = Value::Parse(bench::make_twitter(ctx.options.size));
+        n = twitter.as_Object().at("statuses").as_Array().size();
+        inputs.push_back({"twitter", std::move(twitter), n});
+    }
+
+    const Value error("error"), db("db");
+    const std::vector<Query> queries = {
+        {"events", "$.events[?(@.level=='error')].msg", [&](const Value &root, Nodes &out) {
+            for(const Value &e : root.as_Object().at("events").as_Array())
+            {
+                const Object &obj = e.as_Object();
+                auto level = obj.find("level"), msg = obj.find("msg");
+                if(level != obj.end() && level->second == error && msg != obj.end())
+                    out.push_back(&msg->second);
+            }
+        }},
+        {"events", "$.events[*].ts", [&](const Value &root, Nodes &out) {
+            for(const Value &e : root.as_Object().at("events").as_Array())
+            {
+                const Object &obj = e.as_Object();
+                auto ts = obj.find("ts");
+                if(ts != obj.end())
+                    out.push_back(&ts->second);
+            }
+        }},
+        {"events", "$.events[?(@.tags[0]=='db' && @.level!='debug')].ts", [&](const Value &root, Nodes &out) {
+            for(const Value &e : root.as_Object().at("events").as_Array())
+            {
+                const Object &obj = e.as_Object();
+                auto tags = obj.find("tags"), level = obj.find("level"), ts = obj.find("ts");
+                if(tags == obj.end() || !tags->second.is_Array() || tags->second.as_Array().empty()
+                   || tags->second.as_Array()[0] != db)
+                    continue;
+                if(level != obj.end() && level->second == Value("debug"))
+                    continue;
+                if(ts != obj.end())
+                    out.push_back(&ts->second);
+            }
+        }},
+        {"twitter", "$.statuses[?(@.retweet_count > 500)].user.screen_name", [&](const Value &root, Nodes &out) {
+            for(const Value &s : root.as_Object().at("statuses").as_Array())
+            {
+                const Object &obj = s.as_Object();
+                auto rc = obj.find("retweet_count"), user = obj.find("user");
+                if(rc == obj.end() || !rc->second.is_Number() || !(rc->second.to_double() > 500))
+                    continue;
+                if(user == obj.end() || !user->second.is_Object())
+                    continue;
+                auto name = user->second.as_Object().find("screen_name");
+                if(name != user->second.as_Object().end())
+                    out.push_back(&name->second);
+            }
+        }},
+        {"twitter", "$..screen_name", [&](const Value &root, Nodes &out) {
+            collect(root, "screen_name", out);
+        }},
+    };
+
+    for(const auto &in : inputs)
+        for(const auto &q : queries)
+        {
+            if(in.name.compare(0, std::string(q.doc).size(), q.doc) != 0)
+                continue;
+
+            JsonPath path(q.path);
+            Nodes expected;
+            q.hand(in.root, expected);
+            if(!same(path.Select(in.root), expected))
+                std::fprintf(stderr, "json_bench: path %s differs from hand-written on %s\n",
+                             q.path, in.name.c_str());
+
+            std::string doc = in.name + " " + q.path;
+            ctx.measure("path", doc, "compile", 0, 1, [&] {
+                JsonPath p(q.path);
+                ctx.consume(p.expression().size());
+            });
+
+            ctx.measure("path", doc, "select", 0, in.elements, [&] {
+                ctx.consume(path.Select(in.root).size());
+            });
+
+            for(unsigned threads : thread_counts())
+            {
+                ParallelOptions opt;
+                opt.threads = threads;
+                opt.min_bytes = 0;
+                if(!same(path.Select(in.root, opt), expected))
+                    std::fprintf(stderr, "json_bench: parallel path %s with %u threads differs on %s\n",
+                                 q.path, threads, in.name.c_str());
+
+                ctx.measure("path", doc, "select/t" + std::to_string(threads), 0, in.elements, [&] {
+                    ctx.consume(path.Select(in.root, opt).size());
+                });
+            }
+
+            ctx.measure("path", doc, "hand", 0, in.elements, [&] {
+                Nodes out;
+                q.hand(in.root, out);
+                ctx.consume(out.size());
+            });
+        }
+}
@@ -0,0 +1,81 @@
+/// pmr：树的内存来自不同的std::pmr::memory_resource（见Json_alloc.h）
+///   new        默认的::operator new
+///   monotonic  monotonic_buffer_resource，初始缓冲区为文档长度的8倍，每次迭代之后release
+///   pool       unsynchronized_pool_resource，在迭代之间保留（释放的块留在池中重用）
+///   parse    Value::Parse(text, mr)，不计释放
+///   destroy  只计释放一棵完整的树（monotonic的释放只运行析构函数，不归还内存）
+///   cycle    解析、释放并归还内存：一个请求的完整生命周期
+/// allocs一列是::operator new的次数，monotonic与pool只在向上游申请时才计数。
+/// 先验证三种来源解析的结果与默认的相同。
+
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+
+BENCH_SUITE(pmr)
+{
+    for(const auto &doc : docs)
+    {
+        Value v = Value::Parse(doc.text);
+        std::size_t nodes = bench::count_nodes(v);
+        JsonString expected = v.Serialize();
+
+        std::vector<char> buffer(doc.text.size() * 8);
+        std::pmr::monotonic_buffer_resource mono(buffer.data(), buffer.size());
+        std::pmr::unsynchronized_pool_resource pool;
+
+        struct Mode
+        {
+            const char *name;
+            std::pmr::memory_resource *mr;
+        };
+        for(const Mode &mode : {Mode{"new", nullptr}, Mode{"monotonic", &mono}, Mode{"pool", &pool}})
+        {
+            std::string m = mode.name;
+            std::pmr::memory_resource *mr = mode.mr;
+            auto release = [&] {
+                if(mr == &mono)
+                    mono.release();
+            };
+
+            {
+                Value check = Value::Parse(doc.text, mr);
+                if(check.Serialize() != expected)
+                    std::fprintf(stderr, "json_bench: pmr %s differs for %s\n", mode.name, doc.name.c_str());
+            }
+            release();
+
+            ctx.measure_with("pmr", doc.name, "parse/" + m, doc.text.size(), nodes,
+                             [&](bench::Stopwatch &sw) {
+                sw.start();
+                Value *p = new Value(Value::Parse(doc.text, mr));
+                sw.stop();
+                ctx.consume(p->is_Null());
+                delete p;
+                release();
+            });
+
+            ctx.measure_with("pmr", doc.name, "destroy/" + m, doc.text.size(), nodes,
+                             [&](bench::Stopwatch &sw) {
+                Value *p = new Value(Value::Parse(doc.text, mr));
+                sw.start();
+                delete p;
+                sw.stop();
+                release();
+            });
+
+            ctx.measure("pmr", doc.name, "cycle/" + m, doc.text.size(), nodes, [&] {
+                {
+                    Value p = Value::Parse(doc.text, mr);
+                    ctx.consume(p.is_Null());
+                }
+                release();
+            });
+        }
+    }
+}
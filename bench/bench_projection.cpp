@@ -0,0 +1,49 @@
+/// projection：只需要每条推文的id、created_at与user.screen_name
+///   parse_all   Value::Parse整个文档，再取出这三个字段
+///   projection  Value::Parse(text, Projection)，其余成员只做结构检查地跳过
+/// 先验证两种方式取出的字段相同。
+
+#include <cstdio>
+#include <string>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+std::size_t extract(const Value &doc)
+{
+    std::size_t n = 0;
+    for(const auto &status : doc.as_Object().at("statuses").as_Array())
+    {
+        const Object &o = status.as_Object();
+        n += o.at("id").to_ulonglong() & 1;
+        n += o.at("created_at").to_string().size();
+        n += o.at("user").as_Object().at("screen_name").to_string().size();
+    }
+    return n;
+}
+
+} // namespace
+
+
+BENCH_SUITE(projection)
+{
+    (void)docs;
+
+    JsonString text = bench::make_twitter(ctx.options.size);
+    Projection proj{"statuses.id", "statuses.created_at", "statuses.user.screen_name"};
+    Value full = Value::Parse(text);
+    std::size_t nodes = bench::count_nodes(full);
+    if(extract(full) != extract(Value::Parse(text, proj)))
+        std::fprintf(stderr, "json_bench: projected fields differ\n");
+
+    ctx.measure("projection", "twitter", "parse_all", text.size(), nodes, [&] {
+        ctx.consume(extract(Value::Parse(text)));
+    });
+
+    ctx.measure("projection", "twitter", "projection", text.size(), nodes, [&] {
+        ctx.consume(extract(Value::Parse(text, proj)));
+    });
+}
@@ -0,0 +1,146 @@
+/// records：由大量结构相同的小对象组成的数组（默认1<<20条记录，条数取--size的值）
+///   copy     深拷贝整个数组，alloc_bytes即一份树所占的堆内存
+///   iterate  用Object::for_each遍历每条记录的全部成员
+///   lookup   用Object::at按键读取每条记录的两个字段
+///   compact  只计Value::compact的时间（doc为map）
+/// 每个操作分别在普通的map形式（map）与compact之后的形式（compact）上测量，
+/// 先验证两种形式序列化的结果相同，以及在两种形式上按键与通过const迭代器插入、删除的结果相同。
+
+#include <algorithm>
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+/// 每条记录有id、name、score、active四个键，每16条中有一条多一个tags
+JsonString make_records(std::size_t n)
+{
+    std::string s = "[";
+    char buf[160];
+    for(std::size_t i = 0; i != n; ++i)
+    {
+        std::snprintf(buf, sizeof(buf),
+                      "%s{\"id\":%zu,\"name\":\"user%zu\",\"score\":%zu.%zu,\"active\":%s%s}",
+                      i ? "," : "", i, i, i % 1000, i % 7,
+                      i % 3 ? "true" : "false",
+                      i % 16 ? "" : ",\"tags\":[\"a\",\"b\"]");
+        s += buf;
+    }
+    return s + "]";
+}
+
+} // namespace
+
+
+BENCH_SUITE(records)
+{
+    (void)docs;
+
+    std::size_t n = ctx.options.size;
+    JsonString text = make_records(n);
+    /// compact之后Packed与其所在的Object不相邻；两种形式都用拷贝得到的树测量，
+    /// 使结点都按遍历顺序分配，内存布局可比
+    Value parsed = Value::Parse(text);
+    Value packed = parsed;
+    packed.compact();
+    packed = Value(packed);
+    Value plain = parsed;
+    std::size_t nodes = bench::count_nodes(plain);
+
+    if(packed.Serialize() != plain.Serialize() || packed != plain)
+        std::fprintf(stderr, "json_bench: compact result differs\n");
+    {
+        /// 以字面量与std::string_view为键的erase在压缩的Object上同样删除成员
+        Value a = packed, b = plain;
+        std::size_t erased = 0;
+        for(auto &r : a.as_Array())
+            erased += r.as_Object().erase("score") + r.as_Object().erase(std::string_view("id"));
+        for(auto &r : b.as_Array())
+        {
+            r.as_Object().erase("score");
+            r.as_Object().erase("id");
+        }
+        if(erased != 2 * n || a != b || a.Serialize() != b.Serialize())
+            std::fprintf(stderr, "json_bench: erase on compacted objects differs\n");
+    }
+    {
+        /// 通过const迭代器插入与删除：压缩的Object上迭代器指向packed->view，
+        /// 树来自memory_resource时view与map的分配器不同；只取前1000条记录
+        JsonString small = make_records(std::min<std::size_t>(n, 1000));
+        std::pmr::monotonic_buffer_resource mono;
+        auto edit = [](Value &doc, int op) {
+            for(auto &r : doc.as_Array())
+            {
+                Object &obj = r.as_Object();
+                const Object &view = obj;
+                if(op == 0)
+                    obj.erase(view.find("score"));
+                else if(op == 1)
+                    obj.insert(view.cend(), {"zz", 1});
+                else if(op == 2)
+                    obj.insert(view.find("name"), {"m", 2});
+                else
+                    obj.erase(view.find("id"), view.find("score"));
+            }
+        };
+        for(int op = 0; op != 4; ++op)
+        {
+            Value expected = Value::Parse(small);
+            Value heap = Value::Parse(small);
+            Value pooled = Value::Parse(small, &mono);
+            heap.compact();
+            pooled.compact();
+            edit(expected, op);
+            edit(heap, op);
+            edit(pooled, op);
+            if(heap != expected || pooled != expected || pooled.Serialize() != expected.Serialize())
+                std::fprintf(stderr, "json_bench: positional insert/erase on compacted objects differs\n");
+        }
+    }
+
+    const Value *forms[] = {&plain, &packed};
+    const char *names[] = {"map", "compact"};
+    for(int f = 0; f != 2; ++f)
+    {
+        const Value &v = *forms[f];
+        const Array &records = v.as_Array();
+
+        ctx.measure("records", names[f], "copy", text.size(), nodes, [&] {
+            Value c = v;
+            ctx.consume(c.is_Array());
+        });
+
+        ctx.measure("records", names[f], "iterate", text.size(), nodes, [&] {
+            std::size_t sum = 0;
+            for(const auto &r : records)
+                r.as_Object().for_each([&sum](const String &, const Value &m) {
+                    sum += static_cast<std::size_t>(m.Type());
+                });
+            ctx.consume(sum);
+        });
+
+        ctx.measure("records", names[f], "lookup", text.size(), nodes, [&] {
+            std::size_t sum = 0;
+            for(const auto &r : records)
+            {
+                const Object &o = r.as_Object();
+                sum += static_cast<std::size_t>(o.at("score").to_double());
+                sum += o.at("active").is_True();
+            }
+            ctx.consume(sum);
+        });
+    }
+
+    ctx.measure_with("records", "map", "compact", text.size(), nodes,
+                     [&](bench::Stopwatch &sw) {
+        Value c = plain;
+        sw.start();
+        c.compact();
+        sw.stop();
+    });
+}
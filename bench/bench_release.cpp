@@ -0,0 +1,109 @@
+/// release：请求线程丢弃大树时的尾部延迟
+/// 模拟一个服务：请求按固定间隔到达，每个请求解析一条小消息并读取一个字段；
+/// 每kWindow个请求中有一个还要把缓存的大文档（twitter语料）换成预先准备好的新版本，
+/// 旧版本在这个请求中被丢弃：
+///   sync      旧树在请求线程中析构
+///   deferred  Reclaimer（后台线程，SCHED_IDLE）释放，请求线程只入队
+///   idle      Reclaimer（没有后台线程），每个请求结束后、等待下一个请求之前调用reclaim
+/// 新版本在两个请求之间准备（拷贝），不计入模拟的时间（到达时刻相应推后）；
+/// 到达间隔取「释放旧版本 + kWindow个小请求」耗时的4倍除以kWindow（负载约25%），
+/// 负载更高时后台线程的空闲时间不够，队列中积压的释放也会拖慢请求。
+/// 每个请求的延迟从它的到达时刻算起（前面的工作拖延了它时，等待的时间也计入），
+/// 按p50/p90/p99/p99.9/max报告，ns/node一列就是延迟（ns），并显示直方图。
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+const std::size_t kWindow = 20;
+
+
+double elapsed_ns(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration<double, std::nano>(to - from).count();
+}
+
+} // namespace
+
+
+BENCH_SUITE(release)
+{
+    (void)docs;
+
+    const Value big = Value::Parse(bench::make_twitter(ctx.options.size));
+    std::vector<JsonString> messages;
+    for(const auto &status : big.as_Object().at("statuses").as_Array())
+        messages.push_back(status.Serialize());
+    const String idKey = "id";
+
+    /// 一个小请求
+    auto handle = [&](std::size_t i) {
+        Value msg = Value::Parse(messages[i % messages.size()]);
+        ctx.consume(static_cast<std::size_t>(msg.as_Object().at(idKey).to_longlong()));
+    };
+
+    /// 估计各部分的耗时，决定到达间隔
+    Value *next = new Value(big);
+    Clock::time_point t0 = Clock::now();
+    delete next;
+    for(std::size_t i = 0; i != kWindow; ++i)
+        handle(i);
+    double window = elapsed_ns(t0, Clock::now());
+    auto interval = std::chrono::nanoseconds(static_cast<long long>(4 * window / kWindow));
+    std::size_t requests = kWindow * static_cast<std::size_t>(ctx.options.minTime * 400 + 1);
+
+    for(const char *mode : {"sync", "deferred", "idle"})
+    {
+        std::string m = mode;
+        json::ReleaseOptions opt;
+        opt.background = m == "deferred";
+        json::Reclaimer reclaimer(opt);
+
+        Value state = big;
+        Value fresh = big;
+        bench::LatencyHistogram hist;
+        Clock::time_point arrival = Clock::now() + interval;
+        for(std::size_t i = 0; i != requests; ++i, arrival += interval)
+        {
+            Clock::time_point start = Clock::now();
+            if(start < arrival)
+            {
+                std::this_thread::sleep_until(arrival);
+                start = Clock::now();   /// 定时器唤醒晚了不计入
+            }
+            else
+                start = arrival;
+
+            handle(i);
+            if(i % kWindow == 0)
+            {
+                Value old = std::move(state);
+                state = std::move(fresh);
+                if(m != "sync")
+                    reclaimer.release(std::move(old));
+            }
+            hist.record(elapsed_ns(start, Clock::now()));
+
+            if(i % kWindow == 0)
+            {
+                Clock::time_point p0 = Clock::now();
+                fresh = big;            /// 下一个版本
+                arrival += Clock::now() - p0;
+            }
+            if(m == "idle")
+                reclaimer.reclaim();
+        }
+        reclaimer.drain();
+        ctx.report_latency("release", "twitter", mode, messages[0].size(), hist);
+    }
+}
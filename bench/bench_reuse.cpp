@@ -0,0 +1,54 @@
+/// reuse：反复解析结构相同的小消息（twitter语料中的每条推文单独作为一条消息）
+///   parse       每条消息都用Value::Parse得到一棵新树，旧树逐个结点释放
+///   parse_into  Value::ParseInto在同一棵树上解析，重用结构相同的部分
+/// 先验证两种方式的结果相同。
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+BENCH_SUITE(reuse)
+{
+    (void)docs;
+
+    Value doc = Value::Parse(bench::make_twitter(ctx.options.size));
+    std::vector<JsonString> messages;
+    std::size_t bytes = 0, nodes = 0;
+    for(const auto &status : doc.as_Object().at("statuses").as_Array())
+    {
+        messages.push_back(status.Serialize());
+        bytes += messages.back().size();
+        nodes += bench::count_nodes(status);
+    }
+
+    Value reuse;
+    for(const auto &m : messages)
+    {
+        Value::ParseInto(m, reuse);
+        if(reuse != Value::Parse(m))
+        {
+            std::fprintf(stderr, "json_bench: ParseInto result differs\n");
+            break;
+        }
+    }
+
+    ctx.measure("reuse", "statuses", "parse", bytes, nodes, [&] {
+        Value v;
+        for(const auto &m : messages)
+        {
+            v = Value::Parse(m);
+            ctx.consume(v.is_Object());
+        }
+    });
+
+    ctx.measure("reuse", "statuses", "parse_into", bytes, nodes, [&] {
+        for(const auto &m : messages)
+        {
+            Value::ParseInto(m, reuse);
+            ctx.consume(reuse.is_Object());
+        }
+    });
+}
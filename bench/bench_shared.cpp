@@ -0,0 +1,137 @@
+/// shared：多个读线程查询路由表的同时，一个写线程不断整体替换它
+///   mutex/tN   每次查询都在std::mutex保护下访问同一个Value，写者在锁内替换
+///   rcu/tN     通过SharedDocument::read()查询快照，写者publish新快照
+/// 写者每10ms替换一次，每次替换都要拷贝一个预先生成的版本。
+/// 每次迭代中N个读线程各做一批查询，ns/node为每次查询（墙钟时间）的平均值。
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+const std::size_t nroutes = 10000;
+const std::size_t lookups = 20000;    /// 每个读线程每次迭代的查询次数
+
+Value make_routes(std::size_t generation)
+{
+    Object routes;
+    for(std::size_t i = 0; i != nroutes; ++i)
+        routes["route/" + std::to_string(i)] = Value{
+            {"backend", "10.0." + std::to_string(i % 256) + "." + std::to_string(generation % 256)},
+            {"weight", static_cast<unsigned long long>(i + generation)}};
+    return Value{{"generation", static_cast<unsigned long long>(generation)},
+                 {"routes", routes}};
+}
+
+
+std::vector<unsigned> thread_counts()
+{
+    std::vector<unsigned> counts = {1, 2, 4};
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    if(hw > 4)
+        counts.push_back(hw);
+    return counts;
+}
+
+
+/// 启动threads个读线程各执行一次read(i)，同时运行写线程write()，直到读线程全部结束
+template<typename _Read, typename _Write>
+std::size_t contend(unsigned threads, _Read read, _Write write)
+{
+    std::atomic<bool> done(false);
+    std::atomic<std::size_t> sum(0);
+
+    std::thread writer([&] {
+        for(std::size_t g = 1; !done.load(); ++g)
+        {
+            write(g);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+
+    std::vector<std::thread> readers;
+    for(unsigned t = 0; t != threads; ++t)
+        readers.emplace_back([&, t] { sum += read(t); });
+    for(auto &r : readers)
+        r.join();
+
+    done = true;
+    writer.join();
+    return sum.load();
+}
+
+} // namespace
+
+
+BENCH_SUITE(shared)
+{
+    (void)docs;
+
+    const String routesKey = "routes";
+    std::vector<String> keys;
+    for(std::size_t i = 0; i != nroutes; ++i)
+        keys.push_back("route/" + std::to_string(i * 7919 % nroutes));
+
+    /// 写者在测量之外预先生成若干个版本，只测量替换本身对读者的影响
+    std::vector<Value> versions;
+    for(std::size_t g = 0; g != 8; ++g)
+        versions.push_back(make_routes(g));
+    std::size_t bytes = versions[0].Serialize().size();
+
+    for(unsigned threads : thread_counts())
+    {
+        std::size_t reads = static_cast<std::size_t>(threads) * lookups;
+
+        std::mutex mtx;
+        Value guarded = versions[0];
+        ctx.measure("shared", "routes", "mutex/t" + std::to_string(threads), bytes, reads, [&] {
+            ctx.consume(contend(threads,
+                [&](unsigned t) {
+                    std::size_t n = 0;
+                    for(std::size_t i = 0; i != lookups; ++i)
+                    {
+                        std::lock_guard<std::mutex> lk(mtx);
+                        const Object &routes = guarded.as_Object().at(routesKey).as_Object();
+                        n += routes.find(keys[(i + t) % nroutes])->second.as_Object().size();
+                    }
+                    return n;
+                },
+                [&](std::size_t g) {
+                    Value next = versions[g % versions.size()];
+                    std::lock_guard<std::mutex> lk(mtx);
+                    guarded = std::move(next);
+                }));
+        });
+
+        SharedDocument shared(versions[0]);
+        ctx.measure("shared", "routes", "rcu/t" + std::to_string(threads), bytes, reads, [&] {
+            ctx.consume(contend(threads,
+                [&](unsigned t) {
+                    std::size_t n = 0;
+                    for(std::size_t i = 0; i != lookups; ++i)
+                    {
+                        auto snap = shared.read();
+                        const Object &routes = snap->as_Object().at(routesKey).as_Object();
+                        n += routes.find(keys[(i + t) % nroutes])->second.as_Object().size();
+                    }
+                    return n;
+                },
+                [&](std::size_t g) {
+                    shared.publish(versions[g % versions.size()]);
+                }));
+        });
+
+        if(shared.reclaim() != 0)
+            std::fprintf(stderr, "json_bench: %zu snapshots not reclaimed\n", shared.pending());
+    }
+}
@@ -0,0 +1,163 @@
+/// slab：长期存在、不断修改的文档使用SlabPool（见Json_slab.h）与默认的::operator new
+///   mutate/M    会话状态：512个用户的Object，每次迭代随机做kOps次修改
+///               （替换数字、布尔与null、替换短字符串、Array的push_back与erase、删除并重建用户），
+///               文档与修改时创建的值都来自M（处理请求的线程用ResourceScope选择）
+///   handoff/M   生产者线程创建小文档，通过队列交给消费者线程释放（跨线程释放），
+///               每次迭代kMessages个文档
+///   M为new或slab；ns/node为每次修改或每个文档的耗时。
+/// 先验证两种来源执行同样的修改之后结果相同。
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+const std::size_t kUsers = 512;
+const std::size_t kOps = 20000;
+const std::size_t kMessages = 20000;
+
+
+Value make_user(std::size_t i)
+{
+    return Value{{"name", "user-" + std::to_string(i)}, {"hits", 0}, {"active", false},
+                 {"last", Value()}, {"tags", Value{1, 2, 3}}};
+}
+
+
+/// 确定性的随机修改，seed相同时两种来源得到相同的结果
+void mutate(Value &session, std::uint64_t &seed, std::size_t ops)
+{
+    Object &users = session.as_Object();
+    for(std::size_t i = 0; i != ops; ++i)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::uint32_t r = static_cast<std::uint32_t>(seed >> 33);
+        std::string key = "u" + std::to_string(r % kUsers);
+        switch(r / kUsers % 6)
+        {
+        case 0: users[key].as_Object()["hits"] = static_cast<int>(i); break;
+        case 1: users[key].as_Object()["active"] = (i & 1) != 0; break;
+        case 2: users[key].as_Object()["last"] = Value(); break;
+        case 3: users[key].as_Object()["name"] = "user-" + std::to_string(i % 1000); break;
+        case 4:
+        {
+            Array &tags = users[key].as_Object()["tags"].as_Array();
+            tags.push_back(static_cast<int>(i));
+            if(tags.size() > 8)
+                tags.erase(tags.begin());
+            break;
+        }
+        default:
+            users.erase(key);
+            users[key] = make_user(i);
+            break;
+        }
+    }
+}
+
+} // namespace
+
+
+BENCH_SUITE(slab)
+{
+    (void)docs;
+
+    struct Mode
+    {
+        const char *name;
+        std::pmr::memory_resource *mr;
+    };
+    const Mode modes[] = {{"new", nullptr}, {"slab", &json::SlabPool::global()}};
+
+    JsonString text;
+    {
+        Object users;
+        for(std::size_t i = 0; i != kUsers; ++i)
+            users["u" + std::to_string(i)] = make_user(i);
+        text = Value(users).Serialize();
+    }
+
+    JsonString results[2];
+    for(int m = 0; m != 2; ++m)
+    {
+        json::ResourceScope scope(modes[m].mr);
+        Value session = Value::Parse(text);
+        std::uint64_t seed = 42;
+        mutate(session, seed, kOps);
+        results[m] = session.Serialize();
+    }
+    if(results[0] != results[1])
+        std::fprintf(stderr, "json_bench: slab mutate results differ\n");
+
+    for(const Mode &mode : modes)
+    {
+        std::string name = mode.name;
+        json::ResourceScope scope(mode.mr);
+        Value session = Value::Parse(text);
+        std::uint64_t seed = 7;
+        ctx.measure("slab", "session", "mutate/" + name, text.size(), kOps, [&] {
+            mutate(session, seed, kOps);
+        });
+    }
+
+    for(const Mode &mode : modes)
+    {
+        std::string name = mode.name;
+        ctx.measure("slab", "messages", "handoff/" + name, 0, kMessages, [&] {
+            std::mutex mtx;
+            std::condition_variable cv;
+            std::deque<Value> queue;
+            bool done = false;
+
+            std::thread consumer([&] {
+                std::unique_lock<std::mutex> lk(mtx);
+                for(;;)
+                {
+                    cv.wait(lk, [&] { return done || !queue.empty(); });
+                    if(queue.empty())
+                        return;
+                    Value v = std::move(queue.front());
+                    queue.pop_front();
+                    lk.unlock();
+                    ctx.consume(v.is_Null());
+                    v = Value();        /// 在消费者线程中释放
+                    lk.lock();
+                }
+            });
+
+            {
+                json::ResourceScope scope(mode.mr);
+                for(std::size_t i = 0; i != kMessages; ++i)
+                {
+                    Value msg{{"id", static_cast<int>(i)}, {"ok", true}, {"tags", Value{1, 2, 3}}};
+                    std::lock_guard<std::mutex> lk(mtx);
+                    queue.push_back(std::move(msg));
+                    if(queue.size() == 1)
+                        cv.notify_one();
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                done = true;
+            }
+            cv.notify_one();
+            consumer.join();
+        });
+    }
+
+    json::SlabPool::Stats st = json::SlabPool::global().stats();
+    if(ctx.options.format == "text")
+        std::printf("slab     pool: %llu slabs, %llu remote frees\n",
+                    static_cast<unsigned long long>(st.slabs),
+                    static_cast<unsigned long long>(st.remote_frees));
+}
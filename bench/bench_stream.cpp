@@ -0,0 +1,104 @@
+/// stream：逐个处理一个大文件中顶层数组的元素（twitter的statuses，约16倍--size）
+///   parse_all       读入整个文件，Value::Parse得到整个Array再遍历
+///   stream_mmap     ArrayStream::from_file（mmap）
+///   stream_fd       ArrayStream::from_fd，不预读
+///   stream_fd_ahead ArrayStream::from_fd，后台线程预读
+/// alloc KB即每次处理整个文件所分配的内存；先验证得到的元素个数相同。
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bench.h"
+
+USING_JSON_UTILITIES
+
+namespace
+{
+
+std::size_t visit(const Value &v)
+{
+    return v.is_Object() ? v.as_Object().size() : 1;
+}
+
+} // namespace
+
+
+BENCH_SUITE(stream)
+{
+    (void)docs;
+
+    Value statuses = Value::Parse(bench::make_twitter(ctx.options.size)).as_Object().at("statuses");
+    std::string element = statuses.Serialize();
+    element = element.substr(1, element.size() - 2);
+
+    char path[] = "/tmp/json_bench_stream_XXXXXX";
+    int tmp = ::mkstemp(path);
+    if(tmp < 0)
+    {
+        std::fprintf(stderr, "json_bench: cannot create a temporary file\n");
+        return;
+    }
+    ::close(tmp);
+    std::size_t bytes = 0;
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << '[';
+        for(int i = 0; i != 16; ++i)
+        {
+            out << (i ? "," : "") << element;
+            bytes += element.size() + 1;
+        }
+        out << ']';
+        bytes += 1;
+    }
+
+    std::size_t expect = statuses.as_Array().size() * 16, nodes = bench::count_nodes(statuses) * 16;
+    {
+        ArrayStream s = ArrayStream::from_file(path);
+        Value v;
+        while(s.next(v)) {}
+        if(s.count() != expect)
+            std::fprintf(stderr, "json_bench: stream element count differs\n");
+    }
+
+    ctx.measure("stream", "statuses", "parse_all", bytes, nodes, [&] {
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream text;
+        text << in.rdbuf();
+        Value all = Value::Parse(text.str());
+        std::size_t n = 0;
+        for(const auto &v : all.as_Array())
+            n += visit(v);
+        ctx.consume(n);
+    });
+
+    ctx.measure("stream", "statuses", "stream_mmap", bytes, nodes, [&] {
+        std::size_t n = 0;
+        for(const Value &v : ArrayStream::from_file(path))
+            n += visit(v);
+        ctx.consume(n);
+    });
+
+    ArrayStream::Options opt;
+    for(bool ahead : {false, true})
+    {
+        opt.read_ahead = ahead;
+        ctx.measure("stream", "statuses", ahead ? "stream_fd_ahead" : "stream_fd", bytes, nodes, [&] {
+            int fd = ::open(path, O_RDONLY);
+            std::size_t n = 0;
+            {
+                ArrayStream s = ArrayStream::from_fd(fd, opt);
+                for(const Value &v : s)
+                    n += visit(v);
+            }
+            ::close(fd);
+            ctx.consume(n);
+        });
+    }
+
+    ::unlink(path);
+}